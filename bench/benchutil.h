@@ -0,0 +1,67 @@
+#ifndef BENCHUTIL_H
+#define BENCHUTIL_H
+
+#include <chrono>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#define BENCH_HAS_TSC 1
+#endif
+
+// Small helpers shared by the benchmark executables.
+
+class Stopwatch
+{
+public:
+    Stopwatch() { reset(); }
+
+    void reset() {
+        start_ = std::chrono::steady_clock::now();
+        start_cycles_ = cycles();
+    }
+
+    double elapsedNs() const {
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start_).count();
+    }
+
+    std::uint64_t elapsedCycles() const { return cycles() - start_cycles_; }
+
+    // Time stamp counter where available, zero elsewhere
+    static std::uint64_t cycles() {
+#ifdef BENCH_HAS_TSC
+        return __rdtsc();
+#else
+        return 0;
+#endif
+    }
+
+    static bool hasCycleCounter() {
+#ifdef BENCH_HAS_TSC
+        return true;
+#else
+        return false;
+#endif
+    }
+
+private:
+    std::chrono::steady_clock::time_point start_;
+    std::uint64_t start_cycles_;
+};
+
+// Keeps the optimizer from discarding a rendered result
+template<typename T>
+inline void doNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const T* sink;
+    sink = &value;
+#endif
+}
+
+#endif // BENCHUTIL_H
@@ -0,0 +1,290 @@
+// Cable latency benchmark. Plays a LiveGraph of 32 voices in real time on its own thread,
+// as a sound card callback would, while the main thread drops and pulls cables between
+// two LFOs and the filter and volume inputs at random moments, like a patch panel. The
+// audio thread asks for real-time priority, as sound card threads get, and between
+// blocks picks up edits as they arrive with LiveGraph::applyPending(). It reports the
+// wall-clock time from an edit being sent to it being applied, next to the block length,
+// along with the block render times and how late the OS woke the audio thread.
+//
+// usage: cablebench [--voices N] [--frames N] [--seconds N] [--seed N]
+//
+// It fails when any edit took longer than one block to be applied, when any block started
+// late enough to miss its period, or when the audio thread was ever woken more than a
+// quarter of a block late.
+
+#include "audiocontext.h"
+#include "benchutil.h"
+#include "definitions.h"
+#include "denormals.h"
+#include "livegraph.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace {
+
+struct Options {
+    unsigned voices = 32;
+    unsigned frames = 256;
+    double seconds = 3.0;
+    std::uint64_t seed = 1;
+};
+
+class Random
+{
+public:
+    explicit Random(std::uint64_t seed) : state_(seed * 0x9e3779b97f4a7c15ull + 1) {}
+
+    float uniform(float low, float high) {
+        state_ ^= state_ << 13;
+        state_ ^= state_ >> 7;
+        state_ ^= state_ << 17;
+        return low + (high - low) * static_cast<float>(state_ >> 40) / 16777216.0f;
+    }
+
+    unsigned below(unsigned count) { return std::min(count - 1, static_cast<unsigned>(uniform(0.0f, static_cast<float>(count)))); }
+
+private:
+    std::uint64_t state_;
+};
+
+// the nodes a cable can go between
+struct Panel {
+    unsigned lfos[2];
+    // attenuators in front of the filter cutoff and the master gain
+    unsigned inputs[2];
+    unsigned filter;
+};
+
+bool buildPatch(const Options& options, Random& random, LiveGraph& live, Panel& panel) {
+    const int mixer = live.addNode("mixer");
+    const int filter = live.addNode("lp12");
+    const int master = live.addNode("gain");
+    const int cutoff_depth = live.addNode("muladd");
+    const int gain_depth = live.addNode("muladd");
+    const int lfo_1 = live.addNode("oscillator");
+    const int lfo_2 = live.addNode("oscillator");
+    if (mixer < 0 || filter < 0 || master < 0 || cutoff_depth < 0 || gain_depth < 0 || lfo_1 < 0 || lfo_2 < 0) {
+        return false;
+    }
+
+    bool ok = live.connect(mixer, filter) && live.connect(filter, master) && live.connect(cutoff_depth, filter, 0) &&
+              live.connect(gain_depth, master, 0) && live.setOutput(master) &&
+              live.setParameter(filter, "cutoff", 1200.0f) && live.setParameter(filter, "resonance", 2.0f) &&
+              live.setParameter(master, "gain", 0.6f) && live.setParameter(cutoff_depth, "multiply", 900.0f) &&
+              live.setParameter(gain_depth, "multiply", 0.3f) && live.setParameter(lfo_1, "frequency", 0.7f) &&
+              live.setParameter(lfo_2, "waveform", 1.0f) && live.setParameter(lfo_2, "frequency", 5.0f);
+
+    for (unsigned v = 0; ok && v < options.voices; ++v) {
+        const int voice = live.addNode("voice");
+        const float frequency = random.uniform(55.0f, 880.0f);
+        ok = voice >= 0 && live.connect(voice, mixer) &&
+             live.setParameter(voice, "oscillator_1_waveform", static_cast<float>(random.below(6))) &&
+             live.setParameter(voice, "oscillator_2_waveform", static_cast<float>(random.below(6))) &&
+             live.setParameter(voice, "oscillator_1_frequency", frequency) &&
+             live.setParameter(voice, "oscillator_2_frequency", frequency * 1.01f) &&
+             live.setParameter(voice, "oscillator_1_gain", 0.6f) && live.setParameter(voice, "oscillator_2_gain", 0.4f) &&
+             live.setParameter(voice, "mod_frequency", random.uniform(0.5f, 7.0f)) &&
+             live.setParameter(voice, "sustain", 0.8f) && live.setParameter(voice, "gate", 1.0f);
+    }
+
+    panel = { { static_cast<unsigned>(lfo_1), static_cast<unsigned>(lfo_2) },
+              { static_cast<unsigned>(cutoff_depth), static_cast<unsigned>(gain_depth) },
+              static_cast<unsigned>(filter) };
+    return ok;
+}
+
+// the time an idle audio thread sleeps between looks at the edit queue, per block
+constexpr unsigned IDLE_POLLS = 8;
+
+// Real-time priority for the calling thread; false where the OS refuses it
+bool raiseToRealtime() {
+#if defined(__unix__) || defined(__APPLE__)
+    sched_param parameters {};
+    parameters.sched_priority = sched_get_priority_max(SCHED_FIFO);
+    return pthread_setschedparam(pthread_self(), SCHED_FIFO, &parameters) == 0;
+#else
+    return false;
+#endif
+}
+
+// CPU time the hypervisor gave to other guests so far, in ms, or -1 where unknown. A
+// virtual machine that loses its CPU wakes the audio thread late whatever its priority.
+double stolenMs() {
+#if defined(__linux__)
+    std::FILE* stat = std::fopen("/proc/stat", "r");
+    if (stat == nullptr) {
+        return -1.0;
+    }
+    unsigned long long fields[8] = {};
+    const int read = std::fscanf(stat, "cpu %llu %llu %llu %llu %llu %llu %llu %llu", &fields[0], &fields[1],
+                                 &fields[2], &fields[3], &fields[4], &fields[5], &fields[6], &fields[7]);
+    std::fclose(stat);
+    // the eighth field is steal time, in clock ticks of 10 ms
+    return read == 8 ? static_cast<double>(fields[7]) * 10.0 : -1.0;
+#else
+    return -1.0;
+#endif
+}
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        const bool has_value = i + 1 < argc;
+
+        if (std::strcmp(arg, "--voices") == 0 && has_value) {
+            options.voices = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else if (std::strcmp(arg, "--frames") == 0 && has_value) {
+            options.frames = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else if (std::strcmp(arg, "--seconds") == 0 && has_value) {
+            options.seconds = std::atof(argv[++i]);
+        } else if (std::strcmp(arg, "--seed") == 0 && has_value) {
+            options.seed = std::strtoull(argv[++i], nullptr, 10);
+        } else {
+            return false;
+        }
+    }
+
+    return options.frames > 0 && options.seconds > 0.0;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::fprintf(stderr, "usage: cablebench [--voices N] [--frames N] [--seconds N] [--seed N]\n");
+        return 1;
+    }
+
+    AudioContext context(SAMPLE_RATE, options.frames);
+    LiveGraph live(context);
+    Random random(options.seed);
+    Panel panel;
+    if (!buildPatch(options, random, live, panel)) {
+        return 1;
+    }
+
+    // the cables and settings above are queued like any edit; play them in before timing
+    live.process(options.frames);
+    context.updateBatch(options.frames);
+    live.resetStats();
+
+    const auto period = std::chrono::duration<double>(static_cast<double>(options.frames) / SAMPLE_RATE);
+    const double period_us = period.count() * 1e6;
+    const unsigned blocks = static_cast<unsigned>(options.seconds / period.count());
+
+    std::vector<double> render_ns;
+    render_ns.reserve(blocks);
+    std::atomic<bool> done { false };
+    bool realtime = false;
+    unsigned late_blocks = 0;
+    double max_wake_late_us = 0.0;
+
+    const double stolen_before = stolenMs();
+
+    // the "sound card": one block per period, on a steady clock
+    std::thread audio([&]() {
+        ScopedDenormalDisable denormal_guard;
+        realtime = raiseToRealtime();
+        const auto step = std::chrono::duration_cast<std::chrono::steady_clock::duration>(period);
+        auto next = std::chrono::steady_clock::now();
+        for (unsigned block = 0; block < blocks; ++block) {
+            const auto woken = std::chrono::steady_clock::now();
+            max_wake_late_us = std::max(max_wake_late_us, std::chrono::duration<double, std::micro>(woken - next).count());
+
+            Stopwatch watch;
+            live.process(options.frames);
+            render_ns.push_back(watch.elapsedNs());
+            doNotOptimize(live.buffer()[options.frames - 1]);
+            context.updateBatch(options.frames);
+
+            next += step;
+            const auto now = std::chrono::steady_clock::now();
+            if (now > next) {
+                ++late_blocks;
+                next = now;
+            }
+
+            // idle until the next block, applying edits as they come in
+            for (auto poll = now + step / IDLE_POLLS; poll < next; poll += step / IDLE_POLLS) {
+                std::this_thread::sleep_until(poll);
+                live.applyPending();
+            }
+            std::this_thread::sleep_until(next);
+        }
+        done.store(true);
+    });
+
+    // the patch panel: a cable edit every few milliseconds, at no particular point in the block
+    bool patched[2][2] = {};
+    unsigned edits = 0;
+    while (!done.load()) {
+        std::this_thread::sleep_for(std::chrono::microseconds(2000 + random.below(18000)));
+        const unsigned lfo = random.below(2);
+        const unsigned input = random.below(2);
+        bool ok = true;
+        if (patched[lfo][input]) {
+            ok = live.disconnect(panel.lfos[lfo], panel.inputs[input]);
+            patched[lfo][input] = false;
+        } else {
+            // an attenuator takes one cable, so this unplugs the other LFO from it
+            ok = live.connect(panel.lfos[lfo], panel.inputs[input]);
+            patched[lfo][input] = true;
+            patched[1 - lfo][input] = false;
+        }
+        if (!ok) {
+            audio.join();
+            return 1;
+        }
+        ++edits;
+        if (random.below(4) == 0) {
+            live.setParameter(panel.filter, "cutoff", random.uniform(400.0f, 3000.0f));
+            ++edits;
+        }
+    }
+    audio.join();
+
+    std::sort(render_ns.begin(), render_ns.end());
+    double total = 0.0;
+    for (const double ns : render_ns) {
+        total += ns;
+    }
+    const double p99_render_us = render_ns[std::min(render_ns.size() - 1, render_ns.size() * 99 / 100)] / 1000.0;
+    const double max_latency_us = live.maxLatencyNs() / 1000.0;
+
+    std::printf("%u voices, %u frames at %d Hz: %.0f us blocks, %u blocks\n\n", options.voices, options.frames, SAMPLE_RATE,
+                period_us, blocks);
+    std::printf("%-24s %10u sent, %llu applied\n", "edits", edits, live.commandsApplied());
+    std::printf("%-24s %10.1f us mean, %.1f us max (%.2f blocks)\n", "edit to applied", live.meanLatencyNs() / 1000.0,
+                max_latency_us, max_latency_us / period_us);
+    std::printf("%-24s %10u\n", "most blocks waited", live.maxBlocksWaited());
+    std::printf("%-24s %10.1f us max\n", "applying edits", live.maxApplyNs() / 1000.0);
+    std::printf("%-24s %10.1f us mean, %.1f us p99, %.1f us max\n", "render", total / render_ns.size() / 1000.0,
+                p99_render_us, render_ns.back() / 1000.0);
+    std::printf("%-24s %10s\n", "audio thread priority", realtime ? "realtime" : "normal");
+    std::printf("%-24s %10u\n", "late blocks", late_blocks);
+    std::printf("%-24s %10.1f us max\n", "audio thread woken late", max_wake_late_us);
+    const double stolen_after = stolenMs();
+    if (stolen_before >= 0.0 && stolen_after >= 0.0) {
+        std::printf("%-24s %10.0f ms\n", "CPU stolen by the host", stolen_after - stolen_before);
+    }
+
+    const bool within_block = max_latency_us <= period_us && live.maxBlocksWaited() <= 1;
+    const bool on_time = late_blocks == 0 && max_wake_late_us <= period_us / 4.0;
+    std::printf("\nevery edit applied within one block: %s\n", within_block ? "yes" : "no");
+    std::printf("every block on time: %s\n", on_time ? "yes" : "no");
+    return within_block && on_time ? 0 : 1;
+}
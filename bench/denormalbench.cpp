@@ -0,0 +1,126 @@
+// Measures render cost across a note release to show that filter and envelope tails
+// no longer fall off the subnormal CPU cliff.
+//
+// usage: denormalbench [tail seconds]
+
+#include "adsrnode.h"
+#include "audiocontext.h"
+#include "benchutil.h"
+#include "definitions.h"
+#include "denormals.h"
+#include "gainnode.h"
+#include "lp12filternode.h"
+#include "oscillatornode.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+namespace {
+
+constexpr float SUSTAIN_SECONDS = 0.5f;
+constexpr float WINDOW_SECONDS = 0.25f;
+
+struct WindowResult {
+    float start_time;
+    double ns_per_sample;
+    unsigned long long denormals;
+};
+
+// osc -> gain (adsr) -> resonant lp12 -> lp12, note released after SUSTAIN_SECONDS
+std::vector<WindowResult> renderRelease(float tail_seconds, bool flush_to_zero) {
+    AudioContext context(SAMPLE_RATE, FRAMES);
+    context.setDenormalDiagnostics(true);
+
+    OscillatorNode oscillator(context, wave_shape::sawtooth, 110);
+    GainNode amp(context, 0.0f);
+    LP12FilterNode filter(context, 180, 6);
+    LP12FilterNode filter2(context, 180, 6);
+    ADSRNode adsr(context, .01f, .1f, .8f, .05f);
+
+    oscillator.connect(&amp);
+    amp.connect(&filter);
+    filter.connect(&filter2);
+    adsr.automate(&amp, GainNode::Parameters::Gain);
+    adsr.setGate(true);
+
+    std::vector<WindowResult> results;
+
+    const unsigned window_blocks = static_cast<unsigned>(WINDOW_SECONDS * SAMPLE_RATE / FRAMES);
+    const unsigned total_blocks = static_cast<unsigned>((SUSTAIN_SECONDS + tail_seconds) * SAMPLE_RATE / FRAMES);
+    const unsigned release_block = static_cast<unsigned>(SUSTAIN_SECONDS * SAMPLE_RATE / FRAMES);
+
+    unsigned processing_id = 0;
+    for (unsigned block = 0; block < total_blocks; block += window_blocks) {
+        context.resetDenormalCount();
+
+        Stopwatch watch;
+        {
+            // leave the thread untouched when measuring the unprotected case
+            std::unique_ptr<ScopedDenormalDisable> guard;
+            if (flush_to_zero) {
+                guard = std::make_unique<ScopedDenormalDisable>();
+            }
+
+            for (unsigned i = 0; i < window_blocks; ++i) {
+                if (block + i == release_block) {
+                    adsr.setGate(false);
+                }
+                filter2.process(FRAMES, processing_id++);
+                doNotOptimize(filter2.buffer()[FRAMES - 1]);
+            }
+        }
+        const double ns = watch.elapsedNs();
+
+        results.push_back({ static_cast<float>(block) * FRAMES / SAMPLE_RATE,
+                            ns / (static_cast<double>(window_blocks) * FRAMES),
+                            context.denormalCount() });
+    }
+
+    return results;
+}
+
+// The same two-pole recursion as LP12FilterNode without tail handling or FTZ,
+// left to ring out on zero input. It decays slowly enough that the normal-range run
+// never leaves the normal range in one second. This is what the cliff looks like on
+// this machine.
+double referenceTailNs(bool subnormal_start) {
+    float speed = 0.0f;
+    float pos = subnormal_start ? 1e-39f : 1.0f;
+    const float c = 0.002f;
+    const float r = 0.9999f;
+    const unsigned samples = SAMPLE_RATE;
+
+    Stopwatch watch;
+    for (unsigned i = 0; i < samples; ++i) {
+        speed += (0.0f - pos) * c;
+        pos += speed;
+        speed *= r;
+    }
+    doNotOptimize(pos);
+    return watch.elapsedNs() / samples;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    const float tail_seconds = argc > 1 ? static_cast<float>(std::atof(argv[1])) : 4.0f;
+
+    std::printf("reference recursion, normal state    : %8.2f ns/sample\n", referenceTailNs(false));
+    std::printf("reference recursion, subnormal state : %8.2f ns/sample\n\n", referenceTailNs(true));
+
+    const auto unprotected = renderRelease(tail_seconds, false);
+    const auto protected_run = renderRelease(tail_seconds, true);
+
+    std::printf("%8s  %14s  %10s  %14s  %10s\n", "time", "ns/smp (plain)", "subnormal", "ns/smp (ftz)", "subnormal");
+    for (size_t i = 0; i < unprotected.size() && i < protected_run.size(); ++i) {
+        std::printf("%7.2fs  %14.2f  %10llu  %14.2f  %10llu%s\n",
+                    unprotected[i].start_time,
+                    unprotected[i].ns_per_sample, unprotected[i].denormals,
+                    protected_run[i].ns_per_sample, protected_run[i].denormals,
+                    unprotected[i].start_time >= SUSTAIN_SECONDS ? "  (released)" : "");
+    }
+
+    return 0;
+}
@@ -0,0 +1,270 @@
+// Repatching benchmark. Builds a large modular patch node by node into a PatchGraph, then
+// moves cables at random and reports what each edit costs with the processing order kept
+// up to date incrementally, next to sorting the whole graph again after every edit.
+//
+// usage: graphbench [--nodes N] [--edits N] [--seed N]
+//
+// Half of the edits connect two nodes, which replaces the cable already on a single
+// input or port and often points backwards in the current order, so the order has to be
+// repaired. Most join modules that were added near each other, as a cable dragged across
+// one part of a panel would; one in LONG_RANGE joins any two nodes, which can move much
+// of the graph and is reported apart. Edits that would close a feedback loop are refused
+// and counted. The other half remove a random cable. The order is checked as it goes.
+
+#include "audiocontext.h"
+#include "benchutil.h"
+#include "definitions.h"
+#include "denormals.h"
+#include "patch.h"
+#include "patchgraph.h"
+#include "processingorder.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+namespace {
+
+// the module types the patch is built from, with how often each is picked
+const char* const MODULES[] = { "oscillator", "oscillator", "muladd", "muladd", "lp12", "gain", "gain", "arithmetic", "mixer" };
+constexpr unsigned MODULE_COUNT = sizeof(MODULES) / sizeof(MODULES[0]);
+// new modules take their inputs from the last few added, so the patch is deep as well as wide
+constexpr unsigned WINDOW = 64;
+constexpr unsigned OUTPUT_INPUTS = 32;
+constexpr unsigned LONG_RANGE = 10;
+constexpr unsigned FULL_REBUILD_EVERY = 10;
+constexpr unsigned CHECK_EVERY = 100;
+constexpr double TARGET_US = 100.0;
+
+struct Options {
+    unsigned nodes = 5000;
+    unsigned edits = 20000;
+    std::uint64_t seed = 1;
+};
+
+class Random
+{
+public:
+    explicit Random(std::uint64_t seed) : state_(seed * 0x9e3779b97f4a7c15ull + 1) {}
+
+    unsigned below(unsigned count) {
+        state_ ^= state_ << 13;
+        state_ ^= state_ >> 7;
+        state_ ^= state_ << 17;
+        return static_cast<unsigned>((state_ >> 32) % count);
+    }
+
+private:
+    std::uint64_t state_;
+};
+
+struct Stats {
+    std::vector<double> ns;
+
+    double percentile(unsigned percent) {
+        std::sort(ns.begin(), ns.end());
+        return ns.empty() ? 0.0 : ns[std::min(ns.size() - 1, ns.size() * percent / 100)];
+    }
+
+    void print(const char* label) {
+        if (ns.empty()) {
+            std::printf("%-22s %8s\n", label, "-");
+            return;
+        }
+        double total = 0.0;
+        for (const double value : ns) {
+            total += value;
+        }
+        const double p99 = percentile(99);
+        std::printf("%-22s %8zu %10.2f %10.2f %10.2f\n", label, ns.size(), total / ns.size() / 1000.0, p99 / 1000.0,
+                    ns.back() / 1000.0);
+    }
+};
+
+// a random automation port of the node, or its audio input
+unsigned randomPort(const PatchGraph& graph, unsigned node, Random& random) {
+    const unsigned ports = static_cast<unsigned>(graph.nodeType(node)->ports.size());
+    const unsigned pick = random.below(ports + 1);
+    return pick < ports ? pick : PATCH_INPUT_PORT;
+}
+
+bool buildPatch(const Options& options, Random& random, PatchGraph& graph) {
+    for (unsigned i = 0; i < options.nodes; ++i) {
+        const int node = graph.addNode(MODULES[random.below(MODULE_COUNT)]);
+        if (node < 0) {
+            return false;
+        }
+        if (i == 0) {
+            continue;
+        }
+        const unsigned first = i > WINDOW ? i - WINDOW : 0;
+        const unsigned inputs = 1 + random.below(2);
+        for (unsigned c = 0; c < inputs; ++c) {
+            const unsigned from = first + random.below(i - first);
+            if (!graph.connect(from, static_cast<unsigned>(node), randomPort(graph, static_cast<unsigned>(node), random))) {
+                return false;
+            }
+        }
+    }
+
+    const int output = graph.addNode("mixer");
+    if (output < 0) {
+        return false;
+    }
+    for (unsigned i = options.nodes - OUTPUT_INPUTS; i < options.nodes; ++i) {
+        if (!graph.connect(i, static_cast<unsigned>(output))) {
+            return false;
+        }
+    }
+    return graph.setOutput(static_cast<unsigned>(output));
+}
+
+unsigned countCables(const ProcessingOrder& order) {
+    unsigned cables = 0;
+    for (unsigned node = 0; node < order.nodeCount(); ++node) {
+        cables += static_cast<unsigned>(order.outputs(node).size());
+    }
+    return cables;
+}
+
+// Copies the graph's cables into a fresh order and times sorting it from scratch, plus
+// mapping every position to its node as PatchGraph does
+double timeFullRebuild(const PatchGraph& graph, ProcessingOrder& full, std::vector<AudioNode*>& schedule) {
+    const ProcessingOrder& order = graph.order();
+    full.clear();
+    for (unsigned node = 0; node < order.nodeCount(); ++node) {
+        full.addNode();
+    }
+    for (unsigned node = 0; node < order.nodeCount(); ++node) {
+        for (const ProcessingOrder::Edge& edge : order.outputs(node)) {
+            full.addEdgeUnordered(node, edge.node, edge.tag);
+        }
+    }
+
+    Stopwatch watch;
+    full.rebuild();
+    for (unsigned position = 0; position < full.nodeCount(); ++position) {
+        schedule[position] = graph.node(full.order()[position]);
+    }
+    const double ns = watch.elapsedNs();
+    doNotOptimize(schedule[0]);
+    return ns;
+}
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        const bool has_value = i + 1 < argc;
+
+        if (std::strcmp(arg, "--nodes") == 0 && has_value) {
+            options.nodes = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else if (std::strcmp(arg, "--edits") == 0 && has_value) {
+            options.edits = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else if (std::strcmp(arg, "--seed") == 0 && has_value) {
+            options.seed = std::strtoull(argv[++i], nullptr, 10);
+        } else {
+            return false;
+        }
+    }
+
+    return options.nodes > OUTPUT_INPUTS && options.edits > 0;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::fprintf(stderr, "usage: graphbench [--nodes N] [--edits N] [--seed N]\n");
+        return 1;
+    }
+
+    ScopedDenormalDisable denormal_guard;
+
+    AudioContext context(SAMPLE_RATE, FRAMES);
+    const unsigned max_nodes = options.nodes + 1;
+    PatchGraph graph(context, NodeRegistry::builtin(), static_cast<std::size_t>(max_nodes) * 512, max_nodes);
+    Random random(options.seed);
+
+    Stopwatch build_watch;
+    if (!buildPatch(options, random, graph)) {
+        return 1;
+    }
+    const double build_ms = build_watch.elapsedNs() / 1e6;
+    std::printf("%u nodes, %u cables, built one edit at a time in %.2f ms\n", graph.nodeCount(),
+                countCables(graph.order()), build_ms);
+
+    graph.render(FRAMES, context.lastBatch());
+    context.updateBatch(FRAMES);
+
+    ProcessingOrder full(max_nodes);
+    std::vector<AudioNode*> schedule(max_nodes);
+    Stats connect, connect_far, disconnect, rebuild;
+    unsigned refused = 0;
+
+    // refused edits are counted below rather than reported one by one
+    std::cerr.setstate(std::ios::failbit);
+    for (unsigned edit = 0; edit < options.edits; ++edit) {
+        const unsigned to = random.below(graph.nodeCount());
+        const auto& inputs = graph.order().inputs(to);
+
+        if (random.below(2) == 0 || inputs.empty()) {
+            const bool far = random.below(LONG_RANGE) == 0;
+            const unsigned first = to > WINDOW ? to - WINDOW : 0;
+            const unsigned last = std::min(graph.nodeCount(), to + WINDOW);
+            const unsigned from = far ? random.below(graph.nodeCount()) : first + random.below(last - first);
+            const unsigned port = randomPort(graph, to, random);
+            Stopwatch watch;
+            const bool accepted = graph.connect(from, to, port);
+            const double ns = watch.elapsedNs();
+            if (accepted) {
+                (far ? connect_far : connect).ns.push_back(ns);
+            } else {
+                ++refused;
+            }
+        } else {
+            const ProcessingOrder::Edge cable = inputs[random.below(static_cast<unsigned>(inputs.size()))];
+            Stopwatch watch;
+            if (!graph.disconnect(cable.node, to, cable.tag)) {
+                std::cerr.clear();
+                std::fprintf(stderr, "failed to remove an existing cable\n");
+                return 1;
+            }
+            disconnect.ns.push_back(watch.elapsedNs());
+        }
+
+        if (edit % FULL_REBUILD_EVERY == 0) {
+            rebuild.ns.push_back(timeFullRebuild(graph, full, schedule));
+        }
+        if (edit % CHECK_EVERY == 0 && !graph.order().valid()) {
+            std::cerr.clear();
+            std::fprintf(stderr, "processing order broken after edit %u\n", edit);
+            return 1;
+        }
+    }
+    std::cerr.clear();
+
+    if (!graph.order().valid()) {
+        std::fprintf(stderr, "processing order broken after the last edit\n");
+        return 1;
+    }
+    graph.render(FRAMES, context.lastBatch());
+    doNotOptimize(graph.output()->buffer()[FRAMES - 1]);
+
+    std::printf("%u edits, %u cables after, %u connects refused as feedback loops\n\n", options.edits,
+                countCables(graph.order()), refused);
+    std::printf("%-22s %8s %10s %10s %10s\n", "", "count", "mean us", "p99 us", "max us");
+    connect.print("connect nearby");
+    connect_far.print("connect anywhere");
+    disconnect.print("disconnect");
+    rebuild.print("full re-sort");
+
+    const double p99_us = std::max(connect.percentile(99), disconnect.percentile(99)) / 1000.0;
+    std::printf("\nnearby repatch p99 %.2f us, target %.0f us: %s\n", p99_us, TARGET_US, p99_us < TARGET_US ? "ok" : "over");
+
+    return 0;
+}
@@ -0,0 +1,218 @@
+// Engine instance packing benchmark. Ramps the number of independent EngineInstances
+// from 1 to 256, renders them all on one shared WorkerPool through an EngineScheduler,
+// and reports how many instances fit in 50%, 75% and 90% of the block deadline.
+//
+// usage: instancebench [--rate HZ] [--frames N] [--threads N] [--voices N] [--max-instances N] [--ms N] [--csv]
+//
+// Each instance is a DemoVoiceBank with its own AudioContext. Instances get half, one
+// and one and a half times --voices in turn, so the pool has heavy and light ones to
+// balance. Capacity is judged on the 99th percentile block time, as in polybench.
+// The "spread" column is the slowest instance's peak render time over the mean render
+// time, which shows how evenly the per-instance cost holds as instances are packed in.
+
+#include "benchutil.h"
+#include "demopatch.h"
+#include "denormals.h"
+#include "engineinstance.h"
+#include "enginescheduler.h"
+#include "workerpool.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr unsigned INSTANCE_COUNTS[] = { 1, 2, 4, 8, 12, 16, 24, 32, 48, 64, 96, 128, 160, 192, 256 };
+constexpr double THRESHOLDS[] = { 0.50, 0.75, 0.90 };
+
+// Stop ramping once a block takes this many deadlines; the curve is flat by then
+constexpr double GIVE_UP_LOAD = 4.0;
+
+struct Options {
+    unsigned sample_rate = 48000;
+    unsigned frames = 256;
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    unsigned voices = 4;
+    unsigned max_instances = 256;
+    double ms_per_point = 150.0;
+    bool csv = false;
+};
+
+struct Point {
+    unsigned instances;
+    double mean_ns;
+    double p99_ns;
+    double spread;
+    unsigned long long overruns;
+    bool clocks_agree;
+};
+
+Point measure(const Options& options, unsigned count, WorkerPool& pool) {
+    std::vector<std::unique_ptr<EngineInstance>> instances;
+    EngineScheduler scheduler(pool);
+
+    for (unsigned i = 0; i < count; ++i) {
+        auto instance = std::make_unique<EngineInstance>(static_cast<float>(options.sample_rate), options.frames);
+        instance->makeGraph<DemoVoiceBank>(std::max(1u, options.voices * (1 + i % 3) / 2));
+        scheduler.add(instance.get());
+        instances.push_back(std::move(instance));
+    }
+
+    const auto sample_rate = static_cast<float>(options.sample_rate);
+    for (unsigned i = 0; i < 32; ++i) {
+        scheduler.renderBlock(options.frames, sample_rate);
+    }
+    for (auto& instance : instances) {
+        instance->resetStats();
+    }
+    const unsigned long long warmup_overruns = scheduler.overruns();
+
+    std::vector<double> block_ns;
+    double total_ns = 0.0;
+    double render_ns = 0.0;
+    const double min_ns = options.ms_per_point * 1e6;
+    do {
+        scheduler.renderBlock(options.frames, sample_rate);
+        block_ns.push_back(scheduler.lastBlockNs());
+        total_ns += block_ns.back();
+        for (auto& instance : instances) {
+            render_ns += instance->lastRenderNs();
+            doNotOptimize(instance->buffer()[options.frames - 1]);
+        }
+    } while (total_ns < min_ns || block_ns.size() < 20);
+
+    double peak_ns = 0.0;
+    bool clocks_agree = true;
+    for (auto& instance : instances) {
+        peak_ns = std::max(peak_ns, instance->peakRenderNs());
+        clocks_agree = clocks_agree && instance->context().samplePosition() == instances[0]->context().samplePosition();
+    }
+
+    std::sort(block_ns.begin(), block_ns.end());
+    const size_t p99 = std::min(block_ns.size() - 1, block_ns.size() * 99 / 100);
+    const double blocks = static_cast<double>(block_ns.size());
+    const double mean_render_ns = render_ns / (blocks * count);
+
+    return { count, total_ns / blocks, block_ns[p99], peak_ns / mean_render_ns,
+             scheduler.overruns() - warmup_overruns, clocks_agree };
+}
+
+// Largest instance count whose p99 block fits the budget, interpolating between the
+// measured counts on either side of it
+double capacity(const std::vector<Point>& points, double budget_ns) {
+    double best = 0.0;
+    for (size_t i = 0; i < points.size(); ++i) {
+        if (points[i].p99_ns > budget_ns) {
+            if (i > 0) {
+                const Point& a = points[i - 1];
+                const Point& b = points[i];
+                const double t = (budget_ns - a.p99_ns) / (b.p99_ns - a.p99_ns);
+                best = a.instances + t * (b.instances - a.instances);
+            }
+            return best;
+        }
+        best = points[i].instances;
+    }
+    return best;
+}
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        const bool has_value = i + 1 < argc;
+
+        if (std::strcmp(arg, "--rate") == 0 && has_value) {
+            options.sample_rate = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else if (std::strcmp(arg, "--frames") == 0 && has_value) {
+            options.frames = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else if (std::strcmp(arg, "--threads") == 0 && has_value) {
+            options.threads = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else if (std::strcmp(arg, "--voices") == 0 && has_value) {
+            options.voices = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else if (std::strcmp(arg, "--max-instances") == 0 && has_value) {
+            options.max_instances = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else if (std::strcmp(arg, "--ms") == 0 && has_value) {
+            options.ms_per_point = std::atof(argv[++i]);
+        } else if (std::strcmp(arg, "--csv") == 0) {
+            options.csv = true;
+        } else {
+            return false;
+        }
+    }
+
+    return options.sample_rate > 0 && options.frames > 0 && options.threads > 0 && options.voices > 0 &&
+           options.max_instances > 0;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::fprintf(stderr, "usage: instancebench [--rate HZ] [--frames N] [--threads N] [--voices N] "
+                             "[--max-instances N] [--ms N] [--csv]\n");
+        return 1;
+    }
+
+    ScopedDenormalDisable denormal_guard;
+
+    const double deadline_ns = 1e9 * options.frames / options.sample_rate;
+    WorkerPool pool(options.threads);
+
+    if (options.csv) {
+        std::printf("threads,instances,mean_ns,p99_ns,load,p99_load,spread,overruns\n");
+    } else {
+        std::printf("%u frames at %u Hz: %.1f us deadline per block, %u thread%s, %u voices per instance on average\n",
+                    options.frames, options.sample_rate, deadline_ns / 1000.0, pool.threadCount(),
+                    pool.threadCount() == 1 ? "" : "s", options.voices);
+        std::printf("%9s %11s %11s %8s %8s %8s %9s\n", "instances", "mean us", "p99 us", "load", "p99 load", "spread",
+                    "overruns");
+    }
+
+    std::vector<Point> points;
+    bool clocks_agree = true;
+    for (const unsigned count : INSTANCE_COUNTS) {
+        if (count > options.max_instances) {
+            break;
+        }
+
+        const Point p = measure(options, count, pool);
+        points.push_back(p);
+        clocks_agree = clocks_agree && p.clocks_agree;
+
+        if (options.csv) {
+            std::printf("%u,%u,%.1f,%.1f,%.4f,%.4f,%.3f,%llu\n", pool.threadCount(), count, p.mean_ns, p.p99_ns,
+                        p.mean_ns / deadline_ns, p.p99_ns / deadline_ns, p.spread, p.overruns);
+        } else {
+            std::printf("%9u %11.1f %11.1f %7.1f%% %7.1f%% %7.2fx %9llu\n", count, p.mean_ns / 1000.0,
+                        p.p99_ns / 1000.0, 100.0 * p.mean_ns / deadline_ns, 100.0 * p.p99_ns / deadline_ns, p.spread,
+                        p.overruns);
+        }
+        std::fflush(stdout);
+
+        if (p.mean_ns > GIVE_UP_LOAD * deadline_ns) {
+            break;
+        }
+    }
+
+    if (!clocks_agree) {
+        std::fprintf(stderr, "instance clocks disagree after rendering the same number of blocks\n");
+        return 1;
+    }
+
+    if (options.csv) {
+        return 0;
+    }
+
+    std::printf("\nmax instances within the deadline (p99 block time)\n");
+    for (const double threshold : THRESHOLDS) {
+        std::printf("%7.0f%% %10.0f\n", 100.0 * threshold, capacity(points, threshold * deadline_ns));
+    }
+
+    return 0;
+}
@@ -0,0 +1,351 @@
+// Per-node microbenchmarks. Every AudioNode type is rendered in isolation across a
+// sweep of block sizes and reported as ns/sample, cycles/sample and an estimate of
+// the buffer bytes touched per sample.
+//
+// usage: nodebench [--format table|csv|json] [--filter text] [--min-ms N]
+//
+// cycles are time stamp counter ticks (reference cycles, not core cycles) and are
+// reported as 0 on machines without one. Source signals feeding the node under test
+// come from a pre-rendered table so their cost stays out of the measurement.
+
+#include "adsrnode.h"
+#include "arithmeticnode.h"
+#include "audiocontext.h"
+#include "automationnode.h"
+#include "benchutil.h"
+#include "definitions.h"
+#include "denormals.h"
+#include "gainnode.h"
+#include "lp12filternode.h"
+#include "mixernode.h"
+#include "muladdnode.h"
+#include "oscillatornode.h"
+#include "voicenode.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr unsigned BLOCK_SIZES[] = { 16, 32, 64, 128, 256, 512, 1024, 2048, 4096 };
+constexpr unsigned TABLE_SIZE = 1 << 16;
+
+// Replays a pre-rendered signal; stands in for upstream nodes at memcpy cost
+class TableSourceNode final : public AudioNode
+{
+public:
+    TableSourceNode(AudioContext& context, std::vector<float> table) : AudioNode(context), table_(std::move(table)) {}
+
+protected:
+    void processInternal(unsigned frames) override {
+        for (unsigned i = 0; i < frames; ++i) {
+            buffer_[i] = table_[position_];
+            position_ = (position_ + 1) & (TABLE_SIZE - 1);
+        }
+    }
+
+    void addAutomation(AudioNode*, unsigned) override {}
+    AudioNode* removeAutomation(unsigned) override { return nullptr; }
+
+private:
+    std::vector<float> table_;
+    unsigned position_ = 0;
+};
+
+std::vector<float> makeTable(float offset, float depth, float cycles) {
+    std::vector<float> table(TABLE_SIZE);
+    for (unsigned i = 0; i < TABLE_SIZE; ++i) {
+        table[i] = offset + depth * std::sin(TWO_PI * cycles * static_cast<float>(i) / TABLE_SIZE);
+    }
+    return table;
+}
+
+struct BenchGraph {
+    std::vector<std::unique_ptr<AudioNode>> nodes;
+    AudioNode* output = nullptr;
+    // called before every block with the block's processing id
+    std::function<void(unsigned processing_id, unsigned frames)> tick;
+
+    template<typename T, typename... Args>
+    T* add(Args&&... args) {
+        auto node = std::make_unique<T>(std::forward<Args>(args)...);
+        T* result = node.get();
+        nodes.push_back(std::move(node));
+        return result;
+    }
+};
+
+struct BenchCase {
+    std::string name;
+    // estimated floats read + written per output sample by the node under test
+    unsigned floats_per_sample;
+    std::function<void(AudioContext&, BenchGraph&)> build;
+};
+
+const char* waveName(wave_shape shape) {
+    switch (shape) {
+    case wave_shape::sine: return "sine";
+    case wave_shape::triangle: return "triangle";
+    case wave_shape::square: return "square";
+    case wave_shape::sawtooth: return "sawtooth";
+    case wave_shape::inv_sawtooth: return "inv_sawtooth";
+    case wave_shape::pulse: return "pulse";
+    }
+    return "?";
+}
+
+std::vector<BenchCase> makeCases() {
+    std::vector<BenchCase> cases;
+
+    const wave_shape shapes[] = { wave_shape::sine, wave_shape::triangle, wave_shape::square,
+                                  wave_shape::sawtooth, wave_shape::inv_sawtooth, wave_shape::pulse };
+
+    for (const wave_shape shape : shapes) {
+        cases.push_back({ std::string("oscillator/") + waveName(shape) + "/static", 5,
+                          [shape](AudioContext& context, BenchGraph& graph) {
+                              graph.output = graph.add<OscillatorNode>(context, shape, 220.0f);
+                          } });
+
+        cases.push_back({ std::string("oscillator/") + waveName(shape) + "/modulated", 6,
+                          [shape](AudioContext& context, BenchGraph& graph) {
+                              auto* mod = graph.add<TableSourceNode>(context, makeTable(0.0f, 30.0f, 7.0f));
+                              auto* osc = graph.add<OscillatorNode>(context, shape, 220.0f);
+                              mod->automate(osc, OscillatorNode::Parameters::Frequency);
+                              graph.output = osc;
+                          } });
+    }
+
+    cases.push_back({ "lp12/static-cutoff", 8, [](AudioContext& context, BenchGraph& graph) {
+                          auto* source = graph.add<TableSourceNode>(context, makeTable(0.0f, 0.8f, 1500.0f));
+                          auto* filter = graph.add<LP12FilterNode>(context, 1200.0f, 4.0f);
+                          source->connect(filter);
+                          graph.output = filter;
+                      } });
+
+    cases.push_back({ "lp12/audio-rate-cutoff", 9, [](AudioContext& context, BenchGraph& graph) {
+                          auto* source = graph.add<TableSourceNode>(context, makeTable(0.0f, 0.8f, 1500.0f));
+                          auto* cutoff = graph.add<TableSourceNode>(context, makeTable(0.0f, 800.0f, 11.0f));
+                          auto* filter = graph.add<LP12FilterNode>(context, 1200.0f, 4.0f);
+                          source->connect(filter);
+                          cutoff->automate(filter, LP12FilterNode::Parameters::Cutoff);
+                          graph.output = filter;
+                      } });
+
+    cases.push_back({ "adsr/gated", 3, [](AudioContext& context, BenchGraph& graph) {
+                          auto* adsr = graph.add<ADSRNode>(context, 0.01f, 0.05f, 0.6f, 0.05f);
+                          graph.output = adsr;
+                          // retrigger every ~0.2 s so every stage gets exercised
+                          graph.tick = [adsr, rate = context.sampleRate()](unsigned id, unsigned frames) {
+                              const auto period = static_cast<unsigned long long>(0.2 * rate);
+                              adsr->setGate((static_cast<unsigned long long>(id) * frames / period) % 2 == 0);
+                          };
+                      } });
+
+    cases.push_back({ "gain", 4, [](AudioContext& context, BenchGraph& graph) {
+                          auto* source = graph.add<TableSourceNode>(context, makeTable(0.0f, 0.8f, 1500.0f));
+                          auto* gain = graph.add<GainNode>(context, 0.5f);
+                          source->connect(gain);
+                          graph.output = gain;
+                      } });
+
+    // the table sources are part of these cases; at 256 inputs their copies are a
+    // noticeable share of the total
+    for (unsigned inputs = 2; inputs <= 256; inputs *= 2) {
+        cases.push_back({ "mixer/" + std::to_string(inputs) + "-inputs", 1 + 3 * inputs,
+                          [inputs](AudioContext& context, BenchGraph& graph) {
+                              auto* mixer = graph.add<MixerNode>(context);
+                              for (unsigned i = 0; i < inputs; ++i) {
+                                  auto* source = graph.add<TableSourceNode>(context, makeTable(0.0f, 0.5f, 100.0f + i));
+                                  mixer->addInput(source, 1.0f);
+                              }
+                              graph.output = mixer;
+                          } });
+    }
+
+    cases.push_back({ "muladd", 10, [](AudioContext& context, BenchGraph& graph) {
+                          auto* source = graph.add<TableSourceNode>(context, makeTable(0.0f, 1.0f, 3.0f));
+                          auto* mul_add = graph.add<MulAddNode>(context, 900.0f, 1000.0f);
+                          source->connect(mul_add);
+                          graph.output = mul_add;
+                      } });
+
+    const std::pair<const char*, ArithmeticNode::Operation> operations[] = {
+        { "add", ArithmeticNode::Operation::Add }, { "subtract", ArithmeticNode::Operation::Subtract },
+        { "multiply", ArithmeticNode::Operation::Multiply }, { "divide", ArithmeticNode::Operation::Divide } };
+
+    for (const auto& operation : operations) {
+        cases.push_back({ std::string("arithmetic/") + operation.first, 6,
+                          [op = operation.second](AudioContext& context, BenchGraph& graph) {
+                              auto* source = graph.add<TableSourceNode>(context, makeTable(0.0f, 1.0f, 3.0f));
+                              auto* node = graph.add<ArithmeticNode>(context, op, 2.0f);
+                              source->connect(node);
+                              graph.output = node;
+                          } });
+    }
+
+    cases.push_back({ "automation/static", 1, [](AudioContext& context, BenchGraph& graph) {
+                          graph.output = graph.add<AutomationNode>(context, 0.5f);
+                      } });
+
+    for (const unsigned events_per_block : { 1u, 8u, 64u }) {
+        cases.push_back({ "automation/" + std::to_string(events_per_block) + "-events-per-block", 1,
+                          [events_per_block](AudioContext& context, BenchGraph& graph) {
+                              auto* automation = graph.add<AutomationNode>(context, 0.0f);
+                              graph.output = automation;
+                              // keep the event list fed with set/ramp pairs spread across the next block
+                              graph.tick = [automation, events_per_block, &context](unsigned, unsigned frames) {
+                                  const double rate = context.sampleRate();
+                                  const double block_start = static_cast<double>(context.samplePosition()) / rate;
+                                  const double step = frames / rate / events_per_block;
+                                  for (unsigned e = 0; e < events_per_block; ++e) {
+                                      const double time = block_start + step * e;
+                                      if (e % 2 == 0) {
+                                          automation->setValueAtTime(static_cast<float>(e), time);
+                                      } else {
+                                          automation->linearRampValueAtTime(static_cast<float>(e), time);
+                                      }
+                                  }
+                              };
+                          } });
+    }
+
+    // 3 oscillators, 6 gains, 2 envelopes and a mixer with all of their automation buffers
+    cases.push_back({ "voicenode", 56, [](AudioContext& context, BenchGraph& graph) {
+                          auto* voice = graph.add<VoiceNode>(context);
+                          voice->setParameters(VoiceNode::Builder(context)
+                                                   .setModFrequency(5)
+                                                   .setOscillator1Frequency(130.81f)
+                                                   .setOscillator2Frequency(196.0f)
+                                                   .setOscillator1Waveform(wave_shape::sawtooth)
+                                                   .setOscillator2Waveform(wave_shape::pulse)
+                                                   .setOscillator1Gain(1)
+                                                   .setOscillator2Gain(.2f)
+                                                   .setOscillator1ModGain(.2f)
+                                                   .setOscillator2ModGain(.2f)
+                                                   .setVolumeEnvelopeA(.05f)
+                                                   .setVolumeEnvelopeD(.1f)
+                                                   .setVolumeEnvelopeS(.8f)
+                                                   .setVolumeEnvelopeR(.3f)
+                                                   .parameters());
+                          voice->noteOn();
+                          graph.output = voice;
+                      } });
+
+    return cases;
+}
+
+struct Result {
+    std::string name;
+    unsigned frames;
+    double ns_per_sample;
+    double cycles_per_sample;
+    double bytes_per_sample;
+    unsigned long long blocks;
+};
+
+Result runCase(const BenchCase& bench_case, unsigned frames, double min_ns) {
+    AudioContext context(SAMPLE_RATE, frames);
+    BenchGraph graph;
+    bench_case.build(context, graph);
+
+    unsigned processing_id = 0;
+    const auto renderBlock = [&]() {
+        if (graph.tick) {
+            graph.tick(processing_id, frames);
+        }
+        graph.output->process(frames, processing_id++);
+        context.updateBatch(frames);
+        doNotOptimize(graph.output->buffer()[frames - 1]);
+    };
+
+    // warm caches, allocate buffers and get past attack transients
+    for (unsigned i = 0; i < 64; ++i) {
+        renderBlock();
+    }
+
+    unsigned long long blocks = 0;
+    Stopwatch watch;
+    do {
+        for (unsigned i = 0; i < 16; ++i) {
+            renderBlock();
+        }
+        blocks += 16;
+    } while (watch.elapsedNs() < min_ns);
+
+    const double ns = watch.elapsedNs();
+    const double cycles = static_cast<double>(watch.elapsedCycles());
+    const double samples = static_cast<double>(blocks) * frames;
+
+    return { bench_case.name, frames, ns / samples, cycles / samples,
+             static_cast<double>(bench_case.floats_per_sample) * sizeof(float), blocks };
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    std::string format = "table";
+    std::string filter;
+    double min_ms = 20.0;
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+            format = argv[++i];
+        } else if (std::strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            filter = argv[++i];
+        } else if (std::strcmp(argv[i], "--min-ms") == 0 && i + 1 < argc) {
+            min_ms = std::atof(argv[++i]);
+        } else {
+            std::fprintf(stderr, "usage: nodebench [--format table|csv|json] [--filter text] [--min-ms N]\n");
+            return 1;
+        }
+    }
+
+    ScopedDenormalDisable denormal_guard;
+
+    if (format == "csv") {
+        std::printf("case,frames,ns_per_sample,cycles_per_sample,bytes_per_sample,blocks\n");
+    } else if (format == "json") {
+        std::printf("{\n  \"sample_rate\": %d,\n  \"cycle_counter\": %s,\n  \"results\": [", SAMPLE_RATE,
+                    Stopwatch::hasCycleCounter() ? "\"tsc\"" : "null");
+    } else {
+        std::printf("%-40s %6s %12s %12s %10s\n", "case", "frames", "ns/sample", "cycles/smp", "bytes/smp");
+    }
+
+    bool first = true;
+    for (const BenchCase& bench_case : makeCases()) {
+        if (!filter.empty() && bench_case.name.find(filter) == std::string::npos) {
+            continue;
+        }
+
+        for (const unsigned frames : BLOCK_SIZES) {
+            const Result r = runCase(bench_case, frames, min_ms * 1e6);
+
+            if (format == "csv") {
+                std::printf("%s,%u,%.4f,%.4f,%.0f,%llu\n", r.name.c_str(), r.frames, r.ns_per_sample,
+                            r.cycles_per_sample, r.bytes_per_sample, r.blocks);
+            } else if (format == "json") {
+                std::printf("%s\n    {\"case\": \"%s\", \"frames\": %u, \"ns_per_sample\": %.4f, "
+                            "\"cycles_per_sample\": %.4f, \"bytes_per_sample\": %.0f, \"blocks\": %llu}",
+                            first ? "" : ",", r.name.c_str(), r.frames, r.ns_per_sample, r.cycles_per_sample,
+                            r.bytes_per_sample, r.blocks);
+            } else {
+                std::printf("%-40s %6u %12.3f %12.3f %10.0f\n", r.name.c_str(), r.frames, r.ns_per_sample,
+                            r.cycles_per_sample, r.bytes_per_sample);
+            }
+            std::fflush(stdout);
+            first = false;
+        }
+    }
+
+    if (format == "json") {
+        std::printf("\n  ]\n}\n");
+    }
+
+    return 0;
+}
@@ -0,0 +1,303 @@
+// Oscillator quality versus cost. Renders every waveform with every OscillatorNode
+// algorithm across a frequency sweep, FFTs the output and reports:
+//   alias   energy outside the harmonic series relative to the harmonics, in dB
+//   thd     energy in harmonics 2.. relative to the fundamental, in dB. For the sine this
+//           is purity; for the other shapes it shows how much of the ideal series survives
+//           band-limiting (the naive shapes sit near their textbook value)
+//   ns/smp  render cost at that frequency
+// and finishes with the cheapest algorithm per waveform that keeps aliasing under a bar.
+//
+// usage: oscbench [--bar dB] [--max-freq HZ] [--rate HZ] [--filter text] [--min-ms N] [--csv]
+//
+// The analysis uses a 4-term Blackman-Harris window over 65536 samples. Results are
+// clamped at FLOOR_DB (-150 dB) so a band with no energy doesn't print as -inf. The
+// window's -92 dB sidelobes leak into it well above that, so read anything under about
+// -100 dB as clean rather than as a precise figure.
+
+#include "audiocontext.h"
+#include "benchutil.h"
+#include "definitions.h"
+#include "denormals.h"
+#include "fft.h"
+#include "oscillatornode.h"
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr unsigned ANALYSIS_SIZE = 1 << 16;
+constexpr unsigned BLOCK = 256;
+// half width of a harmonic's main lobe under the window, in bins
+constexpr unsigned LOBE_BINS = 5;
+// lowest value printed, see the note at the top
+constexpr double FLOOR_DB = -150.0;
+
+struct Options {
+    double bar_db = -60.0;
+    double max_frequency = 5000.0;
+    unsigned sample_rate = SAMPLE_RATE;
+    std::string filter;
+    bool csv = false;
+    double min_ms = 5.0;
+};
+
+struct Algorithm {
+    const char* name;
+    OscillatorNode::Algorithm algorithm;
+};
+
+const Algorithm ALGORITHMS[] = {
+    { "naive", OscillatorNode::Algorithm::Naive },
+    { "polyblep", OscillatorNode::Algorithm::PolyBlep },
+    { "wavetable", OscillatorNode::Algorithm::Wavetable },
+    { "oversampled", OscillatorNode::Algorithm::Oversampled },
+};
+
+struct Shape {
+    const char* name;
+    wave_shape shape;
+};
+
+const Shape SHAPES[] = {
+    { "sine", wave_shape::sine },
+    { "triangle", wave_shape::triangle },
+    { "square", wave_shape::square },
+    { "sawtooth", wave_shape::sawtooth },
+    { "inv_sawtooth", wave_shape::inv_sawtooth },
+    { "pulse", wave_shape::pulse },
+};
+
+struct Measurement {
+    double frequency;
+    double alias_db;
+    double thd_db;
+    double ns_per_sample;
+};
+
+double toDb(double ratio) {
+    return ratio > 0.0 ? std::max(FLOOR_DB, 10.0 * std::log10(ratio)) : FLOOR_DB;
+}
+
+// Octaves down from rate / 3.37. Keeping rate / frequency well away from an integer at
+// every octave stops aliases from folding straight back onto the harmonics they came from.
+std::vector<double> sweepFrequencies(unsigned sample_rate) {
+    std::vector<double> frequencies;
+    for (double f = sample_rate / 3.37; f > 40.0; f /= 2.0) {
+        frequencies.insert(frequencies.begin(), f);
+    }
+    return frequencies;
+}
+
+std::vector<float> render(const Options& options, wave_shape shape, OscillatorNode::Algorithm algorithm,
+                          double frequency, unsigned samples) {
+    AudioContext context(static_cast<float>(options.sample_rate), BLOCK);
+    OscillatorNode oscillator(context, shape, static_cast<float>(frequency), 0.0f, 0.3f);
+    oscillator.setAlgorithm(algorithm);
+
+    // settle the decimation filter before capturing
+    unsigned processing_id = 0;
+    for (unsigned i = 0; i < 4; ++i) {
+        oscillator.process(BLOCK, processing_id++);
+    }
+
+    std::vector<float> output(samples);
+    for (unsigned position = 0; position < samples; position += BLOCK) {
+        oscillator.process(BLOCK, processing_id++);
+        std::copy_n(oscillator.buffer(), std::min(BLOCK, samples - position), output.begin() + position);
+    }
+    return output;
+}
+
+double costNs(const Options& options, wave_shape shape, OscillatorNode::Algorithm algorithm, double frequency) {
+    AudioContext context(static_cast<float>(options.sample_rate), BLOCK);
+    OscillatorNode oscillator(context, shape, static_cast<float>(frequency), 0.0f, 0.3f);
+    oscillator.setAlgorithm(algorithm);
+
+    unsigned processing_id = 0;
+    for (unsigned i = 0; i < 16; ++i) {
+        oscillator.process(BLOCK, processing_id++);
+    }
+
+    unsigned long long blocks = 0;
+    Stopwatch watch;
+    do {
+        for (unsigned i = 0; i < 16; ++i) {
+            oscillator.process(BLOCK, processing_id++);
+            doNotOptimize(oscillator.buffer()[BLOCK - 1]);
+        }
+        blocks += 16;
+    } while (watch.elapsedNs() < options.min_ms * 1e6);
+
+    return watch.elapsedNs() / (static_cast<double>(blocks) * BLOCK);
+}
+
+// Splits the power spectrum into the harmonic series of frequency and everything else
+void analyse(const std::vector<float>& signal, double frequency, unsigned sample_rate, double& alias_db, double& thd_db) {
+    const unsigned n = static_cast<unsigned>(signal.size());
+    std::vector<std::complex<double>> spectrum(n);
+
+    for (unsigned i = 0; i < n; ++i) {
+        const double w = 2.0 * M_PI * i / n;
+        const double window = 0.35875 - 0.48829 * std::cos(w) + 0.14128 * std::cos(2.0 * w) - 0.01168 * std::cos(3.0 * w);
+        spectrum[i] = signal[i] * window;
+    }
+    fft(spectrum);
+
+    const unsigned bins = n / 2;
+    std::vector<double> power(bins);
+    for (unsigned i = 0; i < bins; ++i) {
+        power[i] = std::norm(spectrum[i]);
+    }
+
+    std::vector<bool> claimed(bins, false);
+    const auto claim = [&](double bin_centre) {
+        double energy = 0.0;
+        const long centre = std::lround(bin_centre);
+        for (long b = centre - LOBE_BINS; b <= centre + static_cast<long>(LOBE_BINS); ++b) {
+            if (b >= 0 && b < static_cast<long>(bins) && !claimed[b]) {
+                energy += power[b];
+                claimed[b] = true;
+            }
+        }
+        return energy;
+    };
+
+    const double bin_hz = static_cast<double>(sample_rate) / n;
+    claim(0.0); // DC is neither signal nor alias
+
+    const double fundamental = claim(frequency / bin_hz);
+    double overtones = 0.0;
+    for (unsigned k = 2; k * frequency < sample_rate / 2.0 - LOBE_BINS * bin_hz; ++k) {
+        overtones += claim(k * frequency / bin_hz);
+    }
+
+    double alias = 0.0;
+    for (unsigned i = 0; i < bins; ++i) {
+        if (!claimed[i]) {
+            alias += power[i];
+        }
+    }
+
+    alias_db = toDb(alias / (fundamental + overtones));
+    thd_db = toDb(overtones / fundamental);
+}
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        const bool has_value = i + 1 < argc;
+
+        if (std::strcmp(arg, "--bar") == 0 && has_value) {
+            options.bar_db = std::atof(argv[++i]);
+        } else if (std::strcmp(arg, "--max-freq") == 0 && has_value) {
+            options.max_frequency = std::atof(argv[++i]);
+        } else if (std::strcmp(arg, "--rate") == 0 && has_value) {
+            options.sample_rate = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else if (std::strcmp(arg, "--filter") == 0 && has_value) {
+            options.filter = argv[++i];
+        } else if (std::strcmp(arg, "--min-ms") == 0 && has_value) {
+            options.min_ms = std::atof(argv[++i]);
+        } else if (std::strcmp(arg, "--csv") == 0) {
+            options.csv = true;
+        } else {
+            return false;
+        }
+    }
+    return options.sample_rate > 0;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::fprintf(stderr, "usage: oscbench [--bar dB] [--max-freq HZ] [--rate HZ] [--filter text] [--min-ms N] [--csv]\n");
+        return 1;
+    }
+
+    ScopedDenormalDisable denormal_guard;
+
+    const std::vector<double> frequencies = sweepFrequencies(options.sample_rate);
+
+    if (options.csv) {
+        std::printf("shape,algorithm,frequency,alias_db,thd_db,ns_per_sample\n");
+    } else {
+        std::printf("%-13s %-12s %9s %9s %9s %9s\n", "shape", "algorithm", "freq Hz", "alias dB", "thd dB", "ns/smp");
+    }
+
+    struct Choice {
+        const char* algorithm = nullptr;
+        double ns_per_sample = 0.0;
+    };
+    std::vector<std::pair<const char*, Choice>> choices;
+
+    for (const Shape& shape : SHAPES) {
+        Choice choice;
+        bool measured = false;
+
+        for (const Algorithm& algorithm : ALGORITHMS) {
+            const std::string name = std::string(shape.name) + "/" + algorithm.name;
+            if (!options.filter.empty() && name.find(options.filter) == std::string::npos) {
+                continue;
+            }
+            measured = true;
+
+            bool meets_bar = true;
+            double cost_sum = 0.0;
+            unsigned cost_count = 0;
+
+            for (const double frequency : frequencies) {
+                Measurement m { frequency, 0.0, 0.0, 0.0 };
+                analyse(render(options, shape.shape, algorithm.algorithm, frequency, ANALYSIS_SIZE), frequency,
+                        options.sample_rate, m.alias_db, m.thd_db);
+                m.ns_per_sample = costNs(options, shape.shape, algorithm.algorithm, frequency);
+
+                if (frequency <= options.max_frequency) {
+                    meets_bar = meets_bar && m.alias_db <= options.bar_db;
+                    cost_sum += m.ns_per_sample;
+                    ++cost_count;
+                }
+
+                if (options.csv) {
+                    std::printf("%s,%s,%.1f,%.2f,%.2f,%.3f\n", shape.name, algorithm.name, m.frequency, m.alias_db,
+                                m.thd_db, m.ns_per_sample);
+                } else {
+                    std::printf("%-13s %-12s %9.1f %9.1f %9.1f %9.2f\n", shape.name, algorithm.name, m.frequency,
+                                m.alias_db, m.thd_db, m.ns_per_sample);
+                }
+                std::fflush(stdout);
+            }
+
+            const double average_cost = cost_count > 0 ? cost_sum / cost_count : 0.0;
+            if (meets_bar && cost_count > 0 && (!choice.algorithm || average_cost < choice.ns_per_sample)) {
+                choice = { algorithm.name, average_cost };
+            }
+        }
+
+        if (measured) {
+            choices.emplace_back(shape.name, choice);
+        }
+    }
+
+    if (options.csv) {
+        return 0;
+    }
+
+    std::printf("\ncheapest algorithm with alias <= %.0f dB up to %.0f Hz\n", options.bar_db, options.max_frequency);
+    for (const auto& entry : choices) {
+        if (entry.second.algorithm) {
+            std::printf("%-13s %-12s %9.2f ns/smp\n", entry.first, entry.second.algorithm, entry.second.ns_per_sample);
+        } else {
+            std::printf("%-13s %-12s\n", entry.first, "none");
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,187 @@
+// Parameter store benchmark. Times handing knob changes to a bank of VoiceNodes at the
+// start of a block through a ParameterStore, against the naive way of setting every
+// parameter on every voice each block, for a few counts of changed parameters.
+//
+// usage: parambench [--voices N] [--blocks N] [--seed N]
+//
+// It then runs a second thread that moves knobs as fast as it can while the loop below
+// renders and applies changes, and fails if, once the knobs stop, the last value of any
+// parameter didn't reach the voices.
+
+#include "audiocontext.h"
+#include "benchutil.h"
+#include "definitions.h"
+#include "denormals.h"
+#include "mixernode.h"
+#include "parameterstore.h"
+#include "voicenode.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// the gate is per note, not a knob
+constexpr unsigned KNOB_COUNT = static_cast<unsigned>(VoiceNode::ParameterId::Gate);
+constexpr unsigned CHANGED_COUNTS[] = { 0, 1, 4, KNOB_COUNT };
+
+struct Options {
+    unsigned voices = 32;
+    unsigned blocks = 20000;
+    std::uint64_t seed = 1;
+};
+
+class Random
+{
+public:
+    explicit Random(std::uint64_t seed) : state_(seed * 0x9e3779b97f4a7c15ull + 1) {}
+
+    unsigned below(unsigned count) {
+        state_ ^= state_ << 13;
+        state_ ^= state_ >> 7;
+        state_ ^= state_ << 17;
+        return static_cast<unsigned>((state_ >> 32) % count);
+    }
+
+private:
+    std::uint64_t state_;
+};
+
+// a value in the parameter's range, so the voices keep working while they are timed
+float knobValue(unsigned id, unsigned step) {
+    const auto parameter = static_cast<VoiceNode::ParameterId>(id);
+    if (parameter <= VoiceNode::ParameterId::Oscillator2Waveform) {
+        return static_cast<float>(step % 4);
+    }
+    return 0.01f * static_cast<float>(step % 100 + 1);
+}
+
+// Applies whatever changed since the last block to every voice; returns the change count
+unsigned applyChanges(ParameterStore& store, std::vector<ParameterStore::Change>& changes,
+                      std::vector<std::unique_ptr<VoiceNode>>& voices) {
+    const unsigned count = store.takeChanges(changes.data());
+    for (auto& voice : voices) {
+        for (unsigned i = 0; i < count; ++i) {
+            voice->setParameter(static_cast<VoiceNode::ParameterId>(changes[i].id), changes[i].value);
+        }
+    }
+    return count;
+}
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        const bool has_value = i + 1 < argc;
+
+        if (std::strcmp(arg, "--voices") == 0 && has_value) {
+            options.voices = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else if (std::strcmp(arg, "--blocks") == 0 && has_value) {
+            options.blocks = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else if (std::strcmp(arg, "--seed") == 0 && has_value) {
+            options.seed = std::strtoull(argv[++i], nullptr, 10);
+        } else {
+            return false;
+        }
+    }
+
+    return options.voices > 0 && options.blocks > 0;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::fprintf(stderr, "usage: parambench [--voices N] [--blocks N] [--seed N]\n");
+        return 1;
+    }
+
+    ScopedDenormalDisable denormal_guard;
+    AudioContext context(SAMPLE_RATE, FRAMES);
+    MixerNode mixer(context);
+    std::vector<std::unique_ptr<VoiceNode>> voices;
+    for (unsigned v = 0; v < options.voices; ++v) {
+        voices.push_back(std::make_unique<VoiceNode>(context));
+        voices.back()->noteOn();
+        mixer.addInput(voices.back().get(), 1.0f);
+    }
+
+    ParameterStore store(VoiceNode::PARAMETER_COUNT);
+    std::vector<ParameterStore::Change> changes(store.size());
+    Random random(options.seed);
+
+    std::printf("%u voices, %u blocks per row\n\n", options.voices, options.blocks);
+    std::printf("%-28s %14s\n", "", "ns per block");
+
+    // the naive way: every knob's value into every voice, changed or not
+    VoiceNode::VoiceParameters snapshot;
+    Stopwatch watch;
+    for (unsigned block = 0; block < options.blocks; ++block) {
+        snapshot.mod_frequency = knobValue(3, block);
+        for (auto& voice : voices) {
+            voice->setParameters(snapshot);
+        }
+    }
+    std::printf("%-28s %14.1f\n", "all parameters, all voices", watch.elapsedNs() / options.blocks);
+
+    for (const unsigned changed : CHANGED_COUNTS) {
+        double apply_ns = 0.0;
+        for (unsigned block = 0; block < options.blocks; ++block) {
+            // the GUI's share, not timed
+            for (unsigned k = 0; k < changed; ++k) {
+                const unsigned id = changed == KNOB_COUNT ? k : random.below(KNOB_COUNT);
+                store.set(id, knobValue(id, block));
+            }
+            watch.reset();
+            applyChanges(store, changes, voices);
+            apply_ns += watch.elapsedNs();
+        }
+        char label[64];
+        std::snprintf(label, sizeof(label), "store, %u knobs moved", changed);
+        std::printf("%-28s %14.1f\n", label, apply_ns / options.blocks);
+    }
+
+    // knobs turned from another thread while blocks render
+    std::atomic<bool> stop { false };
+    std::thread gui([&]() {
+        Random knobs(options.seed + 1);
+        for (unsigned step = 0; !stop.load(std::memory_order_relaxed); ++step) {
+            const unsigned id = knobs.below(KNOB_COUNT);
+            store.set(id, knobValue(id, step));
+        }
+    });
+
+    // the audio side's view of each parameter, to check against the store at the end
+    std::vector<float> applied(store.size(), 0.0f);
+    unsigned long long applied_count = 0;
+    const unsigned render_blocks = std::max(1u, options.blocks / 100);
+    for (unsigned block = 0; block <= render_blocks; ++block) {
+        if (block == render_blocks) {
+            stop.store(true);
+            gui.join();
+        }
+        const unsigned count = applyChanges(store, changes, voices);
+        for (unsigned i = 0; i < count; ++i) {
+            applied[changes[i].id] = changes[i].value;
+        }
+        applied_count += count;
+        mixer.process(FRAMES, context.lastBatch());
+        doNotOptimize(mixer.buffer()[FRAMES - 1]);
+        context.updateBatch(FRAMES);
+    }
+
+    unsigned stale = 0;
+    for (unsigned id = 0; id < store.size(); ++id) {
+        stale += applied[id] != store.value(id) ? 1 : 0;
+    }
+    std::printf("\nwith knobs moving: %u blocks, %llu changes applied, %u parameters stale\n", render_blocks + 1,
+                applied_count, stale);
+    return stale == 0 ? 0 : 1;
+}
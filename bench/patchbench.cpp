@@ -0,0 +1,408 @@
+// Preset switching benchmark. Writes a bank of binary patches to disk, then switches a
+// PatchGraph through all of them and reports what each switch costs: mapping and
+// checking the file, and instantiating it into the graph. Switches between patches of
+// the same topology only update parameters; the rest rebuild the nodes in the arena.
+// It also times the JSON form for comparison.
+//
+// Last it hot-swaps a PatchPlayer through the bank while the stream runs and compares the
+// swap with the plain instantiate-between-blocks switch above: the worst render time of a
+// block inside a crossfade against the block deadline, and the largest sample-to-sample
+// step around each swap, which is where a naive switch clicks.
+//
+// usage: patchbench [--presets N] [--dir DIR] [--seed N] [--keep]
+//
+// Before timing anything it renders patches/demo.json and the hand-wired DemoPatch side
+// by side and fails unless they are bit-identical, so the registry and the file format
+// are known to rebuild the same graph the C++ code does.
+
+#include "audiocontext.h"
+#include "benchutil.h"
+#include "definitions.h"
+#include "demopatch.h"
+#include "denormals.h"
+#include "patch.h"
+#include "patchgraph.h"
+#include "patchplayer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#ifndef SYNTH_PATCH_DIR
+#define SYNTH_PATCH_DIR "patches"
+#endif
+
+namespace {
+
+// preset topology t plays 1 << t voices through a modulated filter
+constexpr unsigned TOPOLOGIES = 4;
+constexpr unsigned JSON_PRESETS = 1000;
+constexpr unsigned VERIFY_BLOCKS = 400;
+constexpr unsigned HOT_SWAPS = 200;
+// blocks played between swaps, so each one starts from a settled sound
+constexpr unsigned BLOCKS_BETWEEN_SWAPS = 8;
+
+struct Options {
+    unsigned presets = 10000;
+    std::string directory = (std::filesystem::temp_directory_path() / "synth-patchbench").string();
+    std::uint64_t seed = 1;
+    bool keep = false;
+};
+
+class Random
+{
+public:
+    explicit Random(std::uint64_t seed) : state_(seed * 0x9e3779b97f4a7c15ull + 1) {}
+
+    float uniform(float low, float high) {
+        state_ ^= state_ << 13;
+        state_ ^= state_ >> 7;
+        state_ ^= state_ << 17;
+        return low + (high - low) * static_cast<float>(state_ >> 40) / 16777216.0f;
+    }
+
+    unsigned below(unsigned count) { return std::min(count - 1, static_cast<unsigned>(uniform(0.0f, static_cast<float>(count)))); }
+
+private:
+    std::uint64_t state_;
+};
+
+bool buildPreset(unsigned topology, Random& random, Patch& patch) {
+    PatchBuilder builder;
+    const int mixer = builder.addNode("mixer");
+    const int filter = builder.addNode("lp12");
+    const int lfo = builder.addNode("oscillator");
+    const int depth = builder.addNode("muladd");
+    const int envelope = builder.addNode("adsr");
+    const int master = builder.addNode("gain");
+
+    bool ok = builder.connect(mixer, filter) && builder.connect(filter, master) && builder.connect(lfo, depth) &&
+              builder.automate(depth, filter, "cutoff") && builder.automate(envelope, master, "gain") &&
+              builder.setOutput(master);
+
+    ok = ok && builder.setParameter(filter, "cutoff", random.uniform(200.0f, 4000.0f)) &&
+         builder.setParameter(filter, "resonance", random.uniform(0.7f, 4.0f)) &&
+         builder.setParameter(lfo, "waveform", static_cast<float>(random.below(4))) &&
+         builder.setParameter(lfo, "frequency", random.uniform(0.1f, 8.0f)) &&
+         builder.setParameter(depth, "multiply", random.uniform(50.0f, 1500.0f)) &&
+         builder.setParameter(envelope, "attack", random.uniform(0.001f, 0.5f)) &&
+         builder.setParameter(envelope, "release", random.uniform(0.05f, 2.0f)) &&
+         builder.setParameter(envelope, "gate", 1.0f) && builder.setParameter(master, "gain", random.uniform(0.2f, 0.8f));
+
+    for (unsigned v = 0; ok && v < (1u << topology); ++v) {
+        const int voice = builder.addNode("voice");
+        const float frequency = random.uniform(55.0f, 880.0f);
+        ok = voice >= 0 && builder.connect(voice, mixer) &&
+             builder.setParameter(voice, "oscillator_1_waveform", static_cast<float>(random.below(6))) &&
+             builder.setParameter(voice, "oscillator_2_waveform", static_cast<float>(random.below(6))) &&
+             builder.setParameter(voice, "oscillator_1_frequency", frequency) &&
+             builder.setParameter(voice, "oscillator_2_frequency", frequency * random.uniform(0.5f, 2.0f)) &&
+             builder.setParameter(voice, "oscillator_1_gain", random.uniform(0.2f, 1.0f)) &&
+             builder.setParameter(voice, "oscillator_2_gain", random.uniform(0.0f, 0.6f)) &&
+             builder.setParameter(voice, "mod_frequency", random.uniform(0.5f, 7.0f)) &&
+             builder.setParameter(voice, "oscillator_1_mod_gain", random.uniform(0.0f, 4.0f)) &&
+             builder.setParameter(voice, "sustain", random.uniform(0.3f, 1.0f)) &&
+             builder.setParameter(voice, "gate", 1.0f);
+    }
+
+    return ok && builder.build(patch, "preset");
+}
+
+std::string presetPath(const Options& options, unsigned index) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "preset-%05u.synp", index);
+    return (std::filesystem::path(options.directory) / name).string();
+}
+
+bool verifyDemo() {
+    AudioContext patch_context(SAMPLE_RATE, FRAMES);
+    AudioContext code_context(SAMPLE_RATE, FRAMES);
+
+    Patch patch;
+    PatchGraph graph(patch_context);
+    if (!patch.loadJson(SYNTH_PATCH_DIR "/demo.json") || !graph.instantiate(patch)) {
+        return false;
+    }
+    DemoPatch demo(code_context);
+
+    for (unsigned block = 0; block < VERIFY_BLOCKS; ++block) {
+        graph.render(FRAMES, block);
+        demo.output()->process(FRAMES, block);
+        patch_context.updateBatch(FRAMES);
+        code_context.updateBatch(FRAMES);
+        if (std::memcmp(graph.output()->buffer(), demo.output()->buffer(), FRAMES * sizeof(float)) != 0) {
+            std::fprintf(stderr, "demo.json and DemoPatch differ in block %u\n", block);
+            return false;
+        }
+    }
+    std::printf("demo.json renders bit-identical to DemoPatch over %u blocks\n", VERIFY_BLOCKS);
+    return true;
+}
+
+struct Stats {
+    std::vector<double> ns;
+
+    void print(const char* label) {
+        if (ns.empty()) {
+            std::printf("%-22s %8s\n", label, "-");
+            return;
+        }
+        std::sort(ns.begin(), ns.end());
+        double total = 0.0;
+        for (const double value : ns) {
+            total += value;
+        }
+        const size_t p99 = std::min(ns.size() - 1, ns.size() * 99 / 100);
+        std::printf("%-22s %8zu %10.2f %10.2f %10.2f\n", label, ns.size(), total / ns.size() / 1000.0,
+                    ns[p99] / 1000.0, ns.back() / 1000.0);
+    }
+};
+
+// Loads and instantiates the presets in the given order, rendering one block after each
+bool switchThrough(const Options& options, const std::vector<unsigned>& order, Stats& load, Stats& update,
+                   Stats& rebuild, Stats& total) {
+    AudioContext context(SAMPLE_RATE, FRAMES);
+    PatchGraph graph(context);
+
+    for (const unsigned index : order) {
+        Patch next;
+        Stopwatch watch;
+        if (!next.load(presetPath(options, index))) {
+            return false;
+        }
+        const double load_ns = watch.elapsedNs();
+
+        watch.reset();
+        if (!graph.instantiate(next)) {
+            return false;
+        }
+        const double instantiate_ns = watch.elapsedNs();
+
+        load.ns.push_back(load_ns);
+        (graph.rebuilt() ? rebuild : update).ns.push_back(instantiate_ns);
+        total.ns.push_back(load_ns + instantiate_ns);
+
+        graph.render(FRAMES, context.lastBatch());
+        context.updateBatch(FRAMES);
+        doNotOptimize(graph.output()->buffer()[FRAMES - 1]);
+    }
+    return true;
+}
+
+// largest |x[n] - x[n-1]| over a block, counting the step in from the previous block
+float largestStep(const float* buffer, unsigned frames, float& previous) {
+    float largest = 0.0f;
+    for (unsigned i = 0; i < frames; ++i) {
+        largest = std::max(largest, std::fabs(buffer[i] - previous));
+        previous = buffer[i];
+    }
+    return largest;
+}
+
+struct SwapResult {
+    Stats load;
+    Stats block;
+    Stats fade_block;
+    Stats step;
+};
+
+// Swaps a PatchPlayer through the presets in order, loading each one between blocks as a
+// control thread would and then playing until the crossfade is over
+bool hotSwap(const Options& options, unsigned swaps, SwapResult& result) {
+    AudioContext context(SAMPLE_RATE, FRAMES);
+    PatchPlayer player(context, FRAMES);
+
+    float previous = 0.0f;
+    for (unsigned s = 0; s <= swaps; ++s) {
+        Patch next;
+        if (!next.load(presetPath(options, s % options.presets))) {
+            return false;
+        }
+        Stopwatch watch;
+        if (!player.load(next)) {
+            return false;
+        }
+        if (s > 0) {
+            result.load.ns.push_back(watch.elapsedNs());
+        }
+
+        float step = 0.0f;
+        for (unsigned block = 0; block < BLOCKS_BETWEEN_SWAPS || player.swapping(); ++block) {
+            const bool fading = player.swapping();
+            watch.reset();
+            player.process(FRAMES);
+            const double block_ns = watch.elapsedNs();
+            context.updateBatch(FRAMES);
+
+            (fading ? result.fade_block : result.block).ns.push_back(block_ns);
+            const float block_step = largestStep(player.buffer(), FRAMES, previous);
+            step = fading ? std::max(step, block_step) : step;
+        }
+        if (s > 0) {
+            result.step.ns.push_back(step * 1000.0);
+        }
+    }
+    return player.swapsCompleted() == swaps;
+}
+
+// The same sequence switched the plain way: instantiate between two blocks
+bool naiveSwap(const Options& options, unsigned swaps, SwapResult& result) {
+    AudioContext context(SAMPLE_RATE, FRAMES);
+    PatchGraph graph(context);
+
+    float previous = 0.0f;
+    for (unsigned s = 0; s <= swaps; ++s) {
+        Patch next;
+        if (!next.load(presetPath(options, s % options.presets)) || !graph.instantiate(next)) {
+            return false;
+        }
+
+        for (unsigned block = 0; block < BLOCKS_BETWEEN_SWAPS; ++block) {
+            graph.render(FRAMES, context.lastBatch());
+            context.updateBatch(FRAMES);
+            const float block_step = largestStep(graph.output()->buffer(), FRAMES, previous);
+            if (s > 0 && block == 0) {
+                result.step.ns.push_back(block_step * 1000.0);
+            }
+        }
+    }
+    return true;
+}
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        const bool has_value = i + 1 < argc;
+
+        if (std::strcmp(arg, "--presets") == 0 && has_value) {
+            options.presets = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else if (std::strcmp(arg, "--dir") == 0 && has_value) {
+            options.directory = argv[++i];
+        } else if (std::strcmp(arg, "--seed") == 0 && has_value) {
+            options.seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(arg, "--keep") == 0) {
+            options.keep = true;
+        } else {
+            return false;
+        }
+    }
+
+    return options.presets >= TOPOLOGIES;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::fprintf(stderr, "usage: patchbench [--presets N] [--dir DIR] [--seed N] [--keep]\n");
+        return 1;
+    }
+
+    ScopedDenormalDisable denormal_guard;
+
+    if (!verifyDemo()) {
+        return 1;
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(options.directory, error);
+    if (error) {
+        std::fprintf(stderr, "failed to create %s: %s\n", options.directory.c_str(), error.message().c_str());
+        return 1;
+    }
+
+    // topology cycles with the index, so neighbouring presets never share one
+    Random random(options.seed);
+    std::vector<std::string> json;
+    unsigned long long bytes = 0;
+    for (unsigned i = 0; i < options.presets; ++i) {
+        Patch patch;
+        if (!buildPreset(i % TOPOLOGIES, random, patch) || !patch.save(presetPath(options, i))) {
+            return 1;
+        }
+        bytes += patch.size();
+        if (json.size() < JSON_PRESETS) {
+            json.push_back(patch.toJson());
+        }
+    }
+    std::printf("%u presets, %.1f KiB on average, in %s\n\n", options.presets,
+                bytes / 1024.0 / options.presets, options.directory.c_str());
+
+    std::printf("%-22s %8s %10s %10s %10s\n", "", "count", "mean us", "p99 us", "max us");
+
+    // same topology: every preset that shares the middle topology, in order
+    std::vector<unsigned> same;
+    for (unsigned i = 2; i < options.presets; i += TOPOLOGIES) {
+        same.push_back(i);
+    }
+    Stats load, update, rebuild, total;
+    if (!switchThrough(options, same, load, update, rebuild, total)) {
+        return 1;
+    }
+    std::printf("same topology\n");
+    load.print("  map and check");
+    update.print("  update parameters");
+    total.print("  switch");
+
+    // every preset in a shuffled order, so most switches change the topology
+    std::vector<unsigned> mixed(options.presets);
+    for (unsigned i = 0; i < options.presets; ++i) {
+        mixed[i] = i;
+    }
+    for (unsigned i = options.presets - 1; i > 0; --i) {
+        std::swap(mixed[i], mixed[random.below(i + 1)]);
+    }
+    load = Stats();
+    update = Stats();
+    rebuild = Stats();
+    total = Stats();
+    if (!switchThrough(options, mixed, load, update, rebuild, total)) {
+        return 1;
+    }
+    std::printf("mixed topologies\n");
+    load.print("  map and check");
+    update.print("  update parameters");
+    rebuild.print("  rebuild");
+    total.print("  switch");
+
+    Stats parse;
+    for (size_t i = 0; i < json.size(); ++i) {
+        Patch patch;
+        Stopwatch watch;
+        if (!patch.parseJson(json[i], "preset")) {
+            return 1;
+        }
+        parse.ns.push_back(watch.elapsedNs());
+    }
+    std::printf("json\n");
+    parse.print("  parse and build");
+
+    // steps are printed in thousandths of full scale in the time columns
+    SwapResult crossfaded, naive;
+    const unsigned swaps = std::min(HOT_SWAPS, options.presets - 1);
+    if (!hotSwap(options, swaps, crossfaded) || !naiveSwap(options, swaps, naive)) {
+        return 1;
+    }
+    std::printf("hot swap, %.0f ms crossfade, %.0f us deadline\n", PatchPlayer::DEFAULT_CROSSFADE_SECONDS * 1000.0,
+                FRAMES * 1e6 / SAMPLE_RATE);
+    crossfaded.load.print("  load off audio");
+    crossfaded.block.print("  block, steady");
+    crossfaded.fade_block.print("  block, fading");
+    crossfaded.step.print("  step x1000, fading");
+    naive.step.print("  step x1000, naive");
+
+    if (!options.keep) {
+        for (unsigned i = 0; i < options.presets; ++i) {
+            std::filesystem::remove(presetPath(options, i), error);
+        }
+        std::filesystem::remove(options.directory, error);
+    }
+    return 0;
+}
@@ -0,0 +1,346 @@
+// Polyphony scaling benchmark. Ramps the number of active VoiceNodes from 1 to 1024,
+// renders each count single-threaded and split across a WorkerPool, and reports how
+// many voices fit in 50%, 75% and 90% of the block deadline.
+//
+// usage: polybench [--rate HZ] [--frames N] [--threads N] [--max-voices N] [--ms N] [--csv]
+//
+// Voices play a spread of notes and waveforms with their own LFO rates and staggered
+// note on/off cycles, so envelopes are in every stage at once. Capacity is judged on the
+// 99th percentile block time, since the occasional slow block is what drops out.
+//
+// The multi-threaded graph splits the voices into contiguous groups, each summed by its
+// own MixerNode; the pool renders the groups and the calling thread mixes the group
+// outputs. The "mix" column is the serial tail in either mode: the flat MixerNode over
+// every voice single-threaded, the final group mix multi-threaded.
+
+#include "audiocontext.h"
+#include "benchutil.h"
+#include "denormals.h"
+#include "gainnode.h"
+#include "mixernode.h"
+#include "voicenode.h"
+#include "workerpool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr unsigned VOICE_COUNTS[] = { 1, 2, 3, 4, 6, 8, 12, 16, 24, 32, 48, 64, 96, 128,
+                                      192, 256, 384, 512, 640, 768, 896, 1024 };
+constexpr double THRESHOLDS[] = { 0.50, 0.75, 0.90 };
+
+// Per voice: the VoiceNode, 3 oscillators, 6 gains, 2 envelopes and the inner mixer,
+// plus the AutomationNodes behind their parameters. One float buffer each.
+constexpr unsigned BUFFERS_PER_VOICE = 27;
+
+// Stop ramping once a block takes this many deadlines; the curve is flat by then
+constexpr double GIVE_UP_LOAD = 4.0;
+
+struct Options {
+    unsigned sample_rate = 48000;
+    unsigned frames = 256;
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    unsigned max_voices = 1024;
+    double ms_per_point = 150.0;
+    bool csv = false;
+};
+
+// Voices, the mixer tree above them and each voice's gate cycle
+class PolyGraph
+{
+public:
+    PolyGraph(AudioContext& context, unsigned voices, unsigned groups) : mixer_(context), master_(context, 0.8f) {
+        const int scale[] = { 0, 2, 3, 5, 7, 8, 10 };
+        const wave_shape shapes[] = { wave_shape::sawtooth, wave_shape::pulse, wave_shape::square, wave_shape::triangle };
+        const float sample_rate = context.sampleRate();
+
+        for (unsigned i = 0; i < voices; ++i) {
+            const int note = 36 + scale[(i * 3) % 7] + 12 * static_cast<int>((i / 7) % 5);
+            const float frequency = 440.0f * std::pow(2.0f, (note - 69) / 12.0f);
+
+            auto voice = std::make_unique<VoiceNode>(context);
+            voice->setParameters(VoiceNode::Builder(context)
+                                     .setModFrequency(4.0f + 0.37f * static_cast<float>(i % 9))
+                                     .setOscillator1Waveform(shapes[i % 4])
+                                     .setOscillator2Waveform(shapes[(i + 1) % 4])
+                                     .setOscillator1Frequency(frequency)
+                                     .setOscillator2Frequency(frequency * 1.5f)
+                                     .setOscillator1Detune(0.1f * static_cast<float>(i % 5))
+                                     .setOscillator1Gain(1)
+                                     .setOscillator2Gain(.3f)
+                                     .setOscillator1ModGain(.2f)
+                                     .setOscillator2ModGain(.3f)
+                                     .setVolumeEnvelopeA(.02f)
+                                     .setVolumeEnvelopeD(.15f)
+                                     .setVolumeEnvelopeS(.7f)
+                                     .setVolumeEnvelopeR(.4f)
+                                     .parameters());
+
+            // 0.4 .. 1.2 s held, then 0.3 s released, each voice offset from the others
+            const auto period = static_cast<unsigned long long>((0.7 + 0.1 * (i % 9)) * sample_rate);
+            const auto held = period - static_cast<unsigned long long>(0.3 * sample_rate);
+            gates_.push_back({ period, held, static_cast<unsigned long long>(i) * 997 % period, false });
+
+            voices_.push_back(std::move(voice));
+        }
+
+        // no groups: every voice straight into one flat mixer, as the app wires it
+        if (groups == 0) {
+            for (auto& voice : voices_) {
+                mixer_.addInput(voice.get(), 1.0f);
+            }
+        } else {
+            for (unsigned g = 0; g < groups; ++g) {
+                auto group = std::make_unique<MixerNode>(context);
+                const size_t begin = voices_.size() * g / groups;
+                const size_t end = voices_.size() * (g + 1) / groups;
+                for (size_t i = begin; i < end; ++i) {
+                    group->addInput(voices_[i].get(), 1.0f);
+                }
+                mixer_.addInput(group.get(), 1.0f);
+                groups_.push_back(std::move(group));
+            }
+        }
+
+        mixer_.connect(&master_);
+    }
+
+    void updateGates(unsigned long long position) {
+        for (size_t i = 0; i < voices_.size(); ++i) {
+            Gate& gate = gates_[i];
+            const bool on = (position + gate.offset) % gate.period < gate.held;
+            if (on != gate.on) {
+                on ? voices_[i]->noteOn() : voices_[i]->noteOff();
+                gate.on = on;
+            }
+        }
+    }
+
+    std::vector<std::unique_ptr<VoiceNode>>& voices() { return voices_; }
+    std::vector<std::unique_ptr<MixerNode>>& groups() { return groups_; }
+    AudioNode* output() { return &master_; }
+
+private:
+    struct Gate {
+        unsigned long long period;
+        unsigned long long held;
+        unsigned long long offset;
+        bool on;
+    };
+
+    std::vector<std::unique_ptr<VoiceNode>> voices_;
+    std::vector<std::unique_ptr<MixerNode>> groups_;
+    std::vector<Gate> gates_;
+    MixerNode mixer_;
+    GainNode master_;
+};
+
+struct Point {
+    unsigned voices;
+    double mean_ns;
+    double p99_ns;
+    double mix_ns;
+};
+
+Point measure(const Options& options, unsigned voices, WorkerPool* pool) {
+    AudioContext context(static_cast<float>(options.sample_rate), options.frames);
+
+    // a few groups per thread so one slow group doesn't leave the other threads idle
+    const unsigned groups = pool ? std::min(voices, pool->threadCount() * 4) : 0;
+    PolyGraph graph(context, voices, groups);
+
+    const unsigned frames = options.frames;
+    unsigned processing_id = 0;
+    unsigned long long position = 0;
+    double mix_ns = 0.0;
+
+    const auto renderBlock = [&]() {
+        graph.updateGates(position);
+
+        if (pool) {
+            pool->run(static_cast<unsigned>(graph.groups().size()), [&](unsigned g) {
+                graph.groups()[g]->process(frames, processing_id);
+            });
+        } else {
+            for (auto& voice : graph.voices()) {
+                voice->process(frames, processing_id);
+            }
+        }
+
+        // everything below the mixer has already run for this id, so this is only the sum
+        Stopwatch mix_watch;
+        graph.output()->process(frames, processing_id);
+        mix_ns += mix_watch.elapsedNs();
+        doNotOptimize(graph.output()->buffer()[frames - 1]);
+
+        ++processing_id;
+        position += frames;
+        context.updateBatch(frames);
+    };
+
+    for (unsigned i = 0; i < 32; ++i) {
+        renderBlock();
+    }
+    mix_ns = 0.0;
+
+    std::vector<double> block_ns;
+    double total_ns = 0.0;
+    const double min_ns = options.ms_per_point * 1e6;
+    do {
+        Stopwatch watch;
+        renderBlock();
+        block_ns.push_back(watch.elapsedNs());
+        total_ns += block_ns.back();
+    } while (total_ns < min_ns || block_ns.size() < 20);
+
+    std::sort(block_ns.begin(), block_ns.end());
+    const size_t p99 = std::min(block_ns.size() - 1, block_ns.size() * 99 / 100);
+    const double blocks = static_cast<double>(block_ns.size());
+
+    return { voices, total_ns / blocks, block_ns[p99], mix_ns / blocks };
+}
+
+std::vector<Point> sweep(const Options& options, WorkerPool* pool, const char* label) {
+    const double deadline_ns = 1e9 * options.frames / options.sample_rate;
+    std::vector<Point> points;
+
+    if (!options.csv) {
+        std::printf("\n%s (%u thread%s)\n", label, pool ? pool->threadCount() : 1, pool && pool->threadCount() > 1 ? "s" : "");
+        std::printf("%7s %11s %11s %8s %8s %14s %7s %12s\n", "voices", "mean us", "p99 us", "load", "p99 load",
+                    "ns/voice/smp", "mix", "buffers KiB");
+    }
+
+    for (const unsigned voices : VOICE_COUNTS) {
+        if (voices > options.max_voices) {
+            break;
+        }
+
+        const Point p = measure(options, voices, pool);
+        points.push_back(p);
+
+        const double per_voice = p.mean_ns / (static_cast<double>(voices) * options.frames);
+        const double buffers_kib = static_cast<double>(voices) * BUFFERS_PER_VOICE * options.frames * sizeof(float) / 1024.0;
+
+        if (options.csv) {
+            std::printf("%s,%u,%u,%.1f,%.1f,%.4f,%.4f,%.3f,%.1f,%.0f\n", label, pool ? pool->threadCount() : 1, voices,
+                        p.mean_ns, p.p99_ns, p.mean_ns / deadline_ns, p.p99_ns / deadline_ns, per_voice,
+                        p.mix_ns, buffers_kib);
+        } else {
+            std::printf("%7u %11.1f %11.1f %7.1f%% %7.1f%% %14.3f %6.1f%% %12.0f\n", voices, p.mean_ns / 1000.0,
+                        p.p99_ns / 1000.0, 100.0 * p.mean_ns / deadline_ns, 100.0 * p.p99_ns / deadline_ns, per_voice,
+                        100.0 * p.mix_ns / p.mean_ns, buffers_kib);
+        }
+        std::fflush(stdout);
+
+        if (p.mean_ns > GIVE_UP_LOAD * deadline_ns) {
+            break;
+        }
+    }
+
+    return points;
+}
+
+// Largest voice count whose p99 block fits the budget, interpolating between the
+// measured counts on either side of it
+double capacity(const std::vector<Point>& points, double budget_ns) {
+    double best = 0.0;
+    for (size_t i = 0; i < points.size(); ++i) {
+        if (points[i].p99_ns > budget_ns) {
+            if (i > 0) {
+                const Point& a = points[i - 1];
+                const Point& b = points[i];
+                const double t = (budget_ns - a.p99_ns) / (b.p99_ns - a.p99_ns);
+                best = a.voices + t * (b.voices - a.voices);
+            }
+            return best;
+        }
+        best = points[i].voices;
+    }
+    return best;
+}
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        const bool has_value = i + 1 < argc;
+
+        if (std::strcmp(arg, "--rate") == 0 && has_value) {
+            options.sample_rate = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else if (std::strcmp(arg, "--frames") == 0 && has_value) {
+            options.frames = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else if (std::strcmp(arg, "--threads") == 0 && has_value) {
+            options.threads = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else if (std::strcmp(arg, "--max-voices") == 0 && has_value) {
+            options.max_voices = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else if (std::strcmp(arg, "--ms") == 0 && has_value) {
+            options.ms_per_point = std::atof(argv[++i]);
+        } else if (std::strcmp(arg, "--csv") == 0) {
+            options.csv = true;
+        } else {
+            return false;
+        }
+    }
+
+    return options.sample_rate > 0 && options.frames > 0 && options.threads > 0 && options.max_voices > 0;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::fprintf(stderr, "usage: polybench [--rate HZ] [--frames N] [--threads N] [--max-voices N] [--ms N] [--csv]\n");
+        return 1;
+    }
+
+    ScopedDenormalDisable denormal_guard;
+
+    const double deadline_ns = 1e9 * options.frames / options.sample_rate;
+
+    if (options.csv) {
+        std::printf("mode,threads,voices,mean_ns,p99_ns,load,p99_load,ns_per_voice_sample,mix_ns,buffers_kib\n");
+    } else {
+        std::printf("%u frames at %u Hz: %.1f us deadline per block\n", options.frames, options.sample_rate, deadline_ns / 1000.0);
+    }
+
+    const std::vector<Point> single = sweep(options, nullptr, "single");
+
+    std::vector<Point> multi;
+    std::unique_ptr<WorkerPool> pool;
+    if (options.threads > 1) {
+        pool = std::make_unique<WorkerPool>(options.threads);
+        multi = sweep(options, pool.get(), "multi");
+    } else if (!options.csv) {
+        std::printf("\nmulti-threaded sweep skipped: one hardware thread (use --threads N to force)\n");
+    }
+
+    if (options.csv) {
+        return 0;
+    }
+
+    std::printf("\nmax voices within the deadline (p99 block time)\n");
+    std::printf("%8s %10s", "budget", "single");
+    if (!multi.empty()) {
+        std::printf(" %10s %9s", "multi", "speedup");
+    }
+    std::printf("\n");
+
+    for (const double threshold : THRESHOLDS) {
+        const double single_voices = capacity(single, threshold * deadline_ns);
+        std::printf("%7.0f%% %10.0f", 100.0 * threshold, single_voices);
+        if (!multi.empty()) {
+            const double multi_voices = capacity(multi, threshold * deadline_ns);
+            std::printf(" %10.0f %8.2fx", multi_voices, single_voices > 0 ? multi_voices / single_voices : 0.0);
+        }
+        std::printf("\n");
+    }
+
+    return 0;
+}
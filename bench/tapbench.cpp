@@ -0,0 +1,228 @@
+// Signal tap and level meter benchmark. Renders a bank of oscillator nodes and times what
+// a tap on each adds to a block, i.e. the SignalTap::write() that AudioNode::process()
+// makes after rendering, for a few decimations, and then what a LevelMeter adds. The
+// render itself is not timed, as it would bury the tap in noise. A reader drains the
+// taps between blocks, untimed, as a display would between frames.
+//
+// usage: tapbench [--taps N] [--blocks N] [--frames N]
+//
+// It checks that a meter on a full-scale sine reads a peak of 1 and an RMS of 1/sqrt(2).
+// It then writes a counting ramp into one tap from a second thread while this one reads
+// it, and fails if any sample arrives out of order, or if the samples read and dropped
+// don't add up to the samples written.
+
+#include "audiocontext.h"
+#include "benchutil.h"
+#include "definitions.h"
+#include "denormals.h"
+#include "levelmeter.h"
+#include "oscillatornode.h"
+#include "signaltap.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr unsigned DECIMATIONS[] = { 1, 4, 16 };
+// ramp values stay exact in a float below 2^24
+constexpr unsigned long long RAMP_LIMIT = 1ull << 24;
+
+struct Options {
+    unsigned taps = 8;
+    unsigned blocks = 20000;
+    unsigned frames = FRAMES;
+};
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        const bool has_value = i + 1 < argc;
+
+        if (std::strcmp(arg, "--taps") == 0 && has_value) {
+            options.taps = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else if (std::strcmp(arg, "--blocks") == 0 && has_value) {
+            options.blocks = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else if (std::strcmp(arg, "--frames") == 0 && has_value) {
+            options.frames = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else {
+            return false;
+        }
+    }
+
+    return options.taps > 0 && options.blocks > 0 && options.frames > 0;
+}
+
+// Renders every node for options.blocks blocks and writes each block to the node's tap,
+// draining the taps between blocks; returns the mean time per block of the writes
+double tapBlocks(const Options& options, AudioContext& context, std::vector<std::unique_ptr<OscillatorNode>>& nodes,
+                 std::vector<std::unique_ptr<SignalTap>>& taps) {
+    std::vector<float> display(SignalTap::DEFAULT_CAPACITY);
+    double total_ns = 0.0;
+    Stopwatch watch;
+
+    for (unsigned block = 0; block < options.blocks; ++block) {
+        for (auto& node : nodes) {
+            node->process(options.frames, context.lastBatch());
+        }
+        context.updateBatch(options.frames);
+
+        watch.reset();
+        for (std::size_t n = 0; n < nodes.size(); ++n) {
+            taps[n]->write(nodes[n]->buffer(), options.frames);
+        }
+        total_ns += watch.elapsedNs();
+
+        for (auto& tap : taps) {
+            doNotOptimize(tap->read(display.data(), display.size()));
+        }
+    }
+
+    return total_ns / options.blocks;
+}
+
+// Renders every node for options.blocks blocks and measures each block with the node's
+// meter; returns the mean time per block of the measuring
+double meterBlocks(const Options& options, AudioContext& context, std::vector<std::unique_ptr<OscillatorNode>>& nodes,
+                   std::vector<std::unique_ptr<LevelMeter>>& meters) {
+    double total_ns = 0.0;
+    Stopwatch watch;
+
+    for (unsigned block = 0; block < options.blocks; ++block) {
+        for (auto& node : nodes) {
+            node->process(options.frames, context.lastBatch());
+        }
+        context.updateBatch(options.frames);
+
+        watch.reset();
+        for (std::size_t n = 0; n < nodes.size(); ++n) {
+            meters[n]->measure(nodes[n]->buffer(), options.frames);
+        }
+        total_ns += watch.elapsedNs();
+        doNotOptimize(meters.back()->peak());
+    }
+
+    return total_ns / options.blocks;
+}
+
+// Writer thread against this one reading; true if every sample came through in order
+bool checkConcurrent(const Options& options) {
+    const unsigned decimation = 3;
+    SignalTap tap(1024, decimation);
+
+    const unsigned long long ramp_blocks = RAMP_LIMIT / options.frames;
+    const unsigned long long written = (ramp_blocks * options.frames + decimation - 1) / decimation;
+
+    std::thread writer([&]() {
+        std::vector<float> block(options.frames);
+        unsigned long long next = 0;
+        for (unsigned long long b = 0; b < ramp_blocks; ++b) {
+            for (float& sample : block) {
+                sample = static_cast<float>(next++);
+            }
+            tap.write(block.data(), options.frames);
+        }
+    });
+
+    std::vector<float> out(256);
+    unsigned long long read = 0;
+    unsigned long long gaps = 0;
+    float last = -static_cast<float>(decimation);
+    bool ordered = true;
+    bool done = false;
+
+    while (!done) {
+        // the last drain after the writer has finished picks up whatever it left
+        done = read + tap.dropped() >= written;
+        const std::size_t count = tap.read(out.data(), out.size());
+        for (std::size_t i = 0; i < count; ++i) {
+            const float expected = last + static_cast<float>(decimation);
+            if (out[i] != expected) {
+                // dropped samples leave a gap, but never go backwards or off the stride
+                const bool forward = out[i] > expected && static_cast<unsigned long long>(out[i]) % decimation == 0;
+                ordered = ordered && forward;
+                ++gaps;
+            }
+            last = out[i];
+        }
+        read += count;
+    }
+    writer.join();
+    read += tap.read(out.data(), out.size());
+
+    const bool complete = read + tap.dropped() == written;
+    std::printf("concurrent: %llu written, %llu read, %llu dropped in %llu gaps, %s\n", written, read, tap.dropped(),
+                gaps, ordered && complete ? "in order" : "FAILED");
+    return ordered && complete;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::fprintf(stderr, "usage: tapbench [--taps N] [--blocks N] [--frames N]\n");
+        return 1;
+    }
+
+    ScopedDenormalDisable denormal_guard;
+    AudioContext context(SAMPLE_RATE, options.frames);
+    std::vector<std::unique_ptr<OscillatorNode>> nodes;
+    for (unsigned n = 0; n < options.taps; ++n) {
+        nodes.push_back(std::make_unique<OscillatorNode>(context, wave_shape::sine, 110.0f * static_cast<float>(n + 1)));
+    }
+
+    std::printf("%u taps, %u frames, %u blocks per row\n\n", options.taps, options.frames, options.blocks);
+    std::printf("%-24s %14s %18s\n", "", "ns per block", "ns per tap-block");
+
+    std::vector<std::unique_ptr<SignalTap>> taps;
+    for (const unsigned decimation : DECIMATIONS) {
+        taps.clear();
+        for (unsigned n = 0; n < options.taps; ++n) {
+            taps.push_back(std::make_unique<SignalTap>(SignalTap::DEFAULT_CAPACITY, decimation));
+        }
+
+        const double tapped_ns = tapBlocks(options, context, nodes, taps);
+        char label[64];
+        std::snprintf(label, sizeof(label), "decimation %u", decimation);
+        std::printf("%-24s %14.1f %18.1f\n", label, tapped_ns, tapped_ns / options.taps);
+    }
+
+    std::vector<std::unique_ptr<LevelMeter>> meters;
+    for (unsigned n = 0; n < options.taps; ++n) {
+        meters.push_back(std::make_unique<LevelMeter>(static_cast<float>(SAMPLE_RATE)));
+    }
+    const double meter_ns = meterBlocks(options, context, nodes, meters);
+    std::printf("%-24s %14.1f %18.1f\n", "level meter", meter_ns, meter_ns / options.taps);
+
+    // and through the node, as the graph uses it
+    SignalTap attached;
+    nodes.front()->setTap(&attached);
+    nodes.front()->process(options.frames, context.lastBatch());
+    nodes.front()->setTap(nullptr);
+    context.updateBatch(options.frames);
+    const bool through_node = attached.available() == options.frames;
+    std::printf("\nattached to a node: %zu samples from one %u frame block, %s\n", attached.available(),
+                options.frames, through_node ? "ok" : "FAILED");
+
+    // a full-scale sine, long enough for the RMS to settle
+    LevelMeter sine_meter(static_cast<float>(SAMPLE_RATE));
+    nodes.front()->setMeter(&sine_meter);
+    for (unsigned block = 0; block < SAMPLE_RATE * 4 / options.frames; ++block) {
+        nodes.front()->process(options.frames, context.lastBatch());
+        context.updateBatch(options.frames);
+    }
+    nodes.front()->setMeter(nullptr);
+    const bool levels_right =
+        std::fabs(sine_meter.peak() - 1.0f) < 0.01f && std::fabs(sine_meter.rms() - 1.0f / std::sqrt(2.0f)) < 0.02f;
+    std::printf("meter on a full-scale sine: peak %.3f, rms %.3f, %s\n", sine_meter.peak(), sine_meter.rms(),
+                levels_right ? "ok" : "FAILED");
+
+    const bool concurrent = checkConcurrent(options);
+    return through_node && levels_right && concurrent ? 0 : 1;
+}
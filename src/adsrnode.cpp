@@ -3,7 +3,7 @@
 
 ADSRNode::ADSRNode(AudioContext& context, float attack, float decay, float sustain, float release) : AudioNode(context),
     gate_automation_(context, 0.0), attack_(attack), decay_(decay), sustain_(sustain),
-    release_(release), envelope_level_(0.0f), state_(State::Idle)
+    release_(release), envelope_level_(0.0f), release_step_(0.0f), state_(State::Idle)
 {}
 
 
@@ -28,6 +28,18 @@ void ADSRNode::setGate(bool gate) {
 }
 
 
+void ADSRNode::setGateAtTime(bool gate, double time) {
+    gate_automation_.setValueAtTime(gate ? 1.0f : 0.0f, time);
+}
+
+
+void ADSRNode::transferState(const AudioNode& other) {
+    const auto& envelope = static_cast<const ADSRNode&>(other);
+    envelope_level_ = envelope.envelope_level_;
+    release_step_ = envelope.release_step_;
+    state_ = envelope.state_;
+}
+
 void ADSRNode::processInternal(unsigned frames) {
 
     auto sampleRate = context_.sampleRate();
@@ -42,7 +54,7 @@ void ADSRNode::processInternal(unsigned frames) {
         if(gate && state_ == State::Idle) {
             state_ = State::Attack;
         } else if(!gate && state_ != State::Idle && state_ != State::Release) {
-            state_ = State::Release;
+            enterRelease(sampleRate);
         }
 
         switch(state_) {
@@ -72,13 +84,13 @@ void ADSRNode::processInternal(unsigned frames) {
         case State::Sustain:
             envelope_level_ = sustain_;
             if(!gate) {
-                state_ = State::Release;
+                enterRelease(sampleRate);
             }
             break;
 
         case State::Release:
-            envelope_level_ -= sustain_ / (release_ * sampleRate);
-            if(envelope_level_ <= 0.0001f) {
+            envelope_level_ -= release_step_;
+            if(envelope_level_ <= RELEASE_FLOOR) {
                 envelope_level_ = 0.0f;
                 state_ = State::Idle;
             }
@@ -90,6 +102,13 @@ void ADSRNode::processInternal(unsigned frames) {
 
 }
 
+void ADSRNode::enterRelease(float sampleRate) {
+    // ramp down from wherever the envelope currently is, so a release that starts
+    // mid-attack (or with zero sustain) still reaches the floor and goes idle
+    release_step_ = std::max(envelope_level_, RELEASE_FLOOR) / (release_ * sampleRate);
+    state_ = State::Release;
+}
+
 void ADSRNode::addAutomation(AudioNode* node, unsigned port) {
     switch(static_cast<Parameters>(port))
     {
@@ -19,6 +19,10 @@ public:
     void setSustain(float sustain);
     void setRelease(float release);
     void setGate(bool gate);
+    // sample-accurate gate change at a time on the context's sample clock, in seconds
+    void setGateAtTime(bool gate, double time);
+
+    void transferState(const AudioNode& other) override;
 
 protected:
     void processInternal(unsigned frames) override;
@@ -26,6 +30,11 @@ protected:
     AudioNode* removeAutomation(unsigned port) override;
 
 private:
+    void enterRelease(float sampleRate);
+
+    // below this level the release snaps to zero and the envelope goes idle
+    static constexpr float RELEASE_FLOOR = 0.0001f;
+
     AutomationNode gate_automation_;
 
 
@@ -35,6 +44,7 @@ private:
     float release_;
 
     float envelope_level_;
+    float release_step_;
 
     enum class State { Idle, Attack, Decay, Sustain, Release } state_;
 
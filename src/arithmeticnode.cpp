@@ -17,8 +17,7 @@ void ArithmeticNode::processInternal(unsigned int frames) {
     // process the parameter nodes
     operation_automation_.process(frames, last_processing_id_);
 
-    const auto value_buffer = std::make_unique<float []>(frames);
-    memcpy(value_buffer.get(), operation_automation_.buffer(), frames * sizeof(float));
+    const float* value_buffer = operation_automation_.buffer();
 
     for(unsigned i = 0; i < frames; ++i) {
         switch(operation_) {
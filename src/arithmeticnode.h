@@ -23,6 +23,7 @@ public:
     explicit ArithmeticNode(AudioContext& context, Operation op = Operation::Add, float value = 0);
 
     void setValue(float value) { operation_automation_.setBaseValue(value); }
+    void setOperation(Operation op) { operation_ = op; }
 
 protected:
     virtual void processInternal(unsigned int frames);
@@ -0,0 +1,14 @@
+#include "audiobackend.h"
+#include "denormals.h"
+
+#include <cstring>
+
+void AudioBackend::renderBlock(float* output, const unsigned long frames) {
+    ScopedDenormalDisable denormal_guard;
+
+    if (user_callback_) {
+        user_callback_(user_data_, output, frames);
+    } else {
+        std::memset(output, 0, frames * CHANNELS * sizeof(float));
+    }
+}
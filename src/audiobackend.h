@@ -0,0 +1,48 @@
+#ifndef AUDIOBACKEND_H
+#define AUDIOBACKEND_H
+
+#include <functional>
+
+// Common interface for everything that pulls interleaved stereo float blocks out of
+// the graph: the PortAudio player and the headless null, file and pipe sinks.
+class AudioBackend {
+
+public:
+    using RenderCallback = std::function<void(const void* user_data, float* output, unsigned long frames_per_buffer)>;
+
+    static constexpr unsigned CHANNELS = 2;
+
+    AudioBackend(const void* user_data, double sample_rate, unsigned long frames_per_buffer)
+        : sample_rate_(sample_rate), frames_per_buffer_(frames_per_buffer), user_data_(user_data) {}
+    virtual ~AudioBackend() = default;
+
+    AudioBackend(const AudioBackend&) = delete;
+    AudioBackend& operator=(const AudioBackend&) = delete;
+
+    virtual bool initializeStream() = 0;
+    virtual bool start() = 0;
+    virtual bool stop() = 0;
+
+    void setSampleRate(double sample_rate) { sample_rate_ = sample_rate; }
+    double getSampleRate() const { return sample_rate_; }
+
+    void setUserData(const void* user_data) { user_data_ = user_data; }
+
+    void setFramesPerBuffer(unsigned long frames_per_buffer) { frames_per_buffer_ = frames_per_buffer; }
+    unsigned long getFramesPerBuffer() const { return frames_per_buffer_; }
+
+    void setCallback(RenderCallback callback) { user_callback_ = std::move(callback); }
+
+protected:
+    // Runs the user callback for one block, or writes silence when there is none.
+    // Call from the backend's render thread.
+    void renderBlock(float* output, unsigned long frames);
+
+    double sample_rate_;
+    unsigned long frames_per_buffer_;
+    const void* user_data_;
+
+    RenderCallback user_callback_;
+};
+
+#endif // AUDIOBACKEND_H
@@ -2,6 +2,7 @@
 #define AUDIOCONTEXT_H
 
 #include <atomic>
+#include <cstdint>
 
 class AudioContext
 {
@@ -11,13 +12,60 @@ public:
     float sampleRate() const { return sample_rate_.load();}
     void setSampleRate(float sampleRate) { sample_rate_.store(sampleRate); }
 
-    int lastBatch() const { return last_batch_id_; }
-    void updateBatch() { last_batch_id_ += 1; }
+    unsigned lastBatch() const { return last_batch_id_; }
+    // Called by the driver after every rendered block. Scheduled events are timed from the
+    // sample clock, so they land on the same sample whatever the block size.
+    void updateBatch(unsigned frames) {
+        last_batch_id_ += 1;
+        sample_position_.fetch_add(frames, std::memory_order_relaxed);
+    }
+    // first sample of the block being rendered
+    unsigned long long samplePosition() const { return sample_position_.load(std::memory_order_relaxed); }
+    // Puts the sample clock back to zero, for a driver that renders several pieces with one
+    // graph. Only between blocks.
+    void resetClock() {
+        last_batch_id_ = 0;
+        sample_position_.store(0, std::memory_order_relaxed);
+    }
+
+    // Deterministic rendering: the output depends only on the graph, its events and the
+    // seed, never on the block size or the thread count. Costs a little per sample where a
+    // node would otherwise do work once per block.
+    void setDeterministic(bool enabled) { deterministic_.store(enabled, std::memory_order_relaxed); }
+    bool deterministic() const { return deterministic_.load(std::memory_order_relaxed); }
+
+    // Random sources draw their seeds from here in construction order, so the same graph
+    // built the same way renders the same noise
+    void setSeed(std::uint64_t seed) { seed_ = seed; seeds_drawn_ = 0; }
+    std::uint64_t seed() const { return seed_; }
+    std::uint64_t nextRandomSeed() {
+        // splitmix64 over the seed and the draw count
+        std::uint64_t z = seed_ + 0x9e3779b97f4a7c15ull * (seeds_drawn_.fetch_add(1) + 1);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        return z ^ (z >> 31);
+    }
+
+    // When enabled every node samples its output for subnormal floats after processing
+    void setDenormalDiagnostics(bool enabled) { denormal_diagnostics_.store(enabled, std::memory_order_relaxed); }
+    bool denormalDiagnostics() const { return denormal_diagnostics_.load(std::memory_order_relaxed); }
+
+    void reportDenormals(unsigned count) { denormal_count_.fetch_add(count, std::memory_order_relaxed); }
+    unsigned long long denormalCount() const { return denormal_count_.load(std::memory_order_relaxed); }
+    void resetDenormalCount() { denormal_count_.store(0, std::memory_order_relaxed); }
 
 private:
     std::atomic<float> sample_rate_;
-    std::atomic<int> last_batch_id_;
+    std::atomic<unsigned> last_batch_id_;
     std::atomic<unsigned> frames_;
+    std::atomic<unsigned long long> sample_position_ { 0 };
+
+    std::atomic<bool> deterministic_ { false };
+    std::uint64_t seed_ = 0;
+    std::atomic<std::uint64_t> seeds_drawn_ { 0 };
+
+    std::atomic<bool> denormal_diagnostics_ { false };
+    std::atomic<unsigned long long> denormal_count_ { 0 };
 };
 
 #endif // AUDIOCONTEXT_H
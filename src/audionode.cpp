@@ -1,5 +1,8 @@
 ﻿#include "audionode.h"
 #include "audiocontext.h"
+#include "denormals.h"
+#include "levelmeter.h"
+#include "signaltap.h"
 
 AudioNode::AudioNode(AudioContext &context) : input_(nullptr), buffer_(nullptr), buffer_size_(0), context_(context) {}
 
@@ -9,16 +12,29 @@ void AudioNode::setInput(AudioNode *node) {
 
 void AudioNode::process(const unsigned frames, const unsigned processing_id)
 {
-	if (last_processing_id_ == processing_id)
+	if (processed_ && last_processing_id_ == processing_id)
 	{
 		// node has already been processed this cycle; skip
 		return;
 	}
 
     last_processing_id_ = processing_id;
+    processed_ = true;
 
     ensureBufferSize(frames);
 	processInternal(frames);
+
+    if (context_.denormalDiagnostics()) {
+        sampleDenormals(frames);
+    }
+
+    // a node with neither pays for these two loads and nothing else
+    if (SignalTap* tap = tap_.load(std::memory_order_acquire)) {
+        tap->write(buffer_.get(), frames);
+    }
+    if (LevelMeter* meter = meter_.load(std::memory_order_acquire)) {
+        meter->measure(buffer_.get(), frames);
+    }
 }
 
 float* AudioNode::buffer() const
@@ -35,4 +51,19 @@ void AudioNode::ensureBufferSize(const unsigned frames)
 	}
 }
 
+void AudioNode::sampleDenormals(const unsigned frames)
+{
+    unsigned count = 0;
+    for (unsigned i = 0; i < frames; i += DENORMAL_SAMPLE_STRIDE) {
+        count += isDenormal(buffer_[i]) ? 1 : 0;
+    }
 
+    // always look at the tail end of the block, where decays end up
+    if (frames > 0 && (frames - 1) % DENORMAL_SAMPLE_STRIDE != 0 && isDenormal(buffer_[frames - 1])) {
+        count++;
+    }
+
+    if (count > 0) {
+        context_.reportDenormals(count);
+    }
+}
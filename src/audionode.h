@@ -2,8 +2,12 @@
 #define AUDIO_NODE_H
 
 #include "audiocontext.h"
+#include <atomic>
 #include <memory>
 
+class LevelMeter;
+class SignalTap;
+
 class AudioNode {
 
 public:
@@ -25,6 +29,17 @@ public:
 
     float* buffer() const;
 
+    // Copies each block this node renders into tap, or stops when tap is nullptr. May be
+    // called from any thread while audio runs. A detached tap may still be written to by
+    // the block in progress, so it must live until the next block has started or the
+    // stream has stopped.
+    void setTap(SignalTap* tap) { tap_.store(tap, std::memory_order_release); }
+    SignalTap* tap() const { return tap_.load(std::memory_order_acquire); }
+
+    // Measures each block this node renders into meter, or stops with nullptr. Same
+    // threading and lifetime rules as setTap().
+    void setMeter(LevelMeter* meter) { meter_.store(meter, std::memory_order_release); }
+    LevelMeter* meter() const { return meter_.load(std::memory_order_acquire); }
 
     template<typename ParamType>
     void automate(AudioNode* node, ParamType index) {
@@ -32,6 +47,13 @@ public:
     }
 
     void connect(AudioNode *node) { node->setInput(this); }
+    // Unhooks whatever drives the given automation port of this node and returns it
+    AudioNode* disconnectAutomation(unsigned int port) { return removeAutomation(port); }
+
+    // Takes over the running state (phase, envelope level, filter memory) of a node of the
+    // same type, so a rebuilt graph carries on where the old one was. Parameters are not
+    // copied. other is always the same concrete type as this node.
+    virtual void transferState(const AudioNode& /*other*/) {}
 
 protected:
     AudioNode* input_;
@@ -40,7 +62,12 @@ protected:
     std::unique_ptr<float[]> buffer_;
 
     unsigned int buffer_size_ = 0;
-    unsigned int last_processing_id_ = -1;
+    unsigned int last_processing_id_ = 0;
+    // processing ids wrap around, so any value including 0 or UINT_MAX can come first
+    bool processed_ = false;
+
+    std::atomic<SignalTap*> tap_ { nullptr };
+    std::atomic<LevelMeter*> meter_ { nullptr };
 
 protected:
     virtual void processInternal(unsigned int frames) = 0;
@@ -50,6 +77,7 @@ protected:
 
 private:
 	void ensureBufferSize(unsigned int frames);
+    void sampleDenormals(unsigned int frames);
 
 };
 
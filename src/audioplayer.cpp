@@ -1,21 +1,41 @@
 ﻿#include "AudioPlayer.h"
 
 #include <iostream>
+#include <mutex>
 #include <ostream>
-#include <utility>
 
+namespace {
 
-AudioPlayer::AudioPlayer(const void* user_data, const double sample_rate, const unsigned long frames_per_buffer)
-    : stream_(nullptr), last_error_(paNoError), sample_rate_(sample_rate),
-    frames_per_buffer_(frames_per_buffer), user_data_(user_data)
-{
-    // Initialize PortAudio
-    last_error_ = Pa_Initialize();
-    if (last_error_ != paNoError) {
-        std::cerr << "PortAudio initialization failed: " << Pa_GetErrorText(last_error_) << "\n";
+// PortAudio is initialized once per process however many players are open; the first
+// player to open a stream brings it up and the last one to go takes it down
+std::mutex port_audio_mutex;
+unsigned port_audio_users = 0;
+
+PaError acquirePortAudio() {
+    std::lock_guard<std::mutex> lock(port_audio_mutex);
+    if (port_audio_users == 0) {
+        const PaError error = Pa_Initialize();
+        if (error != paNoError) {
+            return error;
+        }
     }
+    ++port_audio_users;
+    return paNoError;
 }
 
+void releasePortAudio() {
+    std::lock_guard<std::mutex> lock(port_audio_mutex);
+    if (--port_audio_users == 0) {
+        Pa_Terminate();
+    }
+}
+
+}
+
+AudioPlayer::AudioPlayer(const void* user_data, const double sample_rate, const unsigned long frames_per_buffer)
+    : AudioBackend(user_data, sample_rate, frames_per_buffer), stream_(nullptr), last_error_(paNoError), initialized_(false)
+{}
+
 AudioPlayer::~AudioPlayer()
 {
     if (stream_) {
@@ -23,15 +43,32 @@ AudioPlayer::~AudioPlayer()
         stream_ = nullptr;
     }
 
-    Pa_Terminate();
+    if (initialized_) {
+        releasePortAudio();
+    }
 }
 
 bool AudioPlayer::initializeStream()
 {
+    if (!initialized_) {
+        // Initialize PortAudio, shared with every other player in the process
+        last_error_ = acquirePortAudio();
+        if (last_error_ != paNoError) {
+            std::cerr << "PortAudio initialization failed: " << Pa_GetErrorText(last_error_) << "\n";
+            return false;
+        }
+        initialized_ = true;
+    }
+
+    // opening again would leak the stream already open
+    if (stream_) {
+        return true;
+    }
+
     // Open an audio I/O stream
     last_error_ = Pa_OpenDefaultStream(&stream_,
         0,          // No input channels
-        2,          // Stereo output
+        CHANNELS,   // Stereo output
         paFloat32,  // 32-bit floating point output
         this->sample_rate_,
         this->frames_per_buffer_,  // Frames per buffer
@@ -39,6 +76,7 @@ bool AudioPlayer::initializeStream()
         this);
     if (last_error_ != paNoError) {
         std::cerr << "Failed to open PortAudio stream: " << Pa_GetErrorText(last_error_) << "\n";
+        stream_ = nullptr;
         return false;
     }
     return true;
@@ -64,27 +102,6 @@ bool AudioPlayer::stop()
     return true;
 }
 
-void AudioPlayer::setSampleRate(const double sample_rate)
-{ this->sample_rate_ = sample_rate; }
-
-double AudioPlayer::getSampleRate() const
-{ return this->sample_rate_; }
-
-void AudioPlayer::setUserData(const void* user_data)
-{ this->user_data_ = user_data; }
-
-void AudioPlayer::setFramesPerBuffer(const unsigned long frames_per_buffer)
-{ this->frames_per_buffer_ = frames_per_buffer; }
-
-unsigned long AudioPlayer::getFramesPerBuffer() const
-{ return this->frames_per_buffer_; }
-
-
-void AudioPlayer::setCallback(std::function<void(const void* user_data, float* output, unsigned long frames_per_buffer)> callback)
-{
-    user_callback_ = std::move(callback);
-}
-
 
 int AudioPlayer::paCallback(const void* input_buffer, void* output_buffer,
     const unsigned long frames_per_buffer,
@@ -92,11 +109,11 @@ int AudioPlayer::paCallback(const void* input_buffer, void* output_buffer,
     PaStreamCallbackFlags status_flags,
     void* user_data)
 {
+    // the callback runs on a PortAudio-owned thread; renderBlock makes sure filter
+    // and envelope tails flush to zero instead of falling into slow subnormal arithmetic
     const auto player = static_cast<AudioPlayer*>(user_data);
     const auto out = static_cast<float*>(output_buffer);
 
-    if (player->user_callback_) {
-        player->user_callback_(player->user_data_, out, frames_per_buffer);
-    }
+    player->renderBlock(out, frames_per_buffer);
     return paContinue;
-}
\ No newline at end of file
+}
@@ -1,27 +1,22 @@
 ﻿#pragma once
 
-#include <functional>
+#include "audiobackend.h"
+
 #include <portaudio.h>
 
-class AudioPlayer {
+// PortAudio output on the default device. PortAudio itself is only brought up in
+// initializeStream(), so constructing a player costs nothing when it's never opened.
+// Any number of players can be open at once; PortAudio stays up until the last closes.
+class AudioPlayer : public AudioBackend {
 
 public:
 	explicit AudioPlayer(const void* user_data = nullptr, double sample_rate = 44100.0, unsigned long frames_per_buffer = 256);
-    ~AudioPlayer();
-
-    bool initializeStream();
-    bool start();
-    bool stop();
-
-    void setSampleRate(double sample_rate);
-    double getSampleRate() const;
+    ~AudioPlayer() override;
 
-    void setUserData(const void* user_data);
-
-    void setFramesPerBuffer(unsigned long frames_per_buffer);
-    unsigned long getFramesPerBuffer() const;
-
-    void setCallback(std::function<void(const void* user_data, float* output, unsigned long frames_per_buffer)> callback);
+    // does nothing when the stream is already open
+    bool initializeStream() override;
+    bool start() override;
+    bool stop() override;
 
 private:
     static int paCallback(const void* input_buffer, void* output_buffer,
@@ -32,9 +27,5 @@ private:
 
     PaStream* stream_;
     PaError last_error_;
-    double sample_rate_;
-    unsigned long frames_per_buffer_;
-    const void* user_data_;
-
-    std::function<void(const void* user_data, float* output, unsigned long frames_per_buffer)> user_callback_;
+    bool initialized_;
 };
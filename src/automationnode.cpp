@@ -1,70 +1,56 @@
 ﻿#include "automationnode.h"
 
-#include <cstring>
-
 AutomationNode::AutomationNode(AudioContext& context, const float base_value, Rate rate) : AudioNode(context), base_value_(base_value), rate_(rate) {}
 
-void AutomationNode::setValueAtTime(float value, float time) {
+void AutomationNode::setValueAtTime(float value, double time) {
     scheduled_events_.push({AutomationEvent::Type::SET, value, time});
 }
 
-void AutomationNode::linearRampValueAtTime(float value, float time) {
+void AutomationNode::linearRampValueAtTime(float value, double time) {
     scheduled_events_.push({AutomationEvent::Type::LINEAR_RAMP, value, time});
 }
 
-void AutomationNode::applyScheduledEvents(float time, unsigned frames) {
-    float frameDuration = 1.0f / context_.sampleRate();
+void AutomationNode::applyScheduledEvents(const unsigned frames) {
+    const double sample_rate = context_.sampleRate();
+    const unsigned long long first_sample = context_.samplePosition();
 
     for (unsigned int i = 0; i < frames; ++i) {
-        float frameTime = time + i * frameDuration;
-
-        // process each event in the priority queue
-        while(!scheduled_events_.empty() && scheduled_events_.top().time <= frameTime) {
-            const auto& event = scheduled_events_.top();
-
-            switch(event.type) {
-                case AutomationEvent::Type::SET:
-                    base_value_ = event.value;
-                    break;
-
-                case AutomationEvent::Type::LINEAR_RAMP: {
-                    if (!scheduled_events_.empty()) {
-                        scheduled_events_.pop();
-                        if (!scheduled_events_.empty()) {
-                            const auto& next_event = scheduled_events_.top();
-                            if (next_event.time > frameTime) {
-                                // Interpolate between the current event and the next event
-                                float t = (frameTime - event.time) / (next_event.time - event.time);
-                                base_value_ = event.value + t * (next_event.value - event.value);
-                            }
-                        }
-                    }
-                    break;
-                }
-            }
+        const double frameTime = static_cast<double>(first_sample + i) / sample_rate;
 
+        // apply every event that has come due; a ramp that has run its course leaves its target behind
+        while (!scheduled_events_.empty() && scheduled_events_.top().time <= frameTime) {
+            base_value_ = scheduled_events_.top().value;
+            previous_event_time_ = scheduled_events_.top().time;
             scheduled_events_.pop();
+        }
 
+        float value = base_value_;
+        if (!scheduled_events_.empty() && scheduled_events_.top().type == AutomationEvent::Type::LINEAR_RAMP) {
+            const AutomationEvent& ramp = scheduled_events_.top();
+            const double t = (frameTime - previous_event_time_) / (ramp.time - previous_event_time_);
+            if (t > 0.0) {
+                value = base_value_ + static_cast<float>(t) * (ramp.value - base_value_);
+            }
         }
+        buffer_[i] = value;
     }
 }
 
 void AutomationNode::processInternal(const unsigned int frames) {
-    float currentTime = static_cast<float>(last_processing_id_ * frames) / context_.sampleRate();
-
     if (input_ != nullptr) {
         input_->process(frames, last_processing_id_);
 
         const float* input_buffer = input_->buffer(); // Get the buffer from the input node
 
-        // Copy the input  buffer into the parameter buffer
-        memcpy(buffer_.get(), input_buffer, frames * sizeof(float));
+        // A patched input modulates around the base value
+        for (unsigned int i = 0; i < frames; ++i) {
+            buffer_[i] = base_value_ + input_buffer[i];
+        }
+    }
+    else if (rate_ == Rate::CONTROL_RATE && !scheduled_events_.empty()) {
+        applyScheduledEvents(frames);
     }
     else {
-
-        if(rate_ == Rate::CONTROL_RATE) {
-            applyScheduledEvents(currentTime, frames);
-        }
         for (unsigned int i = 0; i < frames; ++i) {
             buffer_[i] = base_value_;
         }
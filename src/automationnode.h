@@ -3,6 +3,12 @@
 #include "audionode.h"
 #include <queue>
 
+// Drives one parameter of a node. The buffer always holds the effective value: the base
+// value, plus the patched input signal when one is connected.
+//
+// Scheduled events are timed in seconds on the context's sample clock and take effect
+// on the first sample at or after their time, independent of the block size. A linear
+// ramp runs from the previous event (value and time) to its own value at its own time.
 class AutomationNode final : public AudioNode {
 public:
     enum class Rate {
@@ -18,7 +24,8 @@ public:
 
         Type type;
         float value;
-        float time;
+        // double keeps sample accuracy after hours of uptime
+        double time;
     };
 
     explicit AutomationNode(AudioContext& context, float base_value = 0.0f, Rate rate = AutomationNode::Rate::CONTROL_RATE);
@@ -26,9 +33,8 @@ public:
     void setBaseValue(const float value) { base_value_ = value; }
     float baseValue() const { return base_value_; }
 
-    void setValueAtTime(float value, float time);
-    void linearRampValueAtTime(float value, float time);
-    void applyScheduledEvents(float currentTime, unsigned int frames);
+    void setValueAtTime(float value, double time);
+    void linearRampValueAtTime(float value, double time);
 
 protected:
     void processInternal(unsigned int frames) override;
@@ -36,7 +42,11 @@ protected:
     AudioNode* removeAutomation(unsigned port) override { return nullptr; }
 
 private:
+    // fills the buffer sample by sample while events come due
+    void applyScheduledEvents(unsigned int frames);
+
     float base_value_;
+    double previous_event_time_ = 0.0;
 
     Rate rate_;
     // Priority queue to store automation events sorted by time
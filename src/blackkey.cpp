@@ -1,2 +0,0 @@
-#include "blackkey.h"
-
@@ -0,0 +1,378 @@
+#include "controlsurface.h"
+
+#include <QElapsedTimer>
+#include <QLoggingCategory>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QPaintEvent>
+#include <QWheelEvent>
+#include <QtMath>
+
+namespace {
+
+// off unless enabled, e.g. QT_LOGGING_RULES="synth.knob.paint.debug=true"; reports each
+// knob drag's repaint count and paint time when the button is released
+Q_LOGGING_CATEGORY(knobPaintLog, "synth.knob.paint", QtWarningMsg)
+
+// semitone of each white key in an octave, and whether a black key follows it
+const int WHITE_NOTES[] = { 0, 2, 4, 5, 7, 9, 11 };
+const bool HAS_BLACK_AFTER[] = { true, true, false, true, true, true, false };
+
+const char* const NOTE_NAMES[] = { "C", "C#", "D", "Eb", "E", "F", "F#", "G", "G#", "A", "Bb", "B" };
+
+QFont panelFont(int pointSize, bool bold) {
+    QFont font("Afacad Flux", pointSize);
+    font.setBold(bold);
+    return font;
+}
+
+QRect captionRect(const QRect& knob) {
+    return QRect(knob.left() - 24, knob.bottom() + 2, knob.width() + 48, 18);
+}
+
+}
+
+ControlSurface::ControlSurface(QWidget *parent)
+    : QWidget{parent}
+{
+    setMouseTracking(true);
+    // everything is painted here, over the cached background
+    setAttribute(Qt::WA_OpaquePaintEvent);
+}
+
+void ControlSurface::setSpriteSheet(std::shared_ptr<SpriteSheet> spritesheet) {
+    disconnect(sheet_connection_);
+    spritesheet_ = spritesheet;
+
+    // a sheet loaded after it was set shows without waiting for the knobs to move
+    if (spritesheet_) {
+        sheet_connection_ = connect(spritesheet_.get(), &SpriteSheet::changed, this, &ControlSurface::refreshFrames);
+    }
+    refreshFrames();
+}
+
+void ControlSurface::refreshFrames() {
+    for (Knob& knob : knobs_) {
+        knob.frame = frameFor(knob);
+    }
+    update();
+}
+
+void ControlSurface::addSection(const QRect& rect, const QString& title, int pointSize) {
+    sections_.push_back({ rect, title, pointSize });
+    invalidateBackground();
+}
+
+void ControlSurface::addLabel(const QRect& rect, const QString& text, int pointSize) {
+    labels_.push_back({ rect, text, pointSize });
+    invalidateBackground();
+}
+
+int ControlSurface::addKnob(const QRect& rect, const QString& caption, double minimum, double maximum, double value) {
+    Knob knob { rect, caption, minimum, maximum, qBound(minimum, value, maximum), 0 };
+    knob.frame = frameFor(knob);
+    knobs_.push_back(knob);
+    invalidateBackground();
+    return static_cast<int>(knobs_.size()) - 1;
+}
+
+void ControlSurface::setKnobValue(int knob, double value) {
+    if (knob < 0 || knob >= knobCount()) return;
+
+    Knob& target = knobs_[knob];
+    const double old_value = target.value;
+    target.value = qBound(target.minimum, value, target.maximum);
+    if (target.value == old_value) return;
+
+    // most drag steps land on the same sprite frame and need no repaint
+    const int frame = frameFor(target);
+    if (frame != target.frame) {
+        target.frame = frame;
+        update(target.rect);
+    }
+
+    emit knobChanged(knob, old_value, target.value);
+}
+
+double ControlSurface::knobValue(int knob) const {
+    return knob >= 0 && knob < knobCount() ? knobs_[knob].value : 0.0;
+}
+
+QPoint ControlSurface::knobCenter(int knob) const {
+    return knob >= 0 && knob < knobCount() ? mapToGlobal(knobs_[knob].rect.center()) : QPoint();
+}
+
+void ControlSurface::setKeyboard(const QRect& rect, int whiteKeys, const QColor& background) {
+    keys_.clear();
+    keyboard_rect_ = rect;
+    keyboard_background_ = background;
+
+    if (whiteKeys <= 0) {
+        invalidateBackground();
+        return;
+    }
+
+    const int white_width = rect.width() / whiteKeys;
+    const int black_width = white_width * 2 / 3;
+    const int black_height = rect.height() * 5 / 8;
+
+    for (int i = 0; i < whiteKeys; ++i) {
+        const int note = (i / 7) * 12 + WHITE_NOTES[i % 7];
+        keys_.push_back({ QRect(rect.left() + i * white_width, rect.top(), white_width, rect.height()), note, false });
+    }
+
+    // a black key straddles the line between two white keys
+    for (int i = 0; i + 1 < whiteKeys; ++i) {
+        if (!HAS_BLACK_AFTER[i % 7]) continue;
+        const int note = (i / 7) * 12 + WHITE_NOTES[i % 7] + 1;
+        const int x = rect.left() + (i + 1) * white_width - black_width / 2;
+        keys_.push_back({ QRect(x, rect.top(), black_width, black_height), note, true });
+    }
+
+    invalidateBackground();
+}
+
+int ControlSurface::frameFor(const Knob& knob) const {
+    if (!spritesheet_ || spritesheet_->frameCount() == 0) return 0;
+
+    const int sprite_count = spritesheet_->frameCount();
+    const double range = knob.maximum - knob.minimum;
+    const double mapped_value = range > 0.0 ? (knob.value - knob.minimum) / range : 0.0;
+    return qBound(0, qFloor(mapped_value * sprite_count), sprite_count - 1);
+}
+
+int ControlSurface::knobAt(const QPoint& pos) const {
+    for (int i = 0; i < knobCount(); ++i) {
+        if (knobs_[i].rect.contains(pos)) return i;
+    }
+    return -1;
+}
+
+int ControlSurface::keyAt(const QPoint& pos) const {
+    if (!keyboard_rect_.contains(pos)) return -1;
+
+    // black keys lie on top of the white ones, so they win
+    for (int i = static_cast<int>(keys_.size()) - 1; i >= 0; --i) {
+        if (keys_[i].rect.contains(pos)) return i;
+    }
+    return -1;
+}
+
+void ControlSurface::setHoveredKnob(int knob) {
+    if (knob == hovered_knob_) return;
+
+    if (hovered_knob_ >= 0) emit knobHoverLeft(hovered_knob_);
+    hovered_knob_ = knob;
+    if (hovered_knob_ >= 0) emit knobHoverEntered(hovered_knob_);
+}
+
+void ControlSurface::setHoveredKey(int key) {
+    if (key == hovered_key_) return;
+
+    if (hovered_key_ >= 0) update(keys_[hovered_key_].rect);
+    hovered_key_ = key;
+    if (hovered_key_ >= 0) update(keys_[hovered_key_].rect);
+}
+
+void ControlSurface::invalidateBackground() {
+    background_dirty_ = true;
+    update();
+}
+
+void ControlSurface::renderBackground() {
+    const qreal ratio = devicePixelRatioF();
+    background_ = QPixmap(size() * ratio);
+    background_.setDevicePixelRatio(ratio);
+    background_.fill(Qt::black);
+
+    QPainter painter(&background_);
+    painter.setRenderHint(QPainter::Antialiasing, true);
+
+    for (const Section& section : sections_) {
+        painter.setFont(panelFont(section.point_size, true));
+        const QFontMetrics metrics = painter.fontMetrics();
+        const QRect frame = section.rect.adjusted(0, metrics.height() / 2, 0, 0);
+
+        painter.setPen(QColor(90, 90, 90));
+        painter.setBrush(Qt::NoBrush);
+        painter.drawRoundedRect(QRectF(frame).adjusted(0.5, 0.5, -0.5, -0.5), 3, 3);
+
+        // the title interrupts the frame's top edge, as on a group box
+        const QRect title_rect(frame.left() + 8, section.rect.top(), metrics.horizontalAdvance(section.title) + 8,
+                               metrics.height());
+        painter.fillRect(title_rect, Qt::black);
+        painter.setPen(Qt::white);
+        painter.drawText(title_rect, Qt::AlignCenter, section.title);
+    }
+
+    painter.setPen(Qt::white);
+    for (const Label& label : labels_) {
+        painter.setFont(panelFont(label.point_size, true));
+        painter.drawText(label.rect, Qt::AlignLeft | Qt::AlignBottom, label.text);
+    }
+
+    painter.setFont(panelFont(12, true));
+    for (const Knob& knob : knobs_) {
+        painter.drawText(captionRect(knob.rect), Qt::AlignHCenter | Qt::AlignTop, knob.caption);
+    }
+
+    if (!keys_.empty()) {
+        painter.fillRect(QRect(0, keyboard_rect_.top() - 24, width(), height() - keyboard_rect_.top() + 24),
+                         keyboard_background_);
+    }
+
+    background_dirty_ = false;
+}
+
+void ControlSurface::drawKey(QPainter& painter, const Key& key, int index) const {
+    QColor color = key.black ? Qt::black : Qt::white;
+    if (index == pressed_key_) {
+        color = QColor(0x77, 0x77, 0x77);
+    } else if (index == hovered_key_) {
+        color = key.black ? QColor(0x55, 0x55, 0x55) : QColor(Qt::lightGray);
+    }
+
+    // round bottom corners only: a rounded rect with its top rounding pushed off the key
+    const QRectF body = QRectF(key.rect).adjusted(0.5, -6.0, -0.5, -0.5);
+    painter.save();
+    painter.setClipRect(key.rect);
+    painter.setPen(Qt::black);
+    painter.setBrush(color);
+    painter.drawRoundedRect(body, 5, 5);
+    painter.restore();
+
+    painter.setPen(key.black ? Qt::white : Qt::black);
+    painter.drawText(key.rect.adjusted(0, 0, 0, -8), Qt::AlignHCenter | Qt::AlignBottom, NOTE_NAMES[key.note % 12]);
+}
+
+void ControlSurface::paintEvent(QPaintEvent *event) {
+    const bool measuring = dragged_knob_ >= 0 && knobPaintLog().isDebugEnabled();
+    QElapsedTimer timer;
+    if (measuring) {
+        timer.start();
+    }
+
+    if (background_dirty_ || background_.size() != size() * devicePixelRatioF()) {
+        renderBackground();
+    }
+
+    QPainter painter(this);
+    const QRect dirty = event->rect();
+    painter.drawPixmap(dirty, background_, QRectF(QPointF(dirty.topLeft()) * background_.devicePixelRatio(),
+                                                  QSizeF(dirty.size()) * background_.devicePixelRatio()));
+
+    if (spritesheet_) {
+        for (const Knob& knob : knobs_) {
+            if (knob.rect.intersects(dirty)) {
+                spritesheet_->drawFrame(painter, knob.rect, knob.frame);
+            }
+        }
+    }
+
+    if (!keys_.empty() && keyboard_rect_.intersects(dirty)) {
+        painter.setRenderHint(QPainter::Antialiasing, true);
+        painter.setFont(panelFont(9, true));
+        for (int i = 0; i < static_cast<int>(keys_.size()); ++i) {
+            if (keys_[i].rect.intersects(dirty)) {
+                drawKey(painter, keys_[i], i);
+            }
+        }
+    }
+
+    if (measuring) {
+        painter.end();
+        const qint64 elapsed = timer.nsecsElapsed();
+        ++drag_repaints_;
+        drag_paint_ns_ += elapsed;
+        drag_worst_paint_ns_ = qMax(drag_worst_paint_ns_, elapsed);
+    }
+}
+
+void ControlSurface::mousePressEvent(QMouseEvent *event) {
+    if (event->button() != Qt::LeftButton) {
+        QWidget::mousePressEvent(event);
+        return;
+    }
+
+    const int knob = knobAt(event->pos());
+    if (knob >= 0) {
+        dragged_knob_ = knob;
+        last_mouse_position_ = event->pos();
+        drag_moves_ = 0;
+        drag_repaints_ = 0;
+        drag_paint_ns_ = 0;
+        drag_worst_paint_ns_ = 0;
+        event->accept();
+        return;
+    }
+
+    const int key = keyAt(event->pos());
+    if (key >= 0) {
+        pressed_key_ = key;
+        update(keys_[key].rect);
+        emit keyPressed(keys_[key].note);
+        event->accept();
+        return;
+    }
+
+    QWidget::mousePressEvent(event);
+}
+
+void ControlSurface::mouseMoveEvent(QMouseEvent *event) {
+    if (dragged_knob_ >= 0) {
+        const Knob& knob = knobs_[dragged_knob_];
+        ++drag_moves_;
+
+        // same feel as KnobControl: right and up turn it up
+        const QPoint delta = event->pos() - last_mouse_position_;
+        const double offset = delta.x() - delta.y();
+        const double step = (knob.maximum - knob.minimum) * offset / 100.0;
+
+        setKnobValue(dragged_knob_, knob.value + step);
+        last_mouse_position_ = event->pos();
+        event->accept();
+        return;
+    }
+
+    setHoveredKnob(knobAt(event->pos()));
+    setHoveredKey(keyAt(event->pos()));
+}
+
+void ControlSurface::mouseReleaseEvent(QMouseEvent *event) {
+    if (dragged_knob_ >= 0 && drag_moves_ > 0) {
+        qCDebug(knobPaintLog) << "Knob" << knobs_[dragged_knob_].caption << "drag:" << drag_moves_ << "moves,"
+                              << drag_repaints_ << "repaints, mean"
+                              << (drag_repaints_ > 0 ? drag_paint_ns_ / drag_repaints_ / 1000.0 : 0.0)
+                              << "us, worst" << drag_worst_paint_ns_ / 1000.0 << "us";
+    }
+    dragged_knob_ = -1;
+
+    if (pressed_key_ >= 0) {
+        const int key = pressed_key_;
+        pressed_key_ = -1;
+        update(keys_[key].rect);
+        emit keyReleased(keys_[key].note);
+    }
+
+    event->accept();
+}
+
+void ControlSurface::wheelEvent(QWheelEvent *event) {
+    const int knob = knobAt(event->position().toPoint());
+    if (knob < 0) {
+        QWidget::wheelEvent(event);
+        return;
+    }
+
+    const Knob& target = knobs_[knob];
+    const double step = (target.maximum - target.minimum) * 0.01;
+    setKnobValue(knob, target.value + (event->angleDelta().y() > 0 ? step : -step));
+    event->accept();
+}
+
+void ControlSurface::leaveEvent(QEvent *event) {
+    Q_UNUSED(event);
+
+    setHoveredKnob(-1);
+    setHoveredKey(-1);
+}
@@ -0,0 +1,128 @@
+#ifndef CONTROLSURFACE_H
+#define CONTROLSURFACE_H
+
+#include "spritesheet.h"
+
+#include <QColor>
+#include <QPixmap>
+#include <QRect>
+#include <QString>
+#include <QWidget>
+
+#include <memory>
+#include <vector>
+
+// A whole control panel in one widget: titled sections, captions, knobs drawn from a
+// shared SpriteSheet and a piano keyboard. It draws and hit-tests all of them itself
+// rather than having a QWidget, layout and stylesheet per control.
+//
+// Section frames, captions and the keyboard's backdrop are drawn once into a cached
+// background. A knob turn repaints the knob's rect, and only when its sprite frame
+// changes. A key press or hover repaints that key. Positions are in widget pixels. Other
+// widgets, such as combo boxes, can still be children placed over the surface.
+class ControlSurface : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit ControlSurface(QWidget *parent = nullptr);
+
+    void setSpriteSheet(std::shared_ptr<SpriteSheet> spritesheet);
+
+    void addSection(const QRect& rect, const QString& title, int pointSize = 12);
+    void addLabel(const QRect& rect, const QString& text, int pointSize = 11);
+
+    // A knob in rect with its caption below; returns its id, counting from 0
+    int addKnob(const QRect& rect, const QString& caption, double minimum, double maximum, double value);
+    void setKnobValue(int knob, double value);
+    double knobValue(int knob) const;
+    // the knob's centre in global coordinates, for tooltips
+    QPoint knobCenter(int knob) const;
+    int knobCount() const { return static_cast<int>(knobs_.size()); }
+
+    // whiteKeys white keys from a C, with the black keys between; keys are numbered by
+    // semitone from 0
+    void setKeyboard(const QRect& rect, int whiteKeys, const QColor& background);
+
+signals:
+    void knobChanged(int knob, double oldValue, double newValue);
+    void knobHoverEntered(int knob);
+    void knobHoverLeft(int knob);
+    void keyPressed(int key);
+    void keyReleased(int key);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+    void mouseReleaseEvent(QMouseEvent *event) override;
+    void wheelEvent(QWheelEvent *event) override;
+    void leaveEvent(QEvent *event) override;
+
+private:
+    struct Section {
+        QRect rect;
+        QString title;
+        int point_size;
+    };
+
+    struct Label {
+        QRect rect;
+        QString text;
+        int point_size;
+    };
+
+    struct Knob {
+        QRect rect;
+        QString caption;
+        double minimum;
+        double maximum;
+        double value;
+        int frame;
+    };
+
+    struct Key {
+        QRect rect;
+        int note;
+        bool black;
+    };
+
+    int frameFor(const Knob& knob) const;
+    int knobAt(const QPoint& pos) const;
+    int keyAt(const QPoint& pos) const;
+    void setHoveredKnob(int knob);
+    void setHoveredKey(int key);
+    void invalidateBackground();
+    void renderBackground();
+    void drawKey(QPainter& painter, const Key& key, int index) const;
+    // picks every knob's frame again, for a sheet that was set, loaded or changed
+    void refreshFrames();
+
+private:
+    std::shared_ptr<SpriteSheet> spritesheet_;
+    QMetaObject::Connection sheet_connection_;
+
+    std::vector<Section> sections_;
+    std::vector<Label> labels_;
+    std::vector<Knob> knobs_;
+    // white keys first and black keys after, in paint order
+    std::vector<Key> keys_;
+    QRect keyboard_rect_;
+    QColor keyboard_background_;
+
+    QPixmap background_;
+    bool background_dirty_ = true;
+
+    int dragged_knob_ = -1;
+    QPoint last_mouse_position_;
+    int hovered_knob_ = -1;
+    int hovered_key_ = -1;
+    int pressed_key_ = -1;
+
+    // repaints during the current knob drag, counted while synth.knob.paint debug is on
+    int drag_moves_ = 0;
+    int drag_repaints_ = 0;
+    qint64 drag_paint_ns_ = 0;
+    qint64 drag_worst_paint_ns_ = 0;
+};
+
+#endif // CONTROLSURFACE_H
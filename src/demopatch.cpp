@@ -0,0 +1,91 @@
+#include "demopatch.h"
+#include "definitions.h"
+
+#include <cmath>
+
+DemoPatch::DemoPatch(AudioContext& context) :
+    mod_oscillator_gain_1_(context, .7), mod_oscillator_gain_2_(context, .3),
+    filter_mod_gain_(context, .9),
+    oscillator_1_(context, wave_shape::sawtooth, 165), oscillator_2_(context, wave_shape::sawtooth, 110),
+    lfo_(context, wave_shape::sine, 2), lfo_mul_add_(context, 10, 100), filter_mul_add_(context, 900, 1000),
+    filter_(context, 440), filter_2_(context, 440), gain_volume_(context, .5), filter_mixer_(context),
+    oscillator_1_gain_(context, .4), oscillator_2_gain_(context, .4),
+    adsr_(context, .2, .1, .8, .1) {
+
+    lfo_.connect(&lfo_mul_add_);
+    lfo_mul_add_.connect(&mod_oscillator_gain_1_);
+    lfo_mul_add_.connect(&mod_oscillator_gain_2_);
+    lfo_.connect(&filter_mul_add_);
+
+    filter_mul_add_.connect(&filter_mod_gain_);
+
+    oscillator_1_.connect(&oscillator_1_gain_);
+    oscillator_2_.connect(&oscillator_2_gain_);
+
+    filter_mixer_.addInput(&oscillator_1_gain_, 1);
+    filter_mixer_.addInput(&oscillator_2_gain_, 1);
+    filter_mixer_.connect(&filter_);
+    filter_.connect(&filter_2_);
+    filter_2_.connect(&gain_volume_);
+
+    mod_oscillator_gain_1_.automate(&oscillator_1_, OscillatorNode::Parameters::Frequency);
+    mod_oscillator_gain_2_.automate(&oscillator_2_, OscillatorNode::Parameters::Frequency);
+
+    filter_mod_gain_.automate(&filter_, LP12FilterNode::Parameters::Cutoff);
+    filter_mod_gain_.automate(&filter_2_, LP12FilterNode::Parameters::Cutoff);
+
+    adsr_.automate(&gain_volume_, GainNode::Parameters::Gain);
+
+    adsr_.setGate(true);
+}
+
+void DemoPatch::updateGate(const double seconds) {
+    // the pattern was originally written in FRAMES-sized blocks at SAMPLE_RATE
+    constexpr double block = static_cast<double>(FRAMES) / SAMPLE_RATE;
+
+    if (seconds > 350 * block) {
+        adsr_.setGate(false);
+    } else if (seconds > 300 * block) {
+        adsr_.setGate(true);
+    } else if (seconds > 100 * block) {
+        adsr_.setGate(false);
+    }
+}
+
+DemoVoiceBank::DemoVoiceBank(AudioContext& context, const unsigned voices) : mixer_(context), master_(context, 0.8f) {
+    const int chord[] = { 0, 3, 7, 10 };
+
+    for (unsigned i = 0; i < voices; ++i) {
+        const int note = 48 + chord[i % 4] + 12 * static_cast<int>((i / 4) % 4);
+        const float frequency = 440.0f * std::pow(2.0f, (note - 69) / 12.0f);
+
+        auto voice = std::make_unique<VoiceNode>(context);
+        voice->setParameters(VoiceNode::Builder(context)
+                                 .setModFrequency(5)
+                                 .setOscillator1Frequency(frequency)
+                                 .setOscillator2Frequency(frequency * 1.5f)
+                                 .setOscillator1Gain(1)
+                                 .setOscillator2Gain(.2)
+                                 .setOscillator1ModGain(.2)
+                                 .setOscillator2ModGain(.2)
+                                 .setVolumeEnvelopeA(.05)
+                                 .setVolumeEnvelopeD(.1)
+                                 .setVolumeEnvelopeS(.8)
+                                 .setVolumeEnvelopeR(.5)
+                                 .parameters());
+        voice->noteOn();
+        mixer_.addInput(voice.get(), 1.0f);
+        voices_.push_back(std::move(voice));
+    }
+
+    mixer_.connect(&master_);
+}
+
+void DemoVoiceBank::updateGate(const double seconds, const double length) {
+    if (!released_ && seconds >= length * 0.75) {
+        for (auto& voice : voices_) {
+            voice->noteOff();
+        }
+        released_ = true;
+    }
+}
@@ -0,0 +1,79 @@
+#ifndef DEMOPATCH_H
+#define DEMOPATCH_H
+
+#include "adsrnode.h"
+#include "gainnode.h"
+#include "lp12filternode.h"
+#include "mixernode.h"
+#include "muladdnode.h"
+#include "oscillatornode.h"
+#include "voicenode.h"
+
+#include <memory>
+#include <vector>
+
+// The two-oscillator, dual-filter test patch that used to live in showConsole.
+// Owning the nodes in one object lets the console player and the headless tools
+// share the exact same wiring.
+class DemoPatch
+{
+public:
+    explicit DemoPatch(AudioContext& context);
+
+    DemoPatch(const DemoPatch&) = delete;
+    DemoPatch& operator=(const DemoPatch&) = delete;
+
+    AudioNode* output() { return &gain_volume_; }
+    ADSRNode& envelope() { return adsr_; }
+
+    // Replays the original gate pattern (on, off, retrigger, off) for the given
+    // playback position in seconds
+    void updateGate(double seconds);
+
+private:
+    GainNode mod_oscillator_gain_1_;
+    GainNode mod_oscillator_gain_2_;
+
+    GainNode filter_mod_gain_;
+    OscillatorNode oscillator_1_;
+    OscillatorNode oscillator_2_;
+
+    OscillatorNode lfo_;
+    MulAddNode lfo_mul_add_;
+    MulAddNode filter_mul_add_;
+
+    LP12FilterNode filter_;
+    LP12FilterNode filter_2_;
+    GainNode gain_volume_;
+    MixerNode filter_mixer_;
+
+    GainNode oscillator_1_gain_;
+    GainNode oscillator_2_gain_;
+
+    ADSRNode adsr_;
+};
+
+// N VoiceNodes spread over a minor-seventh chord and summed into a master gain.
+// Used wherever a realistic polyphonic load is needed without the GUI.
+class DemoVoiceBank
+{
+public:
+    DemoVoiceBank(AudioContext& context, unsigned voices);
+
+    DemoVoiceBank(const DemoVoiceBank&) = delete;
+    DemoVoiceBank& operator=(const DemoVoiceBank&) = delete;
+
+    AudioNode* output() { return &master_; }
+    unsigned voiceCount() const { return static_cast<unsigned>(voices_.size()); }
+
+    // Releases every voice once playback passes three quarters of the given length
+    void updateGate(double seconds, double length);
+
+private:
+    std::vector<std::unique_ptr<VoiceNode>> voices_;
+    MixerNode mixer_;
+    GainNode master_;
+    bool released_ = false;
+};
+
+#endif // DEMOPATCH_H
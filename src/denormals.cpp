@@ -0,0 +1,54 @@
+#include "denormals.h"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define SYNTH_DENORMALS_SSE
+#elif defined(__aarch64__) && (defined(__GNUC__) || defined(__clang__))
+#define SYNTH_DENORMALS_AARCH64
+#endif
+
+namespace {
+
+#if defined(SYNTH_DENORMALS_SSE)
+constexpr unsigned long long FLUSH_MODE_BITS = 0x8040; // MXCSR FTZ (bit 15) | DAZ (bit 6)
+#elif defined(SYNTH_DENORMALS_AARCH64)
+constexpr unsigned long long FLUSH_MODE_BITS = 1ull << 24; // FPCR FZ
+#endif
+
+unsigned long long readFloatMode() {
+#if defined(SYNTH_DENORMALS_SSE)
+    return _mm_getcsr();
+#elif defined(SYNTH_DENORMALS_AARCH64)
+    unsigned long long fpcr;
+    __asm__ __volatile__("mrs %0, fpcr" : "=r"(fpcr));
+    return fpcr;
+#else
+    return 0;
+#endif
+}
+
+void writeFloatMode(const unsigned long long mode) {
+#if defined(SYNTH_DENORMALS_SSE)
+    _mm_setcsr(static_cast<unsigned>(mode));
+#elif defined(SYNTH_DENORMALS_AARCH64)
+    __asm__ __volatile__("msr fpcr, %0" : : "r"(mode));
+#else
+    (void)mode;
+#endif
+}
+
+}
+
+ScopedDenormalDisable::ScopedDenormalDisable() : previous_state_(readFloatMode()) {
+    disableForCurrentThread();
+}
+
+ScopedDenormalDisable::~ScopedDenormalDisable() {
+    writeFloatMode(previous_state_);
+}
+
+void ScopedDenormalDisable::disableForCurrentThread() {
+#if defined(SYNTH_DENORMALS_SSE) || defined(SYNTH_DENORMALS_AARCH64)
+    writeFloatMode(readFloatMode() | FLUSH_MODE_BITS);
+#endif
+}
@@ -0,0 +1,41 @@
+#ifndef DENORMALS_H
+#define DENORMALS_H
+
+#include <cmath>
+#include <limits>
+
+// Anything below this is far under audibility; decaying recursive state is snapped to
+// zero before it can drift into the subnormal range.
+constexpr float DENORMAL_SNAP_THRESHOLD = 1e-15f;
+
+// Every Nth output sample is inspected when denormal diagnostics are enabled.
+constexpr unsigned DENORMAL_SAMPLE_STRIDE = 16;
+
+inline bool isDenormal(const float value) {
+    return value != 0.0f && std::fabs(value) < std::numeric_limits<float>::min();
+}
+
+inline float snapToZero(const float value) {
+    return std::fabs(value) < DENORMAL_SNAP_THRESHOLD ? 0.0f : value;
+}
+
+// Enables flush-to-zero / denormals-are-zero on the calling thread for the lifetime
+// of the object and restores the previous floating point mode afterwards.
+// Construct one at the top of every render callback or render thread.
+class ScopedDenormalDisable
+{
+public:
+    ScopedDenormalDisable();
+    ~ScopedDenormalDisable();
+
+    ScopedDenormalDisable(const ScopedDenormalDisable&) = delete;
+    ScopedDenormalDisable& operator=(const ScopedDenormalDisable&) = delete;
+
+    // Sets FTZ/DAZ on the calling thread without restoring it later.
+    static void disableForCurrentThread();
+
+private:
+    unsigned long long previous_state_;
+};
+
+#endif // DENORMALS_H
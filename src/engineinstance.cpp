@@ -0,0 +1,22 @@
+#include "engineinstance.h"
+
+#include <algorithm>
+#include <chrono>
+
+void EngineInstance::render(const unsigned frames) {
+    if (!output_) {
+        return;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+
+    if (block_callback_) {
+        block_callback_(*this, frames);
+    }
+    // the context's batch id is the processing id, so every instance keeps its own
+    output_->process(frames, context_.lastBatch());
+    context_.updateBatch(frames);
+
+    last_render_ns_ = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    peak_render_ns_ = std::max(peak_render_ns_, last_render_ns_);
+}
@@ -0,0 +1,64 @@
+#ifndef ENGINEINSTANCE_H
+#define ENGINEINSTANCE_H
+
+#include "audiocontext.h"
+#include "audionode.h"
+
+#include <functional>
+#include <memory>
+#include <utility>
+
+// One self-contained synth: its own AudioContext, so its own sample clock, batch ids,
+// seed and settings, and the graph built on it. Nothing is shared between instances, so
+// any number of them can live in one process and render on any thread, one block at a
+// time each. EngineScheduler renders many of them on a shared WorkerPool.
+class EngineInstance
+{
+public:
+    // Runs on the render thread before every block, e.g. to play scheduled notes
+    using BlockCallback = std::function<void(EngineInstance& instance, unsigned frames)>;
+
+    EngineInstance(float sample_rate, unsigned frames) : context_(sample_rate, frames) {}
+
+    EngineInstance(const EngineInstance&) = delete;
+    EngineInstance& operator=(const EngineInstance&) = delete;
+
+    AudioContext& context() { return context_; }
+
+    // Builds a graph object owned by this instance, constructed as Graph(context, args...),
+    // and renders its output(). The graph is destroyed before the context it refers to.
+    template<typename Graph, typename... Args>
+    Graph& makeGraph(Args&&... args) {
+        auto graph = std::make_shared<Graph>(context_, std::forward<Args>(args)...);
+        output_ = graph->output();
+        graph_ = graph;
+        return *graph;
+    }
+
+    // For graphs owned elsewhere; they must outlive the instance's use of them
+    void setOutput(AudioNode* output) { output_ = output; }
+    AudioNode* output() const { return output_; }
+
+    void setBlockCallback(BlockCallback callback) { block_callback_ = std::move(callback); }
+
+    // Renders one block and advances this instance's clock. buffer() holds the result
+    // until the next call. Renders nothing when there is no output.
+    void render(unsigned frames);
+    const float* buffer() const { return output_ ? output_->buffer() : nullptr; }
+
+    // wall time of the last render() and the longest one since resetStats()
+    double lastRenderNs() const { return last_render_ns_; }
+    double peakRenderNs() const { return peak_render_ns_; }
+    void resetStats() { last_render_ns_ = peak_render_ns_ = 0.0; }
+
+private:
+    AudioContext context_;
+    std::shared_ptr<void> graph_;
+    AudioNode* output_ = nullptr;
+    BlockCallback block_callback_;
+
+    double last_render_ns_ = 0.0;
+    double peak_render_ns_ = 0.0;
+};
+
+#endif // ENGINEINSTANCE_H
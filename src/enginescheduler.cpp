@@ -0,0 +1,87 @@
+#include "enginescheduler.h"
+#include "engineinstance.h"
+#include "workerpool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+EngineScheduler::EngineScheduler(WorkerPool& pool) : pool_(pool), instances_(new InstanceList()) {}
+
+EngineScheduler::~EngineScheduler() {
+    delete instances_.load();
+}
+
+void EngineScheduler::publish(std::unique_ptr<const InstanceList> instances) {
+    retired_.emplace_back(instances_.exchange(instances.release()));
+}
+
+void EngineScheduler::reclaim() {
+    const InstanceList* in_use = rendering_.load();
+    retired_.erase(std::remove_if(retired_.begin(), retired_.end(),
+                                  [in_use](const std::unique_ptr<const InstanceList>& list) { return list.get() != in_use; }),
+                   retired_.end());
+}
+
+void EngineScheduler::add(EngineInstance* instance) {
+    std::lock_guard<std::mutex> lock(control_mutex_);
+    const InstanceList& current = *instances_.load();
+    if (std::find(current.begin(), current.end(), instance) == current.end()) {
+        auto next = std::make_unique<InstanceList>(current);
+        next->push_back(instance);
+        publish(std::move(next));
+    }
+    reclaim();
+}
+
+void EngineScheduler::remove(EngineInstance* instance) {
+    std::lock_guard<std::mutex> lock(control_mutex_);
+    const InstanceList* current = instances_.load();
+    if (std::find(current->begin(), current->end(), instance) != current->end()) {
+        auto next = std::make_unique<InstanceList>(*current);
+        next->erase(std::remove(next->begin(), next->end(), instance), next->end());
+        publish(std::move(next));
+
+        // a block that started from an older list may still render the instance
+        while (rendering_.load() != nullptr && rendering_.load() != instances_.load()) {
+            std::this_thread::yield();
+        }
+    }
+    reclaim();
+}
+
+unsigned EngineScheduler::instanceCount() {
+    // only control threads replace the list, so it can't be freed under this lock
+    std::lock_guard<std::mutex> lock(control_mutex_);
+    return static_cast<unsigned>(instances_.load()->size());
+}
+
+void EngineScheduler::renderBlock(const unsigned frames, const float sample_rate) {
+    const auto start = std::chrono::steady_clock::now();
+
+    // Marks the list before using it, then checks it is still current: a list replaced
+    // in between may already be freed, so that one is dropped for the new one
+    const InstanceList* instances = instances_.load();
+    rendering_.store(instances);
+    while (instances_.load() != instances) {
+        instances = instances_.load();
+        rendering_.store(instances);
+    }
+
+    const auto count = static_cast<unsigned>(instances->size());
+    if (count > 0) {
+        const unsigned first = rotation_ % count;
+        pool_.run(count, [instances, frames, first, count](unsigned index) {
+            const unsigned slot = first + index;
+            (*instances)[slot < count ? slot : slot - count]->render(frames);
+        });
+        rotation_ = first + 1;
+    }
+    rendering_.store(nullptr);
+
+    last_block_ns_ = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    ++blocks_;
+    if (sample_rate > 0.0f && last_block_ns_ > 1e9 * frames / sample_rate) {
+        ++overruns_;
+    }
+}
@@ -0,0 +1,75 @@
+#ifndef ENGINESCHEDULER_H
+#define ENGINESCHEDULER_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class EngineInstance;
+class WorkerPool;
+
+// Renders a set of independent EngineInstances one block at a time on a shared
+// WorkerPool. Each instance is one task, so instances never wait on each other's
+// graphs. Idle threads take the next instance, which balances heavy and light ones.
+// The starting instance rotates every block, so no instance is always the last to
+// finish and the latency each one sees is spread evenly.
+//
+// The instance list is an immutable snapshot behind an atomic pointer. add() and remove()
+// publish a new one, and renderBlock() marks the one it renders from, so the render path
+// never takes a lock. A replaced snapshot is freed once no block is rendering from it.
+//
+// The instances' MixerNodes must not use the same pool, since WorkerPool::run is not
+// reentrant. One thread renders at a time.
+class EngineScheduler
+{
+public:
+    explicit EngineScheduler(WorkerPool& pool);
+    ~EngineScheduler();
+
+    EngineScheduler(const EngineScheduler&) = delete;
+    EngineScheduler& operator=(const EngineScheduler&) = delete;
+
+    // Safe to call from a control thread while another thread renders; the change
+    // takes effect at the next block. remove() waits for a block in progress to finish,
+    // so the instance can be destroyed once it returns.
+    void add(EngineInstance* instance);
+    void remove(EngineInstance* instance);
+    unsigned instanceCount();
+
+    // Renders one block of every instance and returns once all are done. Counts an
+    // overrun when the whole pass takes longer than the block's playback time at
+    // sample_rate; a sample_rate of 0 disables the check.
+    void renderBlock(unsigned frames, float sample_rate = 0.0f);
+
+    unsigned long long blocksRendered() const { return blocks_; }
+    unsigned long long overruns() const { return overruns_; }
+    double lastBlockNs() const { return last_block_ns_; }
+
+private:
+    using InstanceList = std::vector<EngineInstance*>;
+
+    // swaps in the new list and hands back the old one, which a block may still be using
+    void publish(std::unique_ptr<const InstanceList> instances);
+    // frees the replaced lists no block is rendering from
+    void reclaim();
+
+    WorkerPool& pool_;
+
+    std::atomic<const InstanceList*> instances_;
+    // the list the block in progress renders from, or null between blocks
+    std::atomic<const InstanceList*> rendering_ { nullptr };
+
+    // control threads only
+    std::mutex control_mutex_;
+    std::vector<std::unique_ptr<const InstanceList>> retired_;
+
+    // render thread only
+    unsigned rotation_ = 0;
+
+    unsigned long long blocks_ = 0;
+    unsigned long long overruns_ = 0;
+    double last_block_ns_ = 0.0;
+};
+
+#endif // ENGINESCHEDULER_H
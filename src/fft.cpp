@@ -0,0 +1,50 @@
+#include "fft.h"
+#include "definitions.h"
+
+#include <cmath>
+#include <utility>
+
+void fft(std::vector<std::complex<double>>& data, const bool inverse) {
+    const size_t size = data.size();
+    if (!isPowerOfTwo(size)) {
+        return;
+    }
+
+    // bit reversal permutation
+    for (size_t i = 1, j = 0; i < size; ++i) {
+        size_t bit = size >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+
+        if (i < j) {
+            std::swap(data[i], data[j]);
+        }
+    }
+
+    const double sign = inverse ? 1.0 : -1.0;
+
+    for (size_t length = 2; length <= size; length <<= 1) {
+        const size_t half = length / 2;
+        const double angle = sign * 2.0 * M_PI / static_cast<double>(length);
+
+        for (size_t k = 0; k < half; ++k) {
+            // computed per k rather than by repeated multiplication so large sizes stay exact
+            const std::complex<double> twiddle = std::polar(1.0, angle * static_cast<double>(k));
+            for (size_t start = 0; start < size; start += length) {
+                const std::complex<double> even = data[start + k];
+                const std::complex<double> odd = data[start + k + half] * twiddle;
+                data[start + k] = even + odd;
+                data[start + k + half] = even - odd;
+            }
+        }
+    }
+
+    if (inverse) {
+        const double scale = 1.0 / static_cast<double>(size);
+        for (auto& value : data) {
+            value *= scale;
+        }
+    }
+}
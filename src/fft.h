@@ -0,0 +1,15 @@
+#ifndef FFT_H
+#define FFT_H
+
+#include <complex>
+#include <vector>
+
+// In-place iterative radix-2 FFT over doubles. The size must be a power of two.
+// The inverse transform is scaled by 1/N so fft(fft(x), true) == x.
+void fft(std::vector<std::complex<double>>& data, bool inverse = false);
+
+inline bool isPowerOfTwo(const size_t value) {
+    return value != 0 && (value & (value - 1)) == 0;
+}
+
+#endif // FFT_H
@@ -0,0 +1,76 @@
+#include "fileaudiobackend.h"
+
+#include <algorithm>
+#include <iostream>
+#include <utility>
+
+FileAudioBackend::FileAudioBackend(std::string path, const void* user_data, const double sample_rate,
+                                   const unsigned long frames_per_buffer, const WavWriter::Format format)
+    : AudioBackend(user_data, sample_rate, frames_per_buffer), path_(std::move(path)), format_(format) {}
+
+FileAudioBackend::~FileAudioBackend() {
+    stop();
+}
+
+bool FileAudioBackend::initializeStream() {
+    if (frames_per_buffer_ == 0) {
+        std::cerr << "File backend needs a positive block size\n";
+        return false;
+    }
+
+    if (!writer_.open(path_, static_cast<unsigned>(sample_rate_), CHANNELS, format_)) {
+        return false;
+    }
+
+    buffer_ = std::make_unique<float[]>(frames_per_buffer_ * CHANNELS);
+    return true;
+}
+
+bool FileAudioBackend::start() {
+    if (!writer_.isOpen() || running_) {
+        return false;
+    }
+
+    failed_ = false;
+    running_ = true;
+    worker_ = std::thread(&FileAudioBackend::run, this);
+    return true;
+}
+
+bool FileAudioBackend::stop() {
+    running_ = false;
+    return waitUntilFinished();
+}
+
+bool FileAudioBackend::waitUntilFinished() {
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+
+    const bool closed = writer_.close();
+    return closed && !failed_;
+}
+
+void FileAudioBackend::run() {
+    while (running_) {
+        unsigned long frames = frames_per_buffer_;
+        if (length_frames_ > 0) {
+            const unsigned long long remaining = length_frames_ - frames_written_;
+            if (remaining == 0) {
+                break;
+            }
+            frames = static_cast<unsigned long>(std::min<unsigned long long>(frames, remaining));
+        }
+
+        renderBlock(buffer_.get(), frames);
+
+        if (!writer_.write(buffer_.get(), frames)) {
+            std::cerr << "Failed to write " << path_ << "\n";
+            failed_ = true;
+            break;
+        }
+        frames_written_ += frames;
+    }
+
+    running_ = false;
+}
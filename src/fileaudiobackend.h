@@ -0,0 +1,48 @@
+#ifndef FILEAUDIOBACKEND_H
+#define FILEAUDIOBACKEND_H
+
+#include "audiobackend.h"
+#include "wavwriter.h"
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+
+// Renders the graph into a WAV file from its own thread as fast as the CPU allows.
+// With a length set the render stops on its own; otherwise it runs until stop().
+class FileAudioBackend : public AudioBackend {
+
+public:
+    explicit FileAudioBackend(std::string path, const void* user_data = nullptr, double sample_rate = 44100.0,
+                              unsigned long frames_per_buffer = 256, WavWriter::Format format = WavWriter::Format::Float32);
+    ~FileAudioBackend() override;
+
+    bool initializeStream() override;
+    bool start() override;
+    bool stop() override;
+
+    // 0 renders until stop() is called
+    void setLengthFrames(unsigned long long frames) { length_frames_ = frames; }
+
+    // Blocks until a render with a set length has finished and the file is closed
+    bool waitUntilFinished();
+
+    unsigned long long framesWritten() const { return frames_written_.load(); }
+
+private:
+    void run();
+
+    std::string path_;
+    WavWriter::Format format_;
+    WavWriter writer_;
+
+    unsigned long long length_frames_ = 0;
+    std::unique_ptr<float[]> buffer_;
+    std::thread worker_;
+    std::atomic<bool> running_ { false };
+    std::atomic<bool> failed_ { false };
+    std::atomic<unsigned long long> frames_written_ { 0 };
+};
+
+#endif // FILEAUDIOBACKEND_H
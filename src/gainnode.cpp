@@ -38,10 +38,9 @@ void GainNode::processInternal(const unsigned frames) {
 
     const float* input_buffer = input_->buffer();
     const float* gain_buffer = gain_automation_.buffer();
-    const float base_gain = gain_automation_.baseValue();
 
     for (unsigned int i = 0; i < frames; i++) {
-        const float gain = std::max(0.0f, base_gain + gain_buffer[i]);
+        const float gain = std::max(0.0f, gain_buffer[i]);
         buffer_[i] = input_buffer[i] * gain;
     }
 }
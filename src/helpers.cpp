@@ -1,6 +1,6 @@
+#include "helpers.h"
 
-
-#include <qobject.h>
+#include <cmath>
 
 QString formatNumberPrefix(double number) {
 
@@ -2,7 +2,7 @@
 #define HELPERS_H
 
 
-#include <QObject.h>
+#include <QString>
 
 QString formatNumberPrefix(double number);
 
@@ -1,11 +1,21 @@
 #include "knobcontrol.h"
+#include <QElapsedTimer>
+#include <QLoggingCategory>
 #include <QPainter>
 #include <QMouseEvent>
 #include <QtMath>
 
+namespace {
+
+// off unless enabled, e.g. QT_LOGGING_RULES="synth.knob.paint.debug=true"; reports each
+// drag's repaint count and paint time when the button is released
+Q_LOGGING_CATEGORY(knobPaintLog, "synth.knob.paint", QtWarningMsg)
+
+}
+
 KnobControl::KnobControl(QWidget *parent)
     : QWidget{parent}, dragging_(false), minimum_value_(0.0), maximum_value_(100.0),
-      current_value_(0.0), _spritesheet(nullptr)
+      current_value_(0.0), frame_(-1), _spritesheet(nullptr)
 {
     setMinimumSize(50, 50);
     setMouseTracking(true);  // Enable mouse tracking to detect hover
@@ -30,38 +40,61 @@ void KnobControl::setValue(double value) {
 }
 
 void KnobControl::setSpriteSheet(std::shared_ptr<SpriteSheet> spriteSheet) {
+    disconnect(sheet_connection_);
     _spritesheet = spriteSheet;
-    updateImage();
+
+    // a sheet loaded after it was set shows without waiting for the value to move
+    if(_spritesheet) {
+        sheet_connection_ = connect(_spritesheet.get(), &SpriteSheet::changed, this, &KnobControl::refreshFrame);
+    }
+    refreshFrame();
 }
 
 void KnobControl::paintEvent(QPaintEvent *event) {
     Q_UNUSED(event);
 
-    if(!_spritesheet || _spritesheet->croppedImages().isEmpty()) return;
+    if(!_spritesheet || frame_ < 0) return;
+
+    const bool measuring = dragging_ && knobPaintLog().isDebugEnabled();
+    QElapsedTimer timer;
+    if(measuring) timer.start();
 
     QPainter painter(this);
+    _spritesheet->drawFrame(painter, rect(), frame_);
+
+    if(measuring) {
+        painter.end();
+        const qint64 elapsed = timer.nsecsElapsed();
+        ++drag_repaints_;
+        drag_paint_ns_ += elapsed;
+        drag_worst_paint_ns_ = qMax(drag_worst_paint_ns_, elapsed);
+    }
+}
+
+int KnobControl::frameIndex() const {
+    if(!_spritesheet || _spritesheet->frameCount() == 0) return -1;
 
     // Calculate the mapped value and find the corresponding frame
-    double mappedValue = (current_value_ - minimum_value_) / (maximum_value_ - minimum_value_);
-    int spriteCount = _spritesheet->croppedImages().size();
-    int index = qBound(0, qFloor(mappedValue * spriteCount), spriteCount - 1);
-
-    // Draw the sprite image
-    if(index >= 0 && index < _spritesheet->croppedImages().size()) {
-        QPixmap sprite = _spritesheet->croppedImages()[index];
-        painter.drawPixmap(rect(), sprite);
-    }
+    double range = maximum_value_ - minimum_value_;
+    double mappedValue = range > 0.0 ? (current_value_ - minimum_value_) / range : 0.0;
+    int spriteCount = _spritesheet->frameCount();
+    return qBound(0, qFloor(mappedValue * spriteCount), spriteCount - 1);
 }
 
 void KnobControl::mousePressEvent(QMouseEvent *event) {
     dragging_ = true;
     last_mouse_position_ = event->pos();
+    drag_moves_ = 0;
+    drag_repaints_ = 0;
+    drag_paint_ns_ = 0;
+    drag_worst_paint_ns_ = 0;
     event->accept();
 }
 
 
 void KnobControl::mouseMoveEvent(QMouseEvent *event) {
     if(!dragging_) return;
+    ++drag_moves_;
 
     // Calculate knob value based on mouse movement
     QPoint delta = event->pos() - last_mouse_position_;
@@ -79,12 +112,29 @@ void KnobControl::mouseMoveEvent(QMouseEvent *event) {
 }
 
 void KnobControl::mouseReleaseEvent(QMouseEvent *event) {
+    if(dragging_ && drag_moves_ > 0) {
+        qCDebug(knobPaintLog) << "Knob drag:" << drag_moves_ << "moves," << drag_repaints_ << "repaints, mean"
+                              << (drag_repaints_ > 0 ? drag_paint_ns_ / drag_repaints_ / 1000.0 : 0.0)
+                              << "us, worst" << drag_worst_paint_ns_ / 1000.0 << "us";
+    }
+
     dragging_ = false;
     event->accept();
 }
 
 void KnobControl::updateImage() {
-    update();  // Trigger a repaint
+    // a drag moves the value by far less than a frame; only a new frame needs a repaint
+    const int frame = frameIndex();
+    if(frame == frame_) return;
+
+    frame_ = frame;
+    update();
+}
+
+void KnobControl::refreshFrame() {
+    // the frame index may be the same while the image behind it is not
+    frame_ = frameIndex();
+    update();
 }
 
 void KnobControl::wheelEvent(QWheelEvent *event) {
@@ -40,6 +40,9 @@ protected:
 
 private:
     void updateImage();
+    // picks the frame again and repaints, for a sheet that was set, loaded or changed
+    void refreshFrame();
+    int frameIndex() const;
 
 private:
     bool dragging_;
@@ -48,8 +51,17 @@ private:
     double minimum_value_;
     double maximum_value_;
     double current_value_;
+    // sprite frame on screen, -1 for none
+    int frame_;
 
     std::shared_ptr<SpriteSheet> _spritesheet;
+    QMetaObject::Connection sheet_connection_;
+
+    // repaints during the current drag, counted while synth.knob.paint debug is on
+    int drag_moves_ = 0;
+    int drag_repaints_ = 0;
+    qint64 drag_paint_ns_ = 0;
+    qint64 drag_worst_paint_ns_ = 0;
 
 };
 
@@ -0,0 +1,104 @@
+#include "levelmeter.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define SYNTH_LEVELMETER_SSE
+#endif
+
+static_assert(std::atomic<float>::is_always_lock_free, "LevelMeter needs lock-free atomic floats");
+
+namespace {
+
+// independent accumulators, as many as a 256-bit register holds floats
+constexpr unsigned LANES = 8;
+
+}
+
+LevelMeter::LevelMeter(const float sample_rate, const float release_seconds)
+    : release_frames_(std::max(1.0f, sample_rate * release_seconds)) {}
+
+void LevelMeter::measure(const float* samples, const unsigned frames) {
+    if (samples == nullptr || frames == 0) {
+        return;
+    }
+
+    // one accumulator per lane, so neither reduction has a loop-carried dependency
+    float peaks[LANES] = {};
+    float squares[LANES] = {};
+    unsigned i = 0;
+#if defined(SYNTH_LEVELMETER_SSE)
+    // compilers keep the portable loop below scalar, so the eight lanes are spelled out
+    // as two SSE registers each
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    __m128 peak_low = _mm_setzero_ps();
+    __m128 peak_high = _mm_setzero_ps();
+    __m128 squares_low = _mm_setzero_ps();
+    __m128 squares_high = _mm_setzero_ps();
+    for (; i + LANES <= frames; i += LANES) {
+        const __m128 low = _mm_loadu_ps(samples + i);
+        const __m128 high = _mm_loadu_ps(samples + i + 4);
+        peak_low = _mm_max_ps(peak_low, _mm_andnot_ps(sign, low));
+        peak_high = _mm_max_ps(peak_high, _mm_andnot_ps(sign, high));
+        squares_low = _mm_add_ps(squares_low, _mm_mul_ps(low, low));
+        squares_high = _mm_add_ps(squares_high, _mm_mul_ps(high, high));
+    }
+    _mm_storeu_ps(peaks, peak_low);
+    _mm_storeu_ps(peaks + 4, peak_high);
+    _mm_storeu_ps(squares, squares_low);
+    _mm_storeu_ps(squares + 4, squares_high);
+#else
+    for (; i + LANES <= frames; i += LANES) {
+        for (unsigned lane = 0; lane < LANES; ++lane) {
+            const float sample = samples[i + lane];
+            peaks[lane] = std::max(peaks[lane], std::fabs(sample));
+            squares[lane] += sample * sample;
+        }
+    }
+#endif
+    for (unsigned lane = 0; i < frames; ++i, ++lane) {
+        const float magnitude = std::fabs(samples[i]);
+        peaks[lane] = std::max(peaks[lane], magnitude);
+        squares[lane] += samples[i] * samples[i];
+    }
+
+    float block_peak = 0.0f;
+    float block_squares = 0.0f;
+    for (unsigned lane = 0; lane < LANES; ++lane) {
+        block_peak = std::max(block_peak, peaks[lane]);
+        block_squares += squares[lane];
+    }
+
+    // a NaN or infinity would stay in the smoothed RMS for good, and the SSE max drops a
+    // NaN depending on its lane, so only the sum of squares is sure to carry one
+    if (!std::isfinite(block_squares) || !std::isfinite(block_peak)) {
+        held_peak_ = 0.0f;
+        mean_square_ = 0.0f;
+        peak_.store(held_peak_, std::memory_order_relaxed);
+        published_mean_square_.store(mean_square_, std::memory_order_relaxed);
+        return;
+    }
+
+    // once per block, so the exp is cheap next to the pass above
+    const float decay = std::exp(-static_cast<float>(frames) / release_frames_);
+    held_peak_ = std::max(block_peak, held_peak_ * decay);
+    const float block_mean_square = block_squares / static_cast<float>(frames);
+    mean_square_ = block_mean_square + (mean_square_ - block_mean_square) * decay;
+
+    // a silent path settles on zero instead of decaying into denormals
+    if (held_peak_ < 1e-9f) {
+        held_peak_ = 0.0f;
+    }
+    if (mean_square_ < 1e-18f) {
+        mean_square_ = 0.0f;
+    }
+
+    peak_.store(held_peak_, std::memory_order_relaxed);
+    published_mean_square_.store(mean_square_, std::memory_order_relaxed);
+}
+
+float LevelMeter::rms() const {
+    return std::sqrt(published_mean_square_.load(std::memory_order_relaxed));
+}
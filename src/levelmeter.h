@@ -0,0 +1,46 @@
+#ifndef LEVELMETER_H
+#define LEVELMETER_H
+
+#include <atomic>
+
+// Peak and RMS level of a node's output, measured on the audio thread and read from any
+// other, e.g. to light up the cables of a patch panel.
+//
+// AudioNode::process() calls measure() after each block when a meter is attached with
+// AudioNode::setMeter(). One pass over the block finds its peak and sum of squares, in
+// eight independent lanes: SSE max and add instructions where available, plain floats
+// elsewhere.
+// The shown peak holds and falls back over the release time, and the RMS is smoothed
+// over it, so a reader polling once per display frame misses no burst. Both are
+// published with relaxed atomic stores; nothing blocks or allocates.
+//
+// A meter only moves when its node renders; a node outside the graph's schedule keeps
+// its last level.
+class LevelMeter
+{
+public:
+    // release_seconds: time for the shown peak and RMS to fall to 1/e after the signal stops
+    explicit LevelMeter(float sample_rate, float release_seconds = 0.3f);
+
+    LevelMeter(const LevelMeter&) = delete;
+    LevelMeter& operator=(const LevelMeter&) = delete;
+
+    // Audio thread
+    void measure(const float* samples, unsigned frames);
+
+    // Any thread. Linear, 1.0 being full scale.
+    float peak() const { return peak_.load(std::memory_order_relaxed); }
+    float rms() const;
+
+private:
+    float release_frames_;
+
+    // audio thread only
+    float held_peak_ = 0.0f;
+    float mean_square_ = 0.0f;
+
+    std::atomic<float> peak_ { 0.0f };
+    std::atomic<float> published_mean_square_ { 0.0f };
+};
+
+#endif // LEVELMETER_H
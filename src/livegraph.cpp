@@ -0,0 +1,221 @@
+#include "livegraph.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+namespace {
+
+std::int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+}
+
+LiveGraph::LiveGraph(AudioContext& context, const NodeRegistry& registry, const std::size_t arena_bytes,
+                     const unsigned max_nodes, const unsigned queue_capacity, const unsigned max_edges)
+    : context_(context), graph_(context, registry, arena_bytes, max_nodes, max_edges), shadow_(max_nodes, max_edges),
+      queue_(queue_capacity) {}
+
+int LiveGraph::addNode(const std::string& type) {
+    const int node = graph_.addNode(type);
+    if (node >= 0) {
+        shadow_.addNode();
+    }
+    return node;
+}
+
+bool LiveGraph::setOutput(const unsigned node) {
+    return graph_.setOutput(node);
+}
+
+bool LiveGraph::send(GraphCommand command) {
+    if (queue_.full()) {
+        std::cerr << "Graph command queue is full\n";
+        return false;
+    }
+    command.sent_ns = nowNs();
+    command.sent_batch = context_.lastBatch();
+    queue_.push(command);
+    return true;
+}
+
+bool LiveGraph::connect(const unsigned from, const unsigned to, const unsigned port) {
+    // the node list only changes during setup, so graph_ is safe to read for it here
+    if (from >= graph_.nodeCount() || to >= graph_.nodeCount()) {
+        std::cerr << "Cable between nodes " << from << " and " << to << ", the graph has " << graph_.nodeCount() << "\n";
+        return false;
+    }
+    const NodeType* type = graph_.nodeType(to);
+    if (port != PATCH_INPUT_PORT && port >= type->ports.size()) {
+        std::cerr << type->name << " has no port " << port << "\n";
+        return false;
+    }
+    if (queue_.full()) {
+        std::cerr << "Graph command queue is full\n";
+        return false;
+    }
+
+    const bool exclusive = port != PATCH_INPUT_PORT || !type->add_input;
+    if (!hasRoom(from, to, port, exclusive)) {
+        std::cerr << "Node " << from << " or node " << to << " already has " << shadow_.edgeCapacity() << " cables\n";
+        return false;
+    }
+    if (!shadow_.connectInput(from, to, port, exclusive)) {
+        std::cerr << "Connecting node " << from << " to node " << to << " would close a feedback loop\n";
+        return false;
+    }
+    return send({ GraphCommand::Type::Connect, from, to, port });
+}
+
+bool LiveGraph::hasRoom(const unsigned from, const unsigned to, const unsigned port, const bool exclusive) const {
+    bool replacing = false;
+    for (const ProcessingOrder::Edge& edge : shadow_.inputs(to)) {
+        if (edge.tag != port) {
+            continue;
+        }
+        if (edge.node == from) {
+            // already connected, so nothing changes
+            return true;
+        }
+        replacing = replacing || exclusive;
+    }
+
+    // a replaced cable leaves `to` with as many as before
+    const unsigned capacity = shadow_.edgeCapacity();
+    return shadow_.outputs(from).size() < capacity && (replacing || shadow_.inputs(to).size() < capacity);
+}
+
+bool LiveGraph::disconnect(const unsigned from, const unsigned to, const unsigned port) {
+    if (from >= graph_.nodeCount() || to >= graph_.nodeCount()) {
+        std::cerr << "Cable between nodes " << from << " and " << to << ", the graph has " << graph_.nodeCount() << "\n";
+        return false;
+    }
+    if (queue_.full()) {
+        std::cerr << "Graph command queue is full\n";
+        return false;
+    }
+    if (!shadow_.removeEdge(from, to, port)) {
+        std::cerr << "Node " << from << " isn't connected to node " << to << "\n";
+        return false;
+    }
+    return send({ GraphCommand::Type::Disconnect, from, to, port });
+}
+
+bool LiveGraph::setParameter(const unsigned node, const unsigned parameter, const float value) {
+    if (node >= graph_.nodeCount()) {
+        std::cerr << "Parameter for node " << node << ", the graph has " << graph_.nodeCount() << "\n";
+        return false;
+    }
+    const NodeType* type = graph_.nodeType(node);
+    if (parameter >= type->parameters.size()) {
+        std::cerr << type->name << " has no parameter " << parameter << "\n";
+        return false;
+    }
+    const unsigned choices = type->choiceCount(parameter);
+    if (choices > 0 && !(value >= 0.0f && value < static_cast<float>(choices))) {
+        std::cerr << type->name << " " << type->parameters[parameter].name << " is out of range\n";
+        return false;
+    }
+    return send({ GraphCommand::Type::SetParameter, 0, node, parameter, value });
+}
+
+bool LiveGraph::setParameter(const unsigned node, const std::string& parameter, const float value) {
+    if (node >= graph_.nodeCount()) {
+        std::cerr << "Parameter for node " << node << ", the graph has " << graph_.nodeCount() << "\n";
+        return false;
+    }
+    const int index = graph_.nodeType(node)->parameterIndex(parameter);
+    if (index < 0) {
+        std::cerr << graph_.nodeType(node)->name << " has no parameter " << parameter << "\n";
+        return false;
+    }
+    return setParameter(node, static_cast<unsigned>(index), value);
+}
+
+bool LiveGraph::setTap(const unsigned node, SignalTap* tap) {
+    if (node >= graph_.nodeCount()) {
+        std::cerr << "Tap on node " << node << ", the graph has " << graph_.nodeCount() << "\n";
+        return false;
+    }
+    graph_.node(node)->setTap(tap);
+    return true;
+}
+
+bool LiveGraph::setMeter(const unsigned node, LevelMeter* meter) {
+    if (node >= graph_.nodeCount()) {
+        std::cerr << "Meter on node " << node << ", the graph has " << graph_.nodeCount() << "\n";
+        return false;
+    }
+    graph_.node(node)->setMeter(meter);
+    return true;
+}
+
+void LiveGraph::apply(const GraphCommand& command) {
+    // checked against shadow_ when sent, so these can't fail here
+    switch (command.type) {
+    case GraphCommand::Type::Connect:
+        graph_.connect(command.from, command.to, command.port);
+        break;
+    case GraphCommand::Type::Disconnect:
+        graph_.disconnect(command.from, command.to, command.port);
+        break;
+    case GraphCommand::Type::SetParameter:
+        graph_.nodeType(command.to)->set_parameter(graph_.node(command.to), command.port, command.value);
+        break;
+    }
+}
+
+void LiveGraph::process(const unsigned frames) {
+    applyPending();
+    graph_.render(frames, context_.lastBatch());
+}
+
+void LiveGraph::applyPending() {
+    GraphCommand command;
+    if (!queue_.pop(command)) {
+        return;
+    }
+
+    const std::int64_t start = nowNs();
+    // only this thread writes the stats, so plain load and store is enough
+    unsigned long long applied = commands_applied_.load(std::memory_order_relaxed);
+    double total = total_latency_ns_.load(std::memory_order_relaxed);
+    double longest = max_latency_ns_.load(std::memory_order_relaxed);
+    unsigned waited = max_blocks_waited_.load(std::memory_order_relaxed);
+    do {
+        apply(command);
+        const double latency = static_cast<double>(nowNs() - command.sent_ns);
+        ++applied;
+        total += latency;
+        longest = std::max(longest, latency);
+        waited = std::max(waited, context_.lastBatch() - command.sent_batch);
+    } while (queue_.pop(command));
+
+    commands_applied_.store(applied, std::memory_order_relaxed);
+    total_latency_ns_.store(total, std::memory_order_relaxed);
+    max_latency_ns_.store(longest, std::memory_order_relaxed);
+    max_blocks_waited_.store(waited, std::memory_order_relaxed);
+    const double apply_ns = static_cast<double>(nowNs() - start);
+    if (apply_ns > max_apply_ns_.load(std::memory_order_relaxed)) {
+        max_apply_ns_.store(apply_ns, std::memory_order_relaxed);
+    }
+}
+
+const float* LiveGraph::buffer() const {
+    return graph_.output() ? graph_.output()->buffer() : nullptr;
+}
+
+double LiveGraph::meanLatencyNs() const {
+    const unsigned long long applied = commands_applied_.load(std::memory_order_relaxed);
+    return applied > 0 ? total_latency_ns_.load(std::memory_order_relaxed) / static_cast<double>(applied) : 0.0;
+}
+
+void LiveGraph::resetStats() {
+    commands_applied_.store(0, std::memory_order_relaxed);
+    total_latency_ns_.store(0.0, std::memory_order_relaxed);
+    max_latency_ns_.store(0.0, std::memory_order_relaxed);
+    max_apply_ns_.store(0.0, std::memory_order_relaxed);
+    max_blocks_waited_.store(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,120 @@
+#ifndef LIVEGRAPH_H
+#define LIVEGRAPH_H
+
+#include "patchgraph.h"
+#include "processingorder.h"
+#include "spscqueue.h"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// A change to a running graph, sent from a control thread to the audio thread
+struct GraphCommand
+{
+    enum class Type : std::uint8_t { Connect, Disconnect, SetParameter };
+
+    Type type = Type::Connect;
+    unsigned from = 0;
+    // node the cable goes to, or whose parameter is set
+    unsigned to = 0;
+    // automation port or PATCH_INPUT_PORT, or the parameter index
+    unsigned port = PATCH_INPUT_PORT;
+    float value = 0.0f;
+    // steady clock and batch id at send time, for latency
+    std::int64_t sent_ns = 0;
+    unsigned sent_batch = 0;
+};
+
+// A PatchGraph that is repatched while it plays, e.g. from cables dropped on a patch panel.
+//
+// The nodes are added up front, before the stream starts. After that a control thread
+// calls connect(), disconnect() and setParameter(), which check the edit and queue it on
+// a lock-free SpscQueue; nothing waits on the audio thread. process(), on the audio
+// thread, applies everything queued at the start of the block and then renders it, so
+// an edit is heard from the first block that starts after it was made. An audio thread
+// that idles between blocks can also call applyPending() while it waits.
+//
+// The control thread keeps its own copy of the processing order to check edits against,
+// so a cable that would close a feedback loop is refused right away rather than from the
+// audio thread. The same goes for a cable past max_edges into or out of a node: the
+// audio thread's edge lists and mixer inputs are reserved to that many when the node is
+// added, so applying an edit never allocates. One control thread and one audio thread;
+// nodes can't be added while audio runs.
+class LiveGraph
+{
+public:
+    static constexpr unsigned DEFAULT_QUEUE_CAPACITY = 1024;
+    // enough for a mixer taking a few dozen voices
+    static constexpr unsigned DEFAULT_MAX_EDGES = 64;
+
+    explicit LiveGraph(AudioContext& context, const NodeRegistry& registry = NodeRegistry::builtin(),
+                       std::size_t arena_bytes = PatchGraph::DEFAULT_ARENA_BYTES,
+                       unsigned max_nodes = PatchGraph::DEFAULT_MAX_NODES,
+                       unsigned queue_capacity = DEFAULT_QUEUE_CAPACITY,
+                       unsigned max_edges = DEFAULT_MAX_EDGES);
+
+    LiveGraph(const LiveGraph&) = delete;
+    LiveGraph& operator=(const LiveGraph&) = delete;
+
+    // Setup, before audio runs. Same as PatchGraph.
+    int addNode(const std::string& type);
+    bool setOutput(unsigned node);
+
+    // Control thread. Each fails with a message on std::cerr when the edit is invalid, the
+    // queue is full or a node has no room for another cable, and then nothing is sent.
+    bool connect(unsigned from, unsigned to, unsigned port = PATCH_INPUT_PORT);
+    bool disconnect(unsigned from, unsigned to, unsigned port = PATCH_INPUT_PORT);
+    bool setParameter(unsigned node, unsigned parameter, float value);
+    bool setParameter(unsigned node, const std::string& parameter, float value);
+    // Attaches a tap to a node's output, or detaches it with nullptr; see
+    // AudioNode::setTap() for how long the tap must live. Not queued: the node reads
+    // the pointer at the end of its next block.
+    bool setTap(unsigned node, SignalTap* tap);
+    // Same for a level meter; see AudioNode::setMeter()
+    bool setMeter(unsigned node, LevelMeter* meter);
+
+    // Audio thread. Applies the queued edits, then renders one block under the context's
+    // batch id; the caller advances the context afterwards.
+    void process(unsigned frames);
+    // Audio thread. Applies the queued edits without rendering, for an audio thread that
+    // waits between blocks: calling it while it waits picks edits up as they arrive rather
+    // than at the next block. process() starts with it.
+    void applyPending();
+    const float* buffer() const;
+
+    // Wall-clock time from an edit being sent to it being applied, from which point every
+    // block renders with it. Readable from any thread.
+    unsigned long long commandsApplied() const { return commands_applied_.load(std::memory_order_relaxed); }
+    double meanLatencyNs() const;
+    double maxLatencyNs() const { return max_latency_ns_.load(std::memory_order_relaxed); }
+    // Most blocks started between an edit being sent and it being applied: 0 when
+    // applyPending() picked it up between blocks, 1 when the next block's process() did
+    unsigned maxBlocksWaited() const { return max_blocks_waited_.load(std::memory_order_relaxed); }
+    // longest time one applyPending() spent applying edits
+    double maxApplyNs() const { return max_apply_ns_.load(std::memory_order_relaxed); }
+    void resetStats();
+
+    // the graph itself; only for setup and for reading once audio has stopped
+    const PatchGraph& graph() const { return graph_; }
+
+private:
+    bool send(GraphCommand command);
+    // whether connecting from to `to` stays within the edge capacity of both
+    bool hasRoom(unsigned from, unsigned to, unsigned port, bool exclusive) const;
+    void apply(const GraphCommand& command);
+
+    AudioContext& context_;
+    PatchGraph graph_;
+    // the control thread's copy of graph_'s order, ahead of it by the queued edits
+    ProcessingOrder shadow_;
+    SpscQueue<GraphCommand> queue_;
+
+    std::atomic<unsigned long long> commands_applied_ { 0 };
+    std::atomic<double> total_latency_ns_ { 0.0 };
+    std::atomic<double> max_latency_ns_ { 0.0 };
+    std::atomic<double> max_apply_ns_ { 0.0 };
+    std::atomic<unsigned> max_blocks_waited_ { 0 };
+};
+
+#endif // LIVEGRAPH_H
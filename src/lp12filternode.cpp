@@ -1,11 +1,27 @@
 ﻿#include "lp12filternode.h"
 
 #include "definitions.h"
+#include "denormals.h"
+#include <algorithm>
 #include <cmath>
 #include <limits>
 #include <memory>
 #include <cstring>
 
+namespace {
+
+// Below about 0.5 the resonance term no longer keeps the pole radius under 1 at low
+// cutoffs and the filter blows up; the GUI knob goes down to 0, and modulation can go anywhere
+constexpr float MIN_RESONANCE = 0.6f;
+constexpr float MAX_RESONANCE = 100.0f;
+constexpr float MIN_CUTOFF = 5.0f;
+// as a fraction of the sample rate, keeping w clear of pi
+constexpr float MAX_CUTOFF_RATIO = 0.49f;
+// deterministic mode snaps the state on this grid of the context's sample clock, a power of two
+constexpr unsigned long long DETERMINISTIC_SNAP_INTERVAL = 64;
+
+}
+
 LP12FilterNode::LP12FilterNode(AudioContext& context, float initial_cutoff, float initial_resonance, float initial_detune) : AudioNode(context),
     cutoff_automation_(context, initial_cutoff), resonance_automation_(context, initial_resonance), detune_automation_(context,initial_detune),
     previous_cutoff_(initial_cutoff), previous_resonance_(initial_resonance), previous_detune_(initial_detune) {
@@ -13,6 +29,12 @@ LP12FilterNode::LP12FilterNode(AudioContext& context, float initial_cutoff, floa
     calculateCoefficients(initial_cutoff, initial_resonance, initial_detune);
 }
 
+void LP12FilterNode::transferState(const AudioNode& other) {
+    const auto& filter = static_cast<const LP12FilterNode&>(other);
+    vibra_speed_ = filter.vibra_speed_;
+    vibra_pos_ = filter.vibra_pos_;
+}
+
 // void LP12FilterNode::setCutoff(float cutoff) {
 // 	cutoff_automation_.setStaticValue(cutoff);
 // }
@@ -92,9 +114,12 @@ void LP12FilterNode::calculateCoefficients(float cutoff, float resonance, float
 
 	constexpr float pi2 = TWO_PI;
 
+    const float sample_rate = context_.sampleRate();
     float detunedCutoff = cutoff * std::pow(2.0f, detune / 1200.0f);
+    detunedCutoff = std::min(std::max(detunedCutoff, MIN_CUTOFF), MAX_CUTOFF_RATIO * sample_rate);
+    resonance = std::min(std::max(resonance, MIN_RESONANCE), MAX_RESONANCE);
 
-    w_ = pi2 * detunedCutoff / context_.sampleRate();
+    w_ = pi2 * detunedCutoff / sample_rate;
 	q_ = 1.0f - w_ / (2 * (resonance + 0.5f / (1.0f + w_)) + w_ - 2);
 	r_ = q_ * q_;
 	c_ = r_ + 1.0f - 2.0f * static_cast<float>(cos(w_)) * q_;
@@ -120,11 +145,16 @@ void LP12FilterNode::processInternal(unsigned frames) {
     const float* resonance_buffer = resonance_automation_.buffer();
     const float* detune_buffer = detune_automation_.buffer();
 
+    // snapping at the end of each block would make the output depend on where the blocks
+    // fall, so deterministic mode snaps at fixed positions of the sample clock instead
+    const bool snap_on_clock = context_.deterministic();
+    const unsigned long long first_sample = context_.samplePosition();
+
 	for(unsigned int i = 0; i < frames; ++i) {
 
-        const float current_cutoff = cutoff_automation_.baseValue() + cutoff_buffer[i];
-        const float current_resonance = resonance_automation_.baseValue() + resonance_buffer[i];
-        const float current_detune = detune_automation_.baseValue() + detune_buffer[i];
+        const float current_cutoff = cutoff_buffer[i];
+        const float current_resonance = resonance_buffer[i];
+        const float current_detune = detune_buffer[i];
 
 		// Recalculate coefficients for the current frame if cutoff or resonance has changed
         if(std::fabs(previous_cutoff_ - current_cutoff) > std::numeric_limits<float>::epsilon() ||
@@ -145,11 +175,25 @@ void LP12FilterNode::processInternal(unsigned frames) {
 		vibra_pos_ += vibra_speed_;
 
 		vibra_speed_ *= r_;
+        if (snap_on_clock && ((first_sample + i + 1) & (DETERMINISTIC_SNAP_INTERVAL - 1)) == 0) {
+            vibra_speed_ = snapToZero(vibra_speed_);
+            vibra_pos_ = snapToZero(vibra_pos_);
+        }
 		buffer_[i] = vibra_pos_;
 	}
 
+    // once the input has gone quiet the resonator decays geometrically toward zero;
+    // snap the tail so the recursion never runs on subnormal state
+    if (!snap_on_clock) {
+        vibra_speed_ = snapToZero(vibra_speed_);
+        vibra_pos_ = snapToZero(vibra_pos_);
+    }
 
-
+    // a NaN or Inf on the input would otherwise latch into the state forever
+    if (!std::isfinite(vibra_speed_) || !std::isfinite(vibra_pos_)) {
+        vibra_speed_ = 0.0f;
+        vibra_pos_ = 0.0f;
+    }
 }
 
 
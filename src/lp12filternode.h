@@ -19,6 +19,8 @@ public:
     inline void setResonance(float resonance) { resonance_automation_.setBaseValue(resonance); }
     inline void setDetune(float detune) { detune_automation_.setBaseValue(detune); }
 
+    void transferState(const AudioNode& other) override;
+
 protected:
 	void processInternal(unsigned frames) override;
     void addAutomation(AudioNode* node, unsigned port) override;
@@ -1,16 +1,12 @@
 
 #include "audioplayer.h"
-#include "gainnode.h"
-#include "lp12filternode.h"
+#include "demopatch.h"
 #include "mainwindow.h"
 #include "mainwindow_cable.h"
-#include "muladdnode.h"
 #include <iostream>
 #include <ostream>
 #include <QApplication.h>
 
-#include "oscillatornode.h"
-
 
 int showMainWindow(int argc, char *argv[]) {
     QApplication a(argc, argv);
@@ -35,58 +31,10 @@ int showConsole(int argc, char* argv[]) {
 
     AudioPlayer m_audioPlayer(nullptr, SAMPLE_RATE, FRAMES);
 
-    GainNode modOscillatorGain1(context, .7);
-    GainNode modOscillatorGain2(context, .3);
-
-    GainNode filterModGain(context, .9);
-    OscillatorNode oscillator1(context, wave_shape::sawtooth, 165);
-    OscillatorNode oscillator2(context, wave_shape::sawtooth, 110);
-
-    OscillatorNode lfo(context, wave_shape::sine, 2);
-    MulAddNode lfoMA(context, 10, 100);
-    MulAddNode filterMA(context, 900, 1000);
-
-    LP12FilterNode filter(context, 440);
-    LP12FilterNode filter2(context, 440);
-    GainNode gainVolume(context, .5);
-    MixerNode filter_mixer(context);
-
-    GainNode oscillator1Gain(context, .4);
-    GainNode oscillator2Gain(context, .4);
-
-    GainNode envelopeVolume(context, .1);
-
-    ADSRNode adsr(context, .2, .1, .8, .1);
-
-    lfo.connect(&lfoMA);
-    lfoMA.connect(&modOscillatorGain1);
-    lfoMA.connect(&modOscillatorGain2);
-    lfo.connect(&filterMA);
-
-    filterMA.connect(&filterModGain);
-
-    oscillator1.connect(&oscillator1Gain);
-    oscillator2.connect(&oscillator2Gain);
-
-    filter_mixer.addInput(&oscillator1Gain, 1);
-    filter_mixer.addInput(&oscillator2Gain, 1);
-    filter_mixer.connect(&filter);
-    filter.connect(&filter2);
-    filter2.connect(&gainVolume);
-
-    modOscillatorGain1.automate(&oscillator1, OscillatorNode::Parameters::Frequency);
-    modOscillatorGain2.automate(&oscillator2, OscillatorNode::Parameters::Frequency);
-
-    filterModGain.automate(&filter, LP12FilterNode::Parameters::Cutoff);
-    filterModGain.automate(&filter2, LP12FilterNode::Parameters::Cutoff);
-
-    adsr.automate(&gainVolume, GainNode::Parameters::Gain);
-
-    adsr.setGate(true);
+    DemoPatch patch(context);
 
     //gainVolume.gain()->linearRampValueAtTime(1, 1.2);
 
-    //adsr.automate(&gainVolume, GainNode::Parameters::Gain);
     // auto voiceNode = VoiceNode::Builder(context)
     //                     .setModFrequency(5)
     //                     .setOscillator1Frequency(440)
@@ -98,14 +46,13 @@ int showConsole(int argc, char* argv[]) {
 
     //voiceNode.connect(m_masterGain);
 
-    static int last_processing_id = 0;
-
     // Set the callback for the audio player
-    m_audioPlayer.setCallback([&gainVolume, &context, &adsr](const void* user_data, float* output, unsigned long frames_per_buffer) {
+    m_audioPlayer.setCallback([&patch, &context](const void* user_data, float* output, unsigned long frames_per_buffer) {
 
-        gainVolume.process(frames_per_buffer, last_processing_id++ /*context.lastBatch()*/);  // Process the signal chain
+        AudioNode* out = patch.output();
+        out->process(frames_per_buffer, context.lastBatch());  // Process the signal chain
 
-        float* buffer = gainVolume.buffer();  // Get the processed buffer
+        float* buffer = out->buffer();  // Get the processed buffer
 
         // Copy the buffer to the output
         for (unsigned long i = 0; i < frames_per_buffer; ++i) {
@@ -113,19 +60,9 @@ int showConsole(int argc, char* argv[]) {
             output[i * 2 + 1] = buffer[i];  // Right channel (duplicate for stereo)
         }
 
-        if(last_processing_id > 100) {
-            adsr.setGate(false);
-        }
-
-        if(last_processing_id > 300) {
-            adsr.setGate(true);
-        }
-
-        if(last_processing_id > 350) {
-            adsr.setGate(false);
-        }
+        context.updateBatch(frames_per_buffer);
 
-        //context.updateBatch();
+        patch.updateGate(static_cast<double>(context.samplePosition()) / context.sampleRate());
     });
 
     // Initialize and start the audio player
@@ -1,28 +1,56 @@
 #include "mainwindow.h"
-#include "blackkey.h"
 #include "definitions.h"
-#include "whitekey.h"
 #include "spritesheet.h"
-#include "knobcontrol.h"
 #include "helpers.h"
 
-#include <QVBoxLayout>
-#include <QLabel>
-#include <QGroupBox>
-#include <QRadioButton>
 #include <QComboBox>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QLoggingCategory>
+
+#include <cmath>
+#include <iterator>
+
+namespace {
+
+// off unless enabled, e.g. QT_LOGGING_RULES="synth.startup.debug=true"
+Q_LOGGING_CATEGORY(startupLog, "synth.startup", QtWarningMsg)
+
+// Panel geometry on the 1024x768 window. Knobs are 64 px with their caption below.
+const int KNOB_SIZE = 64;
+const QRect MOD_SECTION(15, 15, 120, 465);
+const QRect OSC_1_SECTION(145, 15, 200, 225);
+const QRect OSC_2_SECTION(145, 255, 200, 225);
+const QRect FILTER_SECTION(355, 15, 120, 465);
+const QRect FILTER_ENVELOPE_SECTION(485, 15, 524, 145);
+const QRect VOLUME_ENVELOPE_SECTION(485, 175, 524, 145);
+const QRect MASTER_SECTION(485, 335, 524, 145);
+const QRect KEYBOARD(57, 524, 910, 220);
+
+// the waveform combos' entries, in the order they are listed; wave_shape is ordered differently
+const wave_shape WAVEFORM_CHOICES[] = { wave_shape::sine, wave_shape::square, wave_shape::sawtooth, wave_shape::triangle };
+const char* const WAVEFORM_NAMES[] = { "Sine", "Square", "Saw", "Triangle" };
+
+QStringList waveformNames() {
+    QStringList names;
+    for (const char* name : WAVEFORM_NAMES) {
+        names << name;
+    }
+    return names;
+}
 
-static int last_processing_id = 0;
+int waveformIndex(wave_shape waveform) {
+    for (int i = 0; i < static_cast<int>(std::size(WAVEFORM_CHOICES)); ++i) {
+        if (WAVEFORM_CHOICES[i] == waveform) return i;
+    }
+    return 0;
+}
 
-template <typename T>
-void connectKnobToMember(KnobControl* knob, T& memberVar, QObject* parent, std::function<void()> onUpdate = nullptr) {
-    QObject::connect(knob, &KnobControl::knobChanged, parent, [&memberVar, onUpdate](double oldValue, double newValue) {
-        memberVar = newValue;  // Update the member variable
+// the four knobs of an envelope section, side by side
+QPoint envelopeKnob(const QRect& section, int index) {
+    return section.topLeft() + QPoint(40 + index * 125, 40);
+}
 
-        if (onUpdate) {
-            onUpdate();  // Call optional onUpdate function if provided
-        }
-    });
 }
 
 int calculateNoteIndex(int keyboardOctaveIndex, int noteIndex) {
@@ -32,154 +60,97 @@ int calculateNoteIndex(int keyboardOctaveIndex, int noteIndex) {
     return activeIndex;
 }
 
-KnobControl * MainWindow::createKnob(QVBoxLayout ** layout,
-                                    double minimum,
-                                    double maximum,
-                                    double initialValue,
-                                    QString labelText,
-                                    int decimalPlaces,
-                                    bool log,
-                                    bool useFormatter,
-                                    QString suffixText) {
-
-    KnobControl *knob = new KnobControl;
-    QLabel *lblTitle = createLabel(labelText, true, 12);
-
-    QVBoxLayout *vbox = new QVBoxLayout;
-    vbox->setSizeConstraint(QLayout::SetFixedSize);
-    vbox->setContentsMargins(1, 1, 1, 1);
-    vbox->setSpacing(1);
-
-    knob->setSpriteSheet(spritesheet_);  // Set the sprite sheet
-    knob->setMinimum(minimum);  // Set minimum value
-    knob->setMaximum(maximum);  // Set maximum value
-    knob->setValue(initialValue);  // Initial value
-
-    knob->setFixedSize(64, 64);
-
-    lblTitle->setAlignment(Qt::AlignHCenter | Qt::AlignTop);
-
-    vbox->addWidget(knob, 0, Qt::AlignHCenter);
-    vbox->addWidget(lblTitle, 0, Qt::AlignHCenter);
-
-    *layout = vbox;
-
-
-    connect(knob, &KnobControl::knobChanged, this, [=](double oldValue, double newValue) {
-        showKnobTooltip(knob, decimalPlaces, log, useFormatter, suffixText);
-    });
-
-    connect(knob, &KnobControl::hoverEntered, this, [=]() {
-        showKnobTooltip(knob, decimalPlaces, log, useFormatter, suffixText);
-    });
-
-    connect(knob, &KnobControl::hoverLeft, this, [=]() {
-        knob_tooltip_.hide();
+int MainWindow::createKnob(QPoint position,
+                           double minimum,
+                           double maximum,
+                           double initialValue,
+                           QString labelText,
+                           int decimalPlaces,
+                           bool log,
+                           bool useFormatter,
+                           QString suffixText) {
+
+    const int knob = surface_->addKnob(QRect(position, QSize(KNOB_SIZE, KNOB_SIZE)), labelText, minimum, maximum, initialValue);
+    knob_slots_.resize(knob + 1);
+    knob_formats_.resize(knob + 1);
+    knob_formats_[knob] = { decimalPlaces, log, useFormatter, suffixText };
+
+    // a drag emits a change per pixel; the tooltip only needs one per frame
+    onKnobChanged(knob, [=](double value) {
+        showKnobTooltip(knob);
     });
 
     return knob;
 }
 
-QLabel * MainWindow::createLabel(QString text, bool bold, int pointSize) {
-    QLabel * label = new QLabel(text);
-
-    QPalette pal = label->palette();
-    pal.setColor(QPalette::WindowText, Qt::white);
-    label->setPalette(pal);
-
-    QFont font("Afacad Flux", pointSize);
-    label->setFont(font);
-
-    if (bold) {
-        QFont font = label->font();
-        font.setBold(true);
-        label->setFont(font);
-    }
-
-    return label;
+void MainWindow::onKnobChanged(int knob, std::function<void(double)> apply) {
+    knob_slots_[knob].push_back(knob_updates_.addSlot(std::move(apply)));
 }
 
-QGroupBox * MainWindow::createGroupBox(QString title, int pointSize) {
-    QGroupBox *gb = new QGroupBox(title);
+// Knob moves are merged in the coalescer and reach memberVar once per display frame
+void MainWindow::connectKnobToMember(int knob, double& memberVar, std::function<void()> onUpdate) {
+    onKnobChanged(knob, [&memberVar, onUpdate](double value) {
+        memberVar = value;  // Update the member variable
 
-    QFont font = QFont("Afacad Flux", pointSize, 700);
-    gb->setFont(font);
+        if (onUpdate) {
+            onUpdate();  // Call optional onUpdate function if provided
+        }
+    });
+}
 
-    gb->setStyleSheet(tr("QGroupBox { color: white;  }"));
-    return gb;
+// Like connectKnobToMember, and also hands the value to the voices through the store.
+// scale converts from the knob's units (mostly 0-100) to the voice parameter's.
+void MainWindow::connectKnobToParameter(int knob, double& memberVar, VoiceNode::ParameterId id, double scale) {
+    connectKnobToMember(knob, memberVar, [this, &memberVar, id, scale]() {
+        voice_parameters_.set(static_cast<unsigned>(id), static_cast<float>(memberVar * scale));
+    });
 }
 
-QComboBox * MainWindow::createComboBox(QStringList items) {
-    QComboBox *cbo = new QComboBox;
+QComboBox * MainWindow::createComboBox(QStringList items, const QRect& rect) {
+    QComboBox *cbo = new QComboBox(surface_);
 
     cbo->addItems(items);
 
     QFont font("Afacad Flux", 10);
     cbo->setFont(font);
+    cbo->setGeometry(rect);
 
     return cbo;
 }
 
-QVBoxLayout *MainWindow::createModLayout() {
-    QVBoxLayout *vbModGroup = new QVBoxLayout;
-
-    QVBoxLayout * waveformVerticalLayout = new QVBoxLayout;
-    QLabel *waveformLabel = createLabel(tr("SHAPE"), true, 11);
+void MainWindow::createModSection() {
+    const QRect& section = MOD_SECTION;
+    surface_->addSection(section, tr("MOD"));
 
-    waveformVerticalLayout->setSpacing(0);
-
-    QStringList waveforms = {"Sine", "Square", "Saw", "Triangle"};
-    auto waveformCombo = createComboBox(waveforms);
-    waveformCombo->setCurrentIndex(static_cast<int>(mod_waveform_));
+    surface_->addLabel(QRect(section.left() + 10, section.top() + 28, 100, 18), tr("SHAPE"));
+    auto waveformCombo = createComboBox(waveformNames(), QRect(section.left() + 10, section.top() + 48, 100, 24));
+    waveformCombo->setCurrentIndex(waveformIndex(mod_waveform_));
 
     connect(waveformCombo, &QComboBox::currentIndexChanged, this, [=](int index){
-        mod_waveform_ = static_cast<wave_shape>(index);
-        updateVoices();
+        if (index < 0) return;
+        mod_waveform_ = WAVEFORM_CHOICES[index];
+        voice_parameters_.set(static_cast<unsigned>(VoiceNode::ParameterId::ModWaveform), static_cast<float>(mod_waveform_));
     });
 
-    waveformVerticalLayout->addWidget(waveformLabel);
-    waveformVerticalLayout->addWidget(waveformCombo);
-    waveformLabel->setContentsMargins(0, 0, 0, 0);
-    waveformCombo->setContentsMargins(0, 0, 0, 0);
-    waveformVerticalLayout->setAlignment(Qt::AlignVCenter);
-
-    vbModGroup->addLayout(waveformVerticalLayout);
-
-    QVBoxLayout* frequencyKnobLayout;
-    auto modFrequencyKnob = createKnob(&frequencyKnobLayout, 0, 10, mod_frequency_, tr("FREQ"), 1);
-    connectKnobToMember(modFrequencyKnob, mod_frequency_, this, std::bind(&MainWindow::updateVoices, this));
-
-    QWidget* frequencyKnobWidget = new QWidget;
-    frequencyKnobWidget->setLayout(frequencyKnobLayout);
-    vbModGroup->addWidget(frequencyKnobWidget);
+    const int x = section.left() + (section.width() - KNOB_SIZE) / 2;
 
-    QVBoxLayout *modMixLayout;
-    auto modMixKnob = createKnob(&modMixLayout, 0, 100, osc_1_mod_mix_, tr("OSC1 TREMOLO"));
-    connectKnobToMember(modMixKnob, osc_1_mod_mix_, this, std::bind(&MainWindow::updateVoices, this));
+    auto modFrequencyKnob = createKnob(QPoint(x, section.top() + 110), 0, 10, mod_frequency_, tr("FREQ"), 1);
+    connectKnobToParameter(modFrequencyKnob, mod_frequency_, VoiceNode::ParameterId::ModFrequency, 1.0);
 
-    QWidget* modMixWidget = new QWidget;
-    modMixWidget->setLayout(modMixLayout);
+    auto modMixKnob = createKnob(QPoint(x, section.top() + 215), 0, 100, osc_1_mod_mix_, tr("OSC1 TREMOLO"));
+    connectKnobToParameter(modMixKnob, osc_1_mod_mix_, VoiceNode::ParameterId::Oscillator1ModGain, 0.01);
 
-    vbModGroup->addWidget(modMixWidget);
-
-
-    QVBoxLayout *modMix2Layout;
-    auto modMix2Knob = createKnob(&modMix2Layout, 0, 100, osc_2_mod_mix_, tr("OSC2 TREMOLO"));
-    connectKnobToMember(modMix2Knob, osc_2_mod_mix_, this, std::bind(&MainWindow::updateVoices, this));
-
-    QWidget* modMix2Widget = new QWidget;
-    modMix2Widget->setLayout(modMix2Layout);
-
-    vbModGroup->addWidget(modMix2Widget);
-
-    return vbModGroup;
+    auto modMix2Knob = createKnob(QPoint(x, section.top() + 320), 0, 100, osc_2_mod_mix_, tr("OSC2 TREMOLO"));
+    connectKnobToParameter(modMix2Knob, osc_2_mod_mix_, VoiceNode::ParameterId::Oscillator2ModGain, 0.01);
 }
 
-void MainWindow::showKnobTooltip(const KnobControl* knob, int decimalPlaces, bool logarithmic, bool useFormatter, QString suffix) {
+void MainWindow::showKnobTooltip(int knob) {
 
-    auto value = logarithmic ? std::pow(2, knob->value()) : knob->value();
-    auto tooltipText = QString("%1 %2").arg((useFormatter ? formatNumberPrefix(value) : QString::number(value, 'f', decimalPlaces)), suffix);
-    auto tooltipPoint = knob->centerPoint() + QPoint(-5, -20);
+    const KnobFormat& format = knob_formats_[knob];
+    auto knobValue = surface_->knobValue(knob);
+    auto value = format.logarithmic ? std::pow(2, knobValue) : knobValue;
+    auto tooltipText = QString("%1 %2").arg((format.use_formatter ? formatNumberPrefix(value) : QString::number(value, 'f', format.decimal_places)), format.suffix);
+    auto tooltipPoint = surface_->knobCenter(knob) + QPoint(-5, -20);
 
     knob_tooltip_.showTooltip(tooltipText, tooltipPoint, 55000);
 
@@ -190,464 +161,177 @@ void MainWindow::showTooltip(const QPoint &point, QString toolTipText)
     knob_tooltip_.showTooltip(toolTipText, point, 25000);
 }
 
-QVBoxLayout* MainWindow::createOsc1Layout() {
-    QVBoxLayout *vbOsc1Group = new QVBoxLayout;
-
-    QGridLayout *osc1Grid = new QGridLayout;
-    vbOsc1Group->addLayout(osc1Grid);
-
-    QVBoxLayout * waveformVerticalLayout = new QVBoxLayout;
-    QLabel *osc1WaveformLabel = createLabel(tr("WAVEFORM"), true, 11);
-
-    auto waveformCombo = createComboBox({"Sine", "Square", "Saw", "Triangle"});
-    waveformCombo->setCurrentIndex(static_cast<int>(osc_1_waveform_));
-
-    connect(waveformCombo, &QComboBox::currentIndexChanged, this, [=](int index){
-        osc_1_waveform_ = static_cast<wave_shape>(index);
-        updateVoices();
-    });
-
-    waveformVerticalLayout->addWidget(osc1WaveformLabel);
-    waveformVerticalLayout->addWidget(waveformCombo);
-
-    osc1WaveformLabel->setContentsMargins(0, 0, 0, 0);
-    waveformCombo->setContentsMargins(0, 0, 0, 0);
-
-    osc1Grid->addLayout(waveformVerticalLayout, 0, 0, Qt::AlignHCenter | Qt::AlignTop);
-
-    QVBoxLayout * detuneKnobLayout;
-    auto detuneKnob = createKnob(&detuneKnobLayout, -1200, 1200, osc_1_detune_, "DETUNE");
-    connectKnobToMember(detuneKnob, osc_1_detune_, this, std::bind(&MainWindow::updateVoices, this));
-    osc1Grid->addLayout(detuneKnobLayout, 1, 0, Qt::AlignHCenter | Qt::AlignTop);
+void MainWindow::createOscillatorSection(const QRect& section, QString title, QStringList intervals,
+                                         wave_shape& waveform, VoiceNode::ParameterId waveformId, int& interval,
+                                         double& detune, VoiceNode::ParameterId detuneId,
+                                         double& mix, VoiceNode::ParameterId mixId) {
+    surface_->addSection(section, title);
 
+    surface_->addLabel(QRect(section.left() + 10, section.top() + 28, 85, 18), tr("WAVEFORM"));
+    auto waveformCombo = createComboBox(waveformNames(), QRect(section.left() + 10, section.top() + 48, 85, 24));
+    waveformCombo->setCurrentIndex(waveformIndex(waveform));
 
-    // // /////////////////////////////////////////////////
-    // // /
-
-    waveformVerticalLayout = new QVBoxLayout;
-    QLabel *osc1IntervalLabel = createLabel(tr("INTERVAL"), true, 11);
-
-    auto intervalCombo = createComboBox({"32'", "16'", "8'"});
-    intervalCombo->setCurrentIndex(osc_1_interval_);
-
-    connect(intervalCombo, &QComboBox::currentIndexChanged, this, [=](int index){
-        // Handle the selected index
-        osc_1_interval_ = index;
-        updateVoices();
+    connect(waveformCombo, &QComboBox::currentIndexChanged, this, [=, &waveform](int index){
+        if (index < 0) return;
+        waveform = WAVEFORM_CHOICES[index];
+        voice_parameters_.set(static_cast<unsigned>(waveformId), static_cast<float>(waveform));
     });
 
-    waveformVerticalLayout->addWidget(osc1IntervalLabel);
-    waveformVerticalLayout->addWidget(intervalCombo);
-
-    osc1IntervalLabel->setContentsMargins(0, 0, 0, 0);
-    intervalCombo->setContentsMargins(0, 0, 0, 0);
-    osc1Grid->addLayout(waveformVerticalLayout, 0, 1, Qt::AlignHCenter | Qt::AlignTop);
-
-    QVBoxLayout * mixKnobLayout;
-    auto mixKnob = createKnob(&mixKnobLayout, 0, 100, osc_1_mix_, "MIX");
-    connectKnobToMember(mixKnob, osc_1_mix_, this, std::bind(&MainWindow::updateVoices, this));
-    osc1Grid->addLayout(mixKnobLayout, 1, 1, Qt::AlignHCenter | Qt::AlignTop);
-
-    vbOsc1Group->setAlignment(Qt::AlignTop);
-
-    return vbOsc1Group;
-}
-
-QVBoxLayout* MainWindow::createOsc2Layout() {
-    QVBoxLayout *vbOscillator = new QVBoxLayout;
-
-    QGridLayout *gridOscillator= new QGridLayout;
-    vbOscillator->addLayout(gridOscillator);
-
-    QVBoxLayout * waveformVerticalLayout = new QVBoxLayout;
-    QLabel *oscWaveformLabel = createLabel(tr("WAVEFORM"), true, 11);
-
-    auto waveformCombo = createComboBox({"Sine", "Square", "Saw", "Triangle"});
-    waveformCombo->setCurrentIndex(static_cast<int>(osc_2_waveform_));
-
-    connect(waveformCombo, &QComboBox::currentIndexChanged, this, [=](int index){
-        // Handle the selected index
-        osc_2_waveform_ = static_cast<wave_shape>(index);
-        updateVoices();
-    });
-
-
-    waveformVerticalLayout->addWidget(oscWaveformLabel);
-    waveformVerticalLayout->addWidget(waveformCombo);
-
-    oscWaveformLabel->setContentsMargins(0, 0, 0, 0);
-    waveformCombo->setContentsMargins(0, 0, 0, 0);
-
-    gridOscillator->addLayout(waveformVerticalLayout, 0, 0, Qt::AlignHCenter | Qt::AlignTop);
-
-    QVBoxLayout * detuneKnobLayout;
-    auto detuneKnob = createKnob(&detuneKnobLayout, -1200, 1200, osc_2_detune_, "DETUNE");
-    connectKnobToMember(detuneKnob, osc_2_detune_, this, std::bind(&MainWindow::updateVoices, this));
-    gridOscillator->addLayout(detuneKnobLayout, 1, 0, Qt::AlignHCenter | Qt::AlignTop);
-
-    // // /////////////////////////////////////////////////
-    // // /
-
-    QVBoxLayout *intervalVerticalLayout = new QVBoxLayout;
-    QLabel *labelInterval = createLabel(tr("INTERVAL"), true, 11);
+    surface_->addLabel(QRect(section.left() + 105, section.top() + 28, 85, 18), tr("INTERVAL"));
+    auto intervalCombo = createComboBox(intervals, QRect(section.left() + 105, section.top() + 48, 85, 24));
+    intervalCombo->setCurrentIndex(interval);
 
-
-    auto intervalCombo = createComboBox({"16'", "8'", "4'"});
-    intervalCombo->setCurrentIndex(osc_2_interval_);
-
-
-    connect(intervalCombo, &QComboBox::currentIndexChanged, this, [=](int index){
+    connect(intervalCombo, &QComboBox::currentIndexChanged, this, [=, &interval](int index){
         // Handle the selected index
-        osc_2_interval_ = index;
-        updateVoices();
+        interval = index;
     });
 
+    auto detuneKnob = createKnob(section.topLeft() + QPoint(20, 100), -1200, 1200, detune, "DETUNE");
+    connectKnobToParameter(detuneKnob, detune, detuneId, 1.0);
 
-    intervalVerticalLayout->addWidget(labelInterval);
-    intervalVerticalLayout->addWidget(intervalCombo);
-
-    labelInterval->setContentsMargins(0, 0, 0, 0);
-    intervalCombo->setContentsMargins(0, 0, 0, 0);
-
-    gridOscillator->addLayout(intervalVerticalLayout, 0, 1, Qt::AlignHCenter | Qt::AlignTop);
-
-    QVBoxLayout * mixKnobLayout;
-    auto mixKnob= createKnob(&mixKnobLayout, 0, 100, osc_2_mix_, "MIX");
-    connectKnobToMember(mixKnob, osc_2_mix_, this, std::bind(&MainWindow::updateVoices, this));
-    gridOscillator->addLayout(mixKnobLayout, 1, 1, Qt::AlignHCenter | Qt::AlignTop);
-
-    vbOscillator->setAlignment(Qt::AlignTop);
-
-    return vbOscillator;
+    auto mixKnob = createKnob(section.topLeft() + QPoint(115, 100), 0, 100, mix, "MIX");
+    connectKnobToParameter(mixKnob, mix, mixId, 0.01);
 }
 
-QVBoxLayout * MainWindow::createFilterLayout() {
+void MainWindow::createFilterSection() {
+    const QRect& section = FILTER_SECTION;
+    surface_->addSection(section, tr("FILTER"));
 
-    QVBoxLayout *vbFilterGroup = new QVBoxLayout;
+    const int x = section.left() + (section.width() - KNOB_SIZE) / 2;
 
-    QVBoxLayout* knobLayout;
-    auto cutoffKnob = createKnob(&knobLayout, log2(20), log2(20000), filter_cutoff_, tr("CUTOFF"), 0, true, true, "hz");
-    connectKnobToMember(cutoffKnob, filter_cutoff_, this,  std::bind(&MainWindow::updateVoices, this));
-    vbFilterGroup->addLayout(knobLayout);
+    auto cutoffKnob = createKnob(QPoint(x, section.top() + 30), log2(20), log2(20000), filter_cutoff_, tr("CUTOFF"), 0, true, true, "hz");
+    connectKnobToMember(cutoffKnob, filter_cutoff_);
 
-    auto knobResonance = createKnob(&knobLayout, 0, 20, filter_resonance_, tr("Q"), 1);
-    connectKnobToMember(knobResonance, filter_resonance_, this, std::bind(&MainWindow::updateVoices, this));
-    vbFilterGroup->addLayout(knobLayout);
+    auto knobResonance = createKnob(QPoint(x, section.top() + 135), 0, 20, filter_resonance_, tr("Q"), 1);
+    connectKnobToMember(knobResonance, filter_resonance_);
 
-    auto knobFilterMod = createKnob(&knobLayout, 0, 100, filter_mod_, tr("MOD"));
-    connectKnobToMember(knobFilterMod, filter_mod_, this, std::bind(&MainWindow::updateVoices, this));
-    vbFilterGroup->addLayout(knobLayout);
+    auto knobFilterMod = createKnob(QPoint(x, section.top() + 240), 0, 100, filter_mod_, tr("MOD"));
+    connectKnobToMember(knobFilterMod, filter_mod_);
 
-    auto knobFilterEnv = createKnob(&knobLayout, 0, 100, filter_envelope_, tr("ENV"));
-    connectKnobToMember(knobFilterEnv, filter_envelope_, this, std::bind(&MainWindow::updateVoices, this));
-    vbFilterGroup->addLayout(knobLayout);
-
-    return vbFilterGroup;
+    auto knobFilterEnv = createKnob(QPoint(x, section.top() + 345), 0, 100, filter_envelope_, tr("ENV"));
+    connectKnobToMember(knobFilterEnv, filter_envelope_);
 }
 
-QHBoxLayout *MainWindow::createFilterEnvelopeLayout() {
-    QHBoxLayout *qhbFilterEnvelope = new QHBoxLayout;
-
+void MainWindow::createFilterEnvelopeSection() {
+    const QRect& section = FILTER_ENVELOPE_SECTION;
+    surface_->addSection(section, tr("FILTER ENVELOPE"));
 
-    QVBoxLayout* knobLayout;
-    auto knobFilterEnvelopeA = createKnob(&knobLayout, 0, 100, filter_envelope_a_, tr("ATTACK"));
-    connectKnobToMember(knobFilterEnvelopeA, filter_envelope_a_, this, std::bind(&MainWindow::updateVoices, this));
-    qhbFilterEnvelope->addLayout(knobLayout);
-    knobLayout->setAlignment(Qt::AlignVCenter);
+    auto knobFilterEnvelopeA = createKnob(envelopeKnob(section, 0), 0, 100, filter_envelope_a_, tr("ATTACK"));
+    connectKnobToMember(knobFilterEnvelopeA, filter_envelope_a_);
 
-    auto knobFilterEnvelopeD = createKnob(&knobLayout, 0, 100, filter_envelope_d_, tr("DECAY"));
-    connectKnobToMember(knobFilterEnvelopeD, filter_envelope_d_, this, std::bind(&MainWindow::updateVoices, this));
-    qhbFilterEnvelope->addLayout(knobLayout);
-    knobLayout->setAlignment(Qt::AlignVCenter);
+    auto knobFilterEnvelopeD = createKnob(envelopeKnob(section, 1), 0, 100, filter_envelope_d_, tr("DECAY"));
+    connectKnobToMember(knobFilterEnvelopeD, filter_envelope_d_);
 
-    auto knobFilterEnvelopeS = createKnob(&knobLayout, 0, 100, filter_envelope_s_ , tr("SUSTAIN"));
-    connectKnobToMember(knobFilterEnvelopeS, filter_envelope_s_, this, std::bind(&MainWindow::updateVoices, this));
-    qhbFilterEnvelope->addLayout(knobLayout);
-    knobLayout->setAlignment(Qt::AlignVCenter);
+    auto knobFilterEnvelopeS = createKnob(envelopeKnob(section, 2), 0, 100, filter_envelope_s_ , tr("SUSTAIN"));
+    connectKnobToMember(knobFilterEnvelopeS, filter_envelope_s_);
 
-    auto knobFilterEnvelopeR = createKnob(&knobLayout, 0, 100, filter_envelope_r_ , tr("RELEASE"));
-    connectKnobToMember(knobFilterEnvelopeR, filter_envelope_r_, this, std::bind(&MainWindow::updateVoices, this));
-    qhbFilterEnvelope->addLayout(knobLayout);
-    knobLayout->setAlignment(Qt::AlignVCenter);
-    return qhbFilterEnvelope;
+    auto knobFilterEnvelopeR = createKnob(envelopeKnob(section, 3), 0, 100, filter_envelope_r_ , tr("RELEASE"));
+    connectKnobToMember(knobFilterEnvelopeR, filter_envelope_r_);
 }
 
-QHBoxLayout *MainWindow::createVolumeEnvelopeLayout() {
-    QHBoxLayout *qhbVolumeEnvelope = new QHBoxLayout;
-    QVBoxLayout* knobLayout;
+void MainWindow::createVolumeEnvelopeSection() {
+    const QRect& section = VOLUME_ENVELOPE_SECTION;
+    surface_->addSection(section, tr("VOLUME ENVELOPE"));
 
-    auto knobVolumeEnvelopeA = createKnob(&knobLayout, 0, 100, volume_envelope_a_, tr("ATTACK"));
-    connectKnobToMember(knobVolumeEnvelopeA, volume_envelope_a_, this, std::bind(&MainWindow::updateVoices, this));
-    qhbVolumeEnvelope->addLayout(knobLayout);
-    knobLayout->setAlignment(Qt::AlignVCenter);
+    auto knobVolumeEnvelopeA = createKnob(envelopeKnob(section, 0), 0, 100, volume_envelope_a_, tr("ATTACK"));
+    connectKnobToParameter(knobVolumeEnvelopeA, volume_envelope_a_, VoiceNode::ParameterId::VolumeEnvelopeA, 0.1);
 
-    auto knobVolumeEnvelopeD = createKnob(&knobLayout, 0, 100, volume_envelope_d_, tr("DECAY"));
-    connectKnobToMember(knobVolumeEnvelopeD, volume_envelope_d_, this, std::bind(&MainWindow::updateVoices, this));
-    qhbVolumeEnvelope->addLayout(knobLayout);
-    knobLayout->setAlignment(Qt::AlignVCenter);
+    auto knobVolumeEnvelopeD = createKnob(envelopeKnob(section, 1), 0, 100, volume_envelope_d_, tr("DECAY"));
+    connectKnobToParameter(knobVolumeEnvelopeD, volume_envelope_d_, VoiceNode::ParameterId::VolumeEnvelopeD, 0.1);
 
-    auto knobVolumeEnvelopeS = createKnob(&knobLayout, 0, 100, volume_envelope_s_, tr("SUSTAIN"));
-    connectKnobToMember(knobVolumeEnvelopeS, volume_envelope_s_, this, std::bind(&MainWindow::updateVoices, this));
-    qhbVolumeEnvelope->addLayout(knobLayout);
-    knobLayout->setAlignment(Qt::AlignVCenter);
+    auto knobVolumeEnvelopeS = createKnob(envelopeKnob(section, 2), 0, 100, volume_envelope_s_, tr("SUSTAIN"));
+    connectKnobToParameter(knobVolumeEnvelopeS, volume_envelope_s_, VoiceNode::ParameterId::VolumeEnvelopeS, 0.01);
 
-    auto knobVolumeEnvelopeR = createKnob(&knobLayout, 0, 100, volume_envelope_r_, tr("RELEASE"));
-    connectKnobToMember(knobVolumeEnvelopeR, volume_envelope_r_, this, std::bind(&MainWindow::updateVoices, this));
-    qhbVolumeEnvelope->addLayout(knobLayout);
-    knobLayout->setAlignment(Qt::AlignVCenter);
-
-    return qhbVolumeEnvelope;
+    auto knobVolumeEnvelopeR = createKnob(envelopeKnob(section, 3), 0, 100, volume_envelope_r_, tr("RELEASE"));
+    connectKnobToParameter(knobVolumeEnvelopeR, volume_envelope_r_, VoiceNode::ParameterId::VolumeEnvelopeR, 0.1);
 }
 
-QHBoxLayout *MainWindow::createMasterLayout() {
-    QHBoxLayout *qhbMaster = new QHBoxLayout;
+void MainWindow::createMasterSection() {
+    const QRect& section = MASTER_SECTION;
+    surface_->addSection(section, tr("MASTER"));
 
-    QVBoxLayout* knobLayout;
-    auto knobDrive = createKnob(&knobLayout, 0, 100, overdrive_ , tr("DRIVE"));
-    connectKnobToMember(knobDrive, overdrive_, this, std::bind(&MainWindow::updateVoices, this));
-    qhbMaster->addLayout(knobLayout);
-    knobLayout->setAlignment(Qt::AlignVCenter);
+    auto knobDrive = createKnob(envelopeKnob(section, 0), 0, 100, overdrive_ , tr("DRIVE"));
+    connectKnobToMember(knobDrive, overdrive_);
 
+    auto knobReverb = createKnob(envelopeKnob(section, 1), 0, 100, reverb_, tr("REVERB"));
+    connectKnobToMember(knobReverb, reverb_);
 
-    auto knobReverb = createKnob(&knobLayout, 0, 100, reverb_, tr("REVERB"));
-    connectKnobToMember(knobReverb, reverb_, this, std::bind(&MainWindow::updateVoices, this));
-    qhbMaster->addLayout(knobLayout);
-    knobLayout->setAlignment(Qt::AlignVCenter);
+    auto knobVolume = createKnob(envelopeKnob(section, 2), 0, 100, volume_, tr("VOLUME"));
+    connectKnobToMember(knobVolume, volume_);
 
+    const int x = section.left() + 395;
 
-    auto knobVolume = createKnob(&knobLayout, 0, 100, volume_, tr("VOLUME"));
-    connectKnobToMember(knobVolume, volume_, this, std::bind(&MainWindow::updateVoices, this));
-    qhbMaster->addLayout(knobLayout);
-    knobLayout->setAlignment(Qt::AlignVCenter);
+    surface_->addLabel(QRect(x, section.top() + 25, 110, 18), tr("MIDI IN"));
+    createComboBox({}, QRect(x, section.top() + 45, 110, 24));
 
-    QVBoxLayout *dropdownLayout = new QVBoxLayout;
-    QComboBox *midiInCombo = new QComboBox;
-    QComboBox *octaveCombo = createComboBox({"+3", "+2", "+1", "NORMAL", "-1", "-2", "-3"});
+    surface_->addLabel(QRect(x, section.top() + 80, 110, 18), tr("OCTAVE"));
+    QComboBox *octaveCombo = createComboBox({"+3", "+2", "+1", "NORMAL", "-1", "-2", "-3"}, QRect(x, section.top() + 100, 110, 24));
 
     octaveCombo->setCurrentIndex(keyboard_octave_offset_);
 
     connect(octaveCombo, &QComboBox::currentIndexChanged, this, [=](int index){
         // Handle the selected index
         keyboard_octave_offset_ = index;
-        updateVoices();
     });
-
-    auto midiLabel = createLabel(tr("MIDI IN"), true, 11);
-    midiLabel->setAlignment(Qt::AlignTop);
-    dropdownLayout->addWidget(midiLabel);
-    dropdownLayout->addWidget(midiInCombo);
-
-    dropdownLayout->addItem(new QSpacerItem(0, 15));
-
-    auto octaveLabel = createLabel(tr("OCTAVE"), true, 11);
-    octaveLabel->setAlignment(Qt::AlignTop);
-    dropdownLayout->addWidget(octaveLabel);
-    dropdownLayout->addWidget(octaveCombo);
-
-    dropdownLayout->setAlignment(Qt::AlignTop);
-
-    qhbMaster->addLayout(dropdownLayout);
-
-    return qhbMaster;
-}
-
-QWidget *MainWindow::createKeyboardWidget() {
-    QWidget* keyBox = new QWidget;
-    keyBox->setFixedSize(910, 220);
-    keyBox->setContentsMargins(0, 0, 0, 0);
-
-    std::vector<QString> noteNames = {"C", "C#", "D", "Eb", "E", "F", "F#", "G", "G#", "A", "Bb", "B"};
-
-    QString whiteStyleSheet = QString(R"(
-                QPushButton {
-                    background-color: white; border: 1px solid black;
-                    border-bottom-right-radius: 5px; border-bottom-left-radius: 5px;
-                }
-                QPushButton:hover { background: lightgray; }
-                QPushButton:pressed {
-                    background: #777777;
-                    padding-top: 2px;
-                }
-    )");
-
-    keyBox->setStyleSheet(whiteStyleSheet);
-
-    QHBoxLayout* whiteKeysLayout = new QHBoxLayout;
-    whiteKeysLayout->setSpacing(0);
-    whiteKeysLayout->setContentsMargins(0, 0, 0, 0);
-
-    const std::vector<int> whiteNoteIndexes = {0, 2, 4, 5, 7, 9, 11, 12, 14, 16, 17, 19, 21, 23};
-    const std::vector<int> blackNoteIndexes = {1, 3, 6, 8, 10, 13, 15, 18, 20, 22};
-
-    for (int i = 0; i < 14; ++i) {
-
-        auto key = new PianoKey("", keyBox);
-        whiteKeysLayout->addWidget(key);
-
-        QLabel *label = new QLabel(noteNames[whiteNoteIndexes[i] % 12]);
-        label->setAlignment(Qt::AlignBottom | Qt::AlignHCenter);
-
-        QVBoxLayout *layout = new QVBoxLayout(key);
-        layout->addWidget(label);
-
-        QFont font("Afacad Flux");
-        font.setBold(true);
-        label->setFont(font);
-
-        connect(key, &QPushButton::pressed, this, [=]() {
-            noteOn(calculateNoteIndex(keyboard_octave_offset_, whiteNoteIndexes[i]));
-        });
-    }
-
-    QWidget* blackKeysWidget = new QWidget(keyBox);
-    blackKeysWidget->setFixedSize(910, 130);  // Black keys only take up 150px height
-    blackKeysWidget->move(0, 10);  // Positioned absolutely on top of the white keys
-
-    QString blackStyleSheet = QString(R"(
-            QPushButton {
-                background-color: black;
-                border-bottom-right-radius: 5px;
-                border-bottom-left-radius: 5px;
-            }
-
-            QPushButton:hover {
-                background-color: #555;
-            }
-
-            QPushButton:pressed {
-                background: #777777;
-                padding-top: 2px;
-            }
-
-    )");
-
-    blackKeysWidget->setStyleSheet(blackStyleSheet);
-    QString blackKeyStyle = "margin: 0px; padding: 0px; color: white;";
-
-    // List of X positions for each black key relative to the keyBox
-    const int spacing = 60;
-    const int left = 75;
-    QVector<int> blackKeyPositions = {left, left + spacing, left + spacing * 3, left + spacing * 4, left + spacing * 5, left + spacing * 7, left + spacing * 8, left + spacing * 10, left + spacing * 11, left + spacing * 12};
-
-    // Manually position black keys at precise locations
-    for (int i = 0; i < blackKeyPositions.size(); ++i) {
-
-        BlackKey* blackKey = new BlackKey(blackKeyStyle, blackKeysWidget);
-        blackKey->setFixedSize(40, 130);  // Same size as before
-        blackKey->move(blackKeyPositions[i], 0);  // Set the exact X position
-
-        QLabel *label = new QLabel(noteNames[blackNoteIndexes[i] % 12]);
-        label->setAlignment(Qt::AlignBottom | Qt::AlignHCenter);
-
-        QFont font("Afacad Flux");
-        font.setBold(true);
-        label->setFont(font);
-
-        QVBoxLayout *layout = new QVBoxLayout(blackKey);
-        layout->addWidget(label);
-
-        connect(blackKey, &QPushButton::pressed, this, [=]() {
-            noteOn(calculateNoteIndex(keyboard_octave_offset_, blackNoteIndexes[i]));
-        });
-
-    }
-
-    QVBoxLayout* pianoLayout = new QVBoxLayout(keyBox);
-    pianoLayout->addLayout(whiteKeysLayout);
-    pianoLayout->setAlignment(Qt::AlignHCenter);
-
-    return keyBox;
 }
 
 void MainWindow::buildLayout() {
-    QWidget* centralWidget = new QWidget(this);
-    setCentralWidget(centralWidget);
-
-    QVBoxLayout* mainLayout = new QVBoxLayout(centralWidget);
-    mainLayout->setSpacing(0);
-
-    // Create a QGridLayout
-    QGridLayout *gridLayout = new QGridLayout;
-    QWidget* gridWidget = new QWidget;
-    gridWidget->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
-    gridWidget->setLayout(gridLayout);
-
-    gridWidget->setObjectName("gridWidget");
-    gridWidget->setStyleSheet("#gridWidget { background-color: black; }");
-
-    mainLayout->addWidget(gridWidget);
-    mainLayout->setContentsMargins(0, 0, 0, 0);
-
-    // Add widgets and layouts to the grid
-    QGroupBox *gbMod = createGroupBox(tr("MOD"));
-    QGroupBox *gbOsc1 = createGroupBox(tr("OSC1"));
-    QGroupBox *gbOsc2 = createGroupBox(tr("OSC2"));
-    QGroupBox *gbFilter = createGroupBox(tr("FILTER"));
-    QGroupBox *gbFilterEnv = createGroupBox(tr("FILTER ENVELOPE"));
-    QGroupBox *gbVolumeEnv = createGroupBox(tr("VOLUME ENVELOPE"));
-    QGroupBox *gbMaster = createGroupBox(tr("MASTER"));
-
-    gbMod->setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Expanding);
-    gbOsc1->setSizePolicy(QSizePolicy::Minimum, QSizePolicy::Expanding);
-    gbOsc2->setSizePolicy(QSizePolicy::Minimum, QSizePolicy::Expanding);
-    gbFilter->setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Expanding);
-    gbFilterEnv->setSizePolicy(QSizePolicy::Minimum, QSizePolicy::Expanding);
-    gbVolumeEnv->setSizePolicy(QSizePolicy::Minimum, QSizePolicy::Expanding);
-    gbMaster->setSizePolicy(QSizePolicy::Minimum, QSizePolicy::Expanding);
-
-    // Column 1 (First column, spanning all 3 rows)
-    gridLayout->addWidget(gbMod, 0, 0, 3, 1);
-    gbMod->setLayout(createModLayout());
-
-    gridLayout->addWidget(gbOsc1, 0, 1);
-    gbOsc1->setLayout(createOsc1Layout());
-
-    gridLayout->addWidget(gbOsc2, 2, 1);
-    gbOsc2->setLayout(createOsc2Layout());
-
-    gridLayout->addWidget(gbFilter, 0, 2, 3, 1);
-    gbFilter->setLayout(createFilterLayout());
-
-    gridLayout->addWidget(gbFilterEnv, 0, 3);
-    gbFilterEnv->setLayout(createFilterEnvelopeLayout());
-
-    gridLayout->addWidget(gbVolumeEnv, 1, 3);
-    gbVolumeEnv->setLayout(createVolumeEnvelopeLayout());
-
-    gridLayout->addWidget(gbMaster, 2, 3);
-    gbMaster->setLayout(createMasterLayout());
-
-    gridLayout->setContentsMargins(0, 0, 0, 0);
-    gridLayout->setAlignment(Qt::AlignTop);
-    gridLayout->setContentsMargins(15, 15, 15, 15);
-
-    QWidget* pianoWidget = createKeyboardWidget();  // This will be the function where you create your piano
-
-    QVBoxLayout *pianoLayout = new QVBoxLayout;
-    QWidget* pianoHolderWidget = new QWidget;
-    pianoHolderWidget->setContentsMargins(0, 0, 0, 0);
-    pianoHolderWidget->setFixedWidth(1024);
-
-    pianoLayout->setAlignment(Qt::AlignHCenter);
+    surface_ = new ControlSurface(this);
+    surface_->setSpriteSheet(spritesheet_);
+    setCentralWidget(surface_);
+
+    createModSection();
+    createOscillatorSection(OSC_1_SECTION, tr("OSC1"), {"32'", "16'", "8'"},
+                            osc_1_waveform_, VoiceNode::ParameterId::Oscillator1Waveform, osc_1_interval_,
+                            osc_1_detune_, VoiceNode::ParameterId::Oscillator1Detune,
+                            osc_1_mix_, VoiceNode::ParameterId::Oscillator1Gain);
+    createOscillatorSection(OSC_2_SECTION, tr("OSC2"), {"16'", "8'", "4'"},
+                            osc_2_waveform_, VoiceNode::ParameterId::Oscillator2Waveform, osc_2_interval_,
+                            osc_2_detune_, VoiceNode::ParameterId::Oscillator2Detune,
+                            osc_2_mix_, VoiceNode::ParameterId::Oscillator2Gain);
+    createFilterSection();
+    createFilterEnvelopeSection();
+    createVolumeEnvelopeSection();
+    createMasterSection();
+
+    surface_->setKeyboard(KEYBOARD, 14, QColor(0x33, 0x33, 0x33));
+
+    // one connection for all knobs, fanned out to each knob's coalesced updates
+    connect(surface_, &ControlSurface::knobChanged, this, [this](int knob, double oldValue, double newValue) {
+        for (const int slot : knob_slots_[knob]) {
+            knob_updates_.post(slot, newValue);
+        }
+    });
 
-    pianoLayout->addWidget(pianoWidget);
+    connect(surface_, &ControlSurface::knobHoverEntered, this, [this](int knob) {
+        showKnobTooltip(knob);
+    });
 
-    pianoHolderWidget->setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Expanding);
-    pianoHolderWidget->setLayout(pianoLayout);
+    connect(surface_, &ControlSurface::knobHoverLeft, this, [this](int knob) {
+        knob_tooltip_.hide();
+    });
 
-    pianoHolderWidget->setObjectName("pianoHolder");
-    pianoHolderWidget->setStyleSheet("#pianoHolder { background-color: #333; }");
+    connect(surface_, &ControlSurface::keyPressed, this, [this](int key) {
+        noteOn(calculateNoteIndex(keyboard_octave_offset_, key));
+    });
 
-    mainLayout->addWidget(pianoHolderWidget);
+    connect(surface_, &ControlSurface::keyReleased, this, [this](int key) {
+        noteOff(calculateNoteIndex(keyboard_octave_offset_, key));
+    });
 }
 
+void MainWindow::applyVoiceParameters() {
+    const unsigned count = voice_parameters_.takeChanges(parameter_changes_.data());
+    if (count == 0) {
+        return;
+    }
 
-void MainWindow::updateVoices() {
-    qDebug() << "m_filterCutoff" << filter_cutoff_;
-    qDebug() << "m_modFrequency" << mod_frequency_;
-    qDebug() << "m_osc1ModMix" << osc_1_mod_mix_;
-    qDebug() << "m_osc2ModMix" << osc_2_mod_mix_;
-    qDebug() << "m_filterEnv" << filter_envelope_;
+    // voice by voice, so each one's nodes are touched once
+    for (VoiceNode* voice : voices_) {
+        for (unsigned i = 0; i < count; ++i) {
+            voice->setParameter(static_cast<VoiceNode::ParameterId>(parameter_changes_[i].id), parameter_changes_[i].value);
+        }
+    }
 }
 
 void MainWindow::noteOn(int noteIndex) {
@@ -670,7 +354,9 @@ MainWindow::MainWindow(QWidget *parent)
     , audio_player_(nullptr, SAMPLE_RATE, FRAMES)
     , audio_context_(SAMPLE_RATE, FRAMES)
     , output_node_(audio_context_, 0.5)
-    , playing_(false) /*, m_voice(wave_shape::sine, wave_shape::sine, wave_shape::sine, 4, .1, .1, 440, 232.24, .5, .5, 0, 0)*/
+    , playing_(false)
+    , voice_parameters_(VoiceNode::PARAMETER_COUNT)
+    , parameter_changes_(VoiceNode::PARAMETER_COUNT) /*, m_voice(wave_shape::sine, wave_shape::sine, wave_shape::sine, 4, .1, .1, 440, 232.24, .5, .5, 0, 0)*/
 {
 
     for(uint i = 0; i < 32; i++) {
@@ -679,6 +365,10 @@ MainWindow::MainWindow(QWidget *parent)
 
     //m_voice.connect(&m_masterGain);
 
+    QElapsedTimer startup;
+    startup.start();
+
+    // frames are scaled from the sheet as knobs first draw them, not here
     spritesheet_ = std::make_shared<SpriteSheet>();
     spritesheet_->setOrientation(Qt::Vertical);
     spritesheet_->setCells(101);  // Number of cells (frames)
@@ -690,6 +380,8 @@ MainWindow::MainWindow(QWidget *parent)
 
     }
 
+    qCDebug(startupLog) << "Panel built in" << startup.nsecsElapsed() / 1000 << "us";
+
     auto voice = voices_.begin();
 
     (*voice)->setParameters(VoiceNode::Builder(audio_context_)
@@ -719,14 +411,14 @@ MainWindow::MainWindow(QWidget *parent)
 
     (*voice)->connect(&output_node_);
 
-    static int sample_count = 0;
-
     // Set the callback for the audio player
     audio_player_.setCallback([this](const void* user_data, float* output, unsigned long frames_per_buffer) {
 
-        sample_count += frames_per_buffer;
+        // knob moves since the last block, before any voice renders
+        applyVoiceParameters();
 
-        output_node_.process(frames_per_buffer, last_processing_id++);  // Process the signal chain
+        output_node_.process(frames_per_buffer, audio_context_.lastBatch());  // Process the signal chain
+        audio_context_.updateBatch(frames_per_buffer);
         float* gainBuffer = output_node_.buffer();  // Get the processed buffer
 
         // Copy the buffer to the output
@@ -735,7 +427,7 @@ MainWindow::MainWindow(QWidget *parent)
             output[i * 2 + 1] = gainBuffer[i];  // Right channel (duplicate for stereo)
         }
 
-        if(sample_count > 88200) {
+        if(audio_context_.samplePosition() > 88200) {
              auto voice = voices_.begin();
              //(*voice)->setParameters(VoiceNode::Builder().parameters());
              (*voice)->noteOff();
@@ -2,23 +2,22 @@
 #define MAINWINDOW_H
 
 #include <QMainWindow>
-#include <QPushButton>
-#include <qboxlayout.h>
-#include <qcombobox.h>
-#include <qgroupbox.h>
-#include <qlabel.h>
 
 //#include "audioplayer.h"
 #include "audioplayer.h"
+#include "controlsurface.h"
 #include "definitions.h"
 #include "gainnode.h"
-#include "knobcontrol.h"
+#include "parameterstore.h"
 #include "spritesheet.h"
 #include "tooltip.h"
+#include "updatecoalescer.h"
 #include "voicenode.h"
 
-typedef std::function<void(double, double)> FnChange;
-typedef std::function<QString(double)> FnFormat;
+#include <functional>
+#include <vector>
+
+class QComboBox;
 
 class MainWindow : public QMainWindow
 {
@@ -30,49 +29,62 @@ public:
 
 
 protected:
+    // The whole panel and keyboard are one ControlSurface; only the combo boxes are
+    // widgets of their own, placed over it
     void buildLayout();
 
-    QLabel * createLabel(QString text, bool bold, int pointSize = -1);
-    KnobControl* createKnob(QVBoxLayout ** layout,
-                            double minimum,
-                            double maximum,
-                            double initialValue,
-                            QString labelText,
-                            int decimalPlaces = 0,
-                            bool log = false,
-                            bool useFormatter = false,
-                            QString suffixText = ""
-                            );
-
-    QGroupBox * createGroupBox(QString title, int pointSize = -1);
-
-    QComboBox * createComboBox(QStringList items);
-
-    QVBoxLayout * createFilterLayout();
-
-    QVBoxLayout * createModLayout();
-
-    QVBoxLayout * createOsc1Layout();
-    QVBoxLayout * createOsc2Layout();
-
-    QHBoxLayout  * createFilterEnvelopeLayout();
-    QHBoxLayout  * createVolumeEnvelopeLayout();
-    QHBoxLayout  * createMasterLayout();
-    QWidget  * createKeyboardWidget();
+    // adds a knob to the surface and returns its id
+    int createKnob(QPoint position,
+                   double minimum,
+                   double maximum,
+                   double initialValue,
+                   QString labelText,
+                   int decimalPlaces = 0,
+                   bool log = false,
+                   bool useFormatter = false,
+                   QString suffixText = ""
+                   );
+
+    QComboBox * createComboBox(QStringList items, const QRect& rect);
+
+    void createModSection();
+    void createOscillatorSection(const QRect& section, QString title, QStringList intervals,
+                                 wave_shape& waveform, VoiceNode::ParameterId waveformId, int& interval,
+                                 double& detune, VoiceNode::ParameterId detuneId,
+                                 double& mix, VoiceNode::ParameterId mixId);
+    void createFilterSection();
+    void createFilterEnvelopeSection();
+    void createVolumeEnvelopeSection();
+    void createMasterSection();
+
+    // apply runs, coalesced to once per display frame, whenever the knob turns
+    void onKnobChanged(int knob, std::function<void(double)> apply);
+    void connectKnobToMember(int knob, double& memberVar, std::function<void()> onUpdate = nullptr);
+    void connectKnobToParameter(int knob, double& memberVar, VoiceNode::ParameterId id, double scale);
 
 private slots:
 
 protected:
-    void updateVoices();
+    // audio thread: hands knob changes since the last block to every voice
+    void applyVoiceParameters();
 
     void noteOn(int nodeIndex);
     void noteOff(int nodeIndex);
 
     void showTooltip(const QPoint &point, QString toolTipText);
-    void showKnobTooltip(const KnobControl* knob, int decimalPlaces = 0, bool logarithmic = false, bool useFormatter = false, QString suffix = "");
+    void showKnobTooltip(int knob);
 
 private:
+    // how a knob's tooltip shows its value
+    struct KnobFormat {
+        int decimal_places = 0;
+        bool logarithmic = false;
+        bool use_formatter = false;
+        QString suffix;
+    };
+
     std::shared_ptr<SpriteSheet> spritesheet_;
+    ControlSurface* surface_ = nullptr;
 
     //std::unique_ptr<AudioPlayer> audio_player_;
     AudioPlayer audio_player_;
@@ -121,10 +133,22 @@ private:
 
     ToolTip knob_tooltip_;
 
+    // knob moves and their tooltips, merged to one update per display frame
+    UpdateCoalescer knob_updates_;
+    // by knob id: its coalescer slots, and its tooltip format
+    std::vector<std::vector<int>> knob_slots_;
+    std::vector<KnobFormat> knob_formats_;
+
     //VoiceNode m_voice[16] { VoiceNode };
 
     std::vector<VoiceNode *> voices_;
 
+    // Knob values for the voices, by VoiceNode::ParameterId. Knobs write it from the GUI
+    // thread, the audio callback applies what changed at the start of each block; the
+    // members above stay the GUI's own copy.
+    ParameterStore voice_parameters_;
+    std::vector<ParameterStore::Change> parameter_changes_;
+
     // volume sets masterGain in real time.
     // since there is only one masterGain
     // at any time we don't need to cache the value
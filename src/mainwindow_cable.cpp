@@ -1,97 +1,257 @@
 #include "mainwindow_cable.h"
 
-#include <QHBoxLayout>
-#include <QLabel>
+#include "definitions.h"
+#include "scopeview.h"
+
+#include <QDebug>
+#include <QKeyEvent>
 #include <QVBoxLayout>
-#include <QWidget>
+
+#include <cmath>
+#include <utility>
+
+namespace
+{
+// one octave from middle C on the home row, black keys on the row above
+const std::pair<int, int> kKeyNotes[] =
+    {
+        { Qt::Key_A, 60 }, { Qt::Key_W, 61 }, { Qt::Key_S, 62 }, { Qt::Key_E, 63 },
+        { Qt::Key_D, 64 }, { Qt::Key_F, 65 }, { Qt::Key_T, 66 }, { Qt::Key_G, 67 },
+        { Qt::Key_Y, 68 }, { Qt::Key_H, 69 }, { Qt::Key_U, 70 }, { Qt::Key_J, 71 },
+        { Qt::Key_K, 72 }
+};
+
+int noteForKey(int key)
+{
+    for (const auto& keyNote : kKeyNotes)
+    {
+        if (keyNote.first == key)
+            return keyNote.second;
+    }
+    return -1;
+}
+}
 
 MainWindow_Cable::MainWindow_Cable(QWidget* parent)
     : QMainWindow(parent)
+    , audio_context_(SAMPLE_RATE, FRAMES)
+    , live_graph_(audio_context_)
+    , audio_player_(nullptr, SAMPLE_RATE, FRAMES)
 {
-    auto* panel = new PatchPanelWidget(this);
-    setCentralWidget(panel);
+    auto* central = new QWidget(this);
+    auto* layout = new QVBoxLayout(central);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->setSpacing(0);
+
+    patch_panel_ = new PatchPanelWidget(central);
+    scope_view_ = new ScopeView(central);
+    scope_view_->setFixedHeight(140);
+    layout->addWidget(patch_panel_, 1);
+    layout->addWidget(scope_view_);
+    setCentralWidget(central);
+
+    keyboard_cv_out_ = patch_panel_->addOutputJack("Keyboard CV Out", QRect(40, 40, 150, 36), QColor(180, 70, 70));
+    vco_pitch_in_ = patch_panel_->addInputJack("VCO 1V/Oct", QRect(330, 40, 150, 36), QColor(70, 120, 180));
+    vcf_cutoff_in_ = patch_panel_->addInputJack("VCF Cutoff CV", QRect(330, 100, 150, 36), QColor(70, 160, 100));
 
-    panel->addOutputJack("Keyboard CV Out", QRect(40, 40, 150, 36), QColor(180, 70, 70));
-    panel->addInputJack("VCO 1V/Oct", QRect(330, 40, 150, 36), QColor(70, 120, 180));
-    panel->addInputJack("VCF Cutoff CV", QRect(330, 100, 150, 36), QColor(70, 160, 100));
+    lfo_out_ = patch_panel_->addOutputJack("LFO Out", QRect(40, 160, 150, 36), QColor(180, 140, 60));
+    pwm_in_ = patch_panel_->addInputJack("PWM In", QRect(330, 160, 150, 36), QColor(140, 90, 180));
 
-    panel->addOutputJack("LFO Out", QRect(40, 160, 150, 36), QColor(180, 140, 60));
-    panel->addInputJack("PWM In", QRect(330, 160, 150, 36), QColor(140, 90, 180));
+    buildGraph();
 
-    resize(560, 280);
+    connect(patch_panel_, &PatchPanelWidget::cableConnected, this, &MainWindow_Cable::onCableConnected);
+    connect(patch_panel_, &PatchPanelWidget::cableDisconnected, this, &MainWindow_Cable::onCableDisconnected);
+
+    // about once per display frame; the panel only redraws when a level changes step
+    level_timer_.setInterval(16);
+    connect(&level_timer_, &QTimer::timeout, this, &MainWindow_Cable::showLevels);
+    level_timer_.start();
+
+    resize(560, 420);
     setWindowTitle("Modular Patch Panel UI Test");
+
+    // edits queued by the panel are applied at the start of each block
+    audio_player_.setCallback([this](const void* user_data, float* output, unsigned long frames_per_buffer) {
+        live_graph_.process(frames_per_buffer);
+        const float* buffer = live_graph_.buffer();
+
+        for (unsigned long i = 0; i < frames_per_buffer; ++i) {
+            const float sample = buffer != nullptr ? buffer[i] : 0.0f;
+            output[i * 2] = sample;
+            output[i * 2 + 1] = sample;
+        }
+
+        audio_context_.updateBatch(frames_per_buffer);
+    });
+
+    if (!audio_player_.initializeStream()) {
+        qDebug() << "Failed to initialize audio stream!";
+    }
+
+    if (!audio_player_.start()) {
+        qDebug() << "Failed to start audio stream!";
+    }
 }
 
-QWidget* MainWindow_Cable::createModularPanel()
+void MainWindow_Cable::buildGraph()
 {
-    auto* holder = new QWidget;
-    auto* layout = new QVBoxLayout(holder);
-    layout->setContentsMargins(0, 0, 0, 0);
-    layout->setSpacing(8);
+    keyboard_node_ = live_graph_.addNode("value");
+    const int vco = live_graph_.addNode("oscillator");
+    const int lfo = live_graph_.addNode("oscillator");
+    const int cutoff_cv = live_graph_.addNode("muladd");
+    const int pwm_cv = live_graph_.addNode("muladd");
+    const int filter = live_graph_.addNode("lp12");
+    envelope_node_ = live_graph_.addNode("adsr");
+    const int amp = live_graph_.addNode("gain");
 
-    //auto* title = createLabel("PATCH PANEL", true, 12);
-    //layout->addWidget(title);
+    if (keyboard_node_ < 0 || vco < 0 || lfo < 0 || cutoff_cv < 0 || pwm_cv < 0 || filter < 0 || envelope_node_ < 0 || amp < 0) {
+        qDebug() << "Failed to build the patch panel graph";
+        return;
+    }
 
-    patch_panel_ = new PatchPanelWidget;
-    patch_panel_->setMinimumHeight(260);
+    const auto port = [this](int node, const char* name) {
+        return static_cast<unsigned>(live_graph_.graph().nodeType(static_cast<unsigned>(node))->portIndex(name));
+    };
 
-    const QColor cvColor(70, 140, 200);
-    const QColor audioColor(180, 70, 70);
+    // pulse VCO, so PWM In is audible; the CV inputs scale what is patched into them
+    live_graph_.setParameter(vco, "waveform", 5.0f);
+    live_graph_.setParameter(vco, "algorithm", 1.0f);
+    live_graph_.setParameter(lfo, "frequency", 3.0f);
+    live_graph_.setParameter(cutoff_cv, "multiply", 1500.0f);
+    live_graph_.setParameter(pwm_cv, "multiply", 0.4f);
+    live_graph_.setParameter(filter, "cutoff", 2000.0f);
+    live_graph_.setParameter(filter, "resonance", 1.5f);
+    live_graph_.setParameter(envelope_node_, "sustain", 0.7f);
+    live_graph_.setParameter(envelope_node_, "release", 0.3f);
+    // the envelope opens the amp
+    live_graph_.setParameter(amp, "gain", 0.0f);
 
-    keyboard_cv_out_ = patch_panel_->addOutputJack(
-        "CV Out",
-        QRect(20, 30, 120, 28),
-        cvColor);
+    // the wiring behind the panel
+    live_graph_.connect(vco, filter);
+    live_graph_.connect(filter, amp);
+    live_graph_.connect(envelope_node_, amp, port(amp, "gain"));
+    live_graph_.connect(cutoff_cv, filter, port(filter, "cutoff"));
+    live_graph_.connect(pwm_cv, vco, port(vco, "pulse_width"));
+    live_graph_.setOutput(amp);
+    showOnScope(static_cast<unsigned>(amp));
 
-    vco_mod_in_ = patch_panel_->addInputJack(
-        "Mod",
-        QRect(220, 30, 120, 28),
-        cvColor);
+    // the keyboard sends its note as a frequency in Hz rather than a voltage
+    bindJack(keyboard_cv_out_, keyboard_node_);
+    bindJack(vco_pitch_in_, vco, port(vco, "frequency"));
+    bindJack(vcf_cutoff_in_, cutoff_cv);
+    bindJack(lfo_out_, lfo);
+    bindJack(pwm_in_, pwm_cv);
 
-    vco_out_ = patch_panel_->addOutputJack(
-        "Out",
-        QRect(220, 90, 120, 28),
-        audioColor);
+    // the keyboard's frequency would read as clipping on an audio meter, so it isn't metered
+    meterOutput(lfo_out_, lfo);
+}
 
-    output_in_ = patch_panel_->addInputJack(
-        "In",
-        QRect(420, 60, 120, 28),
-        audioColor);
+void MainWindow_Cable::meterOutput(OutputJack* jack, int node)
+{
+    auto meter = std::make_unique<LevelMeter>(static_cast<float>(SAMPLE_RATE));
+    if (!live_graph_.setMeter(static_cast<unsigned>(node), meter.get()))
+        return;
 
-    layout->addWidget(patch_panel_);
+    metered_outputs_.push_back({ jack, std::move(meter) });
+}
 
-    return holder;
+void MainWindow_Cable::showLevels()
+{
+    for (const MeteredOutput& output : metered_outputs_)
+        patch_panel_->setOutputLevel(output.jack, output.meter->peak(), output.meter->rms());
 }
 
-void MainWindow_Cable::noteOn(int noteIndex)
+void MainWindow_Cable::bindJack(const JackBase* jack, int node, unsigned port)
 {
-    qDebug() << "NoteOn => Note Index:" << noteIndex;
+    bindings_[jack] = { static_cast<unsigned>(node), port };
+}
 
-    if (!isPatched(keyboard_cv_out_, vco_mod_in_)) {
-        qDebug() << "Keyboard CV not patched to VCO Mod";
+void MainWindow_Cable::onCableConnected(OutputJack* output, InputJack* input)
+{
+    const auto from = bindings_.find(output);
+    const auto to = bindings_.find(input);
+    if (from == bindings_.end() || to == bindings_.end())
+        return;
+
+    // a refused cable (say, one closing a loop) is taken off the panel again
+    if (!live_graph_.connect(from->second.node, to->second.node, to->second.port))
+    {
+        output->removeTarget(input);
         return;
     }
 
-    if (!isPatched(vco_out_, output_in_)) {
-        qDebug() << "VCO Out not patched to Output In";
+    showOnScope(from->second.node);
+}
+
+void MainWindow_Cable::showOnScope(unsigned node)
+{
+    if (static_cast<int>(node) == scope_node_)
+        return;
+
+    if (scope_node_ >= 0)
+        live_graph_.setTap(static_cast<unsigned>(scope_node_), nullptr);
+
+    if (!live_graph_.setTap(node, &scope_tap_))
+    {
+        scope_node_ = -1;
+        return;
+    }
+
+    scope_node_ = static_cast<int>(node);
+    scope_view_->setTap(&scope_tap_, SAMPLE_RATE / static_cast<double>(scope_tap_.decimation()));
+}
+
+void MainWindow_Cable::onCableDisconnected(OutputJack* output, InputJack* input)
+{
+    const auto from = bindings_.find(output);
+    const auto to = bindings_.find(input);
+    if (from == bindings_.end() || to == bindings_.end())
+        return;
+
+    live_graph_.disconnect(from->second.node, to->second.node, to->second.port);
+}
+
+void MainWindow_Cable::keyPressEvent(QKeyEvent* event)
+{
+    const int note = noteForKey(event->key());
+    if (note < 0 || event->isAutoRepeat())
+    {
+        QMainWindow::keyPressEvent(event);
         return;
     }
+    noteOn(note);
+}
 
-    const double frequency = noteIndexToFrequency(noteIndex);
-    qDebug() << "Frequency:" << frequency;
+void MainWindow_Cable::keyReleaseEvent(QKeyEvent* event)
+{
+    const int note = noteForKey(event->key());
+    if (note < 0 || event->isAutoRepeat())
+    {
+        QMainWindow::keyReleaseEvent(event);
+        return;
+    }
+    noteOff(note);
+}
 
-    //auto voice = voices_.begin();
-    //if (voice == voices_.end()) {
-    //    return;
-    //}
+void MainWindow_Cable::noteOn(int noteIndex)
+{
+    if (keyboard_node_ < 0 || envelope_node_ < 0)
+        return;
 
-    //(*voice)->updateOscillator1Frequency(static_cast<float>(frequency));
-    //(*voice)->noteOn();
+    // without a cable from Keyboard CV Out the VCO doesn't follow the keys
+    held_note_ = noteIndex;
+    live_graph_.setParameter(keyboard_node_, 0u, static_cast<float>(noteIndexToFrequency(noteIndex)));
+    live_graph_.setParameter(envelope_node_, "gate", 1.0f);
 }
 
-bool MainWindow_Cable::isPatched(const OutputJack* out, const InputJack* in) const
+void MainWindow_Cable::noteOff(int noteIndex)
 {
-    return out != nullptr && in != nullptr && in->source() == out;
+    // last note priority: releasing an earlier key leaves the current note sounding
+    if (noteIndex != held_note_ || envelope_node_ < 0)
+        return;
+
+    held_note_ = -1;
+    live_graph_.setParameter(envelope_node_, "gate", 0.0f);
 }
 
 double MainWindow_Cable::noteIndexToFrequency(int noteIndex) const
@@ -1,28 +1,90 @@
 #pragma once
 
+#include "audiocontext.h"
+#include "audioplayer.h"
+#include "levelmeter.h"
+#include "livegraph.h"
 #include "patchpanelwidget.h"
+#include "signaltap.h"
+
 #include <QMainWindow>
+#include <QTimer>
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+class QKeyEvent;
+class ScopeView;
 
+// A small modular voice played from the computer keyboard, patched on a PatchPanelWidget.
+// Each jack stands for a node of a LiveGraph, and an input jack also for one of its
+// ports, so dropping or pulling a cable is sent to the audio thread as a graph edit and
+// heard from the next block without stopping the stream. A scope below the panel shows
+// the node behind the last cable plugged, starting with the amp at the end of the chain.
+// Audio outputs are metered, and their cables light up with the level.
 class MainWindow_Cable : public QMainWindow
 {
     Q_OBJECT
 
 public:
     explicit MainWindow_Cable(QWidget* parent = nullptr);
+    ~MainWindow_Cable() override { audio_player_.stop(); }
+
+protected:
+    void keyPressEvent(QKeyEvent* event) override;
+    void keyReleaseEvent(QKeyEvent* event) override;
 
 private:
-    PatchPanelWidget* patch_panel_ = nullptr;
+    // where a jack plugs into the graph; port is PATCH_INPUT_PORT for an audio input
+    struct JackBinding
+    {
+        unsigned node = 0;
+        unsigned port = PATCH_INPUT_PORT;
+    };
 
-    OutputJack* keyboard_cv_out_ = nullptr;
-    InputJack* vco_mod_in_ = nullptr;
-    OutputJack* vco_out_ = nullptr;
-    InputJack* output_in_ = nullptr;
+    struct MeteredOutput
+    {
+        OutputJack* jack = nullptr;
+        std::unique_ptr<LevelMeter> meter;
+    };
+
+    void buildGraph();
+    void bindJack(const JackBase* jack, int node, unsigned port = PATCH_INPUT_PORT);
+    void onCableConnected(OutputJack* output, InputJack* input);
+    void onCableDisconnected(OutputJack* output, InputJack* input);
+    void showOnScope(unsigned node);
+    void meterOutput(OutputJack* jack, int node);
+    void showLevels();
 
-private:
-    QWidget* createModularPanel();
-    bool isPatched(const OutputJack* out, const InputJack* in) const;
     double noteIndexToFrequency(int noteIndex) const;
     void noteOn(int noteIndex);
     void noteOff(int noteIndex);
 
+private:
+    AudioContext audio_context_;
+    LiveGraph live_graph_;
+    AudioPlayer audio_player_;
+
+    PatchPanelWidget* patch_panel_ = nullptr;
+    ScopeView* scope_view_ = nullptr;
+
+    // moved from node to node; both are only touched by the one audio thread
+    SignalTap scope_tap_;
+    int scope_node_ = -1;
+
+    OutputJack* keyboard_cv_out_ = nullptr;
+    InputJack* vco_pitch_in_ = nullptr;
+    InputJack* vcf_cutoff_in_ = nullptr;
+    OutputJack* lfo_out_ = nullptr;
+    InputJack* pwm_in_ = nullptr;
+
+    std::unordered_map<const JackBase*, JackBinding> bindings_;
+
+    std::vector<MeteredOutput> metered_outputs_;
+    QTimer level_timer_;
+
+    int keyboard_node_ = -1;
+    int envelope_node_ = -1;
+    int held_note_ = -1;
 };
@@ -1,4 +1,5 @@
 ﻿#include "mixernode.h"
+#include "workerpool.h"
 #include <algorithm>
 
 void MixerNode::processInternal(unsigned frames) {
@@ -11,7 +12,13 @@ void MixerNode::processInternal(unsigned frames) {
     // Calculate normalization factor
     float normalizationFactor = 1.0f / static_cast<float>(inputs_.size());
 
-    // Sum the outputs of all input nodes with normalization
+    if (pool_ != nullptr && inputs_.size() > 1) {
+        pool_->run(static_cast<unsigned>(inputs_.size()), [this, frames](unsigned index) {
+            inputs_[index].node->process(frames, last_processing_id_);
+        });
+    }
+
+    // Sum the outputs of all input nodes with normalization, always in input order
     for (auto input_node : inputs_) {
         input_node.node->process(frames, last_processing_id_);
         float* inputBuffer = input_node.node->buffer();
@@ -4,6 +4,8 @@
 
 #include "audionode.h"
 
+class WorkerPool;
+
 class MixerNode final : public AudioNode
 {
 public:
@@ -17,6 +19,13 @@ public:
 
     void addInput(AudioNode* node, float gain);
     void removeInput(AudioNode* node);
+    // so that adding up to count inputs doesn't allocate
+    void reserveInputs(unsigned count) { inputs_.reserve(count); }
+
+    // Processes the inputs on the pool's threads, then sums them on the calling thread in
+    // input order, so the result is the same for any thread count. The inputs must not
+    // share upstream nodes, or two threads would process the shared node at once.
+    void setWorkerPool(WorkerPool* pool) { pool_ = pool; }
 
     //void setInputGain(AudioNode* node, float gain);
 
@@ -31,4 +40,5 @@ private:
 private:
     std::vector<InputNodeInfo> inputs_;
     std::mutex input_mutex_;
+    WorkerPool* pool_ = nullptr;
 };
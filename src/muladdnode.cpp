@@ -14,11 +14,9 @@ void MulAddNode::processInternal(unsigned int frames) {
     multiply_automation_.process(frames, last_processing_id_);
     add_automation_.process(frames, last_processing_id_);
 
-    const auto multiply_buffer = std::make_unique<float[]>(frames);
-    memcpy(multiply_buffer.get(), multiply_automation_.buffer(), frames * sizeof(float));
-
-    const auto add_buffer = std::make_unique<float[]>(frames);
-    memcpy(add_buffer.get(), add_automation_.buffer(), frames * sizeof(float));
+    // the automation buffers stay put until their next process, so read them in place
+    const float* multiply_buffer = multiply_automation_.buffer();
+    const float* add_buffer = add_automation_.buffer();
 
     input_->process(frames, last_processing_id_);
     const float* input_buffer = input_->buffer();
@@ -16,6 +16,9 @@ public:
 
     MulAddNode(AudioContext& context, float multiplier = 1.0f, float addend = 0.0f);
 
+    void setMultiplier(float multiplier) { multiply_automation_.setBaseValue(multiplier); }
+    void setAddend(float addend) { add_automation_.setBaseValue(addend); }
+
 private:
     AutomationNode multiply_automation_;
     AutomationNode add_automation_;
@@ -0,0 +1,250 @@
+#include "noderegistry.h"
+#include "adsrnode.h"
+#include "arithmeticnode.h"
+#include "automationnode.h"
+#include "gainnode.h"
+#include "lp12filternode.h"
+#include "mixernode.h"
+#include "muladdnode.h"
+#include "noisenode.h"
+#include "oscillatornode.h"
+#include "voicenode.h"
+
+#include <iostream>
+#include <new>
+
+namespace {
+
+// in wave_shape, OscillatorNode::Algorithm and ArithmeticNode::Operation order
+const char* const WAVEFORMS[] = { "sine", "triangle", "square", "sawtooth", "inv_sawtooth", "pulse", nullptr };
+const char* const ALGORITHMS[] = { "naive", "polyblep", "wavetable", "oversampled", nullptr };
+const char* const OPERATIONS[] = { "add", "subtract", "multiply", "divide", nullptr };
+
+// whether value is the index of one of the choices, i.e. safe to cast to their enum
+bool isChoice(const char* const* choices, const float value) {
+    unsigned count = 0;
+    while (choices[count] != nullptr) {
+        ++count;
+    }
+    return value >= 0.0f && value < static_cast<float>(count);
+}
+
+template<typename Node>
+NodeType makeType(const char* name, std::vector<NodeType::Parameter> parameters, std::vector<const char*> ports) {
+    NodeType type;
+    type.name = name;
+    type.id = NodeRegistry::hashName(name);
+    type.size = sizeof(Node);
+    type.alignment = alignof(Node);
+    type.parameters = std::move(parameters);
+    type.ports = std::move(ports);
+    type.construct = [](void* memory, AudioContext& context) -> AudioNode* { return new (memory) Node(context); };
+    type.set_parameter = [](AudioNode*, unsigned, float) {};
+    return type;
+}
+
+NodeRegistry makeBuiltin() {
+    NodeRegistry registry;
+
+    NodeType gain = makeType<GainNode>("gain", { { "gain", 1.0f } }, { "gain" });
+    gain.set_parameter = [](AudioNode* node, unsigned, float value) { static_cast<GainNode*>(node)->setGain(value); };
+    registry.add(gain);
+
+    NodeType oscillator = makeType<OscillatorNode>("oscillator",
+                                                   { { "waveform", 0.0f, WAVEFORMS },
+                                                     { "frequency", 0.0f },
+                                                     { "detune", 0.0f },
+                                                     { "pulse_width", 0.5f },
+                                                     { "algorithm", 0.0f, ALGORITHMS } },
+                                                   { "frequency", "pulse_width" });
+    oscillator.set_parameter = [](AudioNode* node, unsigned index, float value) {
+        auto target = static_cast<OscillatorNode*>(node);
+        switch (index) {
+        case 0:
+            if (isChoice(WAVEFORMS, value)) {
+                target->setWaveform(static_cast<wave_shape>(static_cast<int>(value)));
+            }
+            break;
+        case 1: target->setFrequency(value); break;
+        case 2: target->setDetune(value); break;
+        case 3: target->setPulseWidth(value); break;
+        case 4:
+            if (isChoice(ALGORITHMS, value)) {
+                target->setAlgorithm(static_cast<OscillatorNode::Algorithm>(static_cast<int>(value)));
+            }
+            break;
+        }
+    };
+    registry.add(oscillator);
+
+    NodeType lp12 = makeType<LP12FilterNode>("lp12", { { "cutoff", 20000.0f }, { "resonance", 1.0f }, { "detune", 0.0f } },
+                                             { "cutoff", "resonance", "detune" });
+    lp12.set_parameter = [](AudioNode* node, unsigned index, float value) {
+        auto filter = static_cast<LP12FilterNode*>(node);
+        switch (index) {
+        case 0: filter->setCutoff(value); break;
+        case 1: filter->setResonance(value); break;
+        case 2: filter->setDetune(value); break;
+        }
+    };
+    registry.add(lp12);
+
+    NodeType adsr = makeType<ADSRNode>("adsr",
+                                       { { "attack", 0.01f }, { "decay", 0.1f }, { "sustain", 0.8f },
+                                         { "release", 0.5f }, { "gate", 0.0f, nullptr, true } },
+                                       { "gate" });
+    adsr.set_parameter = [](AudioNode* node, unsigned index, float value) {
+        auto envelope = static_cast<ADSRNode*>(node);
+        switch (index) {
+        case 0: envelope->setAttack(value); break;
+        case 1: envelope->setDecay(value); break;
+        case 2: envelope->setSustain(value); break;
+        case 3: envelope->setRelease(value); break;
+        case 4: envelope->setGate(value >= 0.5f); break;
+        }
+    };
+    registry.add(adsr);
+
+    NodeType muladd = makeType<MulAddNode>("muladd", { { "multiply", 1.0f }, { "add", 0.0f } }, { "multiply", "add" });
+    muladd.set_parameter = [](AudioNode* node, unsigned index, float value) {
+        auto target = static_cast<MulAddNode*>(node);
+        index == 0 ? target->setMultiplier(value) : target->setAddend(value);
+    };
+    registry.add(muladd);
+
+    NodeType arithmetic = makeType<ArithmeticNode>("arithmetic", { { "operation", 0.0f, OPERATIONS }, { "value", 0.0f } },
+                                                   { "value" });
+    arithmetic.set_parameter = [](AudioNode* node, unsigned index, float value) {
+        auto target = static_cast<ArithmeticNode*>(node);
+        if (index == 0) {
+            if (isChoice(OPERATIONS, value)) {
+                target->setOperation(static_cast<ArithmeticNode::Operation>(static_cast<int>(value)));
+            }
+        } else {
+            target->setValue(value);
+        }
+    };
+    registry.add(arithmetic);
+
+    NodeType mixer = makeType<MixerNode>("mixer", {}, {});
+    mixer.add_input = [](AudioNode* node, AudioNode* input) { static_cast<MixerNode*>(node)->addInput(input, 1.0f); };
+    mixer.remove_input = [](AudioNode* node, AudioNode* input) { static_cast<MixerNode*>(node)->removeInput(input); };
+    mixer.reserve_inputs = [](AudioNode* node, unsigned count) { static_cast<MixerNode*>(node)->reserveInputs(count); };
+    registry.add(mixer);
+
+    // a seed of 0 keeps the one drawn from the context
+    NodeType noise = makeType<NoiseNode>("noise", { { "seed", 0.0f, nullptr, true } }, {});
+    noise.set_parameter = [](AudioNode* node, unsigned, float value) {
+        if (value != 0.0f) {
+            static_cast<NoiseNode*>(node)->setSeed(static_cast<std::uint64_t>(value));
+        }
+    };
+    registry.add(noise);
+
+    // a constant, plus its input when one is patched
+    NodeType constant = makeType<AutomationNode>("value", { { "value", 0.0f } }, {});
+    constant.set_parameter = [](AudioNode* node, unsigned, float value) { static_cast<AutomationNode*>(node)->setBaseValue(value); };
+    registry.add(constant);
+
+    const VoiceNode::VoiceParameters voice_defaults;
+    NodeType voice = makeType<VoiceNode>("voice",
+                                         { { "mod_waveform", 0.0f, WAVEFORMS },
+                                           { "oscillator_1_waveform", 0.0f, WAVEFORMS },
+                                           { "oscillator_2_waveform", 0.0f, WAVEFORMS },
+                                           { "mod_frequency", voice_defaults.mod_frequency },
+                                           { "oscillator_1_mod_gain", voice_defaults.oscillator_1_mod_gain },
+                                           { "oscillator_2_mod_gain", voice_defaults.oscillator_2_mod_gain },
+                                           { "oscillator_1_frequency", voice_defaults.oscillator_1_frequency },
+                                           { "oscillator_2_frequency", voice_defaults.oscillator_2_frequency },
+                                           { "oscillator_1_gain", voice_defaults.oscillator_1_gain },
+                                           { "oscillator_2_gain", voice_defaults.oscillator_2_gain },
+                                           { "oscillator_1_detune", voice_defaults.oscillator_1_detune },
+                                           { "oscillator_2_detune", voice_defaults.oscillator_2_detune },
+                                           { "attack", voice_defaults.volume_envelope_a_ },
+                                           { "decay", voice_defaults.volume_envelope_d_ },
+                                           { "sustain", voice_defaults.volume_envelope_s_ },
+                                           { "release", voice_defaults.volume_envelope_r_ },
+                                           { "gate", 0.0f, nullptr, true } },
+                                         {});
+    // the list above is in VoiceNode::ParameterId order
+    voice.set_parameter = [](AudioNode* node, unsigned index, float value) {
+        const auto id = static_cast<VoiceNode::ParameterId>(index);
+        const bool waveform = id == VoiceNode::ParameterId::ModWaveform ||
+                              id == VoiceNode::ParameterId::Oscillator1Waveform ||
+                              id == VoiceNode::ParameterId::Oscillator2Waveform;
+        if (index < VoiceNode::PARAMETER_COUNT && (!waveform || isChoice(WAVEFORMS, value))) {
+            static_cast<VoiceNode*>(node)->setParameter(id, value);
+        }
+    };
+    registry.add(voice);
+
+    return registry;
+}
+
+}
+
+int NodeType::parameterIndex(const std::string& parameter) const {
+    for (size_t i = 0; i < parameters.size(); ++i) {
+        if (parameter == parameters[i].name) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+int NodeType::portIndex(const std::string& port) const {
+    for (size_t i = 0; i < ports.size(); ++i) {
+        if (port == ports[i]) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+unsigned NodeType::choiceCount(const unsigned parameter) const {
+    unsigned count = 0;
+    for (const char* const* choice = parameters[parameter].choices; choice && *choice; ++choice) {
+        ++count;
+    }
+    return count;
+}
+
+const NodeRegistry& NodeRegistry::builtin() {
+    static const NodeRegistry registry = makeBuiltin();
+    return registry;
+}
+
+bool NodeRegistry::add(NodeType type) {
+    if (find(type.name) || find(type.id)) {
+        std::cerr << "Node type " << type.name << " is already registered\n";
+        return false;
+    }
+    types_.push_back(std::move(type));
+    return true;
+}
+
+const NodeType* NodeRegistry::find(const std::string& name) const {
+    for (const NodeType& type : types_) {
+        if (name == type.name) {
+            return &type;
+        }
+    }
+    return nullptr;
+}
+
+const NodeType* NodeRegistry::find(const std::uint32_t id) const {
+    for (const NodeType& type : types_) {
+        if (type.id == id) {
+            return &type;
+        }
+    }
+    return nullptr;
+}
+
+std::uint32_t NodeRegistry::hashName(const char* name) {
+    std::uint32_t hash = 2166136261u;
+    for (; *name; ++name) {
+        hash = (hash ^ static_cast<unsigned char>(*name)) * 16777619u;
+    }
+    return hash;
+}
@@ -0,0 +1,75 @@
+#ifndef NODEREGISTRY_H
+#define NODEREGISTRY_H
+
+#include "audiocontext.h"
+#include "audionode.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Everything needed to build one kind of node from data: its size for placement into a
+// preallocated arena, its parameters in a fixed order, and its automation ports in the
+// order of the node's Parameters enum. Patch files refer to types by id, a hash of the
+// name, so reordering or adding types doesn't break existing files.
+struct NodeType
+{
+    struct Parameter {
+        const char* name;
+        float default_value;
+        // null-terminated value names for enumerated parameters, stored as their index
+        const char* const* choices = nullptr;
+        // Part of the running state rather than the sound, like a gate or a seed. Set when
+        // the graph is built, left alone when a patch with the same topology is loaded.
+        bool state = false;
+    };
+
+    const char* name = nullptr;
+    std::uint32_t id = 0;
+
+    std::size_t size = 0;
+    std::size_t alignment = 0;
+
+    std::vector<Parameter> parameters;
+    std::vector<const char*> ports;
+
+    AudioNode* (*construct)(void* memory, AudioContext& context) = nullptr;
+    void (*set_parameter)(AudioNode* node, unsigned index, float value) = nullptr;
+    // Patches an audio input into the node. Null means AudioNode::connect, which replaces
+    // the single input; mixers add to their list instead.
+    void (*add_input)(AudioNode* node, AudioNode* input) = nullptr;
+    // its counterpart for removing one input; null means AudioNode::setInput(nullptr)
+    void (*remove_input)(AudioNode* node, AudioNode* input) = nullptr;
+    // makes room for that many inputs, so add_input doesn't allocate up to there
+    void (*reserve_inputs)(AudioNode* node, unsigned count) = nullptr;
+
+    int parameterIndex(const std::string& parameter) const;
+    int portIndex(const std::string& port) const;
+    // number of choices for an enumerated parameter, 0 for a plain number
+    unsigned choiceCount(unsigned parameter) const;
+};
+
+// Lookup table from type name or id to NodeType. builtin() holds every node in the
+// engine; a service with its own nodes copies it and adds to the copy.
+class NodeRegistry
+{
+public:
+    static const NodeRegistry& builtin();
+
+    // Fails with a message on std::cerr when the name or its id is already taken
+    bool add(NodeType type);
+
+    const NodeType* find(const std::string& name) const;
+    const NodeType* find(std::uint32_t id) const;
+
+    const std::vector<NodeType>& types() const { return types_; }
+
+    // FNV-1a, the id stored in patch files
+    static std::uint32_t hashName(const char* name);
+
+private:
+    std::vector<NodeType> types_;
+};
+
+#endif // NODEREGISTRY_H
@@ -0,0 +1,21 @@
+#include "noisenode.h"
+
+NoiseNode::NoiseNode(AudioContext& context) : AudioNode(context) {
+    setSeed(context.nextRandomSeed());
+}
+
+void NoiseNode::setSeed(std::uint64_t seed) {
+    // xorshift never leaves the all-zero state
+    state_ = seed != 0 ? seed : 0x9e3779b97f4a7c15ull;
+}
+
+void NoiseNode::processInternal(const unsigned int frames) {
+    for (unsigned int i = 0; i < frames; ++i) {
+        state_ ^= state_ << 13;
+        state_ ^= state_ >> 7;
+        state_ ^= state_ << 17;
+
+        // top 24 bits as a float in [0, 2), shifted to [-1, 1)
+        buffer_[i] = static_cast<float>(state_ >> 40) * (1.0f / 8388608.0f) - 1.0f;
+    }
+}
@@ -0,0 +1,29 @@
+#ifndef NOISENODE_H
+#define NOISENODE_H
+
+#include "audionode.h"
+
+#include <cstdint>
+
+// White noise in [-1, 1) from a xorshift generator. The seed comes from the context
+// (AudioContext::nextRandomSeed), so the same graph built in the same order renders the
+// same noise for the same context seed, whatever the block size.
+class NoiseNode final : public AudioNode
+{
+public:
+    explicit NoiseNode(AudioContext& context);
+
+    void setSeed(std::uint64_t seed);
+
+    void transferState(const AudioNode& other) override { state_ = static_cast<const NoiseNode&>(other).state_; }
+
+protected:
+    void processInternal(unsigned int frames) override;
+    void addAutomation(AudioNode* node, unsigned port) override {}
+    AudioNode* removeAutomation(unsigned port) override { return nullptr; }
+
+private:
+    std::uint64_t state_;
+};
+
+#endif // NOISENODE_H
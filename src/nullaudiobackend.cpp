@@ -0,0 +1,85 @@
+#include "nullaudiobackend.h"
+
+#include <chrono>
+#include <iostream>
+
+namespace {
+
+// sleep_until wakes late by up to a scheduler tick; the last stretch before a
+// deadline is spent yielding instead so blocks start on time
+constexpr auto SPIN_WINDOW = std::chrono::microseconds(200);
+
+}
+
+NullAudioBackend::NullAudioBackend(const void* user_data, const double sample_rate, const unsigned long frames_per_buffer)
+    : AudioBackend(user_data, sample_rate, frames_per_buffer) {}
+
+NullAudioBackend::~NullAudioBackend() {
+    stop();
+}
+
+bool NullAudioBackend::initializeStream() {
+    if (sample_rate_ <= 0 || frames_per_buffer_ == 0) {
+        std::cerr << "Null backend needs a positive sample rate and block size\n";
+        return false;
+    }
+
+    buffer_ = std::make_unique<float[]>(frames_per_buffer_ * CHANNELS);
+    return true;
+}
+
+bool NullAudioBackend::start() {
+    if (!buffer_ || running_) {
+        return false;
+    }
+
+    blocks_rendered_ = 0;
+    late_blocks_ = 0;
+    max_render_ns_ = 0;
+
+    running_ = true;
+    worker_ = std::thread(&NullAudioBackend::run, this);
+    return true;
+}
+
+bool NullAudioBackend::stop() {
+    running_ = false;
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+    return true;
+}
+
+void NullAudioBackend::run() {
+    using clock = std::chrono::steady_clock;
+
+    const auto period = std::chrono::duration_cast<clock::duration>(
+        std::chrono::duration<double>(static_cast<double>(frames_per_buffer_) / sample_rate_));
+
+    auto deadline = clock::now();
+
+    while (running_) {
+        const auto render_start = clock::now();
+        renderBlock(buffer_.get(), frames_per_buffer_);
+        const auto render_end = clock::now();
+
+        const double render_ns = std::chrono::duration<double, std::nano>(render_end - render_start).count();
+        if (render_ns > max_render_ns_.load(std::memory_order_relaxed)) {
+            max_render_ns_.store(render_ns, std::memory_order_relaxed);
+        }
+        blocks_rendered_.fetch_add(1, std::memory_order_relaxed);
+
+        deadline += period;
+        if (render_end > deadline) {
+            late_blocks_.fetch_add(1, std::memory_order_relaxed);
+            // don't try to catch up on a backlog; a real device would have dropped it
+            deadline = render_end;
+            continue;
+        }
+
+        std::this_thread::sleep_until(deadline - SPIN_WINDOW);
+        while (clock::now() < deadline) {
+            std::this_thread::yield();
+        }
+    }
+}
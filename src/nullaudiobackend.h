@@ -0,0 +1,39 @@
+#ifndef NULLAUDIOBACKEND_H
+#define NULLAUDIOBACKEND_H
+
+#include "audiobackend.h"
+
+#include <atomic>
+#include <memory>
+#include <thread>
+
+// Drives the graph from its own thread at the block cadence a sound card would,
+// and throws the audio away. Useful for soak tests and profiling in containers.
+class NullAudioBackend : public AudioBackend {
+
+public:
+    explicit NullAudioBackend(const void* user_data = nullptr, double sample_rate = 44100.0, unsigned long frames_per_buffer = 256);
+    ~NullAudioBackend() override;
+
+    bool initializeStream() override;
+    bool start() override;
+    bool stop() override;
+
+    unsigned long long blocksRendered() const { return blocks_rendered_.load(); }
+    // Blocks whose deadline had already passed when rendering finished
+    unsigned long long lateBlocks() const { return late_blocks_.load(); }
+    double maxRenderNs() const { return max_render_ns_.load(); }
+
+private:
+    void run();
+
+    std::unique_ptr<float[]> buffer_;
+    std::thread worker_;
+    std::atomic<bool> running_ { false };
+
+    std::atomic<unsigned long long> blocks_rendered_ { 0 };
+    std::atomic<unsigned long long> late_blocks_ { 0 };
+    std::atomic<double> max_render_ns_ { 0 };
+};
+
+#endif // NULLAUDIOBACKEND_H
@@ -1,12 +1,76 @@
 ﻿#include "oscillatornode.h"
 
+#include <algorithm>
 #include <cmath>
 #include "definitions.h"
+#include "wavetable.h"
+
+namespace {
+
+// Two-sample polynomial residual of a step from +1 to -1 at phase 0 (t and dt in cycles).
+// Subtract it for a falling edge, add it for a rising one.
+inline float polyBlep(float t, const float dt) {
+    if (t < dt) {
+        t /= dt;
+        return t + t - t * t - 1.0f;
+    }
+    if (t > 1.0f - dt) {
+        t = (t - 1.0f) / dt;
+        return t * t + t + t + 1.0f;
+    }
+    return 0.0f;
+}
+
+// Integrated polyBlep: the residual of a slope change at phase 0, scaled like polyBlep
+inline float polyBlamp(float t, const float dt) {
+    if (t < dt) {
+        t = t / dt - 1.0f;
+        return -t * t * t / 3.0f;
+    }
+    if (t > 1.0f - dt) {
+        t = (t - 1.0f) / dt + 1.0f;
+        return t * t * t / 3.0f;
+    }
+    return 0.0f;
+}
+
+inline float wrap(const float cycles) {
+    return cycles - std::floor(cycles);
+}
+
+// Blackman windowed sinc low-pass at 0.42 of the output rate, unity gain at DC
+std::array<float, OscillatorNode::OVERSAMPLING_TAPS> makeDecimationFilter() {
+    std::array<float, OscillatorNode::OVERSAMPLING_TAPS> taps {};
+    const double cutoff = 0.42 / OscillatorNode::OVERSAMPLING;
+    const double centre = (OscillatorNode::OVERSAMPLING_TAPS - 1) / 2.0;
+    double sum = 0.0;
+
+    for (unsigned i = 0; i < OscillatorNode::OVERSAMPLING_TAPS; ++i) {
+        const double x = i - centre;
+        const double sinc = x == 0.0 ? 2.0 * cutoff : std::sin(2.0 * M_PI * cutoff * x) / (M_PI * x);
+        const double w = 2.0 * M_PI * i / (OscillatorNode::OVERSAMPLING_TAPS - 1);
+        const double window = 0.42 - 0.5 * std::cos(w) + 0.08 * std::cos(2.0 * w);
+        taps[i] = static_cast<float>(sinc * window);
+        sum += taps[i];
+    }
+    for (auto& tap : taps) {
+        tap = static_cast<float>(tap / sum);
+    }
+    return taps;
+}
+
+// built when the program loads, so picking the algorithm on the audio thread computes nothing
+const std::array<float, OscillatorNode::OVERSAMPLING_TAPS> DECIMATION_FILTER = makeDecimationFilter();
+
+}
 
 
 OscillatorNode::OscillatorNode(AudioContext& context, const wave_shape waveform, const float frequency, const float detune, const float pulse_width)
     : AudioNode(context), waveform_(waveform), phase_(0.0f), detune_cents_(detune),
-    frequency_automation_(context, frequency), pulse_width_automation_(context, pulse_width) {
+    frequency_automation_(context, frequency), pulse_width_automation_(context, pulse_width),
+    oversampling_history_(2 * OVERSAMPLING_TAPS, 0.0f) {
+    // the wavetable algorithm can be picked on the audio thread, so its tables are built here
+    Wavetable::prepare();
 }
 
 void OscillatorNode::setFrequency(const float frequency) {
@@ -24,8 +88,56 @@ void OscillatorNode::setPulseWidth(const float pulse_width) {
 void OscillatorNode::setDetune(const float detune) {
     detune_cents_ = detune;
 }
+
+void OscillatorNode::setAlgorithm(const Algorithm algorithm) {
+    // the history is allocated with the node; switching only clears it, as this may run
+    // on the audio thread
+    if (algorithm == Algorithm::Oversampled && algorithm_ != Algorithm::Oversampled) {
+        std::fill(oversampling_history_.begin(), oversampling_history_.end(), 0.0f);
+        oversampling_position_ = 0;
+    }
+    algorithm_ = algorithm;
+}
+
+void OscillatorNode::transferState(const AudioNode& other) {
+    const auto& oscillator = static_cast<const OscillatorNode&>(other);
+    phase_ = oscillator.phase_;
+
+    if (algorithm_ == Algorithm::Oversampled && oscillator.algorithm_ == Algorithm::Oversampled) {
+        oversampling_history_ = oscillator.oversampling_history_;
+        oversampling_position_ = oscillator.oversampling_position_;
+    }
+}
+
 void OscillatorNode::processInternal(const unsigned int frames) {
 
+    switch (algorithm_) {
+    case Algorithm::Naive:
+        render(frames, [this](const float phase, const float, const float pulse_width) {
+            return generateSample(phase, pulse_width);
+        });
+        break;
+    case Algorithm::PolyBlep:
+        render(frames, [this](const float phase, const float increment, const float pulse_width) {
+            return polyBlepSample(phase, increment, pulse_width);
+        });
+        break;
+    case Algorithm::Wavetable:
+        render(frames, [this](const float phase, const float increment, const float pulse_width) {
+            return wavetableSample(phase, increment, pulse_width);
+        });
+        break;
+    case Algorithm::Oversampled:
+        render(frames, [this](const float phase, const float increment, const float pulse_width) {
+            return oversampledSample(phase, increment, pulse_width);
+        });
+        break;
+    }
+}
+
+template<typename Generator>
+void OscillatorNode::render(const unsigned int frames, Generator generate) {
+
     frequency_automation_.process(frames, last_processing_id_);
     pulse_width_automation_.process(frames, last_processing_id_);
 
@@ -37,15 +149,92 @@ void OscillatorNode::processInternal(const unsigned int frames) {
 
     // Generate waveform samples
     for (unsigned int i = 0; i < frames; ++i) {
-        const float current_freq = (frequency_automation_.baseValue() + frequency_buffer[i]) * detune_factor;
+        const float current_freq = frequency_buffer[i] * detune_factor;
         const float current_pulse_width = pulse_width_buffer[i];
 
-        buffer_[i] = generateSample(phase_, current_pulse_width);
+        float increment = TWO_PI * current_freq / sample_rate;
+        // past the sample rate a sample moves more than a whole cycle; fold that away here,
+        // off the phase's dependency chain, so one correction below is always enough
+        if (increment >= TWO_PI || increment <= -TWO_PI) increment = std::fmod(increment, TWO_PI);
+
+        buffer_[i] = generate(phase_, increment, current_pulse_width);
 
-        // Update phase
-        phase_ += TWO_PI * current_freq / sample_rate;
+        // Update phase; negative frequencies run it backwards
+        phase_ += increment;
         if (phase_ >= TWO_PI) phase_ -= TWO_PI;
+        else if (phase_ < 0.0f) phase_ += TWO_PI;
+    }
+}
+
+float OscillatorNode::polyBlepSample(const float phase, const float increment, const float pulse_width) const {
+    const float t = wrap(phase / TWO_PI);
+    const float dt = std::fabs(increment / TWO_PI);
+
+    switch (waveform_) {
+    case wave_shape::sine:
+        return sine(phase);
+    case wave_shape::triangle:
+        return triangle(phase) + 4.0f * dt * (polyBlamp(t, dt) - polyBlamp(wrap(t + 0.5f), dt));
+    case wave_shape::square:
+        return square(phase) + polyBlep(t, dt) - polyBlep(wrap(t + 0.5f), dt);
+    case wave_shape::sawtooth:
+    case wave_shape::inv_sawtooth: {
+        // the sawtooth drops from +1 to -1 half way through the cycle
+        const float shifted = wrap(t + 0.5f);
+        const float value = 2.0f * shifted - 1.0f - polyBlep(shifted, dt);
+        return waveform_ == wave_shape::sawtooth ? value : -value;
+    }
+    case wave_shape::pulse:
+        return pulse(phase, pulse_width) + polyBlep(t, dt) - polyBlep(wrap(t - wrap(pulse_width)), dt);
+    }
+
+    return 0.0f;
+}
+
+float OscillatorNode::wavetableSample(const float phase, const float increment, const float pulse_width) const {
+    const float t = phase / TWO_PI;
+    const float dt = increment / TWO_PI;
+
+    switch (waveform_) {
+    case wave_shape::sine:
+        return Wavetable::get(Wavetable::Shape::Sine).lookup(t, dt);
+    case wave_shape::triangle:
+        return Wavetable::get(Wavetable::Shape::Triangle).lookup(t, dt);
+    case wave_shape::square:
+        return Wavetable::get(Wavetable::Shape::Square).lookup(t, dt);
+    case wave_shape::sawtooth:
+        return Wavetable::get(Wavetable::Shape::Ramp).lookup(t + 0.5f, dt);
+    case wave_shape::inv_sawtooth:
+        return -Wavetable::get(Wavetable::Shape::Ramp).lookup(t + 0.5f, dt);
+    case wave_shape::pulse: {
+        // difference of two ramps offset by the pulse width
+        const Wavetable& ramp = Wavetable::get(Wavetable::Shape::Ramp);
+        const float width = wrap(pulse_width);
+        return ramp.lookup(t - width, dt) - ramp.lookup(t, dt) + 2.0f * width - 1.0f;
+    }
+    }
+
+    return 0.0f;
+}
+
+float OscillatorNode::oversampledSample(const float phase, const float increment, const float pulse_width) {
+    const float step = increment / OVERSAMPLING;
+
+    for (unsigned s = 0; s < OVERSAMPLING; ++s) {
+        const float value = generateSample(phase + step * static_cast<float>(s), pulse_width);
+        oversampling_history_[oversampling_position_] = value;
+        oversampling_history_[oversampling_position_ + OVERSAMPLING_TAPS] = value;
+        oversampling_position_ = (oversampling_position_ + 1) % OVERSAMPLING_TAPS;
+    }
+
+    // the filter is symmetric, so the oldest-first window can be used as is
+    const auto& taps = DECIMATION_FILTER;
+    const float* window = oversampling_history_.data() + oversampling_position_;
+    float sum = 0.0f;
+    for (unsigned i = 0; i < OVERSAMPLING_TAPS; ++i) {
+        sum += taps[i] * window[i];
     }
+    return sum;
 }
 
 //float OscillatorNode::generateSample(const float phase, const float current_pulse_width) const
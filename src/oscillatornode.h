@@ -4,8 +4,10 @@
 #include "automatedaudionode.h"
 #include "automationnode.h"
 #include "definitions.h"
+#include <array>
 #include <cmath>
 #include <functional>
+#include <vector>
 
 enum class wave_shape {
     sine,
@@ -23,6 +25,21 @@ public:
         PulseWidth = 1
     };
 
+    // How the waveform is produced, from cheapest to most expensive at equal quality:
+    //   Naive        direct evaluation of the ideal shape; aliases heavily above a few hundred Hz
+    //   PolyBlep     naive shape with polynomial band-limited step/ramp corrections at each corner
+    //   Wavetable    band-limited mip-mapped tables (see Wavetable), linearly interpolated
+    //   Oversampled  naive shape at 4x the sample rate, low-pass filtered and decimated
+    enum class Algorithm {
+        Naive,
+        PolyBlep,
+        Wavetable,
+        Oversampled
+    };
+
+    static constexpr unsigned OVERSAMPLING = 4;
+    static constexpr unsigned OVERSAMPLING_TAPS = 128;
+
 public:
     OscillatorNode(AudioContext& context, wave_shape waveform = wave_shape::sine, float frequency = 0, float detune_cents = 0, float pulse_width = 0.5f);
 
@@ -30,9 +47,14 @@ public:
     void setWaveform(wave_shape waveform);
     void setPulseWidth(float pulse_width);
     void setDetune(float detune);
+    void setAlgorithm(Algorithm algorithm);
+    Algorithm algorithm() const { return algorithm_; }
+
+    void transferState(const AudioNode& other) override;
 
 private:
     wave_shape waveform_;
+    Algorithm algorithm_ = Algorithm::Naive;
     float phase_;
     float detune_cents_;
 
@@ -45,6 +67,18 @@ protected:
     void processInternal(unsigned int frames) override;
 
 private:
+    // Runs the frequency/phase loop and fills buffer_ with generate(phase, increment, pulse_width),
+    // phase and increment in radians
+    template<typename Generator>
+    void render(unsigned int frames, Generator generate);
+
+    float polyBlepSample(float phase, float increment, float pulse_width) const;
+    float wavetableSample(float phase, float increment, float pulse_width) const;
+    float oversampledSample(float phase, float increment, float pulse_width);
+
+    // decimation filter delay line, stored twice so the newest OVERSAMPLING_TAPS are contiguous
+    std::vector<float> oversampling_history_;
+    unsigned oversampling_position_ = 0;
 
     using WaveformFunction = std::function<float(const float, const float)>;
     std::array<WaveformFunction, 6> waveform_functions_ = {
@@ -0,0 +1,71 @@
+#include "parameterstore.h"
+
+#include <algorithm>
+
+static_assert(std::atomic<float>::is_always_lock_free, "ParameterStore needs lock-free atomic floats");
+
+namespace {
+
+unsigned lowestBit(std::uint64_t bits) {
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<unsigned>(__builtin_ctzll(bits));
+#else
+    unsigned bit = 0;
+    while ((bits & 1) == 0) {
+        bits >>= 1;
+        ++bit;
+    }
+    return bit;
+#endif
+}
+
+}
+
+ParameterStore::ParameterStore(const unsigned count)
+    : count_(std::min(count, MAX_PARAMETERS)),
+      values_(std::make_unique<std::atomic<float>[]>(count_)),
+      dirty_(std::make_unique<std::atomic<std::uint64_t>[]>((count_ + 63) / 64)) {
+    for (unsigned i = 0; i < count_; ++i) {
+        values_[i].store(0.0f, std::memory_order_relaxed);
+    }
+    for (unsigned i = 0; i < (count_ + 63) / 64; ++i) {
+        dirty_[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+void ParameterStore::set(const unsigned id, const float value) {
+    if (id >= count_) {
+        return;
+    }
+
+    // value first, so whoever sees the bit also sees this value or a later one
+    values_[id].store(value, std::memory_order_relaxed);
+    dirty_[id / 64].fetch_or(std::uint64_t(1) << (id % 64), std::memory_order_release);
+    dirty_words_.fetch_or(std::uint64_t(1) << (id / 64), std::memory_order_release);
+}
+
+float ParameterStore::value(const unsigned id) const {
+    return id < count_ ? values_[id].load(std::memory_order_relaxed) : 0.0f;
+}
+
+unsigned ParameterStore::takeChanges(Change* changes) {
+    unsigned count = 0;
+
+    // A set() racing with this either lands before the exchanges and is taken now, or
+    // marks its word again afterwards and is taken next block. A value read here can be
+    // newer than its bit, in which case the same value comes out once more next block.
+    std::uint64_t words = dirty_words_.exchange(0, std::memory_order_acquire);
+    while (words != 0) {
+        const unsigned word = lowestBit(words);
+        words &= words - 1;
+
+        std::uint64_t bits = dirty_[word].exchange(0, std::memory_order_acquire);
+        while (bits != 0) {
+            const unsigned id = word * 64 + lowestBit(bits);
+            bits &= bits - 1;
+            changes[count++] = { id, values_[id].load(std::memory_order_relaxed) };
+        }
+    }
+
+    return count;
+}
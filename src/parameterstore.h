@@ -0,0 +1,53 @@
+#ifndef PARAMETERSTORE_H
+#define PARAMETERSTORE_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+// Parameter values handed from the GUI to the audio thread without locks, e.g. knob
+// positions going to every voice.
+//
+// Each parameter has a stable id, an index below size(). set() stores the value in an
+// atomic and marks the id in a dirty bitmask; takeChanges(), once per block on the audio
+// thread, clears the mask and returns each parameter set since the last call with its
+// latest value. Several sets between two blocks come out as one change. A second mask
+// with one bit per 64 ids tells takeChanges() which words to look at, so a block where
+// nothing moved costs one atomic exchange however many parameters there are.
+//
+// set() may be called from any number of threads, takeChanges() from one. Neither
+// blocks or allocates.
+class ParameterStore
+{
+public:
+    static constexpr unsigned MAX_PARAMETERS = 64 * 64;
+
+    struct Change {
+        unsigned id;
+        float value;
+    };
+
+    // parameters start at 0.0 and unchanged; count is clamped to MAX_PARAMETERS
+    explicit ParameterStore(unsigned count);
+
+    ParameterStore(const ParameterStore&) = delete;
+    ParameterStore& operator=(const ParameterStore&) = delete;
+
+    unsigned size() const { return count_; }
+
+    // Any thread. Ids out of range are ignored.
+    void set(unsigned id, float value);
+    float value(unsigned id) const;
+
+    // Audio thread. Writes the changed parameters to changes, in id order, and returns
+    // how many; changes must have room for size() entries.
+    unsigned takeChanges(Change* changes);
+
+private:
+    unsigned count_;
+    std::unique_ptr<std::atomic<float>[]> values_;
+    std::unique_ptr<std::atomic<std::uint64_t>[]> dirty_;
+    std::atomic<std::uint64_t> dirty_words_ { 0 };
+};
+
+#endif // PARAMETERSTORE_H
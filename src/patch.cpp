@@ -0,0 +1,686 @@
+#include "patch.h"
+
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <utility>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+std::uint32_t topologyHash(const PatchHeader& header, const PatchNodeRecord* nodes, const PatchEdgeRecord* edges) {
+    std::uint32_t hash = 2166136261u;
+    const auto mix = [&hash](std::uint32_t value) {
+        for (int i = 0; i < 4; ++i, value >>= 8) {
+            hash = (hash ^ (value & 0xffu)) * 16777619u;
+        }
+    };
+
+    mix(header.node_count);
+    mix(header.edge_count);
+    mix(header.output_node);
+    for (std::uint32_t i = 0; i < header.node_count; ++i) {
+        mix(nodes[i].type);
+    }
+    for (std::uint32_t i = 0; i < header.edge_count; ++i) {
+        mix(edges[i].from);
+        mix(edges[i].to);
+        mix(edges[i].port);
+    }
+    return hash;
+}
+
+// a patch nests three levels deep; anything far past that is not a patch
+constexpr unsigned MAX_JSON_DEPTH = 64;
+
+// Just enough JSON for the patch text form: no \u escapes beyond ASCII
+struct JsonValue {
+    enum class Kind { Null, Bool, Number, String, Array, Object };
+
+    Kind kind = Kind::Null;
+    bool boolean = false;
+    double number = 0.0;
+    std::string text;
+    std::vector<JsonValue> items;
+    std::vector<std::pair<std::string, JsonValue>> members;
+
+    const JsonValue* member(const char* name) const {
+        for (const auto& member : members) {
+            if (member.first == name) {
+                return &member.second;
+            }
+        }
+        return nullptr;
+    }
+};
+
+class JsonParser
+{
+public:
+    explicit JsonParser(const std::string& text) : cursor_(text.c_str()), end_(text.c_str() + text.size()) {}
+
+    bool parse(JsonValue& value) {
+        if (!parseValue(value)) {
+            return false;
+        }
+        skipSpace();
+        return cursor_ == end_ || fail("trailing characters after the patch");
+    }
+
+    const std::string& error() const { return error_; }
+    unsigned line() const { return line_; }
+
+private:
+    bool fail(const char* message) {
+        if (error_.empty()) {
+            error_ = message;
+        }
+        return false;
+    }
+
+    void skipSpace() {
+        for (; cursor_ < end_ && (*cursor_ == ' ' || *cursor_ == '\t' || *cursor_ == '\r' || *cursor_ == '\n'); ++cursor_) {
+            line_ += *cursor_ == '\n' ? 1 : 0;
+        }
+    }
+
+    bool literal(const char* word) {
+        const size_t length = std::strlen(word);
+        if (static_cast<size_t>(end_ - cursor_) < length || std::strncmp(cursor_, word, length) != 0) {
+            return fail("unexpected character");
+        }
+        cursor_ += length;
+        return true;
+    }
+
+    bool parseString(std::string& text) {
+        ++cursor_;
+        for (; cursor_ < end_ && *cursor_ != '"'; ++cursor_) {
+            char c = *cursor_;
+            if (c == '\n') {
+                return fail("newline in string");
+            }
+            if (c == '\\') {
+                if (++cursor_ == end_) {
+                    break;
+                }
+                switch (*cursor_) {
+                case 'n': c = '\n'; break;
+                case 't': c = '\t'; break;
+                case 'r': c = '\r'; break;
+                case 'b': c = '\b'; break;
+                case 'f': c = '\f'; break;
+                case '"': case '\\': case '/': c = *cursor_; break;
+                default: return fail("unsupported escape in string");
+                }
+            }
+            text.push_back(c);
+        }
+        if (cursor_ == end_) {
+            return fail("unterminated string");
+        }
+        ++cursor_;
+        return true;
+    }
+
+    bool parseValue(JsonValue& value, const unsigned depth = 0) {
+        skipSpace();
+        if (cursor_ == end_) {
+            return fail("unexpected end of input");
+        }
+        if (depth > MAX_JSON_DEPTH) {
+            return fail("nested too deeply");
+        }
+
+        switch (*cursor_) {
+        case '{': {
+            value.kind = JsonValue::Kind::Object;
+            ++cursor_;
+            skipSpace();
+            if (cursor_ < end_ && *cursor_ == '}') {
+                ++cursor_;
+                return true;
+            }
+            for (;;) {
+                skipSpace();
+                if (cursor_ == end_ || *cursor_ != '"') {
+                    return fail("expected a member name");
+                }
+                std::pair<std::string, JsonValue> member;
+                if (!parseString(member.first)) {
+                    return false;
+                }
+                skipSpace();
+                if (cursor_ == end_ || *cursor_ != ':') {
+                    return fail("expected ':'");
+                }
+                ++cursor_;
+                if (!parseValue(member.second, depth + 1)) {
+                    return false;
+                }
+                value.members.push_back(std::move(member));
+                skipSpace();
+                if (cursor_ < end_ && *cursor_ == ',') {
+                    ++cursor_;
+                } else if (cursor_ < end_ && *cursor_ == '}') {
+                    ++cursor_;
+                    return true;
+                } else {
+                    return fail("expected ',' or '}'");
+                }
+            }
+        }
+        case '[': {
+            value.kind = JsonValue::Kind::Array;
+            ++cursor_;
+            skipSpace();
+            if (cursor_ < end_ && *cursor_ == ']') {
+                ++cursor_;
+                return true;
+            }
+            for (;;) {
+                value.items.emplace_back();
+                if (!parseValue(value.items.back(), depth + 1)) {
+                    return false;
+                }
+                skipSpace();
+                if (cursor_ < end_ && *cursor_ == ',') {
+                    ++cursor_;
+                } else if (cursor_ < end_ && *cursor_ == ']') {
+                    ++cursor_;
+                    return true;
+                } else {
+                    return fail("expected ',' or ']'");
+                }
+            }
+        }
+        case '"':
+            value.kind = JsonValue::Kind::String;
+            return parseString(value.text);
+        case 't':
+            value.kind = JsonValue::Kind::Bool;
+            value.boolean = true;
+            return literal("true");
+        case 'f':
+            value.kind = JsonValue::Kind::Bool;
+            return literal("false");
+        case 'n':
+            return literal("null");
+        default: {
+            // from_chars ignores the locale, which a GUI may have set to a decimal comma
+            value.kind = JsonValue::Kind::Number;
+            const std::from_chars_result result = std::from_chars(cursor_, end_, value.number);
+            if (result.ec == std::errc::result_out_of_range) {
+                return fail("number out of range");
+            }
+            if (result.ec != std::errc() || result.ptr == cursor_) {
+                return fail("unexpected character");
+            }
+            cursor_ = result.ptr;
+            return true;
+        }
+        }
+    }
+
+    const char* cursor_;
+    const char* end_;
+    unsigned line_ = 1;
+    std::string error_;
+};
+
+bool isIndex(const JsonValue* value) {
+    return value && value->kind == JsonValue::Kind::Number && value->number >= 0.0 &&
+           value->number == std::floor(value->number) && value->number < 4294967295.0;
+}
+
+// shortest decimal that reads back as the same float, whatever the locale
+std::string formatFloat(const float value) {
+    char text[32];
+    const std::to_chars_result result = std::to_chars(text, text + sizeof(text), value);
+    return std::string(text, result.ptr);
+}
+
+}
+
+Patch::~Patch() {
+    release();
+}
+
+Patch::Patch(Patch&& other) noexcept {
+    *this = std::move(other);
+}
+
+Patch& Patch::operator=(Patch&& other) noexcept {
+    if (this != &other) {
+        release();
+        owned_ = std::move(other.owned_);
+        mapping_ = std::exchange(other.mapping_, nullptr);
+        mapping_size_ = std::exchange(other.mapping_size_, 0);
+        data_ = std::exchange(other.data_, nullptr);
+        size_ = std::exchange(other.size_, 0);
+    }
+    return *this;
+}
+
+void Patch::release() {
+#ifndef _WIN32
+    if (mapping_) {
+        munmap(mapping_, mapping_size_);
+    }
+#endif
+    mapping_ = nullptr;
+    mapping_size_ = 0;
+    owned_.clear();
+    data_ = nullptr;
+    size_ = 0;
+}
+
+bool Patch::validate(const unsigned char* data, const std::size_t size, const std::string& source) {
+    const auto reject = [&source](const char* message) {
+        std::cerr << source << ": " << message << "\n";
+        return false;
+    };
+
+    if (size < sizeof(PatchHeader)) {
+        return reject("too short for a patch");
+    }
+    const auto& header = *reinterpret_cast<const PatchHeader*>(data);
+    if (std::memcmp(header.magic, PATCH_MAGIC, sizeof(PATCH_MAGIC)) != 0) {
+        return reject("not a patch file");
+    }
+    if (header.version != PATCH_VERSION || header.header_bytes != sizeof(PatchHeader)) {
+        return reject("unsupported patch version");
+    }
+
+    const unsigned long long expected = sizeof(PatchHeader) +
+                                        static_cast<unsigned long long>(header.node_count) * sizeof(PatchNodeRecord) +
+                                        static_cast<unsigned long long>(header.edge_count) * sizeof(PatchEdgeRecord) +
+                                        static_cast<unsigned long long>(header.parameter_count) * sizeof(float);
+    if (expected != size) {
+        return reject("size doesn't match the header");
+    }
+    if (header.node_count == 0 || header.output_node >= header.node_count) {
+        return reject("no output node");
+    }
+
+    const auto nodes = reinterpret_cast<const PatchNodeRecord*>(data + sizeof(PatchHeader));
+    const auto edges = reinterpret_cast<const PatchEdgeRecord*>(nodes + header.node_count);
+    const auto parameters = reinterpret_cast<const float*>(edges + header.edge_count);
+
+    for (std::uint32_t i = 0; i < header.node_count; ++i) {
+        if (nodes[i].first_parameter > header.parameter_count ||
+            nodes[i].parameter_count > header.parameter_count - nodes[i].first_parameter) {
+            return reject("node parameters out of range");
+        }
+    }
+    for (std::uint32_t i = 0; i < header.edge_count; ++i) {
+        if (edges[i].from >= header.node_count || edges[i].to >= header.node_count || edges[i].from == edges[i].to) {
+            return reject("edge out of range");
+        }
+    }
+    for (std::uint32_t i = 0; i < header.parameter_count; ++i) {
+        if (!std::isfinite(parameters[i])) {
+            return reject("parameter is not a finite number");
+        }
+    }
+    if (topologyHash(header, nodes, edges) != header.topology_hash) {
+        return reject("topology hash mismatch");
+    }
+    return true;
+}
+
+bool Patch::load(const std::string& path) {
+#ifdef _WIN32
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "Failed to open patch " << path << "\n";
+        return false;
+    }
+    std::vector<unsigned char> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    return assign(std::move(bytes), path);
+#else
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Failed to open patch " << path << "\n";
+        return false;
+    }
+
+    struct stat status;
+    void* mapping = MAP_FAILED;
+    if (fstat(fd, &status) == 0 && status.st_size > 0) {
+        mapping = mmap(nullptr, static_cast<std::size_t>(status.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+
+    if (mapping == MAP_FAILED) {
+        std::cerr << "Failed to map patch " << path << "\n";
+        return false;
+    }
+
+    const auto size = static_cast<std::size_t>(status.st_size);
+    if (!validate(static_cast<const unsigned char*>(mapping), size, path)) {
+        munmap(mapping, size);
+        return false;
+    }
+
+    release();
+    mapping_ = mapping;
+    mapping_size_ = size;
+    data_ = static_cast<const unsigned char*>(mapping);
+    size_ = size;
+    return true;
+#endif
+}
+
+bool Patch::assign(std::vector<unsigned char> bytes, const std::string& source) {
+    if (!validate(bytes.data(), bytes.size(), source)) {
+        return false;
+    }
+
+    release();
+    owned_ = std::move(bytes);
+    data_ = owned_.data();
+    size_ = owned_.size();
+    return true;
+}
+
+bool Patch::save(const std::string& path) const {
+    std::ofstream file(path, std::ios::binary);
+    if (!file || !file.write(reinterpret_cast<const char*>(data_), static_cast<std::streamsize>(size_))) {
+        std::cerr << "Failed to write patch " << path << "\n";
+        return false;
+    }
+    return true;
+}
+
+bool Patch::loadJson(const std::string& path, const NodeRegistry& registry) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "Failed to open patch " << path << "\n";
+        return false;
+    }
+    std::stringstream text;
+    text << file.rdbuf();
+    return parseJson(text.str(), path, registry);
+}
+
+bool Patch::parseJson(const std::string& text, const std::string& source, const NodeRegistry& registry) {
+    JsonValue root;
+    JsonParser parser(text);
+    if (!parser.parse(root)) {
+        std::cerr << source << ":" << parser.line() << ": " << parser.error() << "\n";
+        return false;
+    }
+
+    const auto reject = [&source](const std::string& message) {
+        std::cerr << source << ": " << message << "\n";
+        return false;
+    };
+
+    const JsonValue* version = root.member("version");
+    const JsonValue* nodes = root.member("nodes");
+    const JsonValue* edges = root.member("edges");
+    if (root.kind != JsonValue::Kind::Object || !version || version->number != PATCH_VERSION) {
+        return reject("expected a version 1 patch object");
+    }
+    if (!nodes || nodes->kind != JsonValue::Kind::Array || (edges && edges->kind != JsonValue::Kind::Array)) {
+        return reject("expected \"nodes\" and \"edges\" arrays");
+    }
+
+    PatchBuilder builder(registry);
+    for (size_t i = 0; i < nodes->items.size(); ++i) {
+        const JsonValue& node = nodes->items[i];
+        const JsonValue* type_name = node.member("type");
+        if (!type_name || type_name->kind != JsonValue::Kind::String) {
+            return reject("node " + std::to_string(i) + " has no type");
+        }
+        if (builder.addNode(type_name->text) < 0) {
+            return false;
+        }
+
+        const NodeType& type = *registry.find(type_name->text);
+        for (const auto& member : node.members) {
+            if (member.first == "type") {
+                continue;
+            }
+
+            const int parameter = type.parameterIndex(member.first);
+            float value = 0.0f;
+            if (parameter >= 0 && member.second.kind == JsonValue::Kind::String && type.parameters[parameter].choices) {
+                const char* const* choices = type.parameters[parameter].choices;
+                int choice = 0;
+                while (choices[choice] && member.second.text != choices[choice]) {
+                    ++choice;
+                }
+                if (!choices[choice]) {
+                    return reject("node " + std::to_string(i) + ": unknown " + member.first + " '" + member.second.text + "'");
+                }
+                value = static_cast<float>(choice);
+            } else if (member.second.kind == JsonValue::Kind::Number) {
+                value = static_cast<float>(member.second.number);
+            } else if (member.second.kind == JsonValue::Kind::Bool) {
+                value = member.second.boolean ? 1.0f : 0.0f;
+            } else {
+                return reject("node " + std::to_string(i) + ": bad value for " + member.first);
+            }
+            if (!builder.setParameter(static_cast<unsigned>(i), member.first, value)) {
+                return false;
+            }
+        }
+    }
+
+    for (size_t i = 0; edges && i < edges->items.size(); ++i) {
+        const JsonValue& edge = edges->items[i];
+        const JsonValue* from = edge.member("from");
+        const JsonValue* to = edge.member("to");
+        const JsonValue* port = edge.member("port");
+        if (!isIndex(from) || !isIndex(to) || (port && port->kind != JsonValue::Kind::String)) {
+            return reject("edge " + std::to_string(i) + " needs node indices \"from\" and \"to\"");
+        }
+
+        const auto from_index = static_cast<unsigned>(from->number);
+        const auto to_index = static_cast<unsigned>(to->number);
+        if (!(port ? builder.automate(from_index, to_index, port->text) : builder.connect(from_index, to_index))) {
+            return false;
+        }
+    }
+
+    const JsonValue* output = root.member("output");
+    if (!isIndex(output) || !builder.setOutput(static_cast<unsigned>(output->number))) {
+        return reject("expected an \"output\" node index");
+    }
+
+    return builder.build(*this, source);
+}
+
+std::string Patch::toJson(const NodeRegistry& registry) const {
+    if (empty()) {
+        return std::string();
+    }
+
+    std::string json = "{\n    \"format\": \"synth-patch\",\n    \"version\": " + std::to_string(PATCH_VERSION) +
+                       ",\n    \"output\": " + std::to_string(header().output_node) + ",\n    \"nodes\": [\n";
+
+    for (std::uint32_t i = 0; i < header().node_count; ++i) {
+        const PatchNodeRecord& record = nodes()[i];
+        const NodeType* type = registry.find(record.type);
+
+        json += "        { \"type\": \"";
+        json += type ? type->name : ("unknown-" + std::to_string(record.type));
+        json += "\"";
+        for (std::uint32_t p = 0; type && p < record.parameter_count && p < type->parameters.size(); ++p) {
+            const NodeType::Parameter& parameter = type->parameters[p];
+            const float value = parameters()[record.first_parameter + p];
+            // defaults are left out, so a diff shows only what the patch sets
+            if (value == parameter.default_value) {
+                continue;
+            }
+            json += ", \"";
+            json += parameter.name;
+            json += "\": ";
+            if (parameter.choices && value >= 0.0f && value < static_cast<float>(type->choiceCount(p))) {
+                json += "\"";
+                json += parameter.choices[static_cast<int>(value)];
+                json += "\"";
+            } else {
+                json += formatFloat(value);
+            }
+        }
+        json += i + 1 < header().node_count ? " },\n" : " }\n";
+    }
+
+    json += "    ],\n    \"edges\": [\n";
+    for (std::uint32_t i = 0; i < header().edge_count; ++i) {
+        const PatchEdgeRecord& edge = edges()[i];
+        json += "        { \"from\": " + std::to_string(edge.from) + ", \"to\": " + std::to_string(edge.to);
+        if (edge.port != PATCH_INPUT_PORT) {
+            const NodeType* type = registry.find(nodes()[edge.to].type);
+            json += ", \"port\": \"";
+            json += type && edge.port < type->ports.size() ? type->ports[edge.port] : std::to_string(edge.port);
+            json += "\"";
+        }
+        json += i + 1 < header().edge_count ? " },\n" : " }\n";
+    }
+    json += "    ]\n}\n";
+    return json;
+}
+
+bool Patch::saveJson(const std::string& path, const NodeRegistry& registry) const {
+    std::ofstream file(path);
+    if (!file || !(file << toJson(registry))) {
+        std::cerr << "Failed to write patch " << path << "\n";
+        return false;
+    }
+    return true;
+}
+
+int PatchBuilder::addNode(const std::string& type_name) {
+    const NodeType* type = registry_.find(type_name);
+    if (!type) {
+        std::cerr << "Unknown node type " << type_name << "\n";
+        return -1;
+    }
+
+    std::vector<float> parameters;
+    for (const NodeType::Parameter& parameter : type->parameters) {
+        parameters.push_back(parameter.default_value);
+    }
+    types_.push_back(type);
+    parameters_.push_back(std::move(parameters));
+    return static_cast<int>(types_.size()) - 1;
+}
+
+bool PatchBuilder::checkNode(const unsigned node) const {
+    if (node >= types_.size()) {
+        std::cerr << "No node " << node << " in the patch\n";
+        return false;
+    }
+    return true;
+}
+
+bool PatchBuilder::setParameter(const unsigned node, const std::string& parameter, const float value) {
+    if (!checkNode(node)) {
+        return false;
+    }
+
+    const NodeType& type = *types_[node];
+    const int index = type.parameterIndex(parameter);
+    if (index < 0) {
+        std::cerr << type.name << " has no parameter " << parameter << "\n";
+        return false;
+    }
+    const unsigned choices = type.choiceCount(static_cast<unsigned>(index));
+    if (!std::isfinite(value) ||
+        (choices > 0 && (value < 0.0f || value >= static_cast<float>(choices) || value != std::floor(value)))) {
+        std::cerr << type.name << " " << parameter << " can't be " << value << "\n";
+        return false;
+    }
+
+    parameters_[node][index] = value;
+    return true;
+}
+
+bool PatchBuilder::connect(const unsigned from, const unsigned to) {
+    if (!checkNode(from) || !checkNode(to)) {
+        return false;
+    }
+    if (from == to) {
+        std::cerr << "Node " << from << " can't feed itself\n";
+        return false;
+    }
+    edges_.push_back({ from, to, PATCH_INPUT_PORT });
+    return true;
+}
+
+bool PatchBuilder::automate(const unsigned from, const unsigned to, const std::string& port) {
+    if (!checkNode(from) || !checkNode(to)) {
+        return false;
+    }
+
+    const int index = types_[to]->portIndex(port);
+    if (index < 0 || from == to) {
+        std::cerr << types_[to]->name << " has no automation port " << port << "\n";
+        return false;
+    }
+    edges_.push_back({ from, to, static_cast<std::uint32_t>(index) });
+    return true;
+}
+
+bool PatchBuilder::setOutput(const unsigned node) {
+    if (!checkNode(node)) {
+        return false;
+    }
+    output_ = static_cast<int>(node);
+    return true;
+}
+
+bool PatchBuilder::build(Patch& patch, const std::string& source) const {
+    if (output_ < 0) {
+        std::cerr << source << ": no output node\n";
+        return false;
+    }
+
+    std::vector<PatchNodeRecord> nodes;
+    std::vector<float> parameters;
+    for (size_t i = 0; i < types_.size(); ++i) {
+        nodes.push_back({ types_[i]->id, static_cast<std::uint32_t>(parameters.size()),
+                          static_cast<std::uint32_t>(parameters_[i].size()) });
+        parameters.insert(parameters.end(), parameters_[i].begin(), parameters_[i].end());
+    }
+
+    PatchHeader header = {};
+    std::memcpy(header.magic, PATCH_MAGIC, sizeof(PATCH_MAGIC));
+    header.version = PATCH_VERSION;
+    header.header_bytes = sizeof(PatchHeader);
+    header.node_count = static_cast<std::uint32_t>(nodes.size());
+    header.edge_count = static_cast<std::uint32_t>(edges_.size());
+    header.parameter_count = static_cast<std::uint32_t>(parameters.size());
+    header.output_node = static_cast<std::uint32_t>(output_);
+    header.topology_hash = topologyHash(header, nodes.data(), edges_.data());
+
+    std::vector<unsigned char> bytes(sizeof(PatchHeader) + nodes.size() * sizeof(PatchNodeRecord) +
+                                     edges_.size() * sizeof(PatchEdgeRecord) + parameters.size() * sizeof(float));
+    unsigned char* cursor = bytes.data();
+    const auto append = [&cursor](const void* data, size_t length) {
+        if (length > 0) {
+            std::memcpy(cursor, data, length);
+            cursor += length;
+        }
+    };
+    append(&header, sizeof(header));
+    append(nodes.data(), nodes.size() * sizeof(PatchNodeRecord));
+    append(edges_.data(), edges_.size() * sizeof(PatchEdgeRecord));
+    append(parameters.data(), parameters.size() * sizeof(float));
+
+    return patch.assign(std::move(bytes), source);
+}
@@ -0,0 +1,128 @@
+#ifndef PATCH_H
+#define PATCH_H
+
+#include "noderegistry.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Binary patch file, version 1. Little-endian, every field 4-byte aligned, laid out as
+//
+//   PatchHeader
+//   PatchNodeRecord[node_count]
+//   PatchEdgeRecord[edge_count]
+//   float[parameter_count]       each node's parameters, in its NodeType's order
+//
+// so a mapped file is used in place: loading is one mmap and a bounds check. The same
+// patch also has a JSON form for review and diffs (see Patch::loadJson), which lists
+// only the parameters that differ from their defaults.
+
+constexpr char PATCH_MAGIC[4] = { 'S', 'Y', 'N', 'P' };
+constexpr std::uint16_t PATCH_VERSION = 1;
+// edge port for a plain audio connection rather than an automation port
+constexpr std::uint32_t PATCH_INPUT_PORT = 0xffffffffu;
+
+struct PatchHeader {
+    char magic[4];
+    std::uint16_t version;
+    std::uint16_t header_bytes;
+    std::uint32_t node_count;
+    std::uint32_t edge_count;
+    std::uint32_t parameter_count;
+    std::uint32_t output_node;
+    // hash of the node types and edges; patches that share it differ only in parameters
+    std::uint32_t topology_hash;
+    std::uint32_t reserved;
+};
+
+struct PatchNodeRecord {
+    std::uint32_t type;             // NodeType::id
+    std::uint32_t first_parameter;
+    std::uint32_t parameter_count;
+};
+
+struct PatchEdgeRecord {
+    std::uint32_t from;
+    std::uint32_t to;
+    std::uint32_t port;             // automation port of `to`, or PATCH_INPUT_PORT
+};
+
+static_assert(sizeof(PatchHeader) == 32, "PatchHeader is part of the file format");
+static_assert(sizeof(PatchNodeRecord) == 12 && sizeof(PatchEdgeRecord) == 12, "records are part of the file format");
+
+// A validated patch in memory, either mapped from a file or owned. Move-only. The
+// accessors point straight into the file's bytes.
+class Patch
+{
+public:
+    Patch() = default;
+    ~Patch();
+
+    Patch(Patch&& other) noexcept;
+    Patch& operator=(Patch&& other) noexcept;
+    Patch(const Patch&) = delete;
+    Patch& operator=(const Patch&) = delete;
+
+    // Each reports the problem on std::cerr and leaves the patch untouched on failure
+    bool load(const std::string& path);
+    bool loadJson(const std::string& path, const NodeRegistry& registry = NodeRegistry::builtin());
+    bool parseJson(const std::string& text, const std::string& source,
+                   const NodeRegistry& registry = NodeRegistry::builtin());
+    bool assign(std::vector<unsigned char> bytes, const std::string& source);
+
+    bool save(const std::string& path) const;
+    bool saveJson(const std::string& path, const NodeRegistry& registry = NodeRegistry::builtin()) const;
+    std::string toJson(const NodeRegistry& registry = NodeRegistry::builtin()) const;
+
+    bool empty() const { return data_ == nullptr; }
+    const unsigned char* data() const { return data_; }
+    std::size_t size() const { return size_; }
+
+    const PatchHeader& header() const { return *reinterpret_cast<const PatchHeader*>(data_); }
+    const PatchNodeRecord* nodes() const { return reinterpret_cast<const PatchNodeRecord*>(data_ + sizeof(PatchHeader)); }
+    const PatchEdgeRecord* edges() const { return reinterpret_cast<const PatchEdgeRecord*>(nodes() + header().node_count); }
+    const float* parameters() const { return reinterpret_cast<const float*>(edges() + header().edge_count); }
+
+private:
+    static bool validate(const unsigned char* data, std::size_t size, const std::string& source);
+    void release();
+
+    std::vector<unsigned char> owned_;
+    void* mapping_ = nullptr;
+    std::size_t mapping_size_ = 0;
+
+    const unsigned char* data_ = nullptr;
+    std::size_t size_ = 0;
+};
+
+// Assembles a patch from type, parameter and port names, filling in every parameter the
+// caller leaves out with its default. Errors go to std::cerr.
+class PatchBuilder
+{
+public:
+    explicit PatchBuilder(const NodeRegistry& registry = NodeRegistry::builtin()) : registry_(registry) {}
+
+    // index of the new node, or -1 for an unknown type
+    int addNode(const std::string& type);
+    bool setParameter(unsigned node, const std::string& parameter, float value);
+    // audio from `from` into `to`; mixers take any number of inputs, other nodes one
+    bool connect(unsigned from, unsigned to);
+    // `from` drives the named automation port of `to`
+    bool automate(unsigned from, unsigned to, const std::string& port);
+    bool setOutput(unsigned node);
+
+    bool build(Patch& patch, const std::string& source = "patch") const;
+
+private:
+    bool checkNode(unsigned node) const;
+
+    const NodeRegistry& registry_;
+    std::vector<const NodeType*> types_;
+    std::vector<std::vector<float>> parameters_;
+    std::vector<PatchEdgeRecord> edges_;
+    int output_ = -1;
+};
+
+#endif // PATCH_H
@@ -0,0 +1,325 @@
+#include "patchgraph.h"
+
+#include <cstddef>
+#include <iostream>
+
+PatchGraph::PatchGraph(AudioContext& context, const NodeRegistry& registry, const std::size_t arena_bytes,
+                       const unsigned max_nodes, const unsigned max_edges)
+    : context_(context), registry_(registry), arena_(std::make_unique<unsigned char[]>(arena_bytes)),
+      arena_bytes_(arena_bytes), max_nodes_(max_nodes), order_(max_nodes, max_edges) {
+    nodes_.reserve(max_nodes);
+    types_.reserve(max_nodes);
+    pending_types_.reserve(max_nodes);
+    schedule_.reserve(max_nodes);
+}
+
+PatchGraph::~PatchGraph() {
+    clear();
+}
+
+void PatchGraph::clear() {
+    // nodes only point at each other, so any order works; reverse mirrors construction
+    for (auto node = nodes_.rbegin(); node != nodes_.rend(); ++node) {
+        (*node)->~AudioNode();
+    }
+    nodes_.clear();
+    types_.clear();
+    arena_used_ = 0;
+    order_.clear();
+    schedule_.clear();
+    ordered_ = true;
+    output_ = nullptr;
+    topology_hash_ = 0;
+    edited_ = false;
+}
+
+bool PatchGraph::resolve(const Patch& patch) {
+    const PatchHeader& header = patch.header();
+    if (header.node_count > max_nodes_) {
+        std::cerr << "Patch has " << header.node_count << " nodes, the graph holds " << max_nodes_ << "\n";
+        return false;
+    }
+
+    pending_types_.clear();
+    std::size_t arena_used = 0;
+    for (std::uint32_t i = 0; i < header.node_count; ++i) {
+        const PatchNodeRecord& record = patch.nodes()[i];
+        const NodeType* type = registry_.find(record.type);
+        if (!type) {
+            std::cerr << "Patch node " << i << " has an unknown type " << record.type << "\n";
+            return false;
+        }
+        if (record.parameter_count != type->parameters.size()) {
+            std::cerr << "Patch node " << i << " has " << record.parameter_count << " parameters, " << type->name
+                      << " takes " << type->parameters.size() << "\n";
+            return false;
+        }
+        if (type->alignment > alignof(std::max_align_t)) {
+            std::cerr << type->name << " needs more alignment than the arena has\n";
+            return false;
+        }
+        arena_used = (arena_used + type->alignment - 1) / type->alignment * type->alignment + type->size;
+        pending_types_.push_back(type);
+    }
+
+    if (arena_used > arena_bytes_) {
+        std::cerr << "Patch needs " << arena_used << " bytes of nodes, the graph holds " << arena_bytes_ << "\n";
+        return false;
+    }
+
+    for (std::uint32_t i = 0; i < header.edge_count; ++i) {
+        const PatchEdgeRecord& edge = patch.edges()[i];
+        if (edge.port != PATCH_INPUT_PORT && edge.port >= pending_types_[edge.to]->ports.size()) {
+            std::cerr << "Patch edge " << i << " goes to a missing port\n";
+            return false;
+        }
+    }
+    return checkParameters(patch, pending_types_);
+}
+
+bool PatchGraph::checkParameters(const Patch& patch, const std::vector<const NodeType*>& types) const {
+    // enumerated parameters index tables inside the nodes, so they must be in range
+    for (unsigned i = 0; i < types.size(); ++i) {
+        const PatchNodeRecord& record = patch.nodes()[i];
+        for (unsigned p = 0; p < record.parameter_count; ++p) {
+            const unsigned choices = types[i]->choiceCount(p);
+            const float value = patch.parameters()[record.first_parameter + p];
+            if (choices > 0 && !(value >= 0.0f && value < static_cast<float>(choices))) {
+                std::cerr << "Patch node " << i << " " << types[i]->parameters[p].name << " is out of range\n";
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool PatchGraph::sameTopology(const Patch& patch) const {
+    const PatchHeader& header = patch.header();
+    if (!output_ || edited_ || header.topology_hash != topology_hash_ || header.node_count != nodes_.size()) {
+        return false;
+    }
+    // the hash covers the edges; the types are compared outright since they are cheap
+    for (unsigned i = 0; i < nodes_.size(); ++i) {
+        if (patch.nodes()[i].type != types_[i]->id) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void PatchGraph::applyParameters(const Patch& patch, const bool state) {
+    const float* parameters = patch.parameters();
+    for (unsigned i = 0; i < nodes_.size(); ++i) {
+        const PatchNodeRecord& record = patch.nodes()[i];
+        for (unsigned p = 0; p < record.parameter_count; ++p) {
+            if (state || !types_[i]->parameters[p].state) {
+                types_[i]->set_parameter(nodes_[i], p, parameters[record.first_parameter + p]);
+            }
+        }
+    }
+}
+
+bool PatchGraph::instantiate(const Patch& patch) {
+    if (patch.empty()) {
+        std::cerr << "Can't instantiate an empty patch\n";
+        return false;
+    }
+
+    const PatchHeader& header = patch.header();
+    if (sameTopology(patch)) {
+        // same types in the same order, so only the values need checking
+        if (!checkParameters(patch, types_)) {
+            return false;
+        }
+        // a sounding note keeps its gate and a noise source its sequence
+        applyParameters(patch, false);
+        rebuilt_ = false;
+        return true;
+    }
+
+    if (!resolve(patch)) {
+        return false;
+    }
+
+    clear();
+
+    std::size_t offset = 0;
+    for (const NodeType* type : pending_types_) {
+        offset = (offset + type->alignment - 1) / type->alignment * type->alignment;
+        nodes_.push_back(type->construct(arena_.get() + offset, context_));
+        if (type->reserve_inputs) {
+            type->reserve_inputs(nodes_.back(), order_.edgeCapacity());
+        }
+        types_.push_back(type);
+        order_.addNode();
+        offset += type->size;
+    }
+    arena_used_ = offset;
+
+    for (std::uint32_t i = 0; i < header.edge_count; ++i) {
+        const PatchEdgeRecord& edge = patch.edges()[i];
+        wire(edge.from, edge.to, edge.port);
+        order_.addEdgeUnordered(edge.from, edge.to, edge.port);
+    }
+    // one sort for the whole patch; edits after this keep it up to date incrementally
+    ordered_ = order_.rebuild();
+    refreshSchedule();
+
+    applyParameters(patch, true);
+
+    output_ = nodes_[header.output_node];
+    topology_hash_ = header.topology_hash;
+    rebuilt_ = true;
+    return true;
+}
+
+void PatchGraph::render(const unsigned frames, const unsigned processing_id) {
+    if (!output_) {
+        return;
+    }
+    if (!ordered_) {
+        output_->process(frames, processing_id);
+        return;
+    }
+    // every input comes earlier, so each pull inside process() finds it already done
+    for (AudioNode* node : schedule_) {
+        node->process(frames, processing_id);
+    }
+}
+
+int PatchGraph::addNode(const std::string& name) {
+    const NodeType* type = registry_.find(name);
+    if (!type) {
+        std::cerr << "Unknown node type " << name << "\n";
+        return -1;
+    }
+    if (nodes_.size() >= max_nodes_) {
+        std::cerr << "The graph already holds " << max_nodes_ << " nodes\n";
+        return -1;
+    }
+    if (type->alignment > alignof(std::max_align_t)) {
+        std::cerr << type->name << " needs more alignment than the arena has\n";
+        return -1;
+    }
+    const std::size_t offset = (arena_used_ + type->alignment - 1) / type->alignment * type->alignment;
+    if (offset + type->size > arena_bytes_) {
+        std::cerr << "No room left in the arena for a " << type->name << "\n";
+        return -1;
+    }
+
+    AudioNode* node = type->construct(arena_.get() + offset, context_);
+    for (unsigned p = 0; p < type->parameters.size(); ++p) {
+        type->set_parameter(node, p, type->parameters[p].default_value);
+    }
+    if (type->reserve_inputs) {
+        type->reserve_inputs(node, order_.edgeCapacity());
+    }
+    nodes_.push_back(node);
+    types_.push_back(type);
+    arena_used_ = offset + type->size;
+
+    order_.addNode();
+    refreshSchedule();
+    edited_ = true;
+    return static_cast<int>(nodes_.size() - 1);
+}
+
+bool PatchGraph::checkEdge(const unsigned from, const unsigned to, const unsigned port) const {
+    if (from >= nodes_.size() || to >= nodes_.size()) {
+        std::cerr << "Cable between nodes " << from << " and " << to << ", the graph has " << nodes_.size() << "\n";
+        return false;
+    }
+    if (port != PATCH_INPUT_PORT && port >= types_[to]->ports.size()) {
+        std::cerr << types_[to]->name << " has no port " << port << "\n";
+        return false;
+    }
+    return true;
+}
+
+bool PatchGraph::connect(const unsigned from, const unsigned to, const unsigned port) {
+    if (!checkEdge(from, to, port)) {
+        return false;
+    }
+
+    // a mixer input adds a cable; any other input or port has room for one
+    const bool exclusive = port != PATCH_INPUT_PORT || !types_[to]->add_input;
+    if (!ordered_) {
+        // the patch already has a loop, so there is no order to keep
+        for (const ProcessingOrder::Edge& edge : order_.inputs(to)) {
+            if (edge.tag == port && exclusive) {
+                order_.removeEdge(edge.node, to, port);
+                break;
+            }
+        }
+        order_.addEdgeUnordered(from, to, port);
+        ordered_ = order_.rebuild();
+    } else if (!order_.connectInput(from, to, port, exclusive)) {
+        std::cerr << "Connecting node " << from << " to node " << to << " would close a feedback loop\n";
+        return false;
+    }
+
+    // taking the input or the port over unhooks the old cable from the node
+    wire(from, to, port);
+    refreshSchedule();
+    edited_ = true;
+    return true;
+}
+
+bool PatchGraph::disconnect(const unsigned from, const unsigned to, const unsigned port) {
+    if (!checkEdge(from, to, port)) {
+        return false;
+    }
+    if (!order_.removeEdge(from, to, port)) {
+        std::cerr << "Node " << from << " isn't connected to node " << to << "\n";
+        return false;
+    }
+
+    unwire(from, to, port);
+    if (!ordered_) {
+        // the cable may have been what closed the loop
+        ordered_ = order_.rebuild();
+    }
+    refreshSchedule();
+    edited_ = true;
+    return true;
+}
+
+bool PatchGraph::setOutput(const unsigned node) {
+    if (node >= nodes_.size()) {
+        std::cerr << "Output node " << node << ", the graph has " << nodes_.size() << "\n";
+        return false;
+    }
+    output_ = nodes_[node];
+    edited_ = true;
+    return true;
+}
+
+void PatchGraph::wire(const unsigned from, const unsigned to, const unsigned port) {
+    if (port != PATCH_INPUT_PORT) {
+        nodes_[from]->automate(nodes_[to], port);
+    } else if (types_[to]->add_input) {
+        types_[to]->add_input(nodes_[to], nodes_[from]);
+    } else {
+        nodes_[from]->connect(nodes_[to]);
+    }
+}
+
+void PatchGraph::unwire(const unsigned from, const unsigned to, const unsigned port) {
+    if (port != PATCH_INPUT_PORT) {
+        nodes_[to]->disconnectAutomation(port);
+    } else if (types_[to]->remove_input) {
+        types_[to]->remove_input(nodes_[to], nodes_[from]);
+    } else {
+        nodes_[to]->setInput(nullptr);
+    }
+}
+
+void PatchGraph::refreshSchedule() {
+    unsigned first = 0;
+    unsigned last = 0;
+    order_.takeDirty(first, last);
+    schedule_.resize(order_.nodeCount());
+    for (unsigned position = first; position < last; ++position) {
+        schedule_[position] = nodes_[order_.order()[position]];
+    }
+}
@@ -0,0 +1,114 @@
+#ifndef PATCHGRAPH_H
+#define PATCHGRAPH_H
+
+#include "noderegistry.h"
+#include "patch.h"
+#include "processingorder.h"
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+// A graph instantiated from a Patch into storage reserved up front. Nodes are
+// constructed in place in one arena, so loading a patch allocates nothing beyond what
+// the nodes themselves do.
+//
+// When the new patch has the same topology as the current one (same node types and
+// edges, see PatchHeader::topology_hash), instantiate() only writes the parameter
+// block into the live nodes, leaving out state parameters such as gates and seeds. That
+// is the common preset switch, and it keeps oscillator phases, envelope levels and
+// sounding notes running. A different topology tears the nodes down and
+// builds them again; their buffers are then allocated on their first block.
+//
+// The graph also keeps a processing order (see ProcessingOrder): render() walks the
+// nodes in it instead of pulling recursively from the output, so a long chain doesn't
+// turn into a deep call stack. Nodes and cables can then be added and removed one at a
+// time with addNode(), connect() and disconnect(), and only the part of the order an
+// edit affects is sorted again. A loaded patch that contains a feedback loop is
+// rendered by pulling from the output instead, as before; edits that would close a loop
+// are refused. Each node has room for max_edges cables in and out, mixer inputs
+// included, before an edit allocates.
+//
+// Not thread-safe: don't instantiate while another thread renders output().
+class PatchGraph
+{
+public:
+    static constexpr std::size_t DEFAULT_ARENA_BYTES = 1 << 20;
+    static constexpr unsigned DEFAULT_MAX_NODES = 1024;
+
+    explicit PatchGraph(AudioContext& context, const NodeRegistry& registry = NodeRegistry::builtin(),
+                        std::size_t arena_bytes = DEFAULT_ARENA_BYTES, unsigned max_nodes = DEFAULT_MAX_NODES,
+                        unsigned max_edges = ProcessingOrder::EDGE_RESERVE);
+    ~PatchGraph();
+
+    PatchGraph(const PatchGraph&) = delete;
+    PatchGraph& operator=(const PatchGraph&) = delete;
+
+    // Reports the problem on std::cerr and keeps the current graph on failure
+    bool instantiate(const Patch& patch);
+    void clear();
+
+    // Renders one block: every node in processing order, or a pull from output() when the
+    // patch has a feedback loop
+    void render(unsigned frames, unsigned processing_id);
+
+    // Edits to the instantiated graph. Each reports the problem on std::cerr and changes
+    // nothing on failure. addNode() places the node in the arena's free space and returns
+    // its index, or -1. connect() on a port that is already driven, or on the audio input
+    // of anything but a mixer, replaces the existing cable.
+    int addNode(const std::string& type);
+    bool connect(unsigned from, unsigned to, unsigned port = PATCH_INPUT_PORT);
+    bool disconnect(unsigned from, unsigned to, unsigned port = PATCH_INPUT_PORT);
+    bool setOutput(unsigned node);
+
+    const ProcessingOrder& order() const { return order_; }
+    // false when the loaded patch had a feedback loop and render() pulls instead
+    bool ordered() const { return ordered_; }
+
+    AudioNode* output() const { return output_; }
+    unsigned nodeCount() const { return static_cast<unsigned>(nodes_.size()); }
+    AudioNode* node(unsigned index) const { return nodes_[index]; }
+    const NodeType* nodeType(unsigned index) const { return types_[index]; }
+
+    // whether the last successful instantiate() rebuilt the nodes rather than only
+    // updating their parameters
+    bool rebuilt() const { return rebuilt_; }
+
+private:
+    bool sameTopology(const Patch& patch) const;
+    bool resolve(const Patch& patch);
+    bool checkParameters(const Patch& patch, const std::vector<const NodeType*>& types) const;
+    // state: also the parameters marked NodeType::Parameter::state
+    void applyParameters(const Patch& patch, bool state);
+    bool checkEdge(unsigned from, unsigned to, unsigned port) const;
+    void wire(unsigned from, unsigned to, unsigned port);
+    void unwire(unsigned from, unsigned to, unsigned port);
+    void refreshSchedule();
+
+    AudioContext& context_;
+    const NodeRegistry& registry_;
+
+    std::unique_ptr<unsigned char[]> arena_;
+    std::size_t arena_bytes_;
+    std::size_t arena_used_ = 0;
+    unsigned max_nodes_;
+
+    std::vector<AudioNode*> nodes_;
+    std::vector<const NodeType*> types_;
+    // types for the patch being loaded, checked before the current graph is touched
+    std::vector<const NodeType*> pending_types_;
+
+    ProcessingOrder order_;
+    // order_ mapped to the nodes, patched over the positions each edit rewrote
+    std::vector<AudioNode*> schedule_;
+    bool ordered_ = true;
+
+    AudioNode* output_ = nullptr;
+    std::uint32_t topology_hash_ = 0;
+    // set by the edit functions, since the graph no longer matches topology_hash_
+    bool edited_ = false;
+    bool rebuilt_ = false;
+};
+
+#endif // PATCHGRAPH_H
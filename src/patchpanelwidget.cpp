@@ -1,12 +1,19 @@
 #include "patchpanelwidget.h"
 
 #include <QApplication>
+#include <QHash>
+#include <QLineF>
 #include <QMouseEvent>
+#include <QPaintEvent>
 #include <QPainter>
 #include <QPainterPath>
 #include <QPen>
+#include <QRegion>
+#include <QVector>
+#include <QWheelEvent>
 
 #include <algorithm>
+#include <cmath>
 
 namespace
 {
@@ -47,6 +54,44 @@ QColor brightenToward200(const QColor& c)
 
     return QColor(r, g, b);
 }
+
+const QColor kPanelBackground(32, 32, 36);
+const QColor kClipColor(0xff, 0x40, 0x40);
+// the RMS shown as a level, in steps
+const float kLevelFloorDb = -60.0f;
+const float kLevelSteps = 8.0f;
+
+// a metered colour fades toward the background as its path goes quiet
+QColor tintForLevel(const QColor& color, float level)
+{
+    if (level < 0.0f)
+        return color;
+    if (level >= 1.0f)
+        return kClipColor;
+
+    const float mix = std::min(1.0f, 0.25f + level);
+    return QColor(
+        kPanelBackground.red() + static_cast<int>((color.red() - kPanelBackground.red()) * mix),
+        kPanelBackground.green() + static_cast<int>((color.green() - kPanelBackground.green()) * mix),
+        kPanelBackground.blue() + static_cast<int>((color.blue() - kPanelBackground.blue()) * mix));
+}
+
+// The direction says which of the two a jack is, so no dynamic_cast is needed
+OutputJack* asOutput(JackBase* jack)
+{
+    return (jack != nullptr && jack->direction() == JackDirection::Output) ? static_cast<OutputJack*>(jack) : nullptr;
+}
+
+InputJack* asInput(JackBase* jack)
+{
+    return (jack != nullptr && jack->direction() == JackDirection::Input) ? static_cast<InputJack*>(jack) : nullptr;
+}
+
+int gridCell(int coordinate, int cellSize)
+{
+    // rounds toward negative infinity, so cells left of or above the origin stay apart
+    return coordinate >= 0 ? coordinate / cellSize : -((-coordinate - 1) / cellSize) - 1;
+}
 }
 
 // ============================================================
@@ -91,6 +136,15 @@ bool JackBase::hitTest(const QPoint& pos) const
     return m_rect.contains(pos);
 }
 
+QRect JackBase::bounds() const
+{
+    const QPoint center = anchor();
+    const QRect outerRing(center.x() - 11, center.y() - 11, 22, 22);
+    const QRect textRect(center.x() - 30, m_rect.bottom() + 2, 60, 14);
+
+    return m_rect.adjusted(-5, -5, 5, 5).united(outerRing).united(textRect.adjusted(-1, -1, 1, 1));
+}
+
 void JackBase::setHovered(bool hovered) noexcept
 {
     m_hovered = hovered;
@@ -101,9 +155,15 @@ bool JackBase::isHovered() const noexcept
     return m_hovered;
 }
 
-void JackBase::drawConnections(QPainter& painter) const
+float JackBase::level() const
+{
+    return -1.0f;
+}
+
+void JackBase::drawConnections(QPainter& painter, const QRectF& visible) const
 {
     Q_UNUSED(painter);
+    Q_UNUSED(visible);
 }
 
 PatchPanelWidget* JackBase::panel() const noexcept
@@ -111,11 +171,22 @@ PatchPanelWidget* JackBase::panel() const noexcept
     return m_panel;
 }
 
-void JackBase::draw(QPainter& painter) const
+void JackBase::draw(QPainter& painter, DetailLevel detail) const
 {
     const QColor& base = m_baseColor;
     const QColor rimColor = m_hovered ? base.lighter(145) : base.lighter(115);
-    const QColor centerColor = isConnected() ? base.lighter(130) : base.darker(170);
+    const QColor centerColor = (level() >= 0.0f)
+                                   ? tintForLevel(base.lighter(130), level())
+                                   : (isConnected() ? base.lighter(130) : base.darker(170));
+
+    if (detail == DetailLevel::Coarse)
+    {
+        const QPoint center = anchor();
+        painter.setPen(Qt::NoPen);
+        painter.setBrush(m_hovered ? rimColor : centerColor);
+        painter.drawEllipse(QRect(center.x() - 10, center.y() - 10, 20, 20));
+        return;
+    }
 
     if (m_hovered)
     {
@@ -203,6 +274,11 @@ bool InputJack::isConnected() const
     return m_source != nullptr;
 }
 
+float InputJack::level() const
+{
+    return m_source != nullptr ? m_source->level() : -1.0f;
+}
+
 // ============================================================
 // OutputJack
 // ============================================================
@@ -221,6 +297,8 @@ void OutputJack::connectTo(InputJack* input, const QColor& color)
 
     m_connections.push_back({ input, color });
     input->setSource(this);
+
+    panel()->invalidateConnections();
 }
 
 void OutputJack::removeTarget(InputJack* input)
@@ -241,6 +319,9 @@ void OutputJack::removeTarget(InputJack* input)
 
     if (removed && input->source() == this)
         input->setSource(nullptr);
+
+    if (removed)
+        panel()->invalidateConnections();
 }
 
 void OutputJack::clearConnections()
@@ -258,23 +339,36 @@ const std::vector<OutputJack::Connection>& OutputJack::connections() const noexc
     return m_connections;
 }
 
+void OutputJack::setLevel(float level) noexcept
+{
+    m_level = level;
+}
+
+float OutputJack::level() const
+{
+    return m_level;
+}
+
 bool OutputJack::isConnected() const
 {
     return !m_connections.empty();
 }
 
-void OutputJack::drawConnections(QPainter& painter) const
+void OutputJack::drawConnections(QPainter& painter, const QRectF& visible) const
 {
     for (const Connection& c : m_connections)
     {
         if (c.target == nullptr)
             continue;
 
+        if (!visible.intersects(PatchPanelWidget::cableBounds(anchor(), c.target->anchor())))
+            continue;
+
         PatchPanelWidget::drawCable(
             painter,
             anchor(),
             c.target->anchor(),
-            c.color,
+            tintForLevel(c.color, m_level),
             0);
     }
 }
@@ -288,6 +382,8 @@ PatchPanelWidget::PatchPanelWidget(QWidget* parent)
 {
     setMouseTracking(true);
     setMinimumSize(560, 240);
+    // every pixel comes from the cable layer, which is opaque
+    setAttribute(Qt::WA_OpaquePaintEvent);
 }
 
 InputJack* PatchPanelWidget::addInputJack(const QString& label, const QRect& rect, const QColor& baseColor)
@@ -295,7 +391,10 @@ InputJack* PatchPanelWidget::addInputJack(const QString& label, const QRect& rec
     auto jack = std::make_unique<InputJack>(this, label, rect, baseColor);
     InputJack* result = jack.get();
     m_jacks.push_back(std::move(jack));
-    update();
+    addToGrid(result);
+
+    m_jackLayerDirty = true;
+    update(toView(result->bounds()));
     return result;
 }
 
@@ -304,7 +403,10 @@ OutputJack* PatchPanelWidget::addOutputJack(const QString& label, const QRect& r
     auto jack = std::make_unique<OutputJack>(this, label, rect, baseColor);
     OutputJack* result = jack.get();
     m_jacks.push_back(std::move(jack));
-    update();
+    addToGrid(result);
+
+    m_jackLayerDirty = true;
+    update(toView(result->bounds()));
     return result;
 }
 
@@ -353,22 +455,332 @@ void PatchPanelWidget::drawCable(QPainter& painter, QPoint start, QPoint end, co
     }
 }
 
-void PatchPanelWidget::paintEvent(QPaintEvent* event)
+QRect PatchPanelWidget::cableBounds(QPoint start, QPoint end)
 {
-    Q_UNUSED(event);
+    // both control points sit at (mx, my), so the curve stays inside the box spanned by
+    // the ends and that point; the margin covers the pen and the drop feedback
+    const int my = std::max(start.y(), end.y()) + 40;
 
-    QPainter painter(this);
-    painter.setRenderHint(QPainter::Antialiasing, true);
+    QRect bounds = QRect(start, end).normalized();
+    bounds.setBottom(my);
+
+    return bounds.adjusted(-4, -4, 4, 4).united(QRect(end - QPoint(10, 10), QSize(21, 21)));
+}
+
+void PatchPanelWidget::invalidateConnections()
+{
+    // a cable changes the look of both its jacks, so both layers go
+    m_cableLayerDirty = true;
+    m_jackLayerDirty = true;
+    update();
+}
+
+void PatchPanelWidget::setOutputLevel(OutputJack* output, float peak, float rms)
+{
+    if (output == nullptr)
+        return;
+
+    float shown = 1.0f;
+    if (!(peak > 1.0f))
+    {
+        const float db = 20.0f * std::log10(std::max(rms, 1e-9f));
+        const float position = std::clamp((db - kLevelFloorDb) / -kLevelFloorDb, 0.0f, 0.999f);
+        shown = std::floor(position * kLevelSteps) / kLevelSteps;
+    }
+
+    if (shown == output->level())
+        return;
+
+    // the output's cables and the jacks at both ends change colour, and nothing else
+    output->setLevel(shown);
+
+    QRect area = toView(output->bounds());
+    for (const OutputJack::Connection& c : output->connections())
+    {
+        if (c.target == nullptr)
+            continue;
+
+        area |= toView(cableBounds(output->anchor(), c.target->anchor()));
+        area |= toView(c.target->bounds());
+    }
+
+    renderLayers(area);
+    update(area);
+}
+
+qreal PatchPanelWidget::zoom() const noexcept
+{
+    return m_zoom;
+}
+
+QPointF PatchPanelWidget::viewOrigin() const noexcept
+{
+    return m_viewOrigin;
+}
+
+void PatchPanelWidget::setView(qreal zoom, const QPointF& origin)
+{
+    zoom = std::clamp(zoom, kMinZoom, kMaxZoom);
+    if (zoom == m_zoom && origin == m_viewOrigin)
+        return;
+
+    if (zoom == m_zoom && scrollLayers(origin))
+    {
+        update();
+        return;
+    }
+
+    m_zoom = zoom;
+    m_viewOrigin = origin;
+
+    // the layers are drawn in view coordinates, so a new zoom redraws both
+    m_cableLayerDirty = true;
+    m_jackLayerDirty = true;
+    update();
+}
+
+bool PatchPanelWidget::scrollLayers(const QPointF& origin)
+{
+    const qreal ratio = devicePixelRatioF();
+    if (m_cableLayerDirty || m_jackLayerDirty
+        || m_cableLayer.size() != size() * ratio || m_jackLayer.size() != size() * ratio)
+        return false;
+
+    // a pan moves the view by whole widget pixels, give or take rounding; anything else
+    // would smear the cached pixels
+    const QPointF shift = (m_viewOrigin - origin) * (m_zoom * ratio);
+    const QPoint pixels = shift.toPoint();
+    if (std::abs(shift.x() - pixels.x()) > 1e-3 || std::abs(shift.y() - pixels.y()) > 1e-3)
+        return false;
+    if (std::abs(pixels.x()) >= m_cableLayer.width() || std::abs(pixels.y()) >= m_cableLayer.height())
+        return false;
+
+    QRegion exposed;
+    m_cableLayer.scroll(pixels.x(), pixels.y(), m_cableLayer.rect(), &exposed);
+    m_jackLayer.scroll(pixels.x(), pixels.y(), m_jackLayer.rect());
 
-    painter.fillRect(rect(), QColor(32, 32, 36));
+    // the origin follows the pixels that moved, so rounding does not build up over a pan
+    m_viewOrigin -= QPointF(pixels) / (m_zoom * ratio);
 
+    for (const QRect& strip : exposed)
+        renderLayers(QRectF(QPointF(strip.topLeft()) / ratio, QSizeF(strip.size()) / ratio).toAlignedRect());
+
+    return true;
+}
+
+QPoint PatchPanelWidget::toScene(const QPoint& pos) const
+{
+    return (QPointF(pos) / m_zoom + m_viewOrigin).toPoint();
+}
+
+QRect PatchPanelWidget::toView(const QRect& sceneRect) const
+{
+    const QRectF view((QPointF(sceneRect.topLeft()) - m_viewOrigin) * m_zoom, QSizeF(sceneRect.size()) * m_zoom);
+    return view.toAlignedRect().adjusted(-1, -1, 1, 1);
+}
+
+QRectF PatchPanelWidget::visibleScene() const
+{
+    return QRectF(m_viewOrigin, QSizeF(size()) / m_zoom);
+}
+
+DetailLevel PatchPanelWidget::detailLevel() const
+{
+    return m_detailLevel;
+}
+
+void PatchPanelWidget::updateDetailLevel()
+{
+    DetailLevel detail = DetailLevel::Full;
+    if (m_zoom < kCoarseZoom)
+    {
+        detail = DetailLevel::Coarse;
+    }
+    else
+    {
+        const QRectF visible = visibleScene();
+        int cables = 0;
+        for (const auto& jack : m_jacks)
+        {
+            const OutputJack* output = asOutput(jack.get());
+            if (output == nullptr)
+                continue;
+
+            for (const OutputJack::Connection& c : output->connections())
+            {
+                if (c.target != nullptr && visible.intersects(cableBounds(output->anchor(), c.target->anchor())))
+                    ++cables;
+            }
+
+            if (cables > kCoarseCableLimit)
+            {
+                detail = DetailLevel::Coarse;
+                break;
+            }
+        }
+    }
+
+    if (detail == m_detailLevel)
+        return;
+
+    m_detailLevel = detail;
+    m_cableLayerDirty = true;
+    m_jackLayerDirty = true;
+}
+
+void PatchPanelWidget::setViewTransform(QPainter& painter) const
+{
+    painter.scale(m_zoom, m_zoom);
+    painter.translate(-m_viewOrigin);
+}
+
+void PatchPanelWidget::paintCables(QPainter& painter, const QRectF& visible) const
+{
+    if (detailLevel() == DetailLevel::Full)
+    {
+        painter.setRenderHint(QPainter::Antialiasing, true);
+        for (const auto& jack : m_jacks)
+            jack->drawConnections(painter, visible);
+        return;
+    }
+
+    // One hairline per cable, gathered by colour so the whole patch is a draw call
+    // per palette entry and level step in use. The line's box is grown a little, as a level cable has none.
+    QHash<QRgb, QVector<QLineF>> lines;
     for (const auto& jack : m_jacks)
-        jack->drawConnections(painter);
+    {
+        const OutputJack* output = asOutput(jack.get());
+        if (output == nullptr)
+            continue;
+
+        for (const OutputJack::Connection& c : output->connections())
+        {
+            if (c.target == nullptr)
+                continue;
+
+            const QLineF line(output->anchor(), c.target->anchor());
+            if (visible.intersects(QRectF(line.p1(), line.p2()).normalized().adjusted(-1, -1, 1, 1)))
+                lines[tintForLevel(c.color, output->level()).rgb()].append(line);
+        }
+    }
+
+    for (auto it = lines.cbegin(); it != lines.cend(); ++it)
+    {
+        painter.setPen(QPen(QColor::fromRgb(it.key()), 0));
+        painter.drawLines(it.value());
+    }
+}
+
+void PatchPanelWidget::paintJacks(QPainter& painter, const QRectF& visible)
+{
+    const DetailLevel detail = detailLevel();
+    painter.setRenderHint(QPainter::Antialiasing, detail == DetailLevel::Full);
+
+    // the layer holds every jack at rest; the hovered one is drawn over it when painting
+    if (m_hoveredJack != nullptr)
+        m_hoveredJack->setHovered(false);
 
     for (const auto& jack : m_jacks)
-        jack->draw(painter);
+    {
+        if (visible.intersects(jack->bounds()))
+            jack->draw(painter, detail);
+    }
 
-    if (m_isDragging && m_dragJack != nullptr)
+    if (m_hoveredJack != nullptr)
+        m_hoveredJack->setHovered(true);
+}
+
+void PatchPanelWidget::renderCableLayer()
+{
+    const qreal ratio = devicePixelRatioF();
+    m_cableLayer = QPixmap(size() * ratio);
+    m_cableLayer.setDevicePixelRatio(ratio);
+    m_cableLayer.fill(kPanelBackground);
+
+    QPainter painter(&m_cableLayer);
+    setViewTransform(painter);
+    paintCables(painter, visibleScene());
+
+    m_cableLayerDirty = false;
+}
+
+void PatchPanelWidget::renderJackLayer()
+{
+    const qreal ratio = devicePixelRatioF();
+    m_jackLayer = QPixmap(size() * ratio);
+    m_jackLayer.setDevicePixelRatio(ratio);
+    m_jackLayer.fill(Qt::transparent);
+
+    QPainter painter(&m_jackLayer);
+    setViewTransform(painter);
+    paintJacks(painter, visibleScene());
+
+    m_jackLayerDirty = false;
+}
+
+void PatchPanelWidget::renderLayers(const QRect& area)
+{
+    // a dirty layer is redrawn whole on the next paint anyway
+    const QRect clip = area.intersected(rect());
+    if (clip.isEmpty())
+        return;
+
+    const QRectF visible(QPointF(clip.topLeft()) / m_zoom + m_viewOrigin, QSizeF(clip.size()) / m_zoom);
+
+    if (!m_cableLayerDirty)
+    {
+        QPainter painter(&m_cableLayer);
+        painter.setClipRect(clip);
+        painter.fillRect(clip, kPanelBackground);
+        setViewTransform(painter);
+        paintCables(painter, visible);
+    }
+
+    if (!m_jackLayerDirty)
+    {
+        QPainter painter(&m_jackLayer);
+        painter.setClipRect(clip);
+        painter.setCompositionMode(QPainter::CompositionMode_Source);
+        painter.fillRect(clip, Qt::transparent);
+        painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+        setViewTransform(painter);
+        paintJacks(painter, visible);
+    }
+}
+
+void PatchPanelWidget::paintEvent(QPaintEvent* event)
+{
+    const qreal ratio = devicePixelRatioF();
+    if (m_cableLayerDirty || m_jackLayerDirty || m_cableLayer.size() != size() * ratio
+        || m_jackLayer.size() != size() * ratio)
+        updateDetailLevel();
+    if (m_cableLayerDirty || m_cableLayer.size() != size() * ratio)
+        renderCableLayer();
+    if (m_jackLayerDirty || m_jackLayer.size() != size() * ratio)
+        renderJackLayer();
+
+    QPainter painter(this);
+
+    const QRect dirty = event->rect();
+    const QRectF source(QPointF(dirty.topLeft()) * ratio, QSizeF(dirty.size()) * ratio);
+    painter.drawPixmap(dirty, m_cableLayer, source);
+    painter.drawPixmap(dirty, m_jackLayer, source);
+
+    const QRect hoverArea = (m_hoveredJack != nullptr) ? toView(m_hoveredJack->bounds()).intersected(dirty) : QRect();
+    if (!hoverArea.isEmpty())
+    {
+        // put back what is under the resting jack, so its label is not drawn twice
+        painter.drawPixmap(hoverArea, m_cableLayer,
+                           QRectF(QPointF(hoverArea.topLeft()) * ratio, QSizeF(hoverArea.size()) * ratio));
+    }
+
+    painter.setRenderHint(QPainter::Antialiasing, true);
+    setViewTransform(painter);
+
+    if (!hoverArea.isEmpty())
+        m_hoveredJack->draw(painter, detailLevel());
+
+    if (m_isDragging && m_dragJack != nullptr && dragCableBounds().intersects(dirty))
     {
         int feedback = 0;
         if (m_dropTargetJack != nullptr)
@@ -385,23 +797,36 @@ void PatchPanelWidget::paintEvent(QPaintEvent* event)
 
 void PatchPanelWidget::mousePressEvent(QMouseEvent* event)
 {
-    JackBase* hit = hitTest(event->pos());
+    JackBase* hit = hitTest(toScene(event->pos()));
 
     if (event->button() == Qt::RightButton)
     {
-        if (auto* input = dynamic_cast<InputJack*>(hit))
+        if (InputJack* input = asInput(hit))
         {
-            input->disconnect();
-            update();
+            if (OutputJack* source = input->source())
+            {
+                input->disconnect();
+                emit cableDisconnected(source, input);
+            }
         }
-        else if (auto* output = dynamic_cast<OutputJack*>(hit))
+        else if (OutputJack* output = asOutput(hit))
         {
+            const auto connections = output->connections();
             output->clearConnections();
-            update();
+            for (const OutputJack::Connection& c : connections)
+                emit cableDisconnected(output, c.target);
         }
         return;
     }
 
+    // the middle button pans anywhere, the left one where there is no jack to drag
+    if (event->button() == Qt::MiddleButton || (event->button() == Qt::LeftButton && hit == nullptr))
+    {
+        m_isPanning = true;
+        m_panLastPos = event->pos();
+        return;
+    }
+
     if (event->button() != Qt::LeftButton)
         return;
 
@@ -411,76 +836,88 @@ void PatchPanelWidget::mousePressEvent(QMouseEvent* event)
     m_isDragging = false;
     m_dragJack = nullptr;
     m_dropTargetJack = nullptr;
-
-    update();
 }
 
 void PatchPanelWidget::mouseMoveEvent(QMouseEvent* event)
 {
-    clearHoverStates();
+    if (m_isPanning)
+    {
+        const QPoint delta = event->pos() - m_panLastPos;
+        m_panLastPos = event->pos();
+        setView(m_zoom, m_viewOrigin - QPointF(delta) / m_zoom);
+        return;
+    }
 
-    JackBase* hovered = hitTest(event->pos());
-    if (hovered != nullptr)
-        hovered->setHovered(true);
+    const QPoint scenePos = toScene(event->pos());
+    JackBase* hovered = hitTest(scenePos);
+    setHoveredJack(hovered);
 
     if (m_pressedJack != nullptr && !m_isDragging)
     {
         const int dragDistance = (event->pos() - m_pressPos).manhattanLength();
         const bool movedFarEnough = dragDistance >= QApplication::startDragDistance();
-        const bool leftSourceJack = !m_pressedJack->rect().contains(event->pos());
+        const bool leftSourceJack = !m_pressedJack->rect().contains(scenePos);
 
         if (movedFarEnough && leftSourceJack)
         {
             m_isDragging = true;
             m_dragJack = m_pressedJack;
-            m_dragPos = event->pos();
+            m_dragPos = scenePos;
         }
     }
 
     if (m_isDragging)
     {
-        m_dragPos = event->pos();
+        // only the strip the cable leaves and the one it moves into are repainted
+        const QRect before = dragCableBounds();
 
-        JackBase* over = hitTest(event->pos());
-        if (over != nullptr && over != m_dragJack)
-        {
-            m_dropTargetJack = over;
-            m_dropTargetJack->setHovered(true);
-        }
-        else
-        {
-            m_dropTargetJack = nullptr;
-        }
-    }
+        m_dragPos = scenePos;
+        m_dropTargetJack = (hovered != nullptr && hovered != m_dragJack) ? hovered : nullptr;
 
-    update();
+        update(before.united(dragCableBounds()));
+    }
 }
 
 void PatchPanelWidget::mouseReleaseEvent(QMouseEvent* event)
 {
+    if (m_isPanning && (event->button() == Qt::MiddleButton || event->button() == Qt::LeftButton))
+    {
+        m_isPanning = false;
+        return;
+    }
+
     if (event->button() != Qt::LeftButton)
         return;
 
+    // a new cable repaints everything through invalidateConnections(), a dropped one
+    // only where it was
+    if (m_isDragging && m_dragJack != nullptr)
+        update(dragCableBounds());
+
     if (m_isDragging && m_dragJack != nullptr)
     {
-        JackBase* target = hitTest(event->pos());
+        JackBase* target = hitTest(toScene(event->pos()));
         if (target != nullptr && target != m_dragJack && canConnect(m_dragJack, target))
         {
-            auto* output = dynamic_cast<OutputJack*>(m_dragJack);
-            auto* input = dynamic_cast<InputJack*>(target);
+            OutputJack* output = asOutput(m_dragJack);
+            InputJack* input = asInput(target);
 
             if (output == nullptr)
             {
-                output = dynamic_cast<OutputJack*>(target);
-                input = dynamic_cast<InputJack*>(m_dragJack);
+                output = asOutput(target);
+                input = asInput(m_dragJack);
             }
 
-            if (output != nullptr && input != nullptr)
+            if (output != nullptr && input != nullptr && input->source() != output)
             {
-                if (input->source() != nullptr && input->source() != output)
+                if (OutputJack* previous = input->source())
+                {
                     input->disconnect();
+                    emit cableDisconnected(previous, input);
+                }
 
                 output->connectTo(input, nextCableColor());
+                emit cableConnected(output, input);
             }
         }
     }
@@ -489,16 +926,64 @@ void PatchPanelWidget::mouseReleaseEvent(QMouseEvent* event)
     m_isDragging = false;
     m_dragJack = nullptr;
     m_dropTargetJack = nullptr;
+}
 
-    update();
+void PatchPanelWidget::wheelEvent(QWheelEvent* event)
+{
+    const int steps = event->angleDelta().y();
+    if (steps == 0)
+    {
+        QWidget::wheelEvent(event);
+        return;
+    }
+
+    // 120 is one notch of a wheel, which zooms by 20%; the scene point under the
+    // pointer stays where it is
+    const QPointF pos = event->position();
+    const QPointF anchorScene = pos / m_zoom + m_viewOrigin;
+    const qreal zoom = std::clamp(m_zoom * std::pow(1.2, steps / 120.0), kMinZoom, kMaxZoom);
+
+    setView(zoom, anchorScene - pos / zoom);
+    event->accept();
+}
+
+void PatchPanelWidget::leaveEvent(QEvent* event)
+{
+    Q_UNUSED(event);
+
+    setHoveredJack(nullptr);
+}
+
+std::uint64_t PatchPanelWidget::gridKey(int column, int row)
+{
+    return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(column)) << 32) | static_cast<std::uint32_t>(row);
+}
+
+void PatchPanelWidget::addToGrid(JackBase* jack)
+{
+    const QRect& rect = jack->rect();
+    const int left = gridCell(rect.left(), kGridCellSize);
+    const int right = gridCell(rect.right(), kGridCellSize);
+    const int top = gridCell(rect.top(), kGridCellSize);
+    const int bottom = gridCell(rect.bottom(), kGridCellSize);
+
+    for (int row = top; row <= bottom; ++row)
+    {
+        for (int column = left; column <= right; ++column)
+            m_jackGrid[gridKey(column, row)].push_back(jack);
+    }
 }
 
 JackBase* PatchPanelWidget::hitTest(const QPoint& pos) const
 {
-    for (const auto& jack : m_jacks)
+    const auto cell = m_jackGrid.find(gridKey(gridCell(pos.x(), kGridCellSize), gridCell(pos.y(), kGridCellSize)));
+    if (cell == m_jackGrid.end())
+        return nullptr;
+
+    for (JackBase* jack : cell->second)
     {
         if (jack->hitTest(pos))
-            return jack.get();
+            return jack;
     }
 
     return nullptr;
@@ -512,8 +997,30 @@ bool PatchPanelWidget::canConnect(const JackBase* a, const JackBase* b) const
     return a->direction() != b->direction();
 }
 
-void PatchPanelWidget::clearHoverStates()
+void PatchPanelWidget::setHoveredJack(JackBase* jack)
 {
-    for (auto& jack : m_jacks)
-        jack->setHovered(false);
+    if (jack == m_hoveredJack)
+        return;
+
+    if (m_hoveredJack != nullptr)
+    {
+        m_hoveredJack->setHovered(false);
+        update(toView(m_hoveredJack->bounds()));
+    }
+
+    m_hoveredJack = jack;
+
+    if (m_hoveredJack != nullptr)
+    {
+        m_hoveredJack->setHovered(true);
+        update(toView(m_hoveredJack->bounds()));
+    }
+}
+
+QRect PatchPanelWidget::dragCableBounds() const
+{
+    if (m_dragJack == nullptr)
+        return QRect();
+
+    return toView(cableBounds(m_dragJack->anchor(), m_dragPos));
 }
@@ -1,12 +1,17 @@
 #pragma once
 
 #include <QColor>
+#include <QPixmap>
 #include <QPoint>
+#include <QPointF>
 #include <QRect>
+#include <QRectF>
 #include <QString>
 #include <QWidget>
 
+#include <cstdint>
 #include <memory>
+#include <unordered_map>
 #include <vector>
 
 class QPainter;
@@ -19,6 +24,14 @@ enum class JackDirection
     Output
 };
 
+// How much of a jack or cable is drawn. The panel picks Coarse when zoomed far out:
+// jacks become plain dots without labels and cables single straight lines.
+enum class DetailLevel
+{
+    Full,
+    Coarse
+};
+
 class JackBase
 {
 public:
@@ -31,13 +44,19 @@ public:
 
     QPoint anchor() const;
     bool hitTest(const QPoint& pos) const;
+    // everything draw() may touch, hover glow and label included
+    QRect bounds() const;
 
     void setHovered(bool hovered) noexcept;
     bool isHovered() const noexcept;
 
     virtual bool isConnected() const = 0;
-    virtual void draw(QPainter& painter) const;
-    virtual void drawConnections(QPainter& painter) const;
+    // Signal level shown on the jack and its cables: below 0 when not metered, 0 for
+    // silence up to just under 1 for full scale, and 1 for clipping
+    virtual float level() const;
+    virtual void draw(QPainter& painter, DetailLevel detail = DetailLevel::Full) const;
+    // draws the cables whose bounds meet visible, in scene coordinates
+    virtual void drawConnections(QPainter& painter, const QRectF& visible) const;
 
 protected:
     PatchPanelWidget* panel() const noexcept;
@@ -64,6 +83,8 @@ public:
     OutputJack* source() const noexcept;
 
     bool isConnected() const override;
+    // the level of the output feeding it
+    float level() const override;
 
 private:
     OutputJack* m_source = nullptr;
@@ -86,13 +107,24 @@ public:
 
     const std::vector<Connection>& connections() const noexcept;
 
+    // set through PatchPanelWidget::setOutputLevel()
+    void setLevel(float level) noexcept;
+    float level() const override;
+
     bool isConnected() const override;
-    void drawConnections(QPainter& painter) const override;
+    void drawConnections(QPainter& painter, const QRectF& visible) const override;
 
 private:
     std::vector<Connection> m_connections;
+    float m_level = -1.0f;
 };
 
+// The jacks and cables live in a scene whose coordinates are the jack rects as added.
+// The widget shows part of it: the wheel zooms about the pointer, and dragging with the
+// middle button, or the left one away from any jack, pans. Only jacks and cables in view
+// are drawn, and below kCoarseZoom, or with more than kCoarseCableLimit cables in view,
+// they are drawn in DetailLevel::Coarse. Panning scrolls the cached layers and draws only
+// the strip that comes into view.
 class PatchPanelWidget : public QWidget
 {
     Q_OBJECT
@@ -104,28 +136,109 @@ public:
     OutputJack* addOutputJack(const QString& label, const QRect& rect,  const QColor& baseColor);
 
     static void drawCable(QPainter& painter, QPoint start, QPoint end, const QColor& color, int feedback = 0);
+    // the area drawCable() may touch for these end points
+    static QRect cableBounds(QPoint start, QPoint end);
+
+    // Called by the jacks whenever a cable is added or removed, from the panel or not,
+    // so the cached layers are redrawn
+    void invalidateConnections();
+
+    // Shows an output's measured level on it, its cables and the inputs they feed. The
+    // RMS is shown in eight steps from -60 dB to full scale, so silent paths go dim, and
+    // a peak over full scale turns them red. Only the output's cables and jacks are
+    // redrawn, and only when it moves to another step, so this can be called for every
+    // output on every frame.
+    void setOutputLevel(OutputJack* output, float peak, float rms);
+
+    qreal zoom() const noexcept;
+    // scene point at the widget's top-left corner
+    QPointF viewOrigin() const noexcept;
+    void setView(qreal zoom, const QPointF& origin);
+
+signals:
+    // Emitted for every cable the user plugs or pulls; a cable dropped on an occupied
+    // input first reports the old one as disconnected. A slot may refuse a new cable by
+    // calling output->removeTarget(input).
+    void cableConnected(OutputJack* output, InputJack* input);
+    void cableDisconnected(OutputJack* output, InputJack* input);
 
 protected:
     void paintEvent(QPaintEvent* event) override;
     void mousePressEvent(QMouseEvent* event) override;
     void mouseMoveEvent(QMouseEvent* event) override;
     void mouseReleaseEvent(QMouseEvent* event) override;
+    void wheelEvent(QWheelEvent* event) override;
+    void leaveEvent(QEvent* event) override;
 
 private:
+    // side of a hit-test grid cell, in pixels; about two jacks across
+    static constexpr int kGridCellSize = 64;
+
+    static constexpr qreal kMinZoom = 0.02;
+    static constexpr qreal kMaxZoom = 4.0;
+    // below this a jack is under about 10 pixels across and a label is unreadable
+    static constexpr qreal kCoarseZoom = 0.45;
+    // a Full cable is three antialiased strokes, so past this many a redraw of the whole
+    // view no longer fits in a 60 Hz frame
+    static constexpr int kCoarseCableLimit = 1500;
+
+    static std::uint64_t gridKey(int column, int row);
+    void addToGrid(JackBase* jack);
     JackBase* hitTest(const QPoint& pos) const;
     bool canConnect(const JackBase* a, const JackBase* b) const;
-    void clearHoverStates();
+    void setHoveredJack(JackBase* jack);
+    // in widget coordinates, like the other rects handed to update()
+    QRect dragCableBounds() const;
+    QPoint toScene(const QPoint& pos) const;
+    QRect toView(const QRect& sceneRect) const;
+    QRectF visibleScene() const;
+    DetailLevel detailLevel() const;
+    // picks the detail for the view; a change redraws both layers
+    void updateDetailLevel();
+    void setViewTransform(QPainter& painter) const;
+    void paintCables(QPainter& painter, const QRectF& visible) const;
+    void paintJacks(QPainter& painter, const QRectF& visible);
+    void renderCableLayer();
+    void renderJackLayer();
+    // redraws the part of both layers inside area, given in widget coordinates
+    void renderLayers(const QRect& area);
+    // moves the view to origin by scrolling both layers, which only works at the same
+    // zoom and for a whole number of pixels; false when the layers must be redrawn
+    bool scrollLayers(const QPointF& origin);
     QColor nextCableColor();
 
 private:
     std::vector<std::unique_ptr<JackBase>> m_jacks;
     int m_nextCableColorIndex = 0;
 
+    // Uniform grid over the jack rects, so a hit test only looks at the jacks in the
+    // pointer's cell. A jack is listed in every cell its rect overlaps, in the order the
+    // jacks were added. Only cells holding a jack are stored.
+    std::unordered_map<std::uint64_t, std::vector<JackBase*>> m_jackGrid;
+
+    // Cached layers, at the widget's pixel ratio: the background with the committed
+    // cables, and the jacks at rest over a transparent background. The hovered jack and
+    // the cable being dragged are drawn over them on every paint.
+    QPixmap m_cableLayer;
+    QPixmap m_jackLayer;
+    bool m_cableLayerDirty = true;
+    bool m_jackLayerDirty = true;
+    // the detail both layers were drawn at
+    DetailLevel m_detailLevel = DetailLevel::Full;
+
+    JackBase* m_hoveredJack = nullptr;
+
+    qreal m_zoom = 1.0;
+    QPointF m_viewOrigin;
+    bool m_isPanning = false;
+    QPoint m_panLastPos;
+
     JackBase* m_pressedJack = nullptr;
     QPoint m_pressPos;
 
     bool m_isDragging = false;
     JackBase* m_dragJack = nullptr;
     JackBase* m_dropTargetJack = nullptr;
+    // in scene coordinates
     QPoint m_dragPos;
 };
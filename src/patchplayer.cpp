@@ -0,0 +1,114 @@
+#include "patchplayer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <unordered_map>
+
+PatchPlayer::PatchPlayer(AudioContext& context, const unsigned max_frames, const NodeRegistry& registry,
+                         const std::size_t arena_bytes, const unsigned max_nodes)
+    : context_(context), max_frames_(max_frames), buffer_(std::make_unique<float[]>(max_frames)) {
+    for (auto& graph : graphs_) {
+        graph = std::make_unique<PatchGraph>(context, registry, arena_bytes, max_nodes);
+    }
+    matches_.reserve(max_nodes);
+}
+
+bool PatchPlayer::swapping() const {
+    return phase_.load(std::memory_order_acquire) != Phase::Idle;
+}
+
+bool PatchPlayer::load(const Patch& patch) {
+    if (swapping()) {
+        std::cerr << "Previous patch swap hasn't finished\n";
+        return false;
+    }
+
+    // while Idle the audio thread only touches the active graph
+    PatchGraph& spare = *graphs_[1 - active_];
+    if (!spare.instantiate(patch)) {
+        return false;
+    }
+
+    // A throwaway block under an id the audio thread has already used, so the new
+    // nodes allocate their buffers here. Matched nodes get their state back below.
+    spare.render(max_frames_, context_.lastBatch() - 1);
+
+    matches_.clear();
+    if (playing_) {
+        matchNodes(*graphs_[active_], spare);
+    }
+
+    phase_.store(Phase::Ready, std::memory_order_release);
+    return true;
+}
+
+void PatchPlayer::matchNodes(const PatchGraph& from, const PatchGraph& to) {
+    std::unordered_map<const NodeType*, std::vector<AudioNode*>> by_type;
+    for (unsigned i = 0; i < from.nodeCount(); ++i) {
+        by_type[from.nodeType(i)].push_back(from.node(i));
+    }
+
+    std::unordered_map<const NodeType*, size_t> taken;
+    for (unsigned i = 0; i < to.nodeCount(); ++i) {
+        const auto candidates = by_type.find(to.nodeType(i));
+        if (candidates == by_type.end()) {
+            continue;
+        }
+        size_t& next = taken[to.nodeType(i)];
+        if (next < candidates->second.size()) {
+            matches_.emplace_back(candidates->second[next++], to.node(i));
+        }
+    }
+}
+
+void PatchPlayer::process(unsigned frames) {
+    frames = std::min(frames, max_frames_);
+
+    if (phase_.load(std::memory_order_acquire) == Phase::Ready) {
+        if (!playing_) {
+            active_ = 1 - active_;
+            playing_ = true;
+            phase_.store(Phase::Idle, std::memory_order_release);
+        } else {
+            for (const auto& match : matches_) {
+                match.second->transferState(*match.first);
+            }
+            const double seconds = crossfade_seconds_.load(std::memory_order_relaxed);
+            fade_length_ = std::max(1ll, std::llround(seconds * context_.sampleRate()));
+            fade_position_ = 0;
+            phase_.store(Phase::Fading, std::memory_order_release);
+        }
+    }
+
+    if (!playing_) {
+        std::memset(buffer_.get(), 0, frames * sizeof(float));
+        return;
+    }
+
+    const unsigned id = context_.lastBatch();
+    graphs_[active_]->render(frames, id);
+    const float* current_buffer = graphs_[active_]->output()->buffer();
+
+    if (phase_.load(std::memory_order_relaxed) != Phase::Fading) {
+        std::memcpy(buffer_.get(), current_buffer, frames * sizeof(float));
+        return;
+    }
+
+    graphs_[1 - active_]->render(frames, id);
+    const float* next_buffer = graphs_[1 - active_]->output()->buffer();
+
+    const float step = 1.0f / static_cast<float>(fade_length_);
+    for (unsigned i = 0; i < frames; ++i) {
+        const float mix = std::min(1.0f, static_cast<float>(fade_position_ + i) * step);
+        buffer_[i] = current_buffer[i] + (next_buffer[i] - current_buffer[i]) * mix;
+    }
+
+    fade_position_ += frames;
+    if (fade_position_ >= fade_length_) {
+        active_ = 1 - active_;
+        swaps_completed_.fetch_add(1, std::memory_order_relaxed);
+        phase_.store(Phase::Idle, std::memory_order_release);
+    }
+}
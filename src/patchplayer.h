@@ -0,0 +1,78 @@
+#ifndef PATCHPLAYER_H
+#define PATCHPLAYER_H
+
+#include "patchgraph.h"
+
+#include <atomic>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// Plays a patch and swaps to another one without stopping the stream or clicking.
+//
+// load() runs on a control thread. It builds the new patch into a spare PatchGraph and
+// renders one throwaway block so every node allocates its buffers there rather than on
+// the audio thread. It then matches the new nodes to the playing ones and hands the
+// graph over. At the start of its next block the audio thread copies the running state
+// of each matched pair (AudioNode::transferState), then plays both graphs under a linear
+// crossfade. The state is carried over, so the two are in phase and a linear fade keeps
+// the level. When the fade ends the old graph becomes the spare for the next load().
+//
+// Nodes are matched by type and by their order among nodes of that type: the k-th
+// oscillator of the new patch takes over from the k-th oscillator of the old one.
+class PatchPlayer
+{
+public:
+    static constexpr double DEFAULT_CROSSFADE_SECONDS = 0.02;
+
+    PatchPlayer(AudioContext& context, unsigned max_frames, const NodeRegistry& registry = NodeRegistry::builtin(),
+                std::size_t arena_bytes = PatchGraph::DEFAULT_ARENA_BYTES,
+                unsigned max_nodes = PatchGraph::DEFAULT_MAX_NODES);
+
+    PatchPlayer(const PatchPlayer&) = delete;
+    PatchPlayer& operator=(const PatchPlayer&) = delete;
+
+    // Control thread. The first patch plays straight away; later ones crossfade in. Fails
+    // while the previous swap is still fading (see swapping()), or when the patch
+    // doesn't instantiate, and the current patch keeps playing either way.
+    bool load(const Patch& patch);
+    bool swapping() const;
+
+    void setCrossfadeSeconds(double seconds) { crossfade_seconds_.store(seconds, std::memory_order_relaxed); }
+
+    // Audio thread. Renders one block into buffer() under the context's batch id; the
+    // caller advances the context afterwards, as with any graph. frames must not exceed
+    // max_frames. Renders silence before the first load().
+    void process(unsigned frames);
+    const float* buffer() const { return buffer_.get(); }
+
+    // swaps the audio thread has completed
+    unsigned long long swapsCompleted() const { return swaps_completed_.load(std::memory_order_relaxed); }
+
+private:
+    enum class Phase { Idle, Ready, Fading };
+
+    void matchNodes(const PatchGraph& from, const PatchGraph& to);
+
+    AudioContext& context_;
+    unsigned max_frames_;
+
+    std::unique_ptr<PatchGraph> graphs_[2];
+    // graph the audio thread plays, or fades out of while fading
+    unsigned active_ = 0;
+    bool playing_ = false;
+
+    std::atomic<Phase> phase_ { Phase::Idle };
+    std::atomic<double> crossfade_seconds_ { DEFAULT_CROSSFADE_SECONDS };
+    std::atomic<unsigned long long> swaps_completed_ { 0 };
+
+    // (old, new) node pairs for the pending swap, written by load() before Ready
+    std::vector<std::pair<AudioNode*, AudioNode*>> matches_;
+
+    unsigned long long fade_length_ = 0;
+    unsigned long long fade_position_ = 0;
+
+    std::unique_ptr<float[]> buffer_;
+};
+
+#endif // PATCHPLAYER_H
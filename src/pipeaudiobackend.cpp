@@ -0,0 +1,238 @@
+#include "pipeaudiobackend.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <climits>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+#ifdef _WIN32
+struct iovec {
+    void* iov_base;
+    size_t iov_len;
+};
+#endif
+
+#ifndef _WIN32
+// A SIGPIPE raised by a write goes to the thread that wrote, so blocking it in the writer
+// thread turns a reader going away into EPIPE without touching how the rest of the
+// process handles the signal
+void blockSigpipe() {
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &set, nullptr);
+}
+
+// takes back the SIGPIPE left pending by a write that failed with EPIPE, so it is not
+// delivered if the thread ever unblocks it
+void discardSigpipe() {
+    sigset_t pending;
+    sigemptyset(&pending);
+    if (sigpending(&pending) == 0 && sigismember(&pending, SIGPIPE) == 1) {
+        sigset_t set;
+        sigemptyset(&set);
+        sigaddset(&set, SIGPIPE);
+        int signal = 0;
+        sigwait(&set, &signal);
+    }
+}
+#endif
+
+// Writes every byte described by the vector, resuming after partial writes
+bool writeAll(int fd, iovec* vectors, int count, unsigned long long& calls) {
+    while (count > 0) {
+#ifdef _WIN32
+        const auto written = _write(fd, vectors[0].iov_base, static_cast<unsigned>(vectors[0].iov_len));
+#else
+        const auto written = ::writev(fd, vectors, std::min(count, IOV_MAX));
+#endif
+        calls++;
+
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+#ifndef _WIN32
+            if (errno == EPIPE) {
+                const int error = errno;
+                discardSigpipe();
+                errno = error;
+            }
+#endif
+            return false;
+        }
+
+        auto remaining = static_cast<size_t>(written);
+        while (count > 0 && remaining >= vectors[0].iov_len) {
+            remaining -= vectors[0].iov_len;
+            ++vectors;
+            --count;
+        }
+
+        if (count > 0) {
+            vectors[0].iov_base = static_cast<std::uint8_t*>(vectors[0].iov_base) + remaining;
+            vectors[0].iov_len -= remaining;
+        }
+    }
+
+    return true;
+}
+
+}
+
+PipeAudioBackend::PipeAudioBackend(std::string path, const void* user_data, const double sample_rate,
+                                   const unsigned long frames_per_buffer, const Format format)
+    : AudioBackend(user_data, sample_rate, frames_per_buffer), path_(std::move(path)), format_(format) {}
+
+PipeAudioBackend::~PipeAudioBackend() {
+    stop();
+
+    if (owns_fd_ && fd_ >= 0) {
+#ifdef _WIN32
+        _close(fd_);
+#else
+        ::close(fd_);
+#endif
+    }
+}
+
+bool PipeAudioBackend::initializeStream() {
+    if (frames_per_buffer_ == 0) {
+        std::cerr << "Pipe backend needs a positive block size\n";
+        return false;
+    }
+
+    if (path_ == "-") {
+        fd_ = 1;
+        owns_fd_ = false;
+#ifdef _WIN32
+        _setmode(fd_, _O_BINARY);
+#endif
+    } else {
+        // opening a FIFO blocks here until the reader shows up
+#ifdef _WIN32
+        fd_ = _open(path_.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, 0644);
+#else
+        fd_ = ::open(path_.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+#endif
+        owns_fd_ = true;
+    }
+
+    if (fd_ < 0) {
+        std::cerr << "Failed to open " << path_ << ": " << std::strerror(errno) << "\n";
+        return false;
+    }
+
+    const size_t bytes_per_sample = format_ == Format::Float32 ? sizeof(float) : sizeof(std::int16_t);
+    block_bytes_ = frames_per_buffer_ * CHANNELS * bytes_per_sample;
+
+    render_buffer_ = std::make_unique<float[]>(frames_per_buffer_ * CHANNELS);
+    batch_ = std::make_unique<std::uint8_t[]>(block_bytes_ * batch_blocks_);
+    return true;
+}
+
+bool PipeAudioBackend::setBatchBlocks(const unsigned blocks) {
+    if (batch_) {
+        std::cerr << "Pipe backend batch size can't change after initializeStream()\n";
+        return false;
+    }
+
+    batch_blocks_ = blocks > 0 ? blocks : 1;
+    return true;
+}
+
+bool PipeAudioBackend::start() {
+    if (fd_ < 0 || running_) {
+        return false;
+    }
+
+    failed_ = false;
+    running_ = true;
+    worker_ = std::thread(&PipeAudioBackend::run, this);
+    return true;
+}
+
+bool PipeAudioBackend::stop() {
+    running_ = false;
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+    return !failed_;
+}
+
+void PipeAudioBackend::run() {
+#ifndef _WIN32
+    blockSigpipe();
+#endif
+
+    unsigned pending = 0;
+    const size_t samples = frames_per_buffer_ * CHANNELS;
+
+    // one vector per block, allocated once before the stream starts
+    std::vector<iovec> vectors(batch_blocks_);
+
+    const auto flush = [&](unsigned blocks) {
+        for (unsigned i = 0; i < blocks; ++i) {
+            vectors[i].iov_base = batch_.get() + i * block_bytes_;
+            vectors[i].iov_len = block_bytes_;
+        }
+
+        unsigned long long calls = 0;
+        const bool ok = writeAll(fd_, vectors.data(), static_cast<int>(blocks), calls);
+        write_calls_ += calls;
+
+        if (!ok) {
+            std::cerr << "Pipe write failed: " << std::strerror(errno) << "\n";
+            failed_ = true;
+            return false;
+        }
+
+        bytes_written_ += block_bytes_ * blocks;
+        return true;
+    };
+
+    while (running_) {
+        std::uint8_t* slot = batch_.get() + pending * block_bytes_;
+
+        if (format_ == Format::Float32) {
+            renderBlock(reinterpret_cast<float*>(slot), frames_per_buffer_);
+        } else {
+            renderBlock(render_buffer_.get(), frames_per_buffer_);
+            for (size_t i = 0; i < samples; ++i) {
+                const float clamped = std::clamp(render_buffer_[i], -1.0f, 1.0f);
+                const auto value = static_cast<std::uint16_t>(static_cast<std::int16_t>(std::lrint(clamped * 32767.0f)));
+                slot[i * 2] = static_cast<std::uint8_t>(value & 0xff);
+                slot[i * 2 + 1] = static_cast<std::uint8_t>(value >> 8);
+            }
+        }
+
+        if (++pending == batch_blocks_) {
+            if (!flush(pending)) {
+                break;
+            }
+            pending = 0;
+        }
+    }
+
+    if (pending > 0 && !failed_) {
+        flush(pending);
+    }
+    running_ = false;
+}
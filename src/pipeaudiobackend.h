@@ -0,0 +1,60 @@
+#ifndef PIPEAUDIOBACKEND_H
+#define PIPEAUDIOBACKEND_H
+
+#include "audiobackend.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+
+// Streams raw interleaved PCM to stdout ("-") or a FIFO/file path. Blocks are
+// collected into batches and handed to the kernel with a single writev, so the
+// reader on the other end sees large writes and the render thread few syscalls.
+// The reader sets the pace: a full pipe blocks the render thread.
+class PipeAudioBackend : public AudioBackend {
+
+public:
+    enum class Format {
+        Float32,
+        S16LE
+    };
+
+    explicit PipeAudioBackend(std::string path = "-", const void* user_data = nullptr, double sample_rate = 44100.0,
+                              unsigned long frames_per_buffer = 256, Format format = Format::Float32);
+    ~PipeAudioBackend() override;
+
+    bool initializeStream() override;
+    bool start() override;
+    bool stop() override;
+
+    // Number of blocks gathered into one writev (default 32). The batch is sized by
+    // initializeStream(), so this fails once the stream is initialized.
+    bool setBatchBlocks(unsigned blocks);
+
+    unsigned long long bytesWritten() const { return bytes_written_.load(); }
+    unsigned long long writeCalls() const { return write_calls_.load(); }
+    bool failed() const { return failed_.load(); }
+
+private:
+    void run();
+
+    std::string path_;
+    Format format_;
+    int fd_ = -1;
+    bool owns_fd_ = false;
+
+    unsigned batch_blocks_ = 32;
+    size_t block_bytes_ = 0;
+    std::unique_ptr<float[]> render_buffer_;
+    std::unique_ptr<std::uint8_t[]> batch_;
+
+    std::thread worker_;
+    std::atomic<bool> running_ { false };
+    std::atomic<bool> failed_ { false };
+    std::atomic<unsigned long long> bytes_written_ { 0 };
+    std::atomic<unsigned long long> write_calls_ { 0 };
+};
+
+#endif // PIPEAUDIOBACKEND_H
@@ -0,0 +1,259 @@
+#include "processingorder.h"
+
+#include <algorithm>
+
+ProcessingOrder::ProcessingOrder(const unsigned max_nodes, const unsigned edge_capacity)
+    : edge_capacity_(edge_capacity) {
+    order_.reserve(max_nodes);
+    position_.reserve(max_nodes);
+    inputs_.reserve(max_nodes);
+    outputs_.reserve(max_nodes);
+    visited_.reserve(max_nodes);
+    forward_.reserve(max_nodes);
+    backward_.reserve(max_nodes);
+    stack_.reserve(max_nodes);
+    slots_.reserve(max_nodes);
+}
+
+void ProcessingOrder::clear() {
+    order_.clear();
+    position_.clear();
+    inputs_.clear();
+    outputs_.clear();
+    visited_.clear();
+    dirty_first_ = dirty_last_ = 0;
+}
+
+unsigned ProcessingOrder::addNode() {
+    const unsigned node = nodeCount();
+    order_.push_back(node);
+    position_.push_back(node);
+    inputs_.emplace_back().reserve(edge_capacity_);
+    outputs_.emplace_back().reserve(edge_capacity_);
+    visited_.push_back(0);
+    markDirty(node, node + 1);
+    return node;
+}
+
+void ProcessingOrder::addEdgeUnordered(const unsigned from, const unsigned to, const unsigned tag) {
+    outputs_[from].push_back({ to, tag });
+    inputs_[to].push_back({ from, tag });
+}
+
+bool ProcessingOrder::addEdge(const unsigned from, const unsigned to, const unsigned tag) {
+    if (from == to) {
+        return false;
+    }
+
+    const unsigned lower = position_[to];
+    const unsigned upper = position_[from];
+    if (upper > lower) {
+        // Only the nodes between the two ends can be out of place: those reachable from
+        // `to` have to move after those that reach `from`
+        forward_.clear();
+        backward_.clear();
+        if (!searchForward(to, upper)) {
+            for (const unsigned position : forward_) {
+                visited_[order_[position]] = 0;
+            }
+            return false;
+        }
+        searchBackward(from, lower);
+        reorder();
+    }
+
+    addEdgeUnordered(from, to, tag);
+    return true;
+}
+
+bool ProcessingOrder::connectInput(const unsigned from, const unsigned to, const unsigned tag, const bool exclusive) {
+    bool replacing = false;
+    unsigned replaced = 0;
+    for (const Edge& edge : inputs_[to]) {
+        if (edge.tag != tag) {
+            continue;
+        }
+        if (edge.node == from) {
+            return true;
+        }
+        if (exclusive) {
+            replacing = true;
+            replaced = edge.node;
+            break;
+        }
+    }
+
+    if (replacing) {
+        removeEdge(replaced, to, tag);
+    }
+    if (!addEdge(from, to, tag)) {
+        if (replacing) {
+            // it ran forwards before, so it goes back without moving anything
+            addEdge(replaced, to, tag);
+        }
+        return false;
+    }
+    return true;
+}
+
+bool ProcessingOrder::eraseEdge(std::vector<Edge>& edges, const unsigned node, const unsigned tag) {
+    const auto edge = std::find_if(edges.begin(), edges.end(),
+                                   [node, tag](const Edge& e) { return e.node == node && e.tag == tag; });
+    if (edge == edges.end()) {
+        return false;
+    }
+    edges.erase(edge);
+    return true;
+}
+
+bool ProcessingOrder::removeEdge(const unsigned from, const unsigned to, const unsigned tag) {
+    if (!eraseEdge(outputs_[from], to, tag)) {
+        return false;
+    }
+    eraseEdge(inputs_[to], from, tag);
+    return true;
+}
+
+bool ProcessingOrder::searchForward(const unsigned start, const unsigned upper) {
+    stack_.clear();
+    stack_.push_back(start);
+    visited_[start] = 1;
+    forward_.push_back(position_[start]);
+
+    while (!stack_.empty()) {
+        const unsigned node = stack_.back();
+        stack_.pop_back();
+        for (const Edge& edge : outputs_[node]) {
+            const unsigned position = position_[edge.node];
+            if (position == upper) {
+                // reached `from`: the new edge would close a cycle
+                return false;
+            }
+            if (position < upper && !visited_[edge.node]) {
+                visited_[edge.node] = 1;
+                forward_.push_back(position);
+                stack_.push_back(edge.node);
+            }
+        }
+    }
+    return true;
+}
+
+void ProcessingOrder::searchBackward(const unsigned start, const unsigned lower) {
+    stack_.clear();
+    stack_.push_back(start);
+    visited_[start] = 1;
+    backward_.push_back(position_[start]);
+
+    while (!stack_.empty()) {
+        const unsigned node = stack_.back();
+        stack_.pop_back();
+        for (const Edge& edge : inputs_[node]) {
+            const unsigned position = position_[edge.node];
+            if (position > lower && !visited_[edge.node]) {
+                visited_[edge.node] = 1;
+                backward_.push_back(position);
+                stack_.push_back(edge.node);
+            }
+        }
+    }
+}
+
+void ProcessingOrder::reorder() {
+    // the searches collect positions rather than nodes, so these sort plain integers
+    std::sort(forward_.begin(), forward_.end());
+    std::sort(backward_.begin(), backward_.end());
+
+    // the affected nodes keep the slots they had between them; the ones that reach
+    // `from` take the first of those slots, in their old relative order. std::merge
+    // into reserved space, as std::inplace_merge may allocate a buffer.
+    slots_.resize(backward_.size() + forward_.size());
+    std::merge(backward_.begin(), backward_.end(), forward_.begin(), forward_.end(), slots_.begin());
+
+    // the nodes, read before order_ is rewritten
+    for (unsigned& entry : backward_) {
+        entry = order_[entry];
+    }
+    for (unsigned& entry : forward_) {
+        entry = order_[entry];
+    }
+
+    unsigned slot = 0;
+    for (const unsigned node : backward_) {
+        position_[node] = slots_[slot];
+        order_[slots_[slot++]] = node;
+        visited_[node] = 0;
+    }
+    for (const unsigned node : forward_) {
+        position_[node] = slots_[slot];
+        order_[slots_[slot++]] = node;
+        visited_[node] = 0;
+    }
+    markDirty(slots_.front(), slots_.back() + 1);
+}
+
+bool ProcessingOrder::rebuild() {
+    // Kahn's algorithm, with order_ doubling as the queue
+    const unsigned count = nodeCount();
+    slots_.assign(count, 0);
+    for (unsigned node = 0; node < count; ++node) {
+        slots_[node] = static_cast<unsigned>(inputs_[node].size());
+    }
+
+    order_.clear();
+    for (unsigned node = 0; node < count; ++node) {
+        if (slots_[node] == 0) {
+            order_.push_back(node);
+        }
+    }
+    for (unsigned head = 0; head < order_.size(); ++head) {
+        for (const Edge& edge : outputs_[order_[head]]) {
+            if (--slots_[edge.node] == 0) {
+                order_.push_back(edge.node);
+            }
+        }
+    }
+
+    const bool acyclic = order_.size() == count;
+    if (!acyclic) {
+        // the nodes on or after a cycle go last, so order_ still lists every node once
+        for (unsigned node = 0; node < count; ++node) {
+            if (slots_[node] > 0) {
+                order_.push_back(node);
+            }
+        }
+    }
+
+    for (unsigned position = 0; position < count; ++position) {
+        position_[order_[position]] = position;
+    }
+    markDirty(0, count);
+    return acyclic;
+}
+
+void ProcessingOrder::markDirty(const unsigned first, const unsigned last) {
+    if (dirty_first_ == dirty_last_) {
+        dirty_first_ = first;
+        dirty_last_ = last;
+    } else {
+        dirty_first_ = std::min(dirty_first_, first);
+        dirty_last_ = std::max(dirty_last_, last);
+    }
+}
+
+void ProcessingOrder::takeDirty(unsigned& first, unsigned& last) {
+    first = dirty_first_;
+    last = dirty_last_;
+    dirty_first_ = dirty_last_ = 0;
+}
+
+bool ProcessingOrder::valid() const {
+    for (unsigned node = 0; node < nodeCount(); ++node) {
+        for (const Edge& edge : outputs_[node]) {
+            if (position_[node] >= position_[edge.node]) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
@@ -0,0 +1,94 @@
+#ifndef PROCESSINGORDER_H
+#define PROCESSINGORDER_H
+
+#include <vector>
+
+// Topological order of a node graph, kept up to date one edit at a time so a large patch
+// doesn't have to be sorted again for every cable.
+//
+// Nodes are indices; the caller keeps what they stand for. order() lists them with every
+// node after all of its inputs, so processing them in that order finds each input already
+// done for the block instead of pulling it recursively. Removing an edge never breaks the
+// order. Adding one only moves nodes when it points backwards, and then only the ones
+// between its two ends that are reachable from one end or reach the other, following
+// Pearce and Kelly's dynamic topological sort. Everything outside that region keeps its
+// position.
+//
+// The positions rewritten since the last takeDirty() are tracked as one range, so a copy
+// of the order (say, one the audio thread plays from) is patched rather than replaced.
+class ProcessingOrder
+{
+public:
+    // edge slots reserved per node by default
+    static constexpr unsigned EDGE_RESERVE = 4;
+
+    // An edge as seen from one end: the node at the other end and a caller-defined tag,
+    // e.g. the automation port it feeds. Several edges may join the same two nodes.
+    struct Edge {
+        unsigned node;
+        unsigned tag;
+    };
+
+    // Up to max_nodes nodes and edge_capacity edges into and out of each node fit without
+    // allocating; past that the lists grow.
+    explicit ProcessingOrder(unsigned max_nodes = 0, unsigned edge_capacity = EDGE_RESERVE);
+
+    void clear();
+    // appended last, which is valid for a node without edges
+    unsigned addNode();
+
+    // Fails, leaving everything as it was, when the edge would close a cycle
+    bool addEdge(unsigned from, unsigned to, unsigned tag = 0);
+    // addEdge() for an input that takes one edge per tag when exclusive: an existing edge
+    // into `to` with the same tag is replaced, and put back if the new one is refused.
+    // Connecting what is already connected succeeds and changes nothing.
+    bool connectInput(unsigned from, unsigned to, unsigned tag, bool exclusive);
+    // false when there is no such edge
+    bool removeEdge(unsigned from, unsigned to, unsigned tag = 0);
+
+    // Adds edges without ordering them; rebuild() must follow. For loading a whole graph,
+    // where one sort is cheaper than an incremental step per edge.
+    void addEdgeUnordered(unsigned from, unsigned to, unsigned tag = 0);
+    // Sorts everything from scratch. Fails when the graph has a cycle.
+    bool rebuild();
+
+    unsigned nodeCount() const { return static_cast<unsigned>(position_.size()); }
+    unsigned edgeCapacity() const { return edge_capacity_; }
+    const std::vector<unsigned>& order() const { return order_; }
+    unsigned position(unsigned node) const { return position_[node]; }
+    const std::vector<Edge>& inputs(unsigned node) const { return inputs_[node]; }
+    const std::vector<Edge>& outputs(unsigned node) const { return outputs_[node]; }
+
+    // Positions of order() rewritten since the last call, as [first, last). Empty when
+    // first == last.
+    void takeDirty(unsigned& first, unsigned& last);
+
+    // whether every edge runs forwards; for tests and benchmarks
+    bool valid() const;
+
+private:
+    bool searchForward(unsigned start, unsigned upper);
+    void searchBackward(unsigned start, unsigned lower);
+    void reorder();
+    void markDirty(unsigned first, unsigned last);
+    static bool eraseEdge(std::vector<Edge>& edges, unsigned node, unsigned tag);
+
+    unsigned edge_capacity_;
+    std::vector<unsigned> order_;
+    std::vector<unsigned> position_;
+    std::vector<std::vector<Edge>> inputs_;
+    std::vector<std::vector<Edge>> outputs_;
+
+    // scratch for addEdge() and rebuild(), kept to avoid allocating per edit
+    std::vector<unsigned char> visited_;
+    // positions of the nodes each search reached, then the nodes themselves in reorder()
+    std::vector<unsigned> forward_;
+    std::vector<unsigned> backward_;
+    std::vector<unsigned> stack_;
+    std::vector<unsigned> slots_;
+
+    unsigned dirty_first_ = 0;
+    unsigned dirty_last_ = 0;
+};
+
+#endif // PROCESSINGORDER_H
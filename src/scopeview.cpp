@@ -0,0 +1,185 @@
+#include "scopeview.h"
+
+#include "definitions.h"
+#include "fft.h"
+#include "signaltap.h"
+
+#include <QGuiApplication>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QPainterPath>
+#include <QScreen>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+const double kLowestFrequency = 20.0;
+const double kFloorDb = -96.0;
+}
+
+ScopeView::ScopeView(QWidget* parent)
+    : QWidget(parent),
+    m_history(kHistorySize, 0.0f),
+    m_incoming(kHistorySize, 0.0f),
+    m_window(kHistorySize, 0.0f),
+    m_bins(kHistorySize)
+{
+    setMinimumSize(200, 100);
+    setAttribute(Qt::WA_OpaquePaintEvent);
+
+    for (int i = 0; i < kHistorySize; ++i)
+        m_window[i] = static_cast<float>(0.5 - 0.5 * std::cos(2.0 * M_PI * i / (kHistorySize - 1)));
+
+    // once per display frame, like UpdateCoalescer
+    const QScreen* screen = QGuiApplication::primaryScreen();
+    const double refreshRate = (screen != nullptr && screen->refreshRate() > 0) ? screen->refreshRate() : 60.0;
+    m_timer.setTimerType(Qt::PreciseTimer);
+    m_timer.setInterval(std::max(1, static_cast<int>(std::floor(1000.0 / refreshRate))));
+    connect(&m_timer, &QTimer::timeout, this, &ScopeView::drain);
+    m_timer.start();
+}
+
+void ScopeView::setTap(SignalTap* tap, double sampleRate)
+{
+    m_tap = tap;
+    m_sampleRate = sampleRate;
+    std::fill(m_history.begin(), m_history.end(), 0.0f);
+
+    // whatever the tap holds from before is stale
+    if (m_tap != nullptr)
+        m_tap->skipTo(0);
+
+    update();
+}
+
+void ScopeView::setMode(Mode mode)
+{
+    m_mode = mode;
+    update();
+}
+
+ScopeView::Mode ScopeView::mode() const noexcept
+{
+    return m_mode;
+}
+
+void ScopeView::drain()
+{
+    if (m_tap == nullptr || !isVisible())
+        return;
+
+    // more than the history holds would only be shifted out again
+    m_tap->skipTo(kHistorySize);
+
+    const std::size_t count = m_tap->read(m_incoming.data(), m_incoming.size());
+    if (count == 0)
+        return;
+
+    const std::size_t kept = m_history.size() - count;
+    std::memmove(m_history.data(), m_history.data() + count, kept * sizeof(float));
+    std::memcpy(m_history.data() + kept, m_incoming.data(), count * sizeof(float));
+
+    update();
+}
+
+void ScopeView::paintEvent(QPaintEvent* event)
+{
+    Q_UNUSED(event);
+
+    QPainter painter(this);
+    painter.fillRect(rect(), QColor(20, 20, 24));
+
+    painter.setPen(QColor(60, 60, 66));
+    painter.drawLine(0, height() / 2, width(), height() / 2);
+
+    painter.setRenderHint(QPainter::Antialiasing, true);
+    if (m_mode == Mode::Scope)
+        drawScope(painter);
+    else
+        drawSpectrum(painter);
+
+    painter.setPen(QColor(140, 140, 150));
+    painter.drawText(rect().adjusted(6, 4, -6, -4), Qt::AlignTop | Qt::AlignRight,
+                     m_mode == Mode::Scope ? tr("Scope") : tr("Spectrum"));
+}
+
+void ScopeView::drawScope(QPainter& painter) const
+{
+    // the latest rising zero crossing that still leaves a full span after it
+    int start = kHistorySize - kScopeSpan;
+    for (int i = kHistorySize - kScopeSpan; i > 0; --i)
+    {
+        if (m_history[i - 1] < 0.0f && m_history[i] >= 0.0f)
+        {
+            start = i;
+            break;
+        }
+    }
+
+    const qreal middle = height() * 0.5;
+    const qreal scale = height() * 0.45;
+    const qreal step = static_cast<qreal>(width()) / (kScopeSpan - 1);
+
+    QPainterPath trace;
+    trace.moveTo(0, middle - std::clamp(m_history[start], -1.0f, 1.0f) * scale);
+    for (int i = 1; i < kScopeSpan; ++i)
+        trace.lineTo(i * step, middle - std::clamp(m_history[start + i], -1.0f, 1.0f) * scale);
+
+    painter.setPen(QPen(QColor(0x00, 0xcc, 0x88), 1.5));
+    painter.setBrush(Qt::NoBrush);
+    painter.drawPath(trace);
+}
+
+void ScopeView::drawSpectrum(QPainter& painter)
+{
+    for (int i = 0; i < kHistorySize; ++i)
+        m_bins[i] = std::complex<double>(m_history[i] * m_window[i], 0.0);
+    fft(m_bins);
+
+    // a full-scale sine comes out at 0 dB: the Hann window halves the amplitude
+    const double normalize = 4.0 / kHistorySize;
+    const double nyquist = m_sampleRate * 0.5;
+    const double binWidth = m_sampleRate / kHistorySize;
+    const double logSpan = std::log(nyquist / kLowestFrequency);
+    const int w = std::max(1, width());
+
+    // each column shows the loudest bin in its frequency range
+    QPainterPath curve;
+    for (int x = 0; x < w; ++x)
+    {
+        const double low = kLowestFrequency * std::exp(logSpan * x / w);
+        const double high = kLowestFrequency * std::exp(logSpan * (x + 1) / w);
+        const int first = std::clamp(static_cast<int>(low / binWidth), 1, kHistorySize / 2 - 1);
+        const int last = std::clamp(static_cast<int>(high / binWidth), first, kHistorySize / 2 - 1);
+
+        double peak = 0.0;
+        for (int bin = first; bin <= last; ++bin)
+            peak = std::max(peak, std::abs(m_bins[bin]));
+
+        const double db = std::max(kFloorDb, 20.0 * std::log10(peak * normalize + 1e-12));
+        const qreal y = height() * (db / kFloorDb);
+
+        if (x == 0)
+            curve.moveTo(x, y);
+        else
+            curve.lineTo(x, y);
+    }
+
+    painter.setPen(QPen(QColor(0x00, 0x88, 0xcc), 1.5));
+    painter.setBrush(Qt::NoBrush);
+    painter.drawPath(curve);
+}
+
+void ScopeView::mousePressEvent(QMouseEvent* event)
+{
+    if (event->button() != Qt::LeftButton)
+    {
+        QWidget::mousePressEvent(event);
+        return;
+    }
+
+    setMode(m_mode == Mode::Scope ? Mode::Spectrum : Mode::Scope);
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <QTimer>
+#include <QWidget>
+
+#include <complex>
+#include <vector>
+
+class SignalTap;
+
+// Shows what a SignalTap carries, as an oscilloscope trace or as a spectrum; a click
+// switches between the two.
+//
+// Once per display frame the view drains the tap into a history of the newest samples
+// and repaints if anything arrived. The scope draws the newest stretch, starting at a
+// rising zero crossing so a steady wave stands still. The spectrum is an FFT of the
+// whole history under a Hann window, in dB against a log frequency axis. All the work
+// happens on the GUI thread; the audio thread only writes to the tap.
+class ScopeView : public QWidget
+{
+    Q_OBJECT
+
+public:
+    enum class Mode
+    {
+        Scope,
+        Spectrum
+    };
+
+    explicit ScopeView(QWidget* parent = nullptr);
+
+    // Reads from tap from now on, or from nothing with nullptr. sampleRate is the rate
+    // the tap's samples come out at, i.e. after its decimation. The view doesn't own
+    // the tap, which must outlive it or be replaced first.
+    void setTap(SignalTap* tap, double sampleRate);
+
+    void setMode(Mode mode);
+    Mode mode() const noexcept;
+
+protected:
+    void paintEvent(QPaintEvent* event) override;
+    void mousePressEvent(QMouseEvent* event) override;
+
+private:
+    // samples kept, and the FFT size; a power of two
+    static constexpr int kHistorySize = 2048;
+    // samples across the scope, the rest is room to find a trigger in
+    static constexpr int kScopeSpan = 1024;
+
+    void drain();
+    void drawScope(QPainter& painter) const;
+    void drawSpectrum(QPainter& painter);
+
+private:
+    SignalTap* m_tap = nullptr;
+    double m_sampleRate = 48000.0;
+    Mode m_mode = Mode::Scope;
+
+    // oldest first; all allocated once, so a frame allocates nothing
+    std::vector<float> m_history;
+    std::vector<float> m_incoming;
+    std::vector<float> m_window;
+    std::vector<std::complex<double>> m_bins;
+
+    QTimer m_timer;
+};
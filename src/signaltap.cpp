@@ -0,0 +1,74 @@
+#include "signaltap.h"
+
+#include <algorithm>
+#include <cstring>
+
+SignalTap::SignalTap(const std::size_t capacity, const unsigned decimation)
+    : decimation_(std::max(decimation, 1u)) {
+    std::size_t size = 1;
+    while (size < capacity) {
+        size <<= 1;
+    }
+    samples_ = std::make_unique<float[]>(size);
+    mask_ = size - 1;
+}
+
+void SignalTap::write(const float* samples, const unsigned frames) {
+    if (samples == nullptr || frames == 0) {
+        return;
+    }
+
+    // the samples of this block to keep are first, first + decimation_, ...
+    const unsigned first = phase_;
+    const std::size_t count = first < frames ? (frames - first + decimation_ - 1) / decimation_ : 0;
+    phase_ = static_cast<unsigned>(first + count * decimation_ - frames);
+    if (count == 0) {
+        return;
+    }
+
+    const std::size_t tail = tail_.load(std::memory_order_relaxed);
+    const std::size_t free = capacity() - (tail - head_.load(std::memory_order_acquire));
+    const std::size_t kept = std::min(count, free);
+    if (kept < count) {
+        dropped_.fetch_add(count - kept, std::memory_order_relaxed);
+    }
+
+    if (decimation_ == 1) {
+        // at most two runs, split where the ring wraps
+        const std::size_t start = tail & mask_;
+        const std::size_t run = std::min(kept, capacity() - start);
+        std::memcpy(&samples_[start], samples, run * sizeof(float));
+        std::memcpy(&samples_[0], samples + run, (kept - run) * sizeof(float));
+    } else {
+        for (std::size_t i = 0; i < kept; ++i) {
+            samples_[(tail + i) & mask_] = samples[first + i * decimation_];
+        }
+    }
+
+    tail_.store(tail + kept, std::memory_order_release);
+}
+
+std::size_t SignalTap::read(float* out, const std::size_t count) {
+    const std::size_t head = head_.load(std::memory_order_relaxed);
+    const std::size_t taken = std::min(count, tail_.load(std::memory_order_acquire) - head);
+
+    const std::size_t start = head & mask_;
+    const std::size_t run = std::min(taken, capacity() - start);
+    std::memcpy(out, &samples_[start], run * sizeof(float));
+    std::memcpy(out + run, &samples_[0], (taken - run) * sizeof(float));
+
+    head_.store(head + taken, std::memory_order_release);
+    return taken;
+}
+
+void SignalTap::skipTo(const std::size_t count) {
+    const std::size_t head = head_.load(std::memory_order_relaxed);
+    const std::size_t tail = tail_.load(std::memory_order_acquire);
+    if (tail - head > count) {
+        head_.store(tail - count, std::memory_order_release);
+    }
+}
+
+std::size_t SignalTap::available() const {
+    return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+}
@@ -0,0 +1,61 @@
+#ifndef SIGNALTAP_H
+#define SIGNALTAP_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+// Copies a node's output from the audio thread to a display, e.g. an oscilloscope or a
+// spectrum view, through a lock-free single-producer, single-consumer ring of samples.
+//
+// AudioNode::process() calls write() after each block when a tap is attached with
+// AudioNode::setTap(). It keeps every decimation-th sample, counting across blocks, and
+// copies them into the ring with at most two memcpy calls when nothing is skipped.
+// Neither side blocks or allocates. When the reader falls behind, the samples that don't
+// fit are dropped and counted, rather than overwriting ones the reader hasn't taken, so
+// what it reads is always contiguous apart from those gaps.
+//
+// One thread writes and one reads. The reader should drain the tap at least once per
+// capacity / (sample rate / decimation) seconds; 8192 samples at 48 kHz is 170 ms.
+class SignalTap
+{
+public:
+    static constexpr std::size_t DEFAULT_CAPACITY = 8192;
+
+    // capacity is rounded up to a power of two; a decimation of 0 counts as 1
+    explicit SignalTap(std::size_t capacity = DEFAULT_CAPACITY, unsigned decimation = 1);
+
+    SignalTap(const SignalTap&) = delete;
+    SignalTap& operator=(const SignalTap&) = delete;
+
+    std::size_t capacity() const { return mask_ + 1; }
+    unsigned decimation() const { return decimation_; }
+
+    // Audio thread
+    void write(const float* samples, unsigned frames);
+
+    // Reader thread. Moves up to count of the oldest samples to out and returns how many.
+    std::size_t read(float* out, std::size_t count);
+    // Reader thread. Drops all but the newest count samples, so a display that was away
+    // doesn't replay them.
+    void skipTo(std::size_t count);
+    std::size_t available() const;
+
+    // Any thread. Samples dropped because the ring was full.
+    unsigned long long dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    std::unique_ptr<float[]> samples_;
+    std::size_t mask_ = 0;
+    unsigned decimation_ = 1;
+
+    // audio thread only: index in the next block of the next sample to keep
+    unsigned phase_ = 0;
+    std::atomic<unsigned long long> dropped_ { 0 };
+
+    // on separate cache lines, so the two threads don't contend for one
+    alignas(64) std::atomic<std::size_t> head_ { 0 };
+    alignas(64) std::atomic<std::size_t> tail_ { 0 };
+};
+
+#endif // SIGNALTAP_H
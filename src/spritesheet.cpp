@@ -1,41 +1,86 @@
 #include "spritesheet.h"
 
+#include <QPaintDevice>
+#include <QPainter>
+
+namespace {
+
+quint64 sizeKey(const QSize& size) {
+    return (static_cast<quint64>(static_cast<quint32>(size.width())) << 32) | static_cast<quint32>(size.height());
+}
+
+}
+
 SpriteSheet::SpriteSheet(QObject *parent)
     : QObject(parent), orientation_(Qt::Horizontal), cells_(1) {}
 
 
 void SpriteSheet::setSource(const QString &file_path) {
     source_ = QPixmap(file_path);
-    generateCroppedImages();
+    clearCache();
 }
 
 void SpriteSheet::setOrientation(Qt::Orientation orientation) {
     orientation_ = orientation;
-    generateCroppedImages();
+    clearCache();
 }
 
 void SpriteSheet::setCells(int cells) {
     cells_ = cells;
-    generateCroppedImages();
+    clearCache();
 }
 
-const QVector<QPixmap>& SpriteSheet::croppedImages() {
-    return cropped_images_;
+int SpriteSheet::frameCount() const {
+    return cells_ > 0 && !source_.isNull() ? cells_ : 0;
 }
 
-void SpriteSheet::generateCroppedImages() {
-    cropped_images_.clear();
-
-    if(cells_ <= 0 || source_.isNull()) return;
+QRect SpriteSheet::frameRect(int index) const {
+    if(index < 0 || index >= frameCount()) return QRect();
 
     int spriteWidth = source_.width() / (orientation_ == Qt::Horizontal ? cells_ : 1);
-    int spriteHeight = source_.height() / (orientation_ == Qt::Vertical ? cells_ : 1);;
+    int spriteHeight = source_.height() / (orientation_ == Qt::Vertical ? cells_ : 1);
+
+    int x = (orientation_ == Qt::Horizontal) ? index * spriteWidth : 0;
+    int y = (orientation_ == Qt::Vertical) ? index * spriteHeight : 0;
+
+    return QRect(x, y, spriteWidth, spriteHeight);
+}
 
-    for(int i = 0; i < cells_; ++i) {
-        int x = (orientation_ == Qt::Horizontal) ? i * spriteWidth : 0;
-        int y = (orientation_ == Qt::Vertical) ? i * spriteHeight : 0;
+const QPixmap& SpriteSheet::scaledFrame(int index, const QSize& size, qreal devicePixelRatio) const {
+    static const QPixmap empty;
+    if(index < 0 || index >= frameCount() || size.isEmpty()) return empty;
 
-        QPixmap croppedImage = source_.copy(x, y, spriteWidth, spriteHeight);
-        cropped_images_.append(croppedImage);
+    // the ratio is part of the key, as two screens can ask for the same device size
+    QVector<QPixmap>& frames = scaled_frames_[std::make_pair(sizeKey(size), devicePixelRatio)];
+    if(frames.size() != cells_) frames.resize(cells_);
+
+    QPixmap& frame = frames[index];
+    if(frame.isNull()) {
+        // painted straight from the source rect, without cutting the frame out first
+        frame = QPixmap(size);
+        frame.fill(Qt::transparent);
+
+        QPainter painter(&frame);
+        painter.setRenderHint(QPainter::SmoothPixmapTransform, true);
+        painter.drawPixmap(QRect(QPoint(0, 0), size), source_, frameRect(index));
+        painter.end();
+
+        frame.setDevicePixelRatio(devicePixelRatio);
     }
+
+    return frame;
+}
+
+void SpriteSheet::drawFrame(QPainter& painter, const QRect& target, int index) const {
+    const qreal ratio = painter.device() != nullptr ? painter.device()->devicePixelRatioF() : 1.0;
+    const QPixmap& frame = scaledFrame(index, target.size() * ratio, ratio);
+    if(frame.isNull()) return;
+
+    // same size as the target in device pixels, so this is a plain copy
+    painter.drawPixmap(target.topLeft(), frame);
+}
+
+void SpriteSheet::clearCache() {
+    scaled_frames_.clear();
+    emit changed();
 }
@@ -1,10 +1,23 @@
 #ifndef SPRITESHEET_H
 #define SPRITESHEET_H
 
+#include <QHash>
 #include <QObject>
 #include <QPixmap>
+#include <QRect>
 #include <QVector>
 
+#include <utility>
+
+class QPainter;
+
+// A strip of equally sized frames in one image, such as a knob's positions, shared by
+// every control that draws from it.
+//
+// Frames stay sub-rects of the source; nothing is cut out when the sheet is set up.
+// A frame is scaled the first time it is drawn at a given size and kept, so a repaint
+// is a blit of an already scaled pixmap. Changing the source, orientation or cell
+// count drops the cache and emits changed().
 class SpriteSheet : public QObject {
     Q_OBJECT
 
@@ -22,17 +35,29 @@ public:
     void setCells(int cells);
     int cells() const { return cells_; }
 
-    // Get the list of cropped images
-    const QVector<QPixmap>& croppedImages();
+    // 0 until a source is loaded
+    int frameCount() const;
+    QRect frameRect(int index) const;
+
+    // the frame scaled to size in device pixels, built on first use
+    const QPixmap& scaledFrame(int index, const QSize& size, qreal devicePixelRatio = 1.0) const;
+
+    // draws the frame into target at the painter's pixel ratio
+    void drawFrame(QPainter& painter, const QRect& target, int index) const;
+
+signals:
+    // the frames look different or there is a different number of them
+    void changed();
 
 private:
+    void clearCache();
+
     QPixmap source_;
     Qt::Orientation orientation_;
     int cells_;
-    QVector<QPixmap> cropped_images_;
 
-private:
-    void generateCroppedImages();    
+    // scaled frames by device size and pixel ratio, each filled in as frames are drawn
+    mutable QHash<std::pair<quint64, qreal>, QVector<QPixmap>> scaled_frames_;
 };
 
 #endif
@@ -0,0 +1,68 @@
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+// Bounded lock-free queue for one producer thread and one consumer thread, e.g. a control
+// thread handing commands to the audio thread. Neither side ever blocks or allocates:
+// push() fails when the queue is full and pop() when it is empty. T should be trivially
+// copyable; slots are copied in and out.
+template<typename T>
+class SpscQueue
+{
+public:
+    // capacity is rounded up to a power of two
+    explicit SpscQueue(std::size_t capacity) {
+        std::size_t size = 1;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        items_ = std::make_unique<T[]>(size);
+        mask_ = size - 1;
+    }
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    std::size_t capacity() const { return mask_ + 1; }
+
+    // producer only
+    bool push(const T& item) {
+        const std::size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_.load(std::memory_order_acquire) > mask_) {
+            return false;
+        }
+        items_[tail & mask_] = item;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // consumer only
+    bool pop(T& item) {
+        const std::size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = items_[head & mask_];
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // exact on the producer side: if false, the next push() succeeds
+    bool full() const { return tail_.load(std::memory_order_relaxed) - head_.load(std::memory_order_acquire) > mask_; }
+
+    // approximate unless called from one of the two threads with the other idle
+    bool empty() const { return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire); }
+
+private:
+    std::unique_ptr<T[]> items_;
+    std::size_t mask_ = 0;
+
+    // on separate cache lines, so the two threads don't contend for one
+    alignas(64) std::atomic<std::size_t> head_ { 0 };
+    alignas(64) std::atomic<std::size_t> tail_ { 0 };
+};
+
+#endif // SPSCQUEUE_H
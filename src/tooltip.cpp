@@ -38,6 +38,8 @@ ToolTip::ToolTip(QWidget *parent)
         }
     });
 
+    hide_timer_.setSingleShot(true);
+    connect(&hide_timer_, &QTimer::timeout, this, [=]() { fadeOut(); });
 }
 
 void ToolTip::showTooltip(const QString& text, const QPoint& position, const double duration) {
@@ -45,21 +47,27 @@ void ToolTip::showTooltip(const QString& text, const QPoint& position, const dou
 
     adjustSize();
     move(position);
-    setWindowOpacity(0);
-    show();
 
-    if(animation_->state() == QAbstractAnimation::Running)
+    // Already up, e.g. while a knob is dragged: only the text and the time left change
+    const bool fadingOut = animation_->state() == QAbstractAnimation::Running && animation_->endValue().toDouble() == 0.0;
+    if(!isVisible() || fadingOut)
     {
-        animation_->stop();
-    }
+        setWindowOpacity(0);
+        show();
 
-    // Fade in quickly
-    animation_->setDuration(100);
-    animation_->setStartValue(0.0);
-    animation_->setEndValue(1.0);
-    animation_->start();
+        if(animation_->state() == QAbstractAnimation::Running)
+        {
+            animation_->stop();
+        }
+
+        // Fade in quickly
+        animation_->setDuration(100);
+        animation_->setStartValue(0.0);
+        animation_->setEndValue(1.0);
+        animation_->start();
+    }
 
-    QTimer::singleShot(duration, this, [=]() { fadeOut(); });
+    hide_timer_.start(static_cast<int>(duration));
 }
 
 void ToolTip::fadeOut() {
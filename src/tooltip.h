@@ -4,6 +4,7 @@
 #include <QWidget>
 #include <QLabel.h>
 #include <QPropertyAnimation>
+#include <QTimer>
 
 class ToolTip : public QWidget
 {
@@ -19,6 +20,8 @@ signals:
 private:
     QLabel *label_;
     QPropertyAnimation *animation_;
+    // one timer for the fade out, restarted by every show
+    QTimer hide_timer_;
 
     void fadeOut();
 };
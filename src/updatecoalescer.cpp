@@ -0,0 +1,60 @@
+#include "updatecoalescer.h"
+
+#include <QGuiApplication>
+#include <QScreen>
+
+#include <cmath>
+
+UpdateCoalescer::UpdateCoalescer(int intervalMs, QObject* parent)
+    : QObject{parent}
+{
+    if (intervalMs <= 0) {
+        const QScreen* screen = QGuiApplication::primaryScreen();
+        const double refreshRate = screen != nullptr && screen->refreshRate() > 0 ? screen->refreshRate() : 60.0;
+        intervalMs = static_cast<int>(std::floor(1000.0 / refreshRate));
+    }
+
+    timer_.setSingleShot(true);
+    timer_.setTimerType(Qt::PreciseTimer);
+    timer_.setInterval(qMax(1, intervalMs));
+    connect(&timer_, &QTimer::timeout, this, &UpdateCoalescer::flush);
+}
+
+int UpdateCoalescer::addSlot(std::function<void(double)> apply) {
+    slots_.push_back({ std::move(apply) });
+    pending_.reserve(slots_.size());
+    due_.reserve(slots_.size());
+    return static_cast<int>(slots_.size()) - 1;
+}
+
+void UpdateCoalescer::post(int slot, double value) {
+    if (slot < 0 || slot >= static_cast<int>(slots_.size())) {
+        return;
+    }
+
+    Slot& target = slots_[slot];
+    target.value = value;
+    if (!target.pending) {
+        target.pending = true;
+        pending_.push_back(slot);
+    }
+
+    if (!timer_.isActive()) {
+        timer_.start();
+    }
+}
+
+void UpdateCoalescer::flush() {
+    timer_.stop();
+
+    // an update may post again; that lands in the next round
+    due_.swap(pending_);
+    pending_.clear();
+
+    for (const int slot : due_) {
+        Slot& target = slots_[slot];
+        target.pending = false;
+        target.apply(target.value);
+    }
+    due_.clear();
+}
@@ -0,0 +1,52 @@
+#ifndef UPDATECOALESCER_H
+#define UPDATECOALESCER_H
+
+#include <QObject>
+#include <QTimer>
+
+#include <functional>
+#include <vector>
+
+// Merges bursts of value changes, such as a knob being dragged, into at most one update
+// per display frame.
+//
+// Each receiver registers a slot once with the function that applies its value. post()
+// only records the latest value and marks the slot pending, so a drag that moves a knob
+// a thousand times a second costs a store per event. The first post() after a flush
+// starts a single-shot timer. When it fires, every pending slot's function runs once with
+// its last posted value, so the final value of a gesture is always delivered, at most
+// one interval late.
+class UpdateCoalescer : public QObject
+{
+    Q_OBJECT
+
+public:
+    // interval 0 means one frame of the primary screen
+    explicit UpdateCoalescer(int intervalMs = 0, QObject* parent = nullptr);
+
+    int addSlot(std::function<void(double)> apply);
+
+    void post(int slot, double value);
+
+    // applies everything pending now, e.g. before reading the values back
+    void flush();
+
+    int interval() const { return timer_.interval(); }
+
+private:
+    struct Slot
+    {
+        std::function<void(double)> apply;
+        double value = 0.0;
+        bool pending = false;
+    };
+
+    QTimer timer_;
+    std::vector<Slot> slots_;
+    // indices into slots_, in the order they were first posted since the last flush
+    std::vector<int> pending_;
+    // the round being applied; kept so flushing doesn't allocate
+    std::vector<int> due_;
+};
+
+#endif // UPDATECOALESCER_H
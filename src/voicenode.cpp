@@ -49,6 +49,29 @@ void VoiceNode::setParameters(const VoiceParameters& parameters) {
 
 }
 
+void VoiceNode::setParameter(const ParameterId id, const float value) {
+    const auto shape = static_cast<wave_shape>(static_cast<int>(value));
+    switch (id) {
+    case ParameterId::ModWaveform: setModWaveform(shape); break;
+    case ParameterId::Oscillator1Waveform: setOscillator1Waveform(shape); break;
+    case ParameterId::Oscillator2Waveform: setOscillator2Waveform(shape); break;
+    case ParameterId::ModFrequency: updateModFrequency(value); break;
+    case ParameterId::Oscillator1ModGain: updateModOscillator1Gain(value); break;
+    case ParameterId::Oscillator2ModGain: updateModOscillator2Gain(value); break;
+    case ParameterId::Oscillator1Frequency: updateOscillator1Frequency(value); break;
+    case ParameterId::Oscillator2Frequency: updateOscillator2Frequency(value); break;
+    case ParameterId::Oscillator1Gain: updateOscillator1Gain(value); break;
+    case ParameterId::Oscillator2Gain: updateOscillator2Gain(value); break;
+    case ParameterId::Oscillator1Detune: updateOscillator1Detune(value); break;
+    case ParameterId::Oscillator2Detune: updateOscillator2Detune(value); break;
+    case ParameterId::VolumeEnvelopeA: updateVolumeEnvelopeA(value); break;
+    case ParameterId::VolumeEnvelopeD: updateVolumeEnvelopeD(value); break;
+    case ParameterId::VolumeEnvelopeS: updateVolumeEnvelopeS(value); break;
+    case ParameterId::VolumeEnvelopeR: updateVolumeEnvelopeR(value); break;
+    case ParameterId::Gate: value >= 0.5f ? noteOn() : noteOff(); break;
+    }
+}
+
 void VoiceNode::buildDeviceChain() {
 
     mod_oscillator_.connect(&mod_oscillator_gain_1_);
@@ -141,6 +164,15 @@ void VoiceNode::updateOscillator2Gain(float gain) {
 }
 
 
+void VoiceNode::transferState(const AudioNode& other) {
+    const auto& voice = static_cast<const VoiceNode&>(other);
+    oscillator_1_.transferState(voice.oscillator_1_);
+    oscillator_2_.transferState(voice.oscillator_2_);
+    mod_oscillator_.transferState(voice.mod_oscillator_);
+    filter_envelope_.transferState(voice.filter_envelope_);
+    volume_envelope_.transferState(voice.volume_envelope_);
+}
+
 void VoiceNode::processInternal(const unsigned frames) {
 
     output_.process(frames, last_processing_id_);
@@ -20,6 +20,29 @@ typedef struct _adsr {
 class VoiceNode : public AudioNode
 {
 public:
+    // Stable ids for setParameter(), in the order of the "voice" node type's parameters,
+    // so patch files and a ParameterStore can refer to them by number. Only append.
+    enum class ParameterId : unsigned {
+        ModWaveform = 0,
+        Oscillator1Waveform,
+        Oscillator2Waveform,
+        ModFrequency,
+        Oscillator1ModGain,
+        Oscillator2ModGain,
+        Oscillator1Frequency,
+        Oscillator2Frequency,
+        Oscillator1Gain,
+        Oscillator2Gain,
+        Oscillator1Detune,
+        Oscillator2Detune,
+        VolumeEnvelopeA,
+        VolumeEnvelopeD,
+        VolumeEnvelopeS,
+        VolumeEnvelopeR,
+        Gate
+    };
+    static constexpr unsigned PARAMETER_COUNT = static_cast<unsigned>(ParameterId::Gate) + 1;
+
     struct VoiceParameters {
         // Oscillator and Modulator Parameters
         wave_shape mod_waveform = wave_shape::sine;
@@ -151,6 +174,8 @@ private:
 
 public:
     void setParameters(const VoiceParameters& parameters);
+    // one parameter by id; waveforms are wave_shape values and the gate opens at 0.5
+    void setParameter(ParameterId id, float value);
 
     void setModWaveform(wave_shape waveform);
     void setOscillator1Waveform(wave_shape waveform);
@@ -178,6 +203,11 @@ public:
     //bool note_on() const { return note_on_; }
     void noteOn() { volume_envelope_.setGate(1.0); }
     void noteOff() { volume_envelope_.setGate(0.0); }
+    // sample-accurate versions, in seconds on the context's sample clock
+    void noteOnAt(double time) { volume_envelope_.setGateAtTime(true, time); }
+    void noteOffAt(double time) { volume_envelope_.setGateAtTime(false, time); }
+
+    void transferState(const AudioNode& other) override;
 
 protected:
     void addAutomation(AudioNode* node, unsigned port) override {}
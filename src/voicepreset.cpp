@@ -0,0 +1,127 @@
+#include "voicepreset.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+
+namespace {
+
+const std::map<std::string, wave_shape> WAVEFORMS = {
+    { "sine", wave_shape::sine },
+    { "triangle", wave_shape::triangle },
+    { "square", wave_shape::square },
+    { "sawtooth", wave_shape::sawtooth },
+    { "inv_sawtooth", wave_shape::inv_sawtooth },
+    { "pulse", wave_shape::pulse },
+};
+
+std::string trim(const std::string& text) {
+    const auto first = text.find_first_not_of(" \t\r");
+    if (first == std::string::npos) {
+        return std::string();
+    }
+    const auto last = text.find_last_not_of(" \t\r");
+    return text.substr(first, last - first + 1);
+}
+
+bool parseNumber(const std::string& text, float& value) {
+    char* end = nullptr;
+    const float parsed = std::strtof(text.c_str(), &end);
+    if (end == text.c_str() || *end != '\0' || !std::isfinite(parsed)) {
+        return false;
+    }
+    value = parsed;
+    return true;
+}
+
+}
+
+VoicePreset::VoicePreset() {
+    // a single oscillator at the note's pitch, which is what a file with no keys gets
+    parameters_.oscillator_1_frequency = 1.0f;
+    parameters_.oscillator_2_frequency = 1.0f;
+    parameters_.oscillator_1_gain = 1.0f;
+}
+
+bool VoicePreset::load(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "Failed to open preset " << path << "\n";
+        return false;
+    }
+
+    VoiceNode::VoiceParameters parameters = VoicePreset().parameters_;
+    std::string name;
+
+    const std::map<std::string, float*> numbers = {
+        { "mod_frequency", &parameters.mod_frequency },
+        { "oscillator_1_mod_gain", &parameters.oscillator_1_mod_gain },
+        { "oscillator_2_mod_gain", &parameters.oscillator_2_mod_gain },
+        { "oscillator_1_frequency", &parameters.oscillator_1_frequency },
+        { "oscillator_2_frequency", &parameters.oscillator_2_frequency },
+        { "oscillator_1_gain", &parameters.oscillator_1_gain },
+        { "oscillator_2_gain", &parameters.oscillator_2_gain },
+        { "oscillator_1_detune", &parameters.oscillator_1_detune },
+        { "oscillator_2_detune", &parameters.oscillator_2_detune },
+        { "attack", &parameters.volume_envelope_a_ },
+        { "decay", &parameters.volume_envelope_d_ },
+        { "sustain", &parameters.volume_envelope_s_ },
+        { "release", &parameters.volume_envelope_r_ },
+    };
+    const std::map<std::string, wave_shape*> waveforms = {
+        { "mod_waveform", &parameters.mod_waveform },
+        { "oscillator_1_waveform", &parameters.oscillator_1_waveform },
+        { "oscillator_2_waveform", &parameters.oscillator_2_waveform },
+    };
+
+    std::string line;
+    for (unsigned line_number = 1; std::getline(file, line); ++line_number) {
+        line = trim(line.substr(0, line.find('#')));
+        if (line.empty()) {
+            continue;
+        }
+
+        const auto equals = line.find('=');
+        const std::string key = equals == std::string::npos ? line : trim(line.substr(0, equals));
+        const std::string value = equals == std::string::npos ? std::string() : trim(line.substr(equals + 1));
+
+        bool ok = !value.empty();
+        if (ok && key == "name") {
+            name = value;
+        } else if (ok && numbers.count(key)) {
+            ok = parseNumber(value, *numbers.at(key));
+        } else if (ok && waveforms.count(key)) {
+            const auto waveform = WAVEFORMS.find(value);
+            ok = waveform != WAVEFORMS.end();
+            if (ok) {
+                *waveforms.at(key) = waveform->second;
+            }
+        } else {
+            ok = false;
+        }
+
+        if (!ok) {
+            std::cerr << path << ":" << line_number << ": bad preset line '" << line << "'\n";
+            return false;
+        }
+    }
+
+    name_ = name;
+    parameters_ = parameters;
+    return true;
+}
+
+VoiceNode::VoiceParameters VoicePreset::parametersForNote(const int note) const {
+    const float frequency = noteFrequency(note);
+
+    VoiceNode::VoiceParameters parameters = parameters_;
+    parameters.oscillator_1_frequency *= frequency;
+    parameters.oscillator_2_frequency *= frequency;
+    return parameters;
+}
+
+float VoicePreset::noteFrequency(const int note) {
+    return 440.0f * std::pow(2.0f, (note - 69) / 12.0f);
+}
@@ -0,0 +1,39 @@
+#ifndef VOICEPRESET_H
+#define VOICEPRESET_H
+
+#include "voicenode.h"
+
+#include <string>
+
+// A VoiceNode sound stored as a text file of "key = value" lines, with '#' starting a
+// comment. Keys are the VoiceParameters field names, except that the volume envelope is
+// attack, decay, sustain and release, plus an optional name. Waveforms are given by name
+// (sine, triangle, square, sawtooth, inv_sawtooth, pulse).
+//
+// oscillator_1_frequency and oscillator_2_frequency are multiples of the played note's
+// frequency, so one preset covers the whole keyboard; everything else is absolute.
+class VoicePreset
+{
+public:
+    VoicePreset();
+
+    // Reports the offending line on std::cerr and leaves the preset untouched on failure
+    bool load(const std::string& path);
+
+    const std::string& name() const { return name_; }
+    const VoiceNode::VoiceParameters& parameters() const { return parameters_; }
+
+    // parameters with the oscillators tuned to the given MIDI note
+    VoiceNode::VoiceParameters parametersForNote(int note) const;
+
+    // how long a note keeps sounding after its note off
+    float releaseSeconds() const { return parameters_.volume_envelope_r_; }
+
+    static float noteFrequency(int note);
+
+private:
+    std::string name_;
+    VoiceNode::VoiceParameters parameters_;
+};
+
+#endif // VOICEPRESET_H
@@ -0,0 +1,83 @@
+#include "wavetable.h"
+#include "definitions.h"
+#include "fft.h"
+
+#include <cmath>
+#include <algorithm>
+#include <complex>
+#include <mutex>
+
+std::unique_ptr<const Wavetable> Wavetable::tables_[4];
+
+void Wavetable::prepare() {
+    static std::once_flag built;
+    std::call_once(built, []() {
+        for (const Shape shape : { Shape::Sine, Shape::Ramp, Shape::Square, Shape::Triangle }) {
+            tables_[static_cast<unsigned>(shape)].reset(new Wavetable(shape));
+        }
+    });
+}
+
+Wavetable::Wavetable(const Shape shape) {
+    std::vector<std::complex<double>> spectrum(SIZE);
+
+    for (unsigned level = 0; level < LEVELS; ++level) {
+        const unsigned harmonics = (SIZE / 4) >> level;
+        std::fill(spectrum.begin(), spectrum.end(), std::complex<double>(0.0, 0.0));
+
+        // Fourier series of each shape, written as bins of an inverse FFT.
+        // sin(2 pi n x) lands in bin n as -i/2 and its mirror as +i/2; cos as 1/2 in both.
+        for (unsigned n = 1; n <= harmonics; ++n) {
+            double sine_amplitude = 0.0;
+            double cosine_amplitude = 0.0;
+
+            switch (shape) {
+            case Shape::Sine:
+                sine_amplitude = n == 1 ? 1.0 : 0.0;
+                break;
+            case Shape::Ramp:
+                sine_amplitude = -2.0 / (M_PI * n);
+                break;
+            case Shape::Square:
+                sine_amplitude = n % 2 == 1 ? 4.0 / (M_PI * n) : 0.0;
+                break;
+            case Shape::Triangle:
+                cosine_amplitude = n % 2 == 1 ? -8.0 / (M_PI * M_PI * n * n) : 0.0;
+                break;
+            }
+
+            const std::complex<double> bin(cosine_amplitude / 2.0, -sine_amplitude / 2.0);
+            spectrum[n] = bin * static_cast<double>(SIZE);
+            spectrum[SIZE - n] = std::conj(bin) * static_cast<double>(SIZE);
+        }
+
+        fft(spectrum, true);
+
+        // one guard sample so interpolation never has to wrap
+        levels_[level].resize(SIZE + 1);
+        for (unsigned i = 0; i < SIZE; ++i) {
+            levels_[level][i] = static_cast<float>(spectrum[i].real());
+        }
+        levels_[level][SIZE] = levels_[level][0];
+    }
+}
+
+float Wavetable::lookup(const float phase, const float increment) const {
+    // the level whose harmonic count still fits below Nyquist: 1024 >> level <= 0.5 / increment
+    const float limit = 0.5f / std::fabs(increment);
+    int level = 0;
+    if (limit < static_cast<float>(SIZE / 4)) {
+        level = limit >= 1.0f ? 10 - std::ilogb(limit) : LEVELS - 1;
+        if (level > static_cast<int>(LEVELS) - 1) {
+            level = LEVELS - 1;
+        }
+    }
+
+    const float position = (phase - std::floor(phase)) * SIZE;
+    const unsigned index = static_cast<unsigned>(position);
+    const float fraction = position - static_cast<float>(index);
+
+    const float* table = levels_[level].data();
+    const unsigned i = index < SIZE ? index : SIZE - 1;
+    return table[i] + (table[i + 1] - table[i]) * fraction;
+}
@@ -0,0 +1,41 @@
+#ifndef WAVETABLE_H
+#define WAVETABLE_H
+
+#include <memory>
+#include <vector>
+
+// Band-limited single-cycle tables with one mip level per octave. Each level only holds
+// the harmonics that stay below Nyquist for the fundamentals it is used for, so lookups
+// don't alias apart from linear interpolation error. prepare() builds every table once,
+// off the audio thread (OscillatorNode's constructor calls it), and they are shared by
+// every oscillator.
+class Wavetable
+{
+public:
+    enum class Shape {
+        Sine,
+        Ramp,       // rises from -1 to 1 over the cycle, drops back at phase 0
+        Square,     // +1 for the first half of the cycle
+        Triangle    // -1 at phase 0, +1 at half a cycle
+    };
+
+    static constexpr unsigned SIZE = 4096;
+    static constexpr unsigned LEVELS = 11; // 1024 harmonics at level 0, halving per level
+
+    // Builds all the tables the first time; cheap after that. Any thread but the audio one.
+    static void prepare();
+    // only after prepare()
+    static const Wavetable& get(Shape shape) { return *tables_[static_cast<unsigned>(shape)]; }
+
+    // phase and increment in cycles; phase may be any value, the fractional part is used
+    float lookup(float phase, float increment) const;
+
+private:
+    explicit Wavetable(Shape shape);
+
+    static std::unique_ptr<const Wavetable> tables_[4];
+
+    std::vector<float> levels_[LEVELS];
+};
+
+#endif // WAVETABLE_H
@@ -0,0 +1,113 @@
+#include "wavwriter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace {
+
+constexpr std::uint16_t WAVE_FORMAT_PCM = 1;
+constexpr std::uint16_t WAVE_FORMAT_IEEE_FLOAT = 3;
+
+void putU16(unsigned char* out, std::uint16_t value) {
+    out[0] = static_cast<unsigned char>(value & 0xff);
+    out[1] = static_cast<unsigned char>((value >> 8) & 0xff);
+}
+
+void putU32(unsigned char* out, std::uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out[i] = static_cast<unsigned char>((value >> (8 * i)) & 0xff);
+    }
+}
+
+}
+
+WavWriter::~WavWriter() {
+    close();
+}
+
+bool WavWriter::open(const std::string& path, const unsigned sample_rate, const unsigned channels, const Format format) {
+    close();
+
+    file_ = std::fopen(path.c_str(), "wb");
+    if (file_ == nullptr) {
+        std::cerr << "Failed to open " << path << " for writing\n";
+        return false;
+    }
+
+    sample_rate_ = sample_rate;
+    channels_ = channels;
+    format_ = format;
+    frames_written_ = 0;
+
+    // placeholder sizes, rewritten by close()
+    return writeHeader();
+}
+
+bool WavWriter::write(const float* interleaved, const unsigned long frames) {
+    if (file_ == nullptr) {
+        return false;
+    }
+
+    const size_t samples = static_cast<size_t>(frames) * channels_;
+    size_t written = 0;
+
+    if (format_ == Format::Float32) {
+        written = std::fwrite(interleaved, sizeof(float), samples, file_);
+    } else {
+        // convert in fixed-size chunks so arbitrarily long writes don't allocate
+        constexpr size_t CHUNK = 4096;
+        unsigned char pcm[CHUNK * 2];
+        for (size_t offset = 0; offset < samples; offset += CHUNK) {
+            const size_t count = std::min(CHUNK, samples - offset);
+            for (size_t i = 0; i < count; ++i) {
+                const float clamped = std::clamp(interleaved[offset + i], -1.0f, 1.0f);
+                const auto value = static_cast<std::int16_t>(std::lrint(clamped * 32767.0f));
+                putU16(pcm + i * 2, static_cast<std::uint16_t>(value));
+            }
+            written += std::fwrite(pcm, 2, count, file_);
+        }
+    }
+
+    frames_written_ += written / std::max(1u, channels_);
+    return written == samples;
+}
+
+bool WavWriter::close() {
+    if (file_ == nullptr) {
+        return true;
+    }
+
+    bool ok = std::fseek(file_, 0, SEEK_SET) == 0 && writeHeader();
+    ok = std::fclose(file_) == 0 && ok;
+    file_ = nullptr;
+
+    if (!ok) {
+        std::cerr << "Failed to finalize WAV file\n";
+    }
+    return ok;
+}
+
+bool WavWriter::writeHeader() {
+    const std::uint16_t bytes_per_sample = format_ == Format::Float32 ? 4 : 2;
+    const std::uint32_t block_align = channels_ * bytes_per_sample;
+    const std::uint64_t data_bytes = frames_written_ * block_align;
+    const std::uint32_t data_size = static_cast<std::uint32_t>(std::min<std::uint64_t>(data_bytes, 0xffffffffu - 36));
+
+    unsigned char header[44];
+    std::copy_n("RIFF", 4, header);
+    putU32(header + 4, 36 + data_size);
+    std::copy_n("WAVE", 4, header + 8);
+    std::copy_n("fmt ", 4, header + 12);
+    putU32(header + 16, 16);
+    putU16(header + 20, format_ == Format::Float32 ? WAVE_FORMAT_IEEE_FLOAT : WAVE_FORMAT_PCM);
+    putU16(header + 22, static_cast<std::uint16_t>(channels_));
+    putU32(header + 24, sample_rate_);
+    putU32(header + 28, sample_rate_ * block_align);
+    putU16(header + 32, static_cast<std::uint16_t>(block_align));
+    putU16(header + 34, static_cast<std::uint16_t>(bytes_per_sample * 8));
+    std::copy_n("data", 4, header + 36);
+    putU32(header + 40, data_size);
+
+    return std::fwrite(header, 1, sizeof(header), file_) == sizeof(header);
+}
@@ -0,0 +1,41 @@
+#ifndef WAVWRITER_H
+#define WAVWRITER_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+// Streams interleaved float frames into a RIFF/WAVE file. Samples are stored either
+// as 32-bit IEEE float or as 16-bit PCM; the header sizes are patched on close().
+class WavWriter
+{
+public:
+    enum class Format {
+        Float32,
+        Pcm16
+    };
+
+    WavWriter() = default;
+    ~WavWriter();
+
+    WavWriter(const WavWriter&) = delete;
+    WavWriter& operator=(const WavWriter&) = delete;
+
+    bool open(const std::string& path, unsigned sample_rate, unsigned channels, Format format = Format::Float32);
+    bool write(const float* interleaved, unsigned long frames);
+    bool close();
+
+    bool isOpen() const { return file_ != nullptr; }
+    std::uint64_t framesWritten() const { return frames_written_; }
+
+private:
+    bool writeHeader();
+
+    std::FILE* file_ = nullptr;
+    unsigned sample_rate_ = 0;
+    unsigned channels_ = 0;
+    Format format_ = Format::Float32;
+    std::uint64_t frames_written_ = 0;
+};
+
+#endif // WAVWRITER_H
@@ -0,0 +1,102 @@
+#include "workerpool.h"
+#include "denormals.h"
+
+namespace {
+
+// How long an idle worker polls for the next block before sleeping on the condition variable
+constexpr unsigned SPIN_ITERATIONS = 2000;
+
+}
+
+WorkerPool::WorkerPool(const unsigned threads) {
+    for (unsigned i = 1; i < threads; ++i) {
+        workers_.emplace_back(&WorkerPool::workerLoop, this);
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+void WorkerPool::run(const unsigned tasks, const Task& task) {
+    if (tasks == 0) {
+        return;
+    }
+
+    if (workers_.empty()) {
+        for (unsigned i = 0; i < tasks; ++i) {
+            task(i);
+        }
+        return;
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        // a worker that woke late for the previous run may still be on its way out
+        done_.wait(lock, [this]() { return active_ == 0; });
+
+        task_ = &task;
+        task_count_ = tasks;
+        pending_.store(tasks);
+        next_task_.store(0);
+        generation_.fetch_add(1);
+    }
+    wake_.notify_all();
+
+    drainTasks();
+
+    for (unsigned spin = 0; spin < SPIN_ITERATIONS && pending_.load(std::memory_order_acquire) != 0; ++spin) {
+        std::this_thread::yield();
+    }
+
+    // task_ refers to the caller's function, so no worker may still be inside it on return
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [this]() { return pending_.load() == 0 && active_ == 0; });
+    task_ = nullptr;
+}
+
+void WorkerPool::drainTasks() {
+    for (unsigned index = next_task_.fetch_add(1); index < task_count_; index = next_task_.fetch_add(1)) {
+        (*task_)(index);
+        pending_.fetch_sub(1, std::memory_order_acq_rel);
+    }
+}
+
+void WorkerPool::workerLoop() {
+    ScopedDenormalDisable::disableForCurrentThread();
+
+    unsigned seen_generation = 0;
+
+    for (;;) {
+        for (unsigned spin = 0; spin < SPIN_ITERATIONS && generation_.load(std::memory_order_relaxed) == seen_generation; ++spin) {
+            std::this_thread::yield();
+        }
+
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(lock, [this, seen_generation]() { return stopping_ || generation_.load() != seen_generation; });
+            if (stopping_) {
+                return;
+            }
+
+            seen_generation = generation_.load();
+            ++active_;
+        }
+
+        drainTasks();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            --active_;
+        }
+        done_.notify_all();
+    }
+}
@@ -0,0 +1,53 @@
+#ifndef WORKERPOOL_H
+#define WORKERPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fork-join pool for splitting one audio block across cores. run() hands out task
+// indices to the workers and to the calling thread, and returns once every task has
+// finished. Workers spin briefly between blocks before going to sleep so back-to-back
+// blocks don't pay a wake-up each time. Worker threads run with denormals disabled.
+class WorkerPool
+{
+public:
+    using Task = std::function<void(unsigned index)>;
+
+    // threads counts the calling thread, so WorkerPool(1) spawns nothing
+    explicit WorkerPool(unsigned threads);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    unsigned threadCount() const { return static_cast<unsigned>(workers_.size()) + 1; }
+
+    // Runs task(0) .. task(tasks - 1) and blocks until all of them are done.
+    // Not reentrant; call from one thread at a time.
+    void run(unsigned tasks, const Task& task);
+
+private:
+    void workerLoop();
+    void drainTasks();
+
+    std::vector<std::thread> workers_;
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+
+    const Task* task_ = nullptr;
+    unsigned task_count_ = 0;
+    std::atomic<unsigned> generation_ { 0 };
+    std::atomic<unsigned> next_task_ { 0 };
+    std::atomic<unsigned> pending_ { 0 };
+    // workers currently inside drainTasks(), guarded by mutex_
+    unsigned active_ = 0;
+    bool stopping_ = false;
+};
+
+#endif // WORKERPOOL_H
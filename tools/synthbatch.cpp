@@ -0,0 +1,333 @@
+// Batch renderer for pre-rendering sample sets. Reads a job list, renders every job
+// concurrently on a worker pool and writes one WAV per job. Each worker thread keeps one
+// AudioContext, graph and sample buffer and resets them between jobs, so after its first
+// few jobs a worker renders without allocating.
+//
+// usage: synthbatch [options] <jobs.txt>
+//   --threads N   worker threads including the main one (default: hardware threads)
+//   --rate HZ     sample rate (default 44100)
+//   --frames N    block size (default 512)
+//   --gain X      master gain applied to every job (default 1)
+//   --pcm16       write 16-bit PCM instead of 32-bit float
+//   --scaling     render everything on one thread first and report scaling efficiency
+//   --deterministic  bit-identical output for any --frames (see AudioContext::setDeterministic)
+//
+// Each non-empty line of the job list is
+//   <preset> <output.wav> <note>@<start>+<length> [<note>@<start>+<length> ...]
+// with MIDI note numbers and times in seconds, e.g.
+//   presets/pluck.txt out/pluck-60.wav 60@0+0.5
+// '#' starts a comment, and relative paths are taken from the job list's directory.
+// Every job runs until its last note has finished its release.
+
+#include "audiocontext.h"
+#include "definitions.h"
+#include "denormals.h"
+#include "gainnode.h"
+#include "mixernode.h"
+#include "voicenode.h"
+#include "voicepreset.h"
+#include "wavwriter.h"
+#include "workerpool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// rendered past the end of the last release so the envelope reaches silence
+constexpr double TAIL_SECONDS = 0.05;
+
+struct Options {
+    std::string job_list;
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    unsigned sample_rate = SAMPLE_RATE;
+    unsigned frames = FRAMES;
+    float gain = 1.0f;
+    WavWriter::Format format = WavWriter::Format::Float32;
+    bool scaling = false;
+    bool deterministic = false;
+};
+
+struct Note {
+    int note;
+    double start;
+    double length;
+};
+
+struct Job {
+    std::string preset;
+    std::string output;
+    std::vector<Note> notes;
+};
+
+void printUsage() {
+    std::fprintf(stderr,
+                 "usage: synthbatch [options] <jobs.txt>\n"
+                 "  --threads N   worker threads including the main one (default %u)\n"
+                 "  --rate HZ     sample rate (default %d)\n"
+                 "  --frames N    block size (default %d)\n"
+                 "  --gain X      master gain applied to every job (default 1)\n"
+                 "  --pcm16       write 16-bit PCM instead of 32-bit float\n"
+                 "  --scaling     render everything on one thread first and report scaling efficiency\n"
+                 "  --deterministic  bit-identical output for any --frames (see AudioContext::setDeterministic)\n"
+                 "job lines: <preset> <output.wav> <note>@<start>+<length> ...\n",
+                 std::max(1u, std::thread::hardware_concurrency()), SAMPLE_RATE, FRAMES);
+}
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        const bool has_value = i + 1 < argc;
+
+        if (std::strcmp(arg, "--threads") == 0 && has_value) {
+            options.threads = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else if (std::strcmp(arg, "--rate") == 0 && has_value) {
+            options.sample_rate = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else if (std::strcmp(arg, "--frames") == 0 && has_value) {
+            options.frames = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else if (std::strcmp(arg, "--gain") == 0 && has_value) {
+            options.gain = static_cast<float>(std::atof(argv[++i]));
+        } else if (std::strcmp(arg, "--pcm16") == 0) {
+            options.format = WavWriter::Format::Pcm16;
+        } else if (std::strcmp(arg, "--scaling") == 0) {
+            options.scaling = true;
+        } else if (std::strcmp(arg, "--deterministic") == 0) {
+            options.deterministic = true;
+        } else if (arg[0] == '-') {
+            return false;
+        } else {
+            options.job_list = arg;
+        }
+    }
+
+    return !options.job_list.empty() && options.threads > 0 && options.sample_rate > 0 && options.frames > 0;
+}
+
+std::string resolve(const std::string& directory, const std::string& path) {
+    return path.empty() || path[0] == '/' || directory.empty() ? path : directory + "/" + path;
+}
+
+bool parseNote(const std::string& text, Note& note) {
+    char* end = nullptr;
+    const char* cursor = text.c_str();
+
+    note.note = static_cast<int>(std::strtol(cursor, &end, 10));
+    if (end == cursor || *end != '@') {
+        return false;
+    }
+    cursor = end + 1;
+    note.start = std::strtod(cursor, &end);
+    if (end == cursor || *end != '+') {
+        return false;
+    }
+    cursor = end + 1;
+    note.length = std::strtod(cursor, &end);
+    return end != cursor && *end == '\0' && note.start >= 0.0 && note.length >= 0.0 && note.note >= 0 && note.note <= 127;
+}
+
+bool loadJobs(const std::string& path, std::vector<Job>& jobs) {
+    std::ifstream file(path);
+    if (!file) {
+        std::fprintf(stderr, "failed to open %s\n", path.c_str());
+        return false;
+    }
+
+    const auto slash = path.find_last_of('/');
+    const std::string directory = slash == std::string::npos ? std::string() : path.substr(0, slash);
+
+    std::string line;
+    for (unsigned line_number = 1; std::getline(file, line); ++line_number) {
+        std::istringstream fields(line.substr(0, line.find('#')));
+        Job job;
+        if (!(fields >> job.preset)) {
+            continue;
+        }
+
+        bool ok = static_cast<bool>(fields >> job.output);
+        for (std::string field; ok && fields >> field;) {
+            Note note;
+            ok = parseNote(field, note);
+            job.notes.push_back(note);
+        }
+        if (!ok || job.notes.empty()) {
+            std::fprintf(stderr, "%s:%u: expected <preset> <output.wav> <note>@<start>+<length> ...\n", path.c_str(),
+                         line_number);
+            return false;
+        }
+
+        job.preset = resolve(directory, job.preset);
+        job.output = resolve(directory, job.output);
+        jobs.push_back(std::move(job));
+    }
+    return true;
+}
+
+// One worker's graph, kept from job to job. Voices are only ever added: a job plugs the
+// first ones it needs into the mixer, after putting them back to rest from a voice that
+// never renders.
+class Renderer {
+public:
+    explicit Renderer(const Options& options)
+        : context_(static_cast<float>(options.sample_rate), options.frames), mixer_(context_),
+          master_(context_, options.gain), rest_(context_) {
+        mixer_.connect(&master_);
+    }
+
+    // Renders one job and returns its length in seconds, or a negative value on failure
+    double render(const Job& job, const VoicePreset& preset, const Options& options);
+
+private:
+    AudioContext context_;
+    MixerNode mixer_;
+    GainNode master_;
+    const VoiceNode rest_;
+    std::vector<std::unique_ptr<VoiceNode>> voices_;
+    // plugged into the mixer by the last job
+    size_t plugged_ = 0;
+    // carries on across jobs, so no node mistakes a job's first block for one it has done
+    unsigned processing_id_ = 0;
+    // grows to the longest job the worker has seen, then stays put
+    std::vector<float> samples_;
+};
+
+double Renderer::render(const Job& job, const VoicePreset& preset, const Options& options) {
+    for (size_t i = 0; i < plugged_; ++i) {
+        mixer_.removeInput(voices_[i].get());
+    }
+    context_.resetClock();
+    context_.setDeterministic(options.deterministic);
+
+    // Every voice runs from the start with its gate scheduled on the sample clock, so notes
+    // land on their exact sample and the output doesn't depend on the block size. It also
+    // keeps the mixer's input count, and with it the level, constant for the whole job.
+    while (voices_.size() < job.notes.size()) {
+        voices_.push_back(std::make_unique<VoiceNode>(context_));
+    }
+    plugged_ = job.notes.size();
+
+    double end = 0.0;
+    for (size_t i = 0; i < job.notes.size(); ++i) {
+        const Note& note = job.notes[i];
+        VoiceNode& voice = *voices_[i];
+        voice.transferState(rest_);
+        voice.setParameters(preset.parametersForNote(note.note));
+        voice.noteOnAt(note.start);
+        voice.noteOffAt(note.start + note.length);
+        mixer_.addInput(&voice, 1.0f);
+        end = std::max(end, note.start + note.length + preset.releaseSeconds());
+    }
+    end += TAIL_SECONDS;
+
+    const unsigned long long total = static_cast<unsigned long long>(std::ceil(end * options.sample_rate));
+    samples_.clear();
+    samples_.reserve(total);
+
+    for (unsigned long long position = 0; position < total; position += options.frames) {
+        const auto frames = static_cast<unsigned>(std::min<unsigned long long>(options.frames, total - position));
+        master_.process(frames, processing_id_++);
+        context_.updateBatch(frames);
+        samples_.insert(samples_.end(), master_.buffer(), master_.buffer() + frames);
+    }
+
+    WavWriter writer;
+    if (!writer.open(job.output, options.sample_rate, 1, options.format) ||
+        !writer.write(samples_.data(), samples_.size()) || !writer.close()) {
+        return -1.0;
+    }
+    return static_cast<double>(total) / options.sample_rate;
+}
+
+struct Pass {
+    double wall_seconds = 0.0;
+    double rendered_seconds = 0.0;
+    unsigned failed = 0;
+};
+
+Pass renderAll(const std::vector<Job>& jobs, const std::map<std::string, VoicePreset>& presets,
+               const Options& options, unsigned threads) {
+    WorkerPool pool(threads);
+    std::vector<double> lengths(jobs.size(), 0.0);
+
+    const auto start = std::chrono::steady_clock::now();
+    pool.run(static_cast<unsigned>(jobs.size()), [&](unsigned index) {
+        thread_local Renderer renderer(options);
+        lengths[index] = renderer.render(jobs[index], presets.at(jobs[index].preset), options);
+    });
+
+    Pass pass;
+    pass.wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        if (lengths[i] < 0.0) {
+            std::fprintf(stderr, "job %zu (%s) failed\n", i + 1, jobs[i].output.c_str());
+            ++pass.failed;
+        } else {
+            pass.rendered_seconds += lengths[i];
+        }
+    }
+    return pass;
+}
+
+void printPass(const char* label, unsigned threads, const Pass& pass) {
+    std::printf("%-8s %3u thread%s  %10.1f s rendered in %8.2f s  %8.1f x realtime\n", label, threads,
+                threads == 1 ? " " : "s", pass.rendered_seconds, pass.wall_seconds,
+                pass.rendered_seconds / pass.wall_seconds);
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage();
+        return 1;
+    }
+
+    ScopedDenormalDisable denormal_guard;
+
+    std::vector<Job> jobs;
+    if (!loadJobs(options.job_list, jobs)) {
+        return 1;
+    }
+    if (jobs.empty()) {
+        std::fprintf(stderr, "%s has no jobs\n", options.job_list.c_str());
+        return 1;
+    }
+
+    // presets are shared read-only by every job that names them
+    std::map<std::string, VoicePreset> presets;
+    for (const Job& job : jobs) {
+        if (!presets.count(job.preset) && !presets[job.preset].load(job.preset)) {
+            return 1;
+        }
+    }
+
+    std::printf("%zu jobs, %zu presets, %u Hz, %u frames\n", jobs.size(), presets.size(), options.sample_rate,
+                options.frames);
+
+    Pass single;
+    if (options.scaling) {
+        single = renderAll(jobs, presets, options, 1);
+        printPass("single", 1, single);
+    }
+
+    const Pass parallel = renderAll(jobs, presets, options, options.threads);
+    printPass("parallel", options.threads, parallel);
+
+    if (options.scaling && single.failed == 0 && parallel.failed == 0) {
+        const double speedup = single.wall_seconds / parallel.wall_seconds;
+        std::printf("speedup %.2fx, scaling efficiency %.0f%%\n", speedup, 100.0 * speedup / options.threads);
+    }
+
+    return parallel.failed == 0 && single.failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,765 @@
+// Golden render and performance regression check. Renders a fixed set of patches and
+// compares them against the reference renders in golden/, then times a set of nodes and
+// patches against the ns/sample budgets in golden/budgets.txt. Exits non-zero on any
+// mismatch or overrun, so it can gate a DSP refactor or an optimization. It also renders
+// one patch in deterministic mode at several block sizes and thread counts and requires
+// bit-identical output from all of them, and checks that a parameter's automation holds
+// its effective value: the base value, plus the patched input when there is one.
+//
+// usage: synthcheck [options]
+//   --golden-dir DIR   where the reference renders and budgets live (default: source tree)
+//   --tolerance X      largest allowed absolute sample difference (default 1e-4)
+//   --exact            require bit-identical output
+//   --slack X          allowed slowdown over a budget, as a fraction (default 0.25)
+//   --slack-ns X       allowed slowdown in ns/sample on top of that, for the tiny nodes (default 0.5)
+//   --skip-golden      only check performance
+//   --skip-perf        only check output, for noisy or shared machines
+//   --skip-determinism skip the deterministic-mode check
+//   --update           rewrite the reference renders from the current tree
+//   --update-budgets   rewrite the budgets from this machine
+//   --filter TEXT      only run cases whose name contains TEXT
+//
+// Update the references only for changes that are meant to alter the sound, and the
+// budgets only on the machine the baseline was taken on.
+
+#include "adsrnode.h"
+#include "arithmeticnode.h"
+#include "audiocontext.h"
+#include "automationnode.h"
+#include "benchutil.h"
+#include "definitions.h"
+#include "demopatch.h"
+#include "denormals.h"
+#include "gainnode.h"
+#include "lp12filternode.h"
+#include "mixernode.h"
+#include "muladdnode.h"
+#include "noisenode.h"
+#include "oscillatornode.h"
+#include "voicenode.h"
+#include "wavwriter.h"
+#include "workerpool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifndef SYNTH_GOLDEN_DIR
+#define SYNTH_GOLDEN_DIR "golden"
+#endif
+
+namespace {
+
+constexpr unsigned PERF_RUNS = 5;
+constexpr double PERF_RUN_MS = 10.0;
+// a case over its limit is measured again this many times before it counts as a failure
+constexpr unsigned PERF_RETRIES = 2;
+constexpr const char* CALIBRATION = "calibration";
+
+const unsigned DETERMINISM_THREADS[] = { 1, 4, 16 };
+const unsigned DETERMINISM_FRAMES[] = { 64, 512, 4096 };
+constexpr double DETERMINISM_SECONDS = 2.0;
+constexpr std::uint64_t DETERMINISM_SEED = 1234;
+
+struct Options {
+    std::string golden_dir = SYNTH_GOLDEN_DIR;
+    double tolerance = 1e-4;
+    double slack = 0.25;
+    double slack_ns = 0.5;
+    bool exact = false;
+    bool golden = true;
+    bool perf = true;
+    bool determinism = true;
+    bool update = false;
+    bool update_budgets = false;
+    std::string filter;
+};
+
+// A graph plus whatever owns its nodes, and a hook run after every block
+struct Patch {
+    std::vector<std::shared_ptr<void>> owned;
+    AudioNode* output = nullptr;
+    std::function<void(double seconds)> update;
+
+    template<typename T, typename... Args>
+    T* add(Args&&... args) {
+        auto node = std::make_shared<T>(std::forward<Args>(args)...);
+        owned.push_back(node);
+        return node.get();
+    }
+};
+
+using PatchBuilder = std::function<void(AudioContext&, Patch&)>;
+
+struct Case {
+    std::string name;
+    double seconds;
+    PatchBuilder build;
+};
+
+void buildShowConsole(AudioContext& context, Patch& patch) {
+    auto* demo = patch.add<DemoPatch>(context);
+    patch.output = demo->output();
+    patch.update = [demo](double seconds) { demo->updateGate(seconds); };
+}
+
+void buildVoice(AudioContext& context, Patch& patch) {
+    auto* voice = patch.add<VoiceNode>(context);
+    voice->setParameters(VoiceNode::Builder(context)
+                             .setModFrequency(5)
+                             .setOscillator1Waveform(wave_shape::sawtooth)
+                             .setOscillator2Waveform(wave_shape::pulse)
+                             .setOscillator1Frequency(110)
+                             .setOscillator2Frequency(165)
+                             .setOscillator1Gain(1)
+                             .setOscillator2Gain(.3f)
+                             .setOscillator1ModGain(.2f)
+                             .setOscillator2ModGain(.3f)
+                             .setOscillator2Detune(7)
+                             .setVolumeEnvelopeA(.05f)
+                             .setVolumeEnvelopeD(.2f)
+                             .setVolumeEnvelopeS(.6f)
+                             .setVolumeEnvelopeR(.3f)
+                             .parameters());
+    voice->noteOn();
+    patch.output = voice;
+    patch.update = [voice](double seconds) {
+        if (seconds >= 1.0) {
+            voice->noteOff();
+        }
+    };
+}
+
+// sawtooth through an LP12 whose cutoff a 1 Hz triangle sweeps between 200 Hz and 6.2 kHz
+PatchBuilder filterSweep(float resonance) {
+    return [resonance](AudioContext& context, Patch& patch) {
+        auto* source = patch.add<OscillatorNode>(context, wave_shape::sawtooth, 110.0f);
+        auto* sweep = patch.add<OscillatorNode>(context, wave_shape::triangle, 1.0f);
+        auto* depth = patch.add<MulAddNode>(context, 3000.0f, 3000.0f);
+        auto* filter = patch.add<LP12FilterNode>(context, 200.0f, resonance);
+
+        sweep->connect(depth);
+        depth->automate(filter, LP12FilterNode::Parameters::Cutoff);
+        source->connect(filter);
+        patch.output = filter;
+    };
+}
+
+const std::vector<Case>& goldenCases() {
+    static const std::vector<Case> cases = {
+        { "showconsole", 2.0, buildShowConsole },
+        { "voicenode", 1.5, buildVoice },
+        { "filter-sweep", 1.0, filterSweep(1.0f) },
+        { "filter-sweep-resonant", 1.0, filterSweep(8.0f) },
+    };
+    return cases;
+}
+
+// Single nodes fed by an AutomationNode constant, plus the golden patches as a whole
+std::vector<Case> perfCases() {
+    std::vector<Case> cases;
+
+    const auto single = [&cases](const std::string& name, std::function<AudioNode*(AudioContext&, Patch&)> make) {
+        cases.push_back({ "node/" + name, 0.0, [make](AudioContext& context, Patch& patch) {
+                              patch.output = make(context, patch);
+                          } });
+    };
+
+    const auto withInput = [](AudioContext& context, Patch& patch, AudioNode* node) {
+        patch.add<AutomationNode>(context, 0.25f)->connect(node);
+        return node;
+    };
+
+    single("oscillator-sine", [](AudioContext& c, Patch& p) { return p.add<OscillatorNode>(c, wave_shape::sine, 220.0f); });
+    single("oscillator-sawtooth", [](AudioContext& c, Patch& p) { return p.add<OscillatorNode>(c, wave_shape::sawtooth, 220.0f); });
+    single("oscillator-pulse", [](AudioContext& c, Patch& p) { return p.add<OscillatorNode>(c, wave_shape::pulse, 220.0f); });
+    single("lp12", [withInput](AudioContext& c, Patch& p) { return withInput(c, p, p.add<LP12FilterNode>(c, 1200.0f, 4.0f)); });
+    single("adsr", [](AudioContext& c, Patch& p) {
+        auto* adsr = p.add<ADSRNode>(c, .01f, .1f, .7f, .1f);
+        adsr->setGate(true);
+        return adsr;
+    });
+    single("gain", [withInput](AudioContext& c, Patch& p) { return withInput(c, p, p.add<GainNode>(c, 0.5f)); });
+    single("muladd", [withInput](AudioContext& c, Patch& p) { return withInput(c, p, p.add<MulAddNode>(c, 2.0f, 1.0f)); });
+    single("arithmetic-multiply", [withInput](AudioContext& c, Patch& p) {
+        return withInput(c, p, p.add<ArithmeticNode>(c, ArithmeticNode::Operation::Multiply, 2.0f));
+    });
+    single("automation", [](AudioContext& c, Patch& p) { return p.add<AutomationNode>(c, 0.5f); });
+    single("mixer-8", [](AudioContext& c, Patch& p) {
+        auto* mixer = p.add<MixerNode>(c);
+        for (unsigned i = 0; i < 8; ++i) {
+            mixer->addInput(p.add<AutomationNode>(c, 0.1f * i), 1.0f);
+        }
+        return mixer;
+    });
+
+    for (const Case& golden : goldenCases()) {
+        cases.push_back({ "patch/" + golden.name, 0.0, golden.build });
+    }
+
+    return cases;
+}
+
+bool matches(const Options& options, const std::string& name) {
+    return options.filter.empty() || name.find(options.filter) != std::string::npos;
+}
+
+std::vector<float> render(const Case& c) {
+    AudioContext context(SAMPLE_RATE, FRAMES);
+    Patch patch;
+    c.build(context, patch);
+
+    const auto total = static_cast<size_t>(c.seconds * SAMPLE_RATE);
+    std::vector<float> output(total);
+
+    unsigned processing_id = 0;
+    for (size_t position = 0; position < total; position += FRAMES) {
+        const auto frames = static_cast<unsigned>(std::min<size_t>(FRAMES, total - position));
+        patch.output->process(frames, processing_id++);
+        context.updateBatch(frames);
+        std::copy_n(patch.output->buffer(), frames, output.begin() + position);
+
+        if (patch.update) {
+            patch.update(static_cast<double>(position + frames) / SAMPLE_RATE);
+        }
+    }
+
+    return output;
+}
+
+// Reads the mono float files written by writeGolden; nothing more general
+bool readGolden(const std::string& path, std::vector<float>& samples) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        return false;
+    }
+
+    char riff[12];
+    if (!in.read(riff, 12) || std::memcmp(riff, "RIFF", 4) != 0 || std::memcmp(riff + 8, "WAVE", 4) != 0) {
+        return false;
+    }
+
+    bool float_mono = false;
+    char header[8];
+    while (in.read(header, 8)) {
+        const std::uint32_t size = static_cast<unsigned char>(header[4]) | static_cast<unsigned char>(header[5]) << 8 |
+                                   static_cast<unsigned char>(header[6]) << 16 |
+                                   static_cast<std::uint32_t>(static_cast<unsigned char>(header[7])) << 24;
+
+        if (std::memcmp(header, "fmt ", 4) == 0) {
+            std::vector<unsigned char> fmt(size);
+            in.read(reinterpret_cast<char*>(fmt.data()), size);
+            float_mono = size >= 4 && fmt[0] == 3 && fmt[1] == 0 && fmt[2] == 1 && fmt[3] == 0;
+        } else if (std::memcmp(header, "data", 4) == 0) {
+            if (!float_mono) {
+                return false;
+            }
+            samples.resize(size / sizeof(float));
+            return static_cast<bool>(in.read(reinterpret_cast<char*>(samples.data()), samples.size() * sizeof(float)));
+        } else {
+            in.seekg(size + (size & 1), std::ios::cur);
+        }
+    }
+
+    return false;
+}
+
+bool writeGolden(const std::string& path, const std::vector<float>& samples) {
+    WavWriter writer;
+    return writer.open(path, SAMPLE_RATE, 1, WavWriter::Format::Float32) &&
+           writer.write(samples.data(), samples.size()) && writer.close();
+}
+
+bool checkGolden(const Options& options) {
+    bool ok = true;
+
+    for (const Case& c : goldenCases()) {
+        if (!matches(options, c.name)) {
+            continue;
+        }
+
+        const std::string path = options.golden_dir + "/" + c.name + ".wav";
+        const std::vector<float> rendered = render(c);
+
+        if (options.update) {
+            if (!writeGolden(path, rendered)) {
+                std::printf("golden %-28s FAIL  could not write %s\n", c.name.c_str(), path.c_str());
+                ok = false;
+            } else {
+                std::printf("golden %-28s updated\n", c.name.c_str());
+            }
+            continue;
+        }
+
+        std::vector<float> expected;
+        if (!readGolden(path, expected)) {
+            std::printf("golden %-28s FAIL  missing or unreadable %s\n", c.name.c_str(), path.c_str());
+            ok = false;
+            continue;
+        }
+
+        if (expected.size() != rendered.size()) {
+            std::printf("golden %-28s FAIL  %zu samples, reference has %zu\n", c.name.c_str(), rendered.size(), expected.size());
+            ok = false;
+            continue;
+        }
+
+        double max_diff = 0.0;
+        double sum_squares = 0.0;
+        size_t worst = 0;
+        size_t differing = 0;
+        for (size_t i = 0; i < rendered.size(); ++i) {
+            // compare bit patterns as well so NaN and -0 changes are not missed in exact mode
+            const bool identical = std::memcmp(&rendered[i], &expected[i], sizeof(float)) == 0;
+            if (identical) {
+                continue;
+            }
+            ++differing;
+
+            // a NaN or infinity on either side fails under any tolerance; a NaN difference
+            // would otherwise lose every comparison with max_diff and pass
+            double diff = std::fabs(static_cast<double>(rendered[i]) - expected[i]);
+            if (!std::isfinite(rendered[i]) || !std::isfinite(expected[i])) {
+                diff = INFINITY;
+            }
+            sum_squares += diff * diff;
+            if (diff > max_diff || differing == 1) {
+                max_diff = diff;
+                worst = i;
+            }
+        }
+
+        const bool passed = options.exact ? differing == 0 : max_diff <= options.tolerance;
+        ok = ok && passed;
+
+        if (differing == 0) {
+            std::printf("golden %-28s ok    bit-exact\n", c.name.c_str());
+        } else {
+            std::printf("golden %-28s %s  %zu samples differ, max %.3g at %.4f s, rms %.3g (%s)\n", c.name.c_str(),
+                        passed ? "ok  " : "FAIL", differing, max_diff, static_cast<double>(worst) / SAMPLE_RATE,
+                        std::sqrt(sum_squares / rendered.size()),
+                        options.exact ? "exact required" : ("tolerance " + std::to_string(options.tolerance)).c_str());
+        }
+    }
+
+    return ok;
+}
+
+// Best of several short runs; the minimum is the least noisy estimate on a busy machine
+double measureNs(const Case& c) {
+    AudioContext context(SAMPLE_RATE, FRAMES);
+    Patch patch;
+    c.build(context, patch);
+
+    unsigned processing_id = 0;
+    double position = 0.0;
+    const auto renderBlock = [&]() {
+        patch.output->process(FRAMES, processing_id++);
+        context.updateBatch(FRAMES);
+        position += static_cast<double>(FRAMES) / SAMPLE_RATE;
+        if (patch.update) {
+            patch.update(position);
+        }
+    };
+
+    for (unsigned i = 0; i < 32; ++i) {
+        renderBlock();
+    }
+
+    double best = INFINITY;
+    for (unsigned run = 0; run < PERF_RUNS; ++run) {
+        unsigned long long blocks = 0;
+        const auto start = std::chrono::steady_clock::now();
+        double elapsed = 0.0;
+        do {
+            for (unsigned i = 0; i < 8; ++i) {
+                renderBlock();
+            }
+            blocks += 8;
+            elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        } while (elapsed < PERF_RUN_MS * 1e6);
+
+        best = std::min(best, elapsed / (static_cast<double>(blocks) * FRAMES));
+    }
+
+    return best;
+}
+
+// A fixed scalar workload (sinf into a two-pole recursion) timed like the cases. Budgets are
+// scaled by how fast it runs now against when they were taken, which takes out clock speed
+// changes and most of the noise from other load on the machine.
+double calibrationNs() {
+    std::vector<float> buffer(FRAMES);
+    float phase = 0.0f;
+    float position = 0.0f;
+    float speed = 0.0f;
+
+    double best = INFINITY;
+    for (unsigned run = 0; run < PERF_RUNS; ++run) {
+        unsigned long long blocks = 0;
+        const auto start = std::chrono::steady_clock::now();
+        double elapsed = 0.0;
+        do {
+            for (unsigned i = 0; i < FRAMES; ++i) {
+                speed += (std::sin(phase) - position) * 0.01f;
+                position += speed;
+                speed *= 0.999f;
+                buffer[i] = position;
+                phase += 0.05f;
+                if (phase >= TWO_PI) phase -= TWO_PI;
+            }
+            ++blocks;
+            elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        } while (elapsed < PERF_RUN_MS * 1e6 / 2);
+
+        best = std::min(best, elapsed / (static_cast<double>(blocks) * FRAMES));
+    }
+
+    doNotOptimize(buffer[FRAMES - 1]);
+    return best;
+}
+
+std::map<std::string, double> readBudgets(const std::string& path) {
+    std::map<std::string, double> budgets;
+    std::ifstream in(path);
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::istringstream fields(line);
+        std::string name;
+        double ns = 0.0;
+        if (fields >> name >> ns) {
+            budgets[name] = ns;
+        }
+    }
+    return budgets;
+}
+
+bool writeBudgets(const std::string& path, const std::map<std::string, double>& budgets) {
+    std::ofstream out(path);
+    out << "# ns/sample budgets for synthcheck, " << FRAMES << "-frame blocks at " << SAMPLE_RATE << " Hz\n"
+        << "# regenerate with synthcheck --update-budgets on the baseline machine\n"
+        << "# measurements are scaled by calibration (the reference workload) before comparing\n";
+    for (const auto& entry : budgets) {
+        char value[32];
+        std::snprintf(value, sizeof(value), "%.3f", entry.second);
+        out << entry.first << ' ' << value << '\n';
+    }
+    return static_cast<bool>(out);
+}
+
+bool checkPerf(const Options& options) {
+    const std::string path = options.golden_dir + "/budgets.txt";
+    std::map<std::string, double> budgets = readBudgets(path);
+    bool ok = true;
+
+    if (options.update_budgets) {
+        budgets[CALIBRATION] = calibrationNs();
+    } else if (budgets.find(CALIBRATION) == budgets.end()) {
+        std::printf("perf   FAIL  no %s entry in %s\n", CALIBRATION, path.c_str());
+        return false;
+    }
+    const double baseline_calibration = budgets[CALIBRATION];
+
+    for (const Case& c : perfCases()) {
+        if (!matches(options, c.name)) {
+            continue;
+        }
+
+        // how much slower than the baseline this machine runs right now
+        double speed = calibrationNs() / baseline_calibration;
+        double ns = measureNs(c);
+
+        if (options.update_budgets) {
+            budgets[c.name] = ns / speed;
+            std::printf("perf   %-28s %8.2f ns/sample  budget updated\n", c.name.c_str(), ns / speed);
+            continue;
+        }
+
+        const auto budget = budgets.find(c.name);
+        if (budget == budgets.end()) {
+            std::printf("perf   %-28s %8.2f ns/sample  FAIL  no budget in %s\n", c.name.c_str(), ns, path.c_str());
+            ok = false;
+            continue;
+        }
+
+        const double limit = budget->second * (1.0 + options.slack) + options.slack_ns;
+        for (unsigned retry = 0; retry < PERF_RETRIES && ns / speed > limit; ++retry) {
+            speed = calibrationNs() / baseline_calibration;
+            ns = measureNs(c);
+        }
+
+        const bool passed = ns / speed <= limit;
+        ok = ok && passed;
+        std::printf("perf   %-28s %8.2f ns/sample  %s  %.2f at baseline speed, budget %.2f, limit %.2f\n", c.name.c_str(),
+                    ns, passed ? "ok  " : "FAIL", ns / speed, budget->second, limit);
+    }
+
+    if (options.update_budgets && !writeBudgets(path, budgets)) {
+        std::printf("perf   could not write %s\n", path.c_str());
+        return false;
+    }
+
+    return ok;
+}
+
+// Voices whose notes start and stop between block boundaries and a noise source through a
+// filter and a gain that follow scheduled set and ramp events, summed by a mixer that
+// processes its inputs on the pool
+void buildDeterminism(AudioContext& context, Patch& patch, WorkerPool& pool) {
+    auto* mixer = patch.add<MixerNode>(context);
+    mixer->setWorkerPool(&pool);
+
+    const wave_shape shapes[] = { wave_shape::sawtooth, wave_shape::pulse, wave_shape::triangle, wave_shape::square };
+    for (unsigned i = 0; i < 8; ++i) {
+        auto* voice = patch.add<VoiceNode>(context);
+        voice->setParameters(VoiceNode::Builder(context)
+                                 .setModFrequency(3.0f + i)
+                                 .setOscillator1Waveform(shapes[i % 4])
+                                 .setOscillator2Waveform(shapes[(i + 1) % 4])
+                                 .setOscillator1Frequency(110.0f * std::pow(2.0f, i / 5.0f))
+                                 .setOscillator2Frequency(165.0f * std::pow(2.0f, i / 7.0f))
+                                 .setOscillator1Gain(1)
+                                 .setOscillator2Gain(.3f)
+                                 .setOscillator1ModGain(.2f)
+                                 .setOscillator2ModGain(.3f)
+                                 .setVolumeEnvelopeA(.05f)
+                                 .setVolumeEnvelopeD(.2f)
+                                 .setVolumeEnvelopeS(.6f)
+                                 .setVolumeEnvelopeR(.3f)
+                                 .parameters());
+        voice->noteOnAt(0.001 + 0.0137 * i);
+        voice->noteOffAt(1.0 + 0.0731 * i);
+        mixer->addInput(voice, 1.0f);
+    }
+
+    // the noise stops after the voices have gone quiet, so the filter tail decays far enough
+    // to be snapped to zero in plain sight; a per-block snap would show the block size there
+    auto* noise = patch.add<NoiseNode>(context);
+    auto* level = patch.add<GainNode>(context, 0.0f);
+    level->gain()->setValueAtTime(0.2f, 0.1234);
+    level->gain()->linearRampValueAtTime(0.05f, 1.7777);
+    level->gain()->setValueAtTime(0.0f, 1.9501);
+    noise->connect(level);
+
+    auto* filter = patch.add<LP12FilterNode>(context, 800.0f, 4.0f);
+    auto* cutoff = patch.add<AutomationNode>(context, 0.0f);
+    cutoff->setValueAtTime(200.0f, 0.2003);
+    cutoff->linearRampValueAtTime(4000.0f, 0.8107);
+    cutoff->setValueAtTime(3000.0f, 0.9123);
+    cutoff->automate(filter, LP12FilterNode::Parameters::Cutoff);
+    level->connect(filter);
+    mixer->addInput(filter, 1.0f);
+
+    auto* master = patch.add<GainNode>(context, 0.8f);
+    mixer->connect(master);
+    patch.output = master;
+}
+
+std::vector<float> renderDeterminism(unsigned threads, unsigned frames, bool deterministic, double* ns_per_sample = nullptr) {
+    AudioContext context(SAMPLE_RATE, frames);
+    context.setDeterministic(deterministic);
+    context.setSeed(DETERMINISM_SEED);
+
+    WorkerPool pool(threads);
+    Patch patch;
+    buildDeterminism(context, patch, pool);
+
+    const auto total = static_cast<size_t>(DETERMINISM_SECONDS * SAMPLE_RATE);
+    std::vector<float> output(total);
+
+    unsigned processing_id = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t position = 0; position < total; position += frames) {
+        const auto block = static_cast<unsigned>(std::min<size_t>(frames, total - position));
+        patch.output->process(block, processing_id++);
+        context.updateBatch(block);
+        std::copy_n(patch.output->buffer(), block, output.begin() + position);
+    }
+    if (ns_per_sample) {
+        *ns_per_sample = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / total;
+    }
+
+    return output;
+}
+
+bool checkDeterminism() {
+    const std::vector<float> reference = renderDeterminism(1, FRAMES, true);
+    bool ok = true;
+
+    for (const unsigned threads : DETERMINISM_THREADS) {
+        for (const unsigned frames : DETERMINISM_FRAMES) {
+            const std::vector<float> rendered = renderDeterminism(threads, frames, true);
+
+            size_t differing = 0;
+            size_t first = 0;
+            for (size_t i = 0; i < rendered.size(); ++i) {
+                if (std::memcmp(&rendered[i], &reference[i], sizeof(float)) != 0 && differing++ == 0) {
+                    first = i;
+                }
+            }
+
+            const std::string name = std::to_string(threads) + " threads, " + std::to_string(frames) + " frames";
+            if (differing == 0) {
+                std::printf("determ %-28s ok    bit-identical\n", name.c_str());
+            } else {
+                std::printf("determ %-28s FAIL  %zu samples differ, first at %.4f s\n", name.c_str(), differing,
+                            static_cast<double>(first) / SAMPLE_RATE);
+                ok = false;
+            }
+        }
+    }
+
+    // the cost of the mode itself, single threaded at the default block size; best of five
+    double normal = INFINITY;
+    double deterministic = INFINITY;
+    for (unsigned run = 0; run < 5; ++run) {
+        double ns = 0.0;
+        renderDeterminism(1, FRAMES, false, &ns);
+        normal = std::min(normal, ns);
+        renderDeterminism(1, FRAMES, true, &ns);
+        deterministic = std::min(deterministic, ns);
+    }
+    std::printf("determ %-28s %8.2f ns/sample, %.2f without, %+.1f%%\n", "overhead", deterministic, normal,
+                100.0 * (deterministic / normal - 1.0));
+
+    return ok;
+}
+
+// Renders one block of node and returns the first sample that isn't expected, or -1
+int firstMismatch(AutomationNode& node, AudioContext& context, float expected) {
+    node.process(FRAMES, context.lastBatch());
+    context.updateBatch(FRAMES);
+    for (unsigned i = 0; i < FRAMES; ++i) {
+        if (node.buffer()[i] != expected) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+bool reportAutomation(const char* name, bool ok, const std::string& detail) {
+    std::printf("automation %-24s %s  %s\n", name, ok ? "ok  " : "FAIL", detail.c_str());
+    return ok;
+}
+
+bool checkAutomation() {
+    AudioContext context(SAMPLE_RATE, FRAMES);
+    bool ok = true;
+
+    // the base value alone, not added to itself
+    AutomationNode unpatched(context, 440.0f);
+    const int unpatched_at = firstMismatch(unpatched, context, 440.0f);
+    ok = reportAutomation("unpatched", unpatched_at < 0,
+                          unpatched_at < 0 ? "440" : "sample " + std::to_string(unpatched_at) + " reads " +
+                                                         std::to_string(unpatched.buffer()[unpatched_at])) && ok;
+
+    // a patched input modulates around the base value
+    AutomationNode offset(context, 5.0f);
+    AutomationNode patched(context, 440.0f);
+    patched.setInput(&offset);
+    const int patched_at = firstMismatch(patched, context, 445.0f);
+    ok = reportAutomation("patched", patched_at < 0,
+                          patched_at < 0 ? "440 + 5" : "sample " + std::to_string(patched_at) + " reads " +
+                                                           std::to_string(patched.buffer()[patched_at])) && ok;
+
+    // and an unpatched oscillator plays the frequency it is set to
+    OscillatorNode oscillator(context, wave_shape::sine, 440.0f);
+    unsigned crossings = 0;
+    float last = 0.0f;
+    for (unsigned block = 0; block < SAMPLE_RATE / FRAMES; ++block) {
+        oscillator.process(FRAMES, context.lastBatch());
+        context.updateBatch(FRAMES);
+        for (unsigned i = 0; i < FRAMES; ++i) {
+            const float sample = oscillator.buffer()[i];
+            crossings += last < 0.0f && sample >= 0.0f ? 1 : 0;
+            last = sample;
+        }
+    }
+    const double seconds = static_cast<double>(SAMPLE_RATE / FRAMES * FRAMES) / SAMPLE_RATE;
+    const double hz = crossings / seconds;
+    char measured[32];
+    std::snprintf(measured, sizeof(measured), "%.1f Hz", hz);
+    ok = reportAutomation("oscillator at 440 Hz", std::fabs(hz - 440.0) <= 2.0, measured) && ok;
+
+    return ok;
+}
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        const bool has_value = i + 1 < argc;
+
+        if (std::strcmp(arg, "--golden-dir") == 0 && has_value) {
+            options.golden_dir = argv[++i];
+        } else if (std::strcmp(arg, "--tolerance") == 0 && has_value) {
+            options.tolerance = std::atof(argv[++i]);
+        } else if (std::strcmp(arg, "--slack") == 0 && has_value) {
+            options.slack = std::atof(argv[++i]);
+        } else if (std::strcmp(arg, "--slack-ns") == 0 && has_value) {
+            options.slack_ns = std::atof(argv[++i]);
+        } else if (std::strcmp(arg, "--filter") == 0 && has_value) {
+            options.filter = argv[++i];
+        } else if (std::strcmp(arg, "--exact") == 0) {
+            options.exact = true;
+        } else if (std::strcmp(arg, "--skip-golden") == 0) {
+            options.golden = false;
+        } else if (std::strcmp(arg, "--skip-perf") == 0) {
+            options.perf = false;
+        } else if (std::strcmp(arg, "--skip-determinism") == 0) {
+            options.determinism = false;
+        } else if (std::strcmp(arg, "--update") == 0) {
+            options.update = true;
+        } else if (std::strcmp(arg, "--update-budgets") == 0) {
+            options.update_budgets = true;
+        } else {
+            return false;
+        }
+    }
+
+    return options.tolerance >= 0 && options.slack >= 0 && options.slack_ns >= 0;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::fprintf(stderr, "usage: synthcheck [--golden-dir DIR] [--tolerance X] [--exact] [--slack X] [--slack-ns X] "
+                             "[--skip-golden] "
+                             "[--skip-perf] [--skip-determinism] [--update] [--update-budgets] [--filter TEXT]\n");
+        return 1;
+    }
+
+    ScopedDenormalDisable denormal_guard;
+
+    bool ok = true;
+    if (options.golden) {
+        ok = checkGolden(options) && ok;
+    }
+    if (options.perf) {
+        ok = checkPerf(options) && ok;
+    }
+    if (options.determinism && !options.update && !options.update_budgets && matches(options, "determinism")) {
+        ok = checkDeterminism() && ok;
+    }
+    if (!options.update && !options.update_budgets && matches(options, "automation")) {
+        ok = checkAutomation() && ok;
+    }
+
+    std::printf("%s\n", ok ? "synthcheck passed" : "synthcheck FAILED");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,110 @@
+// Converts patches between the binary form the engine loads and the JSON form kept for
+// review and diffs, and checks that a patch instantiates.
+//
+// usage: synthpatch [options] <input> [<output>]
+//   --types       list the registered node types with their parameters and ports
+//
+// Files ending in .json are read and written as JSON, anything else as binary. With no
+// output the patch is printed as JSON, so `synthpatch a.synp | diff - b.json` works.
+
+#include "audiocontext.h"
+#include "definitions.h"
+#include "noderegistry.h"
+#include "patch.h"
+#include "patchgraph.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+namespace {
+
+struct Options {
+    std::string input;
+    std::string output;
+    bool types = false;
+};
+
+bool isJson(const std::string& path) {
+    return path.size() >= 5 && path.compare(path.size() - 5, 5, ".json") == 0;
+}
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+
+        if (std::strcmp(arg, "--types") == 0) {
+            options.types = true;
+        } else if (arg[0] == '-') {
+            return false;
+        } else if (options.input.empty()) {
+            options.input = arg;
+        } else if (options.output.empty()) {
+            options.output = arg;
+        } else {
+            return false;
+        }
+    }
+
+    return options.types || !options.input.empty();
+}
+
+void printTypes(const NodeRegistry& registry) {
+    for (const NodeType& type : registry.types()) {
+        std::printf("%s (id %08x, %zu bytes)\n", type.name, type.id, type.size);
+        for (unsigned p = 0; p < type.parameters.size(); ++p) {
+            const NodeType::Parameter& parameter = type.parameters[p];
+            std::printf("    %-24s %g", parameter.name, parameter.default_value);
+            for (unsigned c = 0; c < type.choiceCount(p); ++c) {
+                std::printf("%s%s", c == 0 ? "  [" : " ", parameter.choices[c]);
+            }
+            std::printf("%s%s\n", type.choiceCount(p) > 0 ? "]" : "", parameter.state ? "  (state)" : "");
+        }
+        for (const char* port : type.ports) {
+            std::printf("    port %s\n", port);
+        }
+    }
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::fprintf(stderr, "usage: synthpatch [--types] <input> [<output>]\n");
+        return 1;
+    }
+
+    const NodeRegistry& registry = NodeRegistry::builtin();
+    if (options.types) {
+        printTypes(registry);
+        if (options.input.empty()) {
+            return 0;
+        }
+    }
+
+    Patch patch;
+    if (!(isJson(options.input) ? patch.loadJson(options.input, registry) : patch.load(options.input))) {
+        return 1;
+    }
+
+    // catches unknown types and out-of-range values the file format itself can't
+    AudioContext context(SAMPLE_RATE, FRAMES);
+    PatchGraph graph(context, registry);
+    if (!graph.instantiate(patch)) {
+        return 1;
+    }
+
+    if (options.output.empty()) {
+        std::fputs(patch.toJson(registry).c_str(), stdout);
+        return 0;
+    }
+
+    if (!(isJson(options.output) ? patch.saveJson(options.output, registry) : patch.save(options.output))) {
+        return 1;
+    }
+    std::printf("%s: %u nodes, %u edges, %u parameters, %zu bytes, topology %08x\n", options.output.c_str(),
+                patch.header().node_count, patch.header().edge_count, patch.header().parameter_count, patch.size(),
+                patch.header().topology_hash);
+    return 0;
+}
@@ -0,0 +1,180 @@
+// Plays the demo graph through one of the headless audio backends:
+//   null  - renders at real-time block cadence and discards the audio (soak/profiling)
+//   file  - renders into a WAV file as fast as possible
+//   pipe  - streams raw PCM to stdout or a FIFO for another local process
+
+#include "audiocontext.h"
+#include "definitions.h"
+#include "demopatch.h"
+#include "fileaudiobackend.h"
+#include "nullaudiobackend.h"
+#include "pipeaudiobackend.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+
+namespace {
+
+struct Options {
+    std::string backend = "null";
+    std::string path = "-";
+    double seconds = 10.0;
+    unsigned voices = 0;
+    unsigned sample_rate = SAMPLE_RATE;
+    unsigned frames = FRAMES;
+    bool s16 = false;
+};
+
+void printUsage() {
+    std::fprintf(stderr,
+                 "usage: synthplay [options]\n"
+                 "  --backend B   null, file or pipe (default null)\n"
+                 "  --out PATH    WAV path for file, FIFO/file or - (stdout) for pipe\n"
+                 "  --seconds N   how much audio to play (default 10)\n"
+                 "  --voices N    play N VoiceNodes instead of the demo patch\n"
+                 "  --rate HZ     sample rate (default %d)\n"
+                 "  --frames N    block size (default %d)\n"
+                 "  --s16         16-bit output for file and pipe backends\n",
+                 SAMPLE_RATE, FRAMES);
+}
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        const bool has_value = i + 1 < argc;
+
+        if (std::strcmp(arg, "--backend") == 0 && has_value) {
+            options.backend = argv[++i];
+        } else if (std::strcmp(arg, "--out") == 0 && has_value) {
+            options.path = argv[++i];
+        } else if (std::strcmp(arg, "--seconds") == 0 && has_value) {
+            options.seconds = std::atof(argv[++i]);
+        } else if (std::strcmp(arg, "--voices") == 0 && has_value) {
+            options.voices = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else if (std::strcmp(arg, "--rate") == 0 && has_value) {
+            options.sample_rate = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else if (std::strcmp(arg, "--frames") == 0 && has_value) {
+            options.frames = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else if (std::strcmp(arg, "--s16") == 0) {
+            options.s16 = true;
+        } else {
+            return false;
+        }
+    }
+
+    return options.seconds > 0 && options.frames > 0 && options.sample_rate > 0;
+}
+
+std::unique_ptr<AudioBackend> createBackend(const Options& options) {
+    if (options.backend == "null") {
+        return std::make_unique<NullAudioBackend>(nullptr, options.sample_rate, options.frames);
+    }
+
+    if (options.backend == "file") {
+        auto backend = std::make_unique<FileAudioBackend>(options.path == "-" ? "synthplay.wav" : options.path, nullptr,
+                                                          options.sample_rate, options.frames,
+                                                          options.s16 ? WavWriter::Format::Pcm16 : WavWriter::Format::Float32);
+        backend->setLengthFrames(static_cast<unsigned long long>(options.seconds * options.sample_rate));
+        return backend;
+    }
+
+    if (options.backend == "pipe") {
+        return std::make_unique<PipeAudioBackend>(options.path, nullptr, options.sample_rate, options.frames,
+                                                  options.s16 ? PipeAudioBackend::Format::S16LE : PipeAudioBackend::Format::Float32);
+    }
+
+    return nullptr;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage();
+        return 1;
+    }
+
+    auto backend = createBackend(options);
+    if (!backend) {
+        std::fprintf(stderr, "Unknown backend '%s'\n", options.backend.c_str());
+        return 1;
+    }
+
+    AudioContext context(static_cast<float>(options.sample_rate), options.frames);
+
+    std::unique_ptr<DemoPatch> demo;
+    std::unique_ptr<DemoVoiceBank> bank;
+    AudioNode* output = nullptr;
+
+    if (options.voices == 0) {
+        demo = std::make_unique<DemoPatch>(context);
+        output = demo->output();
+    } else {
+        bank = std::make_unique<DemoVoiceBank>(context, options.voices);
+        output = bank->output();
+    }
+
+    const auto total_frames = static_cast<unsigned long long>(options.seconds * options.sample_rate);
+    std::atomic<unsigned long long> position { 0 };
+    unsigned processing_id = 0;
+
+    backend->setCallback([&](const void*, float* out, unsigned long frames) {
+        output->process(frames, processing_id++);
+        context.updateBatch(frames);
+
+        const float* buffer = output->buffer();
+        for (unsigned long i = 0; i < frames; ++i) {
+            out[i * 2] = buffer[i];
+            out[i * 2 + 1] = buffer[i];
+        }
+
+        const double seconds = static_cast<double>(position += frames) / options.sample_rate;
+        if (demo) {
+            demo->updateGate(seconds);
+        } else {
+            bank->updateGate(seconds, options.seconds);
+        }
+    });
+
+    if (!backend->initializeStream() || !backend->start()) {
+        std::fprintf(stderr, "Failed to start the %s backend\n", options.backend.c_str());
+        return 1;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+
+    if (auto* file = dynamic_cast<FileAudioBackend*>(backend.get())) {
+        if (!file->waitUntilFinished()) {
+            return 1;
+        }
+    } else {
+        auto* pipe = dynamic_cast<PipeAudioBackend*>(backend.get());
+        while (position < total_frames && !(pipe && pipe->failed())) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+    }
+
+    const bool stopped = backend->stop();
+    const double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const double played = static_cast<double>(position) / options.sample_rate;
+
+    std::fprintf(stderr, "%s backend: %.2f s of audio in %.2f s wall (%.1fx)\n",
+                 options.backend.c_str(), played, wall, played / wall);
+
+    if (auto* null = dynamic_cast<NullAudioBackend*>(backend.get())) {
+        std::fprintf(stderr, "blocks %llu, late %llu, worst block %.1f us of %.1f us budget\n",
+                     null->blocksRendered(), null->lateBlocks(), null->maxRenderNs() / 1000.0,
+                     1e6 * options.frames / options.sample_rate);
+    } else if (auto* pipe = dynamic_cast<PipeAudioBackend*>(backend.get())) {
+        std::fprintf(stderr, "%llu bytes in %llu write calls\n", pipe->bytesWritten(), pipe->writeCalls());
+    }
+
+    return stopped ? 0 : 1;
+}
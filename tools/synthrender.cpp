@@ -0,0 +1,147 @@
+// Headless offline renderer: builds a graph, renders it to a WAV file as fast as the
+// CPU allows and reports the realtime factor. Needs neither Qt nor an audio device.
+
+#include "audiocontext.h"
+#include "definitions.h"
+#include "demopatch.h"
+#include "denormals.h"
+#include "wavwriter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Options {
+    std::string output;
+    double seconds = 10.0;
+    unsigned voices = 0;
+    unsigned sample_rate = SAMPLE_RATE;
+    unsigned frames = FRAMES;
+    WavWriter::Format format = WavWriter::Format::Float32;
+};
+
+void printUsage() {
+    std::fprintf(stderr,
+                 "usage: synthrender [options] <output.wav>\n"
+                 "  --seconds N   length to render (default 10)\n"
+                 "  --voices N    render N VoiceNodes instead of the demo patch\n"
+                 "  --rate HZ     sample rate (default %d)\n"
+                 "  --frames N    block size (default %d)\n"
+                 "  --pcm16       write 16-bit PCM instead of 32-bit float\n",
+                 SAMPLE_RATE, FRAMES);
+}
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        const bool has_value = i + 1 < argc;
+
+        if (std::strcmp(arg, "--seconds") == 0 && has_value) {
+            options.seconds = std::atof(argv[++i]);
+        } else if (std::strcmp(arg, "--voices") == 0 && has_value) {
+            options.voices = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else if (std::strcmp(arg, "--rate") == 0 && has_value) {
+            options.sample_rate = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else if (std::strcmp(arg, "--frames") == 0 && has_value) {
+            options.frames = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else if (std::strcmp(arg, "--pcm16") == 0) {
+            options.format = WavWriter::Format::Pcm16;
+        } else if (arg[0] == '-') {
+            return false;
+        } else {
+            options.output = arg;
+        }
+    }
+
+    return !options.output.empty() && options.seconds > 0 && options.frames > 0 && options.sample_rate > 0;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage();
+        return 1;
+    }
+
+    ScopedDenormalDisable denormal_guard;
+
+    AudioContext context(static_cast<float>(options.sample_rate), options.frames);
+
+    std::unique_ptr<DemoPatch> demo;
+    std::unique_ptr<DemoVoiceBank> bank;
+    AudioNode* output = nullptr;
+
+    if (options.voices == 0) {
+        demo = std::make_unique<DemoPatch>(context);
+        output = demo->output();
+    } else {
+        bank = std::make_unique<DemoVoiceBank>(context, options.voices);
+        output = bank->output();
+    }
+
+    WavWriter writer;
+    if (!writer.open(options.output, options.sample_rate, 2, options.format)) {
+        return 1;
+    }
+
+    const auto total_frames = static_cast<unsigned long long>(options.seconds * options.sample_rate);
+    std::vector<float> interleaved(static_cast<size_t>(options.frames) * 2);
+
+    double render_ns = 0;
+    const auto wall_start = std::chrono::steady_clock::now();
+
+    unsigned processing_id = 0;
+    for (unsigned long long position = 0; position < total_frames; position += options.frames) {
+        const auto frames = static_cast<unsigned>(std::min<unsigned long long>(options.frames, total_frames - position));
+
+        const auto block_start = std::chrono::steady_clock::now();
+        output->process(frames, processing_id++);
+        context.updateBatch(frames);
+        render_ns += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - block_start).count();
+
+        const float* buffer = output->buffer();
+        for (unsigned i = 0; i < frames; ++i) {
+            interleaved[i * 2] = buffer[i];
+            interleaved[i * 2 + 1] = buffer[i];
+        }
+
+        if (!writer.write(interleaved.data(), frames)) {
+            std::fprintf(stderr, "Failed to write %s\n", options.output.c_str());
+            return 1;
+        }
+
+        const double seconds = static_cast<double>(position + frames) / options.sample_rate;
+        if (demo) {
+            demo->updateGate(seconds);
+        } else {
+            bank->updateGate(seconds, options.seconds);
+        }
+    }
+
+    if (!writer.close()) {
+        return 1;
+    }
+
+    const double wall_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - wall_start).count();
+    const double audio_ns = static_cast<double>(total_frames) * 1e9 / options.sample_rate;
+    const unsigned voice_count = options.voices == 0 ? 1 : options.voices;
+    const double ns_per_sample = render_ns / static_cast<double>(total_frames);
+
+    std::printf("rendered %.2f s (%llu frames, %u frames/block) to %s\n",
+                options.seconds, total_frames, options.frames, options.output.c_str());
+    std::printf("realtime factor   : %.1fx (render only %.1fx)\n", audio_ns / wall_ns, audio_ns / render_ns);
+    std::printf("ns/sample         : %.2f\n", ns_per_sample);
+    std::printf("ns/sample/voice   : %.2f (%u %s)\n", ns_per_sample / voice_count, voice_count,
+                options.voices == 0 ? "demo patch" : "voices");
+
+    return 0;
+}
@@ -0,0 +1,479 @@
+// Long-duration soak test. Renders hours of audio as fast as the CPU allows while a
+// seeded random player keeps hitting notes, retuning oscillators (including negative and
+// past-Nyquist frequencies), swapping waveforms, throwing extreme cutoff and resonance
+// values at LP12 filters and replacing voices with fresh ones. Once per report window it
+// prints and checks:
+//   nonfinite  NaN or Inf samples on the output or the probes
+//   peak       largest output sample, for information
+//   dc         mean over the window of the up probe through an LP12 whose cutoff and
+//              resonance the player keeps moving within the musical range. The mixed output
+//              can't be used for this: an oscillator tuned just past a multiple of the sample
+//              rate aliases down to a legitimate near-DC tone, and a resonance-100 filter
+//              dropped to a few Hz rings for seconds
+//   drift      measured frequency of two lone sine probes, one at +f and one at -f, in ppm
+//              of the nominal frequency, relative to the first window
+//   stale      blocks where a probe's buffer did not change, i.e. a node was skipped
+//   ns/smp     render cost over the window, compared first windows against last
+// Processing ids start at --start-id and wrap, so the default of UINT_MAX has the fresh
+// graph see the largest id first and wrap straight after.
+//
+// usage: synthsoak [options]
+//   --hours N            audio to render (default 1)
+//   --voices N           voices in the random player (default 8)
+//   --seed N             random seed (default 1)
+//   --rate HZ            sample rate (default 44100)
+//   --frames N           block size (default 512)
+//   --report-seconds N   audio seconds per report window (default 60)
+//   --events N           random player events per audio second (default 20)
+//   --start-id N         first processing id (default 4294967295)
+//   --max-dc X           largest allowed window DC (default 0.05)
+//   --max-drift-ppm X    largest allowed probe frequency drift (default 10)
+//   --max-slowdown X     allowed slowdown of the last windows over the first, as a fraction (default 0.5)
+//
+// Exits non-zero when any check fails.
+
+#include "audiocontext.h"
+#include "definitions.h"
+#include "denormals.h"
+#include "gainnode.h"
+#include "lp12filternode.h"
+#include "mixernode.h"
+#include "oscillatornode.h"
+#include "voicenode.h"
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace {
+
+constexpr float PROBE_FREQUENCY = 997.0f;
+// windows averaged at each end of the run for the slowdown check
+constexpr unsigned SLOWDOWN_WINDOWS = 3;
+
+struct Options {
+    double hours = 1.0;
+    unsigned voices = 8;
+    unsigned seed = 1;
+    unsigned sample_rate = SAMPLE_RATE;
+    unsigned frames = FRAMES;
+    double report_seconds = 60.0;
+    double events = 20.0;
+    unsigned start_id = UINT_MAX;
+    double max_dc = 0.05;
+    double max_drift_ppm = 10.0;
+    double max_slowdown = 0.5;
+};
+
+void printUsage() {
+    std::fprintf(stderr,
+                 "usage: synthsoak [options]\n"
+                 "  --hours N            audio to render (default 1)\n"
+                 "  --voices N           voices in the random player (default 8)\n"
+                 "  --seed N             random seed (default 1)\n"
+                 "  --rate HZ            sample rate (default %d)\n"
+                 "  --frames N           block size (default %d)\n"
+                 "  --report-seconds N   audio seconds per report window (default 60)\n"
+                 "  --events N           random player events per audio second (default 20)\n"
+                 "  --start-id N         first processing id (default %u)\n"
+                 "  --max-dc X           largest allowed window DC (default 0.05)\n"
+                 "  --max-drift-ppm X    largest allowed probe frequency drift (default 10)\n"
+                 "  --max-slowdown X     allowed slowdown of the last windows over the first (default 0.5)\n",
+                 SAMPLE_RATE, FRAMES, UINT_MAX);
+}
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        const bool has_value = i + 1 < argc;
+
+        if (std::strcmp(arg, "--hours") == 0 && has_value) {
+            options.hours = std::atof(argv[++i]);
+        } else if (std::strcmp(arg, "--voices") == 0 && has_value) {
+            options.voices = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else if (std::strcmp(arg, "--seed") == 0 && has_value) {
+            options.seed = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (std::strcmp(arg, "--rate") == 0 && has_value) {
+            options.sample_rate = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else if (std::strcmp(arg, "--frames") == 0 && has_value) {
+            options.frames = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else if (std::strcmp(arg, "--report-seconds") == 0 && has_value) {
+            options.report_seconds = std::atof(argv[++i]);
+        } else if (std::strcmp(arg, "--events") == 0 && has_value) {
+            options.events = std::atof(argv[++i]);
+        } else if (std::strcmp(arg, "--start-id") == 0 && has_value) {
+            options.start_id = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (std::strcmp(arg, "--max-dc") == 0 && has_value) {
+            options.max_dc = std::atof(argv[++i]);
+        } else if (std::strcmp(arg, "--max-drift-ppm") == 0 && has_value) {
+            options.max_drift_ppm = std::atof(argv[++i]);
+        } else if (std::strcmp(arg, "--max-slowdown") == 0 && has_value) {
+            options.max_slowdown = std::atof(argv[++i]);
+        } else {
+            return false;
+        }
+    }
+
+    return options.hours > 0 && options.voices > 0 && options.sample_rate > 0 && options.frames > 0 &&
+           options.report_seconds > 0;
+}
+
+// Pulse is left out: its mean depends on the pulse width, which would read as DC
+const wave_shape WAVEFORMS[] = {
+    wave_shape::sine, wave_shape::triangle, wave_shape::square, wave_shape::sawtooth, wave_shape::inv_sawtooth,
+};
+
+// One voice of the random player and the filter behind it
+struct Slot {
+    std::unique_ptr<VoiceNode> voice;
+    std::unique_ptr<LP12FilterNode> filter;
+    bool playing = false;
+};
+
+class Player
+{
+public:
+    Player(AudioContext& context, MixerNode& mixer, unsigned voices, unsigned seed, LP12FilterNode& probe_filter)
+        : context_(context), mixer_(mixer), random_(seed), slots_(voices), probe_filter_(probe_filter) {
+        for (Slot& slot : slots_) {
+            slot.filter = std::make_unique<LP12FilterNode>(context_, 2000.0f, 1.0f);
+            mixer_.addInput(slot.filter.get(), 1.0f);
+            replaceVoice(slot);
+        }
+    }
+
+    void event() {
+        Slot& slot = slots_[std::uniform_int_distribution<size_t>(0, slots_.size() - 1)(random_)];
+        VoiceNode& voice = *slot.voice;
+        LP12FilterNode& filter = *slot.filter;
+
+        switch (std::uniform_int_distribution<int>(0, 10)(random_)) {
+        case 0:
+        case 1:
+            slot.playing = !slot.playing;
+            if (slot.playing) {
+                voice.noteOn();
+            } else {
+                voice.noteOff();
+            }
+            break;
+        case 2:
+            voice.updateOscillator1Frequency(frequency());
+            break;
+        case 3:
+            voice.updateOscillator2Frequency(frequency());
+            break;
+        case 4:
+            voice.updateOscillator1Detune(uniform(-2400.0f, 2400.0f));
+            voice.setOscillator1Waveform(waveform());
+            voice.setOscillator2Waveform(waveform());
+            break;
+        case 5:
+            // deliberately reaches past both ends of the usable range
+            filter.setCutoff(std::exp(uniform(std::log(1.0f), std::log(40000.0f))));
+            break;
+        case 6:
+            filter.setResonance(chance(0.1) ? uniform(-5.0f, 0.6f) : uniform(0.0f, 40.0f));
+            break;
+        case 7:
+            filter.setDetune(uniform(-2400.0f, 2400.0f));
+            break;
+        case 8:
+            voice.updateModFrequency(uniform(0.0f, 20.0f));
+            voice.updateModOscillator1Gain(uniform(0.0f, 1.0f));
+            voice.updateModOscillator2Gain(uniform(0.0f, 1.0f));
+            break;
+        case 9:
+            if (chance(0.1)) {
+                replaceVoice(slot);
+            } else {
+                voice.updateVolumeEnvelopeA(uniform(0.0f, 0.5f));
+                voice.updateVolumeEnvelopeD(uniform(0.0f, 0.5f));
+                voice.updateVolumeEnvelopeS(uniform(0.0f, 1.0f));
+                voice.updateVolumeEnvelopeR(uniform(0.0f, 1.0f));
+            }
+            break;
+        case 10:
+            probe_filter_.setCutoff(std::exp(uniform(std::log(20.0f), std::log(20000.0f))));
+            probe_filter_.setResonance(uniform(0.6f, 4.0f));
+            break;
+        }
+    }
+
+    bool chance(double probability) { return std::uniform_real_distribution<double>(0.0, 1.0)(random_) < probability; }
+
+private:
+    float uniform(float low, float high) { return std::uniform_real_distribution<float>(low, high)(random_); }
+
+    wave_shape waveform() {
+        return WAVEFORMS[std::uniform_int_distribution<size_t>(0, std::size(WAVEFORMS) - 1)(random_)];
+    }
+
+    // mostly musical, sometimes negative or well past Nyquist
+    float frequency() {
+        if (chance(0.05)) {
+            return uniform(-2000.0f, 0.0f);
+        }
+        if (chance(0.05)) {
+            return uniform(20000.0f, 100000.0f);
+        }
+        return std::exp(uniform(std::log(20.0f), std::log(8000.0f)));
+    }
+
+    // a new voice joins the graph mid-run and sees whatever processing id comes next
+    void replaceVoice(Slot& slot) {
+        auto voice = std::make_unique<VoiceNode>(context_);
+        voice->setParameters(VoiceNode::Builder(context_)
+                                 .setOscillator1Waveform(waveform())
+                                 .setOscillator2Waveform(waveform())
+                                 .setOscillator1Frequency(frequency())
+                                 .setOscillator2Frequency(frequency())
+                                 .setOscillator1Gain(uniform(0.0f, 1.0f))
+                                 .setOscillator2Gain(uniform(0.0f, 1.0f))
+                                 .setVolumeEnvelopeA(uniform(0.0f, 0.2f))
+                                 .setVolumeEnvelopeD(uniform(0.0f, 0.5f))
+                                 .setVolumeEnvelopeS(uniform(0.0f, 1.0f))
+                                 .setVolumeEnvelopeR(uniform(0.0f, 1.0f))
+                                 .parameters());
+        voice->connect(slot.filter.get());
+        slot.voice = std::move(voice);
+        slot.playing = false;
+    }
+
+    AudioContext& context_;
+    MixerNode& mixer_;
+    std::mt19937 random_;
+    std::vector<Slot> slots_;
+    LP12FilterNode& probe_filter_;
+};
+
+// Frequency of a lone sine from its upward zero crossings, interpolated between samples
+class FrequencyProbe
+{
+public:
+    FrequencyProbe(AudioContext& context, float frequency, unsigned frames)
+        : oscillator_(context, wave_shape::sine, frequency), previous_block_(frames, 0.0f) {}
+
+    OscillatorNode& node() { return oscillator_; }
+    unsigned staleBlocks() const { return stale_blocks_; }
+
+    // returns the number of non-finite samples in the block
+    unsigned analyse(unsigned frames, unsigned long long first_sample) {
+        const float* buffer = oscillator_.buffer();
+        if (buffer == nullptr || std::equal(buffer, buffer + frames, previous_block_.begin())) {
+            ++stale_blocks_;
+            return 0;
+        }
+
+        unsigned nonfinite = 0;
+        for (unsigned i = 0; i < frames; ++i) {
+            const float sample = buffer[i];
+            if (!std::isfinite(sample)) {
+                ++nonfinite;
+                continue;
+            }
+            if (last_sample_ < 0.0f && sample >= 0.0f) {
+                const double position = static_cast<double>(first_sample + i - window_start_) - 1.0 +
+                                        last_sample_ / (last_sample_ - sample);
+                if (crossings_ == 0) {
+                    first_crossing_ = position;
+                }
+                last_crossing_ = position;
+                ++crossings_;
+            }
+            last_sample_ = sample;
+        }
+
+        std::copy_n(buffer, frames, previous_block_.begin());
+        return nonfinite;
+    }
+
+    // measured frequency over the window, then starts the next one
+    double endWindow(unsigned sample_rate, unsigned long long next_window_start) {
+        const double frequency = crossings_ > 1 && last_crossing_ > first_crossing_
+            ? (crossings_ - 1) * static_cast<double>(sample_rate) / (last_crossing_ - first_crossing_)
+            : 0.0;
+        crossings_ = 0;
+        window_start_ = next_window_start;
+        return frequency;
+    }
+
+private:
+    OscillatorNode oscillator_;
+    std::vector<float> previous_block_;
+    unsigned stale_blocks_ = 0;
+
+    unsigned long long window_start_ = 0;
+    float last_sample_ = 0.0f;
+    unsigned long long crossings_ = 0;
+    double first_crossing_ = 0.0;
+    double last_crossing_ = 0.0;
+};
+
+double ppm(double measured, double nominal) {
+    return (measured - nominal) / nominal * 1e6;
+}
+
+double mean(const std::vector<double>& values, size_t first, size_t count) {
+    double sum = 0.0;
+    for (size_t i = first; i < first + count; ++i) {
+        sum += values[i];
+    }
+    return sum / count;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage();
+        return 1;
+    }
+
+    ScopedDenormalDisable denormal_guard;
+
+    AudioContext context(static_cast<float>(options.sample_rate), options.frames);
+
+    // the down probe runs its phase backwards, which is where an unwrapped accumulator drifts
+    FrequencyProbe up(context, PROBE_FREQUENCY, options.frames);
+    FrequencyProbe down(context, -PROBE_FREQUENCY, options.frames);
+    LP12FilterNode dc_filter(context, 2000.0f, 1.0f);
+    up.node().connect(&dc_filter);
+
+    MixerNode mixer(context);
+    GainNode output(context, 1.0f / options.voices);
+    mixer.connect(&output);
+    Player player(context, mixer, options.voices, options.seed, dc_filter);
+
+    const unsigned long long total_samples =
+        static_cast<unsigned long long>(options.hours * 3600.0 * options.sample_rate);
+    const unsigned long long window_samples =
+        std::max<unsigned long long>(options.frames, static_cast<unsigned long long>(options.report_seconds * options.sample_rate));
+    const double event_probability = options.events * options.frames / options.sample_rate;
+
+    std::printf("soaking %.2f h of audio, %u voices, seed %u, first processing id %u\n\n", options.hours,
+                options.voices, options.seed, options.start_id);
+    std::printf("%10s %8s %8s %10s %10s %10s %10s %10s\n", "audio s", "x rt", "ns/smp", "nonfinite", "dc", "peak",
+                "up ppm", "down ppm");
+
+    unsigned processing_id = options.start_id;
+    unsigned long long rendered = 0;
+    unsigned long long window_start = 0;
+    unsigned long long nonfinite = 0;
+    unsigned long long window_nonfinite = 0;
+    double window_sum = 0.0;
+    double window_peak = 0.0;
+    double window_ns = 0.0;
+
+    std::vector<double> window_costs;
+    bool have_reference = false;
+    double reference_up = 0.0;
+    double reference_down = 0.0;
+    double worst_dc = 0.0;
+    double worst_drift = 0.0;
+
+    while (rendered < total_samples) {
+        for (double p = event_probability; p > 0.0; p -= 1.0) {
+            if (p >= 1.0 || player.chance(p)) {
+                player.event();
+            }
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        output.process(options.frames, processing_id);
+        up.node().process(options.frames, processing_id);
+        down.node().process(options.frames, processing_id);
+        dc_filter.process(options.frames, processing_id);
+        context.updateBatch(options.frames);
+        window_ns += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        ++processing_id;
+
+        const float* buffer = output.buffer();
+        const float* dc_buffer = dc_filter.buffer();
+        for (unsigned i = 0; i < options.frames; ++i) {
+            const float sample = buffer[i];
+            if (!std::isfinite(sample) || !std::isfinite(dc_buffer[i])) {
+                ++window_nonfinite;
+                continue;
+            }
+            window_sum += dc_buffer[i];
+            window_peak = std::max(window_peak, static_cast<double>(std::fabs(sample)));
+        }
+        window_nonfinite += up.analyse(options.frames, rendered);
+        window_nonfinite += down.analyse(options.frames, rendered);
+
+        rendered += options.frames;
+
+        if (rendered - window_start < window_samples && rendered < total_samples) {
+            continue;
+        }
+
+        const unsigned long long samples = rendered - window_start;
+        const double ns_per_sample = window_ns / samples;
+        const double realtime = samples * 1e9 / options.sample_rate / window_ns;
+        const double dc = window_sum / samples;
+        const double up_frequency = up.endWindow(options.sample_rate, rendered);
+        const double down_frequency = down.endWindow(options.sample_rate, rendered);
+
+        if (!have_reference) {
+            reference_up = up_frequency;
+            reference_down = down_frequency;
+            have_reference = true;
+        }
+        worst_dc = std::max(worst_dc, std::fabs(dc));
+        worst_drift = std::max({ worst_drift, std::fabs(ppm(up_frequency, reference_up)),
+                                 std::fabs(ppm(down_frequency, reference_down)) });
+        nonfinite += window_nonfinite;
+        window_costs.push_back(ns_per_sample);
+
+        std::printf("%10.0f %8.1f %8.2f %10llu %10.5f %10.4f %10.3f %10.3f\n",
+                    static_cast<double>(rendered) / options.sample_rate, realtime, ns_per_sample, window_nonfinite, dc,
+                    window_peak, ppm(up_frequency, PROBE_FREQUENCY), ppm(down_frequency, PROBE_FREQUENCY));
+        std::fflush(stdout);
+
+        window_start = rendered;
+        window_nonfinite = 0;
+        window_sum = 0.0;
+        window_peak = 0.0;
+        window_ns = 0.0;
+    }
+
+    bool ok = true;
+    const auto check = [&ok](bool passed, const char* what, const char* format, double value, double limit) {
+        std::printf("%-10s %s  ", what, passed ? "ok  " : "FAIL");
+        std::printf(format, value, limit);
+        std::printf("\n");
+        ok = ok && passed;
+    };
+
+    std::printf("\n");
+    check(nonfinite == 0, "nonfinite", "%.0f samples (limit %.0f)", static_cast<double>(nonfinite), 0.0);
+    check(worst_dc <= options.max_dc, "dc", "worst window %.5f (limit %.5f)", worst_dc, options.max_dc);
+    check(worst_drift <= options.max_drift_ppm, "drift", "worst %.3f ppm (limit %.3f)", worst_drift,
+          options.max_drift_ppm);
+    check(up.staleBlocks() + down.staleBlocks() == 0, "stale", "%.0f blocks (limit %.0f)",
+          static_cast<double>(up.staleBlocks() + down.staleBlocks()), 0.0);
+
+    // the last window is usually partial, so compare whole windows only
+    const size_t whole = window_costs.size() > 1 ? window_costs.size() - 1 : window_costs.size();
+    if (whole >= 2 * SLOWDOWN_WINDOWS) {
+        const double first = mean(window_costs, 0, SLOWDOWN_WINDOWS);
+        const double last = mean(window_costs, whole - SLOWDOWN_WINDOWS, SLOWDOWN_WINDOWS);
+        const double slowdown = last / first - 1.0;
+        check(slowdown <= options.max_slowdown, "slowdown", "%+.1f%% (limit %.1f%%)", slowdown * 100.0,
+              options.max_slowdown * 100.0);
+    } else {
+        std::printf("%-10s skip  needs %u whole report windows\n", "slowdown", 2 * SLOWDOWN_WINDOWS);
+    }
+
+    std::printf("\n%s\n", ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}